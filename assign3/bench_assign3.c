@@ -0,0 +1,1354 @@
+#include <pthread.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "dberror.h"
+
+#include "btree_mgr.h"
+#include "hash_mgr.h"
+#include "expr.h"
+#include "record_mgr.h"
+#include "tables.h"
+#include "test_helper.h"
+#include "rm_serializer.h"
+
+// print one measurement of the running benchmark
+#define BENCH_RESULT(format, ...)					\
+		do {									\
+			printf("[%s-%s] ", __FILE__, testName);				\
+			printf(format, __VA_ARGS__);					\
+			printf("\n");							\
+		} while(0)
+
+// benchmark methods
+static void benchChurn (void);
+static void benchFilter (void);
+static void benchCompoundPredicates (void);
+static void benchValues (void);
+static void benchGetSetAttr (void);
+static void benchVarchar (void);
+static void benchTimestamps (void);
+static void benchIndexLookups (void);
+static void benchHashLookups (void);
+static void benchBulkLoad (void);
+static void benchKeyCompression (void);
+static void benchConcurrentIndex (void);
+static void benchSecondaryIndex (void);
+static void benchZoneMaps (void);
+
+// helper methods
+static double elapsedSeconds (struct timespec *start);
+static long fileSize (char *name);
+Record *benchRecord (Schema *schema, int a, char *b, int c);
+static void setBenchKey (Record *record, Schema *schema, int a);
+static void *insertIndexKeys (void *arg);
+static void *lookupIndexKeys (void *arg);
+
+// a thread of benchConcurrentIndex, it handles every step-th key from first
+typedef struct IndexWorker {
+	BTreeHandle *tree;
+	int first;
+	int step;
+	int numKeys;
+	int numLookups;
+	int errors;
+} IndexWorker;
+Schema *benchSchema (void);
+
+// test name
+char *testName;
+
+// main method
+int
+main (void)
+{
+	testName = "";
+	srand(42);
+	benchChurn();
+	benchFilter();
+	benchCompoundPredicates();
+	benchValues();
+	benchGetSetAttr();
+	benchVarchar();
+	benchTimestamps();
+	benchIndexLookups();
+	benchHashLookups();
+	benchBulkLoad();
+	benchKeyCompression();
+	benchConcurrentIndex();
+	benchSecondaryIndex();
+	benchZoneMaps();
+
+	return 0;
+}
+
+// ************************************************************
+// insert/delete cycles on a table of fixed size, the slots of deleted records
+// are reused so the file does not grow after the first cycle
+void
+benchChurn (void)
+{
+	RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+	int numRecords = 5000, numCycles = 10, nextKey = 0, i, j;
+	RID *rids;
+	Record *r;
+	Schema *schema;
+	struct timespec start;
+	testName = "insert/delete churn";
+	schema = benchSchema();
+	rids = (RID *) malloc(sizeof(RID) * numRecords);
+
+	TEST_CHECK(initRecordManager(NULL));
+	TEST_CHECK(createTable("bench_table", schema));
+	TEST_CHECK(openTable(table, "bench_table"));
+
+	// a is the key, every insert takes the next one
+	r = benchRecord(schema, 1, "aaaa", 1);
+	for(i = 0; i < numRecords; i++)
+	{
+		setBenchKey(r, schema, nextKey++);
+		TEST_CHECK(insertRecord(table, r));
+		rids[i] = r->id;
+	}
+	BENCH_RESULT("loaded %d records, file size %ld bytes", numRecords, fileSize("bench_table"));
+
+	// every cycle replaces half of the records at random
+	for(j = 0; j < numCycles; j++)
+	{
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		for(i = 0; i < numRecords / 2; i++)
+		{
+			int pos = rand() % numRecords;
+			TEST_CHECK(deleteRecord(table, rids[pos]));
+			setBenchKey(r, schema, nextKey++);
+			TEST_CHECK(insertRecord(table, r));
+			rids[pos] = r->id;
+		}
+		double seconds = elapsedSeconds(&start);
+		BENCH_RESULT("cycle %d: %.2f us per delete+insert, %d tuples, file size %ld bytes",
+				j, seconds * 1e6 / (numRecords / 2), getNumTuples(table), fileSize("bench_table"));
+	}
+
+	TEST_CHECK(closeTable(table));
+	TEST_CHECK(deleteTable("bench_table"));
+	TEST_CHECK(shutdownRecordManager());
+
+	freeRecord(r);
+	free(rids);
+	free(table);
+}
+
+// ************************************************************
+// evaluate a < 500 on a batch of records, once record by record and once a
+// block of records at a time
+void
+benchFilter (void)
+{
+	int numRecords = 4096, numRounds = 200, matches, i, j;
+	RecordBatch *batch;
+	ExprProgram *program;
+	Expr *attr, *cons, *cond;
+	Schema *schema;
+	uint64_t *selection;
+	struct timespec start;
+	double seconds;
+	testName = "filter a < 500";
+	schema = benchSchema();
+	selection = (uint64_t *) malloc(sizeof(uint64_t) * (numRecords / EXPR_BLOCK_SIZE));
+
+	TEST_CHECK(createRecordBatch(&batch, schema, numRecords));
+	for(i = 0; i < numRecords; i++)
+	{
+		Record *r = benchRecord(schema, rand() % 1000, "aaaa", 1);
+		memcpy(batch->records[i].data, r->data, getRecordSize(schema));
+		freeRecord(r);
+	}
+	batch->count = numRecords;
+
+	MAKE_ATTRREF(attr, 0);
+	MAKE_CONS(cons, stringToValue("i500"));
+	MAKE_BINOP_EXPR(cond, attr, cons, OP_COMP_SMALLER);
+	TEST_CHECK(compileExpr(cond, schema, &program));
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	matches = 0;
+	for(j = 0; j < numRounds; j++)
+		for(i = 0; i < numRecords; i++)
+		{
+			bool match;
+			evalExprProgram(program, &batch->records[i], &match);
+			matches += match;
+		}
+	seconds = elapsedSeconds(&start);
+	BENCH_RESULT("record at a time: %.1f M values/s, %d matches",
+			numRecords * (double) numRounds / seconds / 1e6, matches / numRounds);
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	matches = 0;
+	for(j = 0; j < numRounds; j++)
+	{
+		evalExprProgramBatch(program, batch->records, numRecords, selection);
+		for(i = 0; i < numRecords / EXPR_BLOCK_SIZE; i++)
+			matches += __builtin_popcountll(selection[i]);
+	}
+	seconds = elapsedSeconds(&start);
+	BENCH_RESULT("block at a time: %.1f M values/s, %d matches",
+			numRecords * (double) numRounds / seconds / 1e6, matches / numRounds);
+
+	TEST_CHECK(freeExprProgram(program));
+	freeExpr(cond);
+	TEST_CHECK(freeRecordBatch(batch));
+	freeSchema(schema);
+	free(selection);
+}
+
+// ************************************************************
+// evaluate a < x AND b = zzzz with evalExpr for several selectivities of
+// a < x, once with the cheap integer comparison first and once with the
+// string comparison first, and with the optimized program
+void
+benchCompoundPredicates (void)
+{
+	int numRecords = 4096, numRounds = 20, i, j, k;
+	int bounds[] = { 10, 100, 500, 900 };
+	RecordBatch *batch;
+	Schema *schema;
+	struct timespec start;
+	testName = "compound predicates";
+	schema = benchSchema();
+
+	TEST_CHECK(createRecordBatch(&batch, schema, numRecords));
+	for(i = 0; i < numRecords; i++)
+	{
+		Record *r = benchRecord(schema, rand() % 1000, i % 2 ? "aaaa" : "zzzz", 1);
+		memcpy(batch->records[i].data, r->data, getRecordSize(schema));
+		freeRecord(r);
+	}
+
+	for(k = 0; k < 4; k++)
+	{
+		Expr *attr, *cons, *smaller, *equal, *intFirst, *stringFirst, *optimized;
+		ExprProgram *program;
+		Value *bound, *res;
+		double seconds[3];
+		int matches[3] = { 0, 0, 0 };
+
+		MAKE_VALUE(bound, DT_INT, bounds[k]);
+		MAKE_ATTRREF(attr, 0);
+		MAKE_CONS(cons, bound);
+		MAKE_BINOP_EXPR(smaller, attr, cons, OP_COMP_SMALLER);
+		MAKE_ATTRREF(attr, 1);
+		MAKE_CONS(cons, stringToValue("szzzz"));
+		MAKE_BINOP_EXPR(equal, attr, cons, OP_COMP_EQUAL);
+		MAKE_BINOP_EXPR(intFirst, smaller, equal, OP_BOOL_AND);
+		// the string side first is what optimizeExpr would undo
+		MAKE_BINOP_EXPR(stringFirst, equal, smaller, OP_BOOL_AND);
+		TEST_CHECK(optimizeExpr(stringFirst, schema, &optimized));
+		TEST_CHECK(compileExpr(optimized, schema, &program));
+
+		for(j = 0; j < 3; j++)
+		{
+			clock_gettime(CLOCK_MONOTONIC, &start);
+			for(int round = 0; round < numRounds; round++)
+				for(i = 0; i < numRecords; i++)
+				{
+					Record *r = &batch->records[i];
+					bool match;
+					if (j == 2)
+						evalExprProgram(program, r, &match);
+					else
+					{
+						TEST_CHECK(evalExpr(r, schema, j == 0 ? intFirst : stringFirst, &res));
+						match = res->v.boolV;
+						freeVal(res);
+					}
+					matches[j] += match;
+				}
+			seconds[j] = elapsedSeconds(&start);
+		}
+		BENCH_RESULT("a < %d (%d%%): int first %.0f ns, string first %.0f ns, compiled %.0f ns per record, %d matches",
+				bounds[k], bounds[k] / 10,
+				seconds[0] * 1e9 / numRecords / numRounds, seconds[1] * 1e9 / numRecords / numRounds,
+				seconds[2] * 1e9 / numRecords / numRounds, matches[0] / numRounds);
+
+		TEST_CHECK(freeExprProgram(program));
+		freeExpr(optimized);
+		// both trees share their arguments
+		free(stringFirst->expr.op->args);
+		free(stringFirst->expr.op);
+		free(stringFirst);
+		freeExpr(intFirst);
+	}
+
+	TEST_CHECK(freeRecordBatch(batch));
+	freeSchema(schema);
+}
+
+// ************************************************************
+// read the string attribute b of every record, with getAttr, which allocates
+// a value and a copy of the string, with getAttrView, which does neither, and
+// with evalExprArena, which resets its arena for every record
+void
+benchValues (void)
+{
+	int numRecords = 4096, numRounds = 200, i, j, k, length;
+	long bytes[3] = { 0, 0, 0 };
+	double seconds[3];
+	RecordBatch *batch;
+	ExprArena *arena;
+	Expr *attr;
+	Schema *schema;
+	struct timespec start;
+	testName = "string values";
+	schema = benchSchema();
+
+	TEST_CHECK(createRecordBatch(&batch, schema, numRecords));
+	for(i = 0; i < numRecords; i++)
+	{
+		Record *r = benchRecord(schema, i, i % 2 ? "aaaa" : "zz", 1);
+		memcpy(batch->records[i].data, r->data, getRecordSize(schema));
+		freeRecord(r);
+	}
+	TEST_CHECK(createExprArena(&arena, EXPR_ARENA_SIZE));
+	MAKE_ATTRREF(attr, 1);
+
+	for(k = 0; k < 3; k++)
+	{
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		for(j = 0; j < numRounds; j++)
+			for(i = 0; i < numRecords; i++)
+			{
+				Record *r = &batch->records[i];
+				Value *value, view;
+				if (k == 0)
+				{
+					getAttr(r, schema, 1, &value);
+					bytes[k] += strlen(value->v.stringV);
+					freeVal(value);
+				}
+				else if (k == 1)
+				{
+					getAttrView(r, schema, 1, &view, &length);
+					bytes[k] += length;
+				}
+				else
+				{
+					resetExprArena(arena);
+					evalExprArena(r, schema, attr, arena, &value);
+					bytes[k] += strlen(value->v.stringV);
+				}
+			}
+		seconds[k] = elapsedSeconds(&start);
+	}
+	BENCH_RESULT("getAttr %.1f ns, getAttrView %.1f ns, evalExprArena %.1f ns per value, %ld bytes",
+			seconds[0] * 1e9 / numRecords / numRounds, seconds[1] * 1e9 / numRecords / numRounds,
+			seconds[2] * 1e9 / numRecords / numRounds, bytes[1] / numRounds);
+
+	freeExpr(attr);
+	TEST_CHECK(freeExprArena(arena));
+	TEST_CHECK(freeRecordBatch(batch));
+	freeSchema(schema);
+}
+
+// ************************************************************
+// setAttr and getAttr on a record with one attribute of every datatype
+void
+benchGetSetAttr (void)
+{
+	int numRounds = 1000000, i, k;
+	char *names[] = { "int", "float", "bool", "string" };
+	DataType dt[] = { DT_INT, DT_FLOAT, DT_BOOL, DT_STRING };
+	int sizes[] = { 0, 0, 0, 8 };
+	char **cpNames = (char **) malloc(sizeof(char*) * 4);
+	DataType *cpDt = (DataType *) malloc(sizeof(DataType) * 4);
+	int *cpSizes = (int *) malloc(sizeof(int) * 4);
+	int *cpKeys = (int *) calloc(1, sizeof(int));
+	Schema *schema;
+	Record *r;
+	Value *values[4], *value;
+	struct timespec start;
+	testName = "get/set attributes";
+
+	for(i = 0; i < 4; i++)
+	{
+		cpNames[i] = (char *) malloc(strlen(names[i]) + 1);
+		strcpy(cpNames[i], names[i]);
+	}
+	memcpy(cpDt, dt, sizeof(DataType) * 4);
+	memcpy(cpSizes, sizes, sizeof(int) * 4);
+	schema = createSchema(4, cpNames, cpDt, cpSizes, 1, cpKeys);
+	TEST_CHECK(createRecord(&r, schema));
+	values[0] = stringToValue("i123456");
+	values[1] = stringToValue("f2.5");
+	values[2] = stringToValue("bt");
+	values[3] = stringToValue("sabcdefg");
+
+	for(k = 0; k < 4; k++)
+	{
+		double setSeconds, getSeconds;
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		for(i = 0; i < numRounds; i++)
+		{
+			values[k]->v.intV += (k < 2);
+			setAttr(r, schema, k, values[k]);
+		}
+		setSeconds = elapsedSeconds(&start);
+
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		for(i = 0; i < numRounds; i++)
+		{
+			getAttr(r, schema, k, &value);
+			freeVal(value);
+		}
+		getSeconds = elapsedSeconds(&start);
+		BENCH_RESULT("%s: setAttr %.1f ns, getAttr %.1f ns", names[k],
+				setSeconds * 1e9 / numRounds, getSeconds * 1e9 / numRounds);
+	}
+
+	for(k = 0; k < 4; k++)
+		freeVal(values[k]);
+	freeRecord(r);
+	freeSchema(schema);
+}
+
+// ************************************************************
+// store mostly short strings with a few long ones in a STRING[256] and a
+// VARCHAR[256] attribute, a VARCHAR slot only keeps a short prefix so many
+// more records fit on a page and a scan reads fewer pages
+void
+benchVarchar (void)
+{
+	RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+	RM_ScanHandle *sc = (RM_ScanHandle *) malloc(sizeof(RM_ScanHandle));
+	char *typeNames[] = { "STRING[256]", "VARCHAR[256]" };
+	DataType types[] = { DT_STRING, DT_VARCHAR };
+	int numRecords = 10000, i, k;
+	char shortValue[17], longValue[201];
+	struct timespec start;
+	testName = "varchar density";
+
+	memset(shortValue, 's', 16);
+	shortValue[16] = '\0';
+	memset(longValue, 'l', 200);
+	longValue[200] = '\0';
+
+	for(k = 0; k < 2; k++)
+	{
+		char **cpNames = (char **) malloc(sizeof(char*) * 2);
+		DataType *cpDt = (DataType *) malloc(sizeof(DataType) * 2);
+		int *cpSizes = (int *) malloc(sizeof(int) * 2);
+		int *cpKeys = (int *) calloc(1, sizeof(int));
+		double insertSeconds, scanSeconds;
+		int found = 0;
+		Schema *schema;
+		Record *r;
+		Value *value;
+
+		cpNames[0] = (char *) malloc(2);
+		strcpy(cpNames[0], "a");
+		cpNames[1] = (char *) malloc(2);
+		strcpy(cpNames[1], "b");
+		cpDt[0] = DT_INT;
+		cpDt[1] = types[k];
+		cpSizes[0] = 0;
+		cpSizes[1] = 256;
+		schema = createSchema(2, cpNames, cpDt, cpSizes, 1, cpKeys);
+
+		TEST_CHECK(initRecordManager(NULL));
+		TEST_CHECK(createTable("bench_table", schema));
+		TEST_CHECK(openTable(table, "bench_table"));
+		TEST_CHECK(createRecord(&r, schema));
+
+		// every 50th value does not fit into the inline prefix
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		for(i = 0; i < numRecords; i++)
+		{
+			MAKE_VALUE(value, DT_INT, i);
+			TEST_CHECK(setAttr(r, schema, 0, value));
+			freeVal(value);
+			MAKE_STRING_VALUE(value, i % 50 == 0 ? longValue : shortValue);
+			TEST_CHECK(setAttr(r, schema, 1, value));
+			freeVal(value);
+			TEST_CHECK(insertRecord(table, r));
+		}
+		insertSeconds = elapsedSeconds(&start);
+
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		TEST_CHECK(startScan(table, sc, NULL));
+		while(next(sc, r) == RC_OK)
+			found++;
+		TEST_CHECK(closeScan(sc));
+		scanSeconds = elapsedSeconds(&start);
+		TEST_CHECK(closeTable(table));
+
+		BENCH_RESULT("%s: file size %ld bytes, overflow file %ld bytes, insert %.2f us, scan %.2f us per record (%d records)",
+				typeNames[k], fileSize("bench_table"), k == 1 ? fileSize("bench_table.ovf") : 0L,
+				insertSeconds * 1e6 / numRecords, scanSeconds * 1e6 / found, found);
+
+		TEST_CHECK(deleteTable("bench_table"));
+		TEST_CHECK(shutdownRecordManager());
+		freeRecord(r);
+		freeSchema(schema);
+	}
+	free(sc);
+	free(table);
+}
+
+// ************************************************************
+// filter a day of events by their time, once stored as text in a STRING[26]
+// and once as a TIMESTAMP
+void
+benchTimestamps (void)
+{
+	int numRecords = 4096, numRounds = 200, matches, i, j, k;
+	char *typeNames[] = { "STRING[26]", "TIMESTAMP" };
+	DataType types[] = { DT_STRING, DT_TIMESTAMP };
+	int64_t start;
+	struct timespec begin;
+	testName = "timestamp filter";
+	TEST_CHECK(parseTimestamp("2024-03-01 00:00:00", &start));
+
+	for(k = 0; k < 2; k++)
+	{
+		char **cpNames = (char **) malloc(sizeof(char*));
+		DataType *cpDt = (DataType *) malloc(sizeof(DataType));
+		int *cpSizes = (int *) malloc(sizeof(int));
+		int *cpKeys = (int *) calloc(1, sizeof(int));
+		uint64_t selection[numRecords / EXPR_BLOCK_SIZE];
+		RecordBatch *batch;
+		ExprProgram *program;
+		Expr *attr, *low, *high, *cond;
+		Schema *schema;
+		Value *value;
+
+		cpNames[0] = (char *) malloc(3);
+		strcpy(cpNames[0], "at");
+		cpDt[0] = types[k];
+		cpSizes[0] = 26;
+		schema = createSchema(1, cpNames, cpDt, cpSizes, 1, cpKeys);
+
+		// the same events spread over 30 days for both types
+		TEST_CHECK(createRecordBatch(&batch, schema, numRecords));
+		for(i = 0; i < numRecords; i++)
+		{
+			int64_t micros = start + (int64_t) i * 7919 % (30 * 86400) * 1000000;
+			if (types[k] == DT_TIMESTAMP)
+				MAKE_VALUE(value, DT_TIMESTAMP, micros);
+			else
+			{
+				char buf[TIMESTAMP_STRING_SIZE];
+				formatTimestamp(micros, buf);
+				MAKE_STRING_VALUE(value, buf);
+			}
+			TEST_CHECK(setAttr(&batch->records[i], schema, 0, value));
+			freeVal(value);
+		}
+		batch->count = numRecords;
+
+		MAKE_ATTRREF(attr, 0);
+		if (types[k] == DT_TIMESTAMP)
+		{
+			MAKE_CONS(low, stringToValue("T2024-03-10"));
+			MAKE_CONS(high, stringToValue("T2024-03-10 23:59:59"));
+		}
+		else
+		{
+			MAKE_CONS(low, stringToValue("s2024-03-10 00:00:00"));
+			MAKE_CONS(high, stringToValue("s2024-03-10 23:59:59"));
+		}
+		MAKE_BETWEEN_EXPR(cond, attr, low, high);
+		TEST_CHECK(compileExpr(cond, schema, &program));
+
+		clock_gettime(CLOCK_MONOTONIC, &begin);
+		matches = 0;
+		for(j = 0; j < numRounds; j++)
+		{
+			evalExprProgramBatch(program, batch->records, numRecords, selection);
+			for(i = 0; i < numRecords / EXPR_BLOCK_SIZE; i++)
+				matches += __builtin_popcountll(selection[i]);
+		}
+		double seconds = elapsedSeconds(&begin);
+		BENCH_RESULT("%s: %.1f M values/s, %d matches, record size %d bytes", typeNames[k],
+				numRecords * (double) numRounds / seconds / 1e6, matches / numRounds,
+				getRecordSize(schema));
+
+		TEST_CHECK(freeExprProgram(program));
+		freeExpr(cond);
+		TEST_CHECK(freeRecordBatch(batch));
+		freeSchema(schema);
+	}
+}
+
+// ************************************************************
+// point lookups a = k and range scans over 1% of the keys, once with a full
+// scan of the table on the copy c of a that has no index, once through a
+// b-tree on a and once through startScan on the key index of a. the key index
+// includes c, so a scan projecting a and c never reads a heap page
+void
+benchIndexLookups (void)
+{
+	RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+	RM_ScanHandle *sc = (RM_ScanHandle *) malloc(sizeof(RM_ScanHandle));
+	int numRecords = 20000, numHeapLookups = 20, numIndexLookups = 20000, i, j;
+	int rangeSize = numRecords / 100, matches;
+	int include[] = {2}, proj[] = {0, 2};
+	BT_ScanHandle *treeScan;
+	BTreeHandle *tree;
+	Record *r;
+	Schema *schema;
+	Value *key, *low, *high;
+	Expr *attr, *lowCons, *highCons, *cond;
+	struct timespec start;
+	double heapSeconds, indexSeconds;
+	RID rid;
+	RC rc;
+	testName = "index lookups";
+	schema = benchSchema();
+	TEST_CHECK(setKeyIncludes(schema, 1, include));
+
+	TEST_CHECK(initRecordManager(NULL));
+	TEST_CHECK(initIndexManager(NULL));
+	TEST_CHECK(createTable("bench_table", schema));
+	TEST_CHECK(openTable(table, "bench_table"));
+	TEST_CHECK(createBtree("bench_index", DT_INT, 0));
+	TEST_CHECK(openBtree(&tree, "bench_index"));
+
+	// a is unique and loaded in random order
+	for(i = 0; i < numRecords; i++)
+	{
+		int a = (int) ((long) i * 7919 % numRecords);
+		r = benchRecord(schema, a, "aaaa", a);
+		TEST_CHECK(insertRecord(table, r));
+		MAKE_VALUE(key, DT_INT, a);
+		TEST_CHECK(insertKey(tree, key, r->id));
+		freeVal(key);
+		freeRecord(r);
+	}
+	TEST_CHECK(getTreeHeight(tree, &i));
+	TEST_CHECK(getNumNodes(tree, &j));
+	BENCH_RESULT("loaded %d records, index height %d, %d nodes, file size %ld bytes",
+			numRecords, i, j, fileSize("bench_index"));
+
+	TEST_CHECK(createRecord(&r, schema));
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	matches = 0;
+	for(j = 0; j < numHeapLookups; j++)
+	{
+		MAKE_ATTRREF(attr, 2);
+		MAKE_VALUE(key, DT_INT, rand() % numRecords);
+		MAKE_CONS(lowCons, key);
+		MAKE_BINOP_EXPR(cond, attr, lowCons, OP_COMP_EQUAL);
+		TEST_CHECK(startScan(table, sc, cond));
+		while((rc = next(sc, r)) == RC_OK)
+			matches++;
+		TEST_CHECK(closeScan(sc));
+		freeExpr(cond);
+	}
+	heapSeconds = elapsedSeconds(&start) / numHeapLookups;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for(j = 0; j < numIndexLookups; j++)
+	{
+		MAKE_VALUE(key, DT_INT, rand() % numRecords);
+		TEST_CHECK(findKey(tree, key, &rid));
+		TEST_CHECK(getRecord(table, rid, r));
+		freeVal(key);
+		matches++;
+	}
+	indexSeconds = elapsedSeconds(&start) / numIndexLookups;
+	BENCH_RESULT("a = k: heap scan of c %.1f us, index %.2f us per lookup (%.0fx), %d matches",
+			heapSeconds * 1e6, indexSeconds * 1e6, heapSeconds / indexSeconds, matches);
+
+	// the same through the key index the record manager keeps on a
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for(j = 0; j < numIndexLookups; j++)
+	{
+		MAKE_VALUE(key, DT_INT, rand() % numRecords);
+		TEST_CHECK(getRecordByKey(table, &key, r));
+		freeVal(key);
+	}
+	indexSeconds = elapsedSeconds(&start) / numIndexLookups;
+	BENCH_RESULT("getRecordByKey: %.2f us per lookup", indexSeconds * 1e6);
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for(j = 0; j < numIndexLookups; j++)
+	{
+		MAKE_ATTRREF(attr, 0);
+		MAKE_VALUE(key, DT_INT, rand() % numRecords);
+		MAKE_CONS(lowCons, key);
+		MAKE_BINOP_EXPR(cond, attr, lowCons, OP_COMP_EQUAL);
+		TEST_CHECK(startScan(table, sc, cond));
+		while((rc = next(sc, r)) == RC_OK)
+			matches++;
+		TEST_CHECK(closeScan(sc));
+		freeExpr(cond);
+	}
+	indexSeconds = elapsedSeconds(&start) / numIndexLookups;
+	BENCH_RESULT("startScan a = k: %.2f us per scan through the key index", indexSeconds * 1e6);
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	matches = 0;
+	for(j = 0; j < numHeapLookups; j++)
+	{
+		int from = rand() % (numRecords - rangeSize);
+		MAKE_ATTRREF(attr, 2);
+		MAKE_VALUE(low, DT_INT, from);
+		MAKE_VALUE(high, DT_INT, from + rangeSize - 1);
+		MAKE_CONS(lowCons, low);
+		MAKE_CONS(highCons, high);
+		MAKE_BETWEEN_EXPR(cond, attr, lowCons, highCons);
+		TEST_CHECK(startScan(table, sc, cond));
+		while((rc = next(sc, r)) == RC_OK)
+			matches++;
+		TEST_CHECK(closeScan(sc));
+		freeExpr(cond);
+	}
+	heapSeconds = elapsedSeconds(&start) / numHeapLookups;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for(j = 0; j < numHeapLookups * 10; j++)
+	{
+		int from = rand() % (numRecords - rangeSize);
+		MAKE_VALUE(low, DT_INT, from);
+		MAKE_VALUE(high, DT_INT, from + rangeSize - 1);
+		TEST_CHECK(openTreeRangeScan(tree, low, high, &treeScan));
+		while(nextEntry(treeScan, &rid) == RC_OK)
+		{
+			TEST_CHECK(getRecord(table, rid, r));
+			matches++;
+		}
+		TEST_CHECK(closeTreeScan(treeScan));
+		freeVal(low);
+		freeVal(high);
+	}
+	indexSeconds = elapsedSeconds(&start) / (numHeapLookups * 10);
+	BENCH_RESULT("a BETWEEN k AND k + %d: heap scan of c %.1f us, index %.1f us per scan (%.0fx), %d matches",
+			rangeSize - 1, heapSeconds * 1e6, indexSeconds * 1e6, heapSeconds / indexSeconds, matches);
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for(j = 0; j < numHeapLookups * 10; j++)
+	{
+		int from = rand() % (numRecords - rangeSize);
+		MAKE_ATTRREF(attr, 0);
+		MAKE_VALUE(low, DT_INT, from);
+		MAKE_VALUE(high, DT_INT, from + rangeSize - 1);
+		MAKE_CONS(lowCons, low);
+		MAKE_CONS(highCons, high);
+		MAKE_BETWEEN_EXPR(cond, attr, lowCons, highCons);
+		TEST_CHECK(startScan(table, sc, cond));
+		while((rc = next(sc, r)) == RC_OK)
+			matches++;
+		TEST_CHECK(closeScan(sc));
+		freeExpr(cond);
+	}
+	indexSeconds = elapsedSeconds(&start) / (numHeapLookups * 10);
+	BENCH_RESULT("startScan a BETWEEN k AND k + %d: %.1f us per scan through the key index, pages sorted",
+			rangeSize - 1, indexSeconds * 1e6);
+	heapSeconds = indexSeconds;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for(j = 0; j < numHeapLookups * 10; j++)
+	{
+		int from = rand() % (numRecords - rangeSize);
+		MAKE_ATTRREF(attr, 0);
+		MAKE_VALUE(low, DT_INT, from);
+		MAKE_VALUE(high, DT_INT, from + rangeSize - 1);
+		MAKE_CONS(lowCons, low);
+		MAKE_CONS(highCons, high);
+		MAKE_BETWEEN_EXPR(cond, attr, lowCons, highCons);
+		TEST_CHECK(startProjectedScan(table, sc, cond, 2, proj));
+		while((rc = next(sc, r)) == RC_OK)
+			matches++;
+		TEST_CHECK(closeScan(sc));
+		freeExpr(cond);
+	}
+	indexSeconds = elapsedSeconds(&start) / (numHeapLookups * 10);
+	BENCH_RESULT("startProjectedScan a, c with a BETWEEN k AND k + %d: %.1f us per index-only scan (%.1fx), key index %ld bytes",
+			rangeSize - 1, indexSeconds * 1e6, heapSeconds / indexSeconds, fileSize("bench_table.idx"));
+
+	freeRecord(r);
+	TEST_CHECK(closeBtree(tree));
+	TEST_CHECK(deleteBtree("bench_index"));
+	TEST_CHECK(closeTable(table));
+	TEST_CHECK(deleteTable("bench_table"));
+	TEST_CHECK(shutdownIndexManager());
+	TEST_CHECK(shutdownRecordManager());
+	free(sc);
+	free(table);
+}
+
+// ************************************************************
+// equality probes on a B+ tree and a hash index over the same keys, both
+// much larger than their buffer pools
+void
+benchHashLookups (void)
+{
+	int numKeys = 200000, numLookups = 200000, height, buckets, depth, i;
+	BTreeHandle *tree;
+	HashHandle *hash;
+	Value *key;
+	struct timespec start;
+	double treeSeconds, hashSeconds;
+	RID rid;
+	testName = "hash lookups";
+
+	TEST_CHECK(initIndexManager(NULL));
+	TEST_CHECK(createBtree("bench_index", DT_INT, 0));
+	TEST_CHECK(openBtree(&tree, "bench_index"));
+	TEST_CHECK(createHashIndex("bench_hash", DT_INT, 0));
+	TEST_CHECK(openHashIndex(&hash, "bench_hash"));
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for(i = 0; i < numKeys; i++)
+	{
+		MAKE_VALUE(key, DT_INT, (int) ((long) i * 7919 % numKeys));
+		rid.page = i / 100;
+		rid.slot = i % 100;
+		TEST_CHECK(insertKey(tree, key, rid));
+		freeVal(key);
+	}
+	treeSeconds = elapsedSeconds(&start) / numKeys;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for(i = 0; i < numKeys; i++)
+	{
+		MAKE_VALUE(key, DT_INT, (int) ((long) i * 7919 % numKeys));
+		rid.page = i / 100;
+		rid.slot = i % 100;
+		TEST_CHECK(insertHashKey(hash, key, rid));
+		freeVal(key);
+	}
+	hashSeconds = elapsedSeconds(&start) / numKeys;
+	TEST_CHECK(getTreeHeight(tree, &height));
+	TEST_CHECK(getHashNumBuckets(hash, &buckets));
+	TEST_CHECK(getHashGlobalDepth(hash, &depth));
+	BENCH_RESULT("loaded %d keys: b-tree height %d, %.2f us per insert; hash %d buckets, depth %d, %.2f us per insert",
+			numKeys, height, treeSeconds * 1e6, buckets, depth, hashSeconds * 1e6);
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for(i = 0; i < numLookups; i++)
+	{
+		MAKE_VALUE(key, DT_INT, rand() % numKeys);
+		TEST_CHECK(findKey(tree, key, &rid));
+		freeVal(key);
+	}
+	treeSeconds = elapsedSeconds(&start) / numLookups;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for(i = 0; i < numLookups; i++)
+	{
+		MAKE_VALUE(key, DT_INT, rand() % numKeys);
+		TEST_CHECK(findHashKey(hash, key, &rid));
+		freeVal(key);
+	}
+	hashSeconds = elapsedSeconds(&start) / numLookups;
+	BENCH_RESULT("a = k: b-tree %.2f us, hash %.2f us per lookup (%.1fx)",
+			treeSeconds * 1e6, hashSeconds * 1e6, treeSeconds / hashSeconds);
+
+	TEST_CHECK(closeBtree(tree));
+	TEST_CHECK(deleteBtree("bench_index"));
+	TEST_CHECK(closeHashIndex(hash));
+	TEST_CHECK(deleteHashIndex("bench_hash"));
+	TEST_CHECK(shutdownIndexManager());
+}
+
+// ************************************************************
+// building a B+ tree over keys in random order one insert at a time and by
+// bulk loading, in memory and with sorted runs spilled to disk
+void
+benchBulkLoad (void)
+{
+	int numKeys = 200000, sortPages[] = { 0, 64 }, nodes, height, i, p;
+	BT_LoadHandle *load;
+	BTreeHandle *tree;
+	Value *key;
+	struct timespec start;
+	double seconds;
+	RID rid;
+	testName = "bulk loading";
+
+	TEST_CHECK(initIndexManager(NULL));
+	TEST_CHECK(createBtree("bench_index", DT_INT, 0));
+	TEST_CHECK(openBtree(&tree, "bench_index"));
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for(i = 0; i < numKeys; i++)
+	{
+		MAKE_VALUE(key, DT_INT, (int) ((long) i * 7919 % numKeys));
+		rid.page = i / 100;
+		rid.slot = i % 100;
+		TEST_CHECK(insertKey(tree, key, rid));
+		freeVal(key);
+	}
+	TEST_CHECK(closeBtree(tree));
+	seconds = elapsedSeconds(&start);
+	TEST_CHECK(openBtree(&tree, "bench_index"));
+	TEST_CHECK(getNumNodes(tree, &nodes));
+	TEST_CHECK(getTreeHeight(tree, &height));
+	BENCH_RESULT("insertKey: %.2f s for %d keys, %d nodes, height %d, file size %ld bytes",
+			seconds, numKeys, nodes, height, fileSize("bench_index"));
+	TEST_CHECK(closeBtree(tree));
+	TEST_CHECK(deleteBtree("bench_index"));
+
+	for(p = 0; p < 2; p++)
+	{
+		TEST_CHECK(createBtree("bench_index", DT_INT, 0));
+		TEST_CHECK(openBtree(&tree, "bench_index"));
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		TEST_CHECK(startBulkLoad(tree, 100, sortPages[p], &load));
+		for(i = 0; i < numKeys; i++)
+		{
+			MAKE_VALUE(key, DT_INT, (int) ((long) i * 7919 % numKeys));
+			rid.page = i / 100;
+			rid.slot = i % 100;
+			TEST_CHECK(bulkLoadKey(load, key, rid));
+			freeVal(key);
+		}
+		TEST_CHECK(finishBulkLoad(load));
+		TEST_CHECK(getNumNodes(tree, &nodes));
+		TEST_CHECK(getTreeHeight(tree, &height));
+		TEST_CHECK(closeBtree(tree));
+		seconds = elapsedSeconds(&start);
+		BENCH_RESULT("bulk load, %s: %.2f s, %d nodes, height %d, file size %ld bytes",
+				sortPages[p] == 0 ? "sorted in memory" : "runs of 64 pages", seconds, nodes, height,
+				fileSize("bench_index"));
+		TEST_CHECK(deleteBtree("bench_index"));
+	}
+	TEST_CHECK(shutdownIndexManager());
+}
+
+// ************************************************************
+// string keys sharing a long prefix, nodes only store the bytes after the
+// common prefix of their keys so pages hold more of them than the 32 bytes
+// of the key would allow
+void
+benchKeyCompression (void)
+{
+	int numKeys = 100000, fills[] = { 0, 100 }, nodes, height, i, f;
+	BT_LoadHandle *load;
+	BTreeHandle *tree;
+	Value *key;
+	struct timespec start;
+	double seconds;
+	char name[32];
+	RID rid;
+	testName = "key compression";
+
+	TEST_CHECK(initIndexManager(NULL));
+	for(f = 0; f < 2; f++)
+	{
+		TEST_CHECK(createBtreeWithLength("bench_index", DT_STRING, 32, 0));
+		TEST_CHECK(openBtree(&tree, "bench_index"));
+		if(fills[f] > 0)
+			TEST_CHECK(startBulkLoad(tree, fills[f], 0, &load));
+		for(i = 0; i < numKeys; i++)
+		{
+			sprintf(name, "customer%08d", (int) ((long) i * 7919 % numKeys));
+			MAKE_STRING_VALUE(key, name);
+			rid.page = i / 100;
+			rid.slot = i % 100;
+			if(fills[f] > 0)
+			{
+				TEST_CHECK(bulkLoadKey(load, key, rid));
+			}
+			else
+			{
+				TEST_CHECK(insertKey(tree, key, rid));
+			}
+			freeVal(key);
+		}
+		if(fills[f] > 0)
+			TEST_CHECK(finishBulkLoad(load));
+		TEST_CHECK(getNumNodes(tree, &nodes));
+		TEST_CHECK(getTreeHeight(tree, &height));
+
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		for(i = 0; i < numKeys; i++)
+		{
+			sprintf(name, "customer%08d", i);
+			MAKE_STRING_VALUE(key, name);
+			TEST_CHECK(findKey(tree, key, &rid));
+			freeVal(key);
+		}
+		seconds = elapsedSeconds(&start);
+		TEST_CHECK(closeBtree(tree));
+		BENCH_RESULT("%s: %d nodes, %.0f keys per node (%d uncompressed), height %d, %.2f us per lookup, file size %ld bytes",
+				fills[f] > 0 ? "bulk load" : "insertKey", nodes, (double) numKeys / nodes,
+				(PAGE_SIZE - 20) / (32 + (int) sizeof(RID)), height, seconds * 1e6 / numKeys,
+				fileSize("bench_index"));
+		TEST_CHECK(deleteBtree("bench_index"));
+	}
+	TEST_CHECK(shutdownIndexManager());
+}
+
+// ************************************************************
+// threads inserting disjoint keys into one B+ tree and then looking up keys.
+// inserts that stay in their leaf latch only that leaf and readers latch
+// nothing, so threads wait for each other in the buffer pool and on splits
+void
+benchConcurrentIndex (void)
+{
+	int numKeys = 100000, numLookups = 400000, threadCounts[] = { 1, 2, 4, 8 }, t, i;
+	int cores = (int) sysconf(_SC_NPROCESSORS_ONLN);
+	double insertRate[4], lookupRate[4];
+	IndexWorker workers[8];
+	pthread_t threads[8];
+	BTreeHandle *tree;
+	struct timespec start;
+	testName = "concurrent index";
+
+	TEST_CHECK(initIndexManager(NULL));
+	for(t = 0; t < 4; t++)
+	{
+		int numThreads = threadCounts[t], errors = 0;
+		TEST_CHECK(createBtree("bench_index", DT_INT, 0));
+		TEST_CHECK(openBtree(&tree, "bench_index"));
+		for(i = 0; i < numThreads; i++)
+		{
+			workers[i].tree = tree;
+			workers[i].first = i;
+			workers[i].step = numThreads;
+			workers[i].numKeys = numKeys;
+			workers[i].numLookups = numLookups / numThreads;
+			workers[i].errors = 0;
+		}
+
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		for(i = 0; i < numThreads; i++)
+			pthread_create(&threads[i], NULL, insertIndexKeys, &workers[i]);
+		for(i = 0; i < numThreads; i++)
+			pthread_join(threads[i], NULL);
+		insertRate[t] = numKeys / elapsedSeconds(&start);
+
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		for(i = 0; i < numThreads; i++)
+			pthread_create(&threads[i], NULL, lookupIndexKeys, &workers[i]);
+		for(i = 0; i < numThreads; i++)
+			pthread_join(threads[i], NULL);
+		lookupRate[t] = numLookups / elapsedSeconds(&start);
+
+		for(i = 0; i < numThreads; i++)
+			errors += workers[i].errors;
+		ASSERT_EQUALS_INT(0, errors, "every insert and lookup succeeded");
+		TEST_CHECK(closeBtree(tree));
+		TEST_CHECK(deleteBtree("bench_index"));
+		BENCH_RESULT("%d threads on %d cores: %.0f k inserts/s (%.1fx), %.0f k lookups/s (%.1fx)",
+				numThreads, cores, insertRate[t] / 1e3, insertRate[t] / insertRate[0],
+				lookupRate[t] / 1e3, lookupRate[t] / lookupRate[0]);
+	}
+	TEST_CHECK(shutdownIndexManager());
+}
+
+double
+elapsedSeconds (struct timespec *start)
+{
+	struct timespec end;
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	return (end.tv_sec - start->tv_sec) + (end.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+long
+fileSize (char *name)
+{
+	struct stat st;
+	if (stat(name, &st) != 0)
+		return -1;
+	return (long) st.st_size;
+}
+
+// ************************************************************
+// equality scans on an attribute shared by many records, read from the heap
+// and through a secondary index, and the cost of keeping the index up to date
+void
+benchSecondaryIndex (void)
+{
+	RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+	RM_ScanHandle *sc = (RM_ScanHandle *) malloc(sizeof(RM_ScanHandle));
+	int numRecords = 20000, numValues = 200, numHeapScans = 20, numIndexScans = 400;
+	int numUpdates = 5000, byC[] = {2}, matches, i, j;
+	RM_AccessPath path;
+	Record *r;
+	Schema *schema;
+	Value *value;
+	Expr *attr, *cons, *cond;
+	struct timespec start;
+	double plainSeconds, indexSeconds;
+	RC rc;
+	testName = "secondary index";
+	schema = benchSchema();
+
+	TEST_CHECK(initRecordManager(NULL));
+	TEST_CHECK(createTable("bench_table", schema));
+	TEST_CHECK(openTable(table, "bench_table"));
+	for(i = 0; i < numRecords; i++)
+	{
+		int a = (int) ((long) i * 7919 % numRecords);
+		r = benchRecord(schema, a, "aaaa", a % numValues);
+		TEST_CHECK(insertRecord(table, r));
+		freeRecord(r);
+	}
+
+	// c = k matches numRecords / numValues records spread over the table
+	TEST_CHECK(createRecord(&r, schema));
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	matches = 0;
+	for(j = 0; j < numHeapScans; j++)
+	{
+		MAKE_ATTRREF(attr, 2);
+		MAKE_VALUE(value, DT_INT, rand() % numValues);
+		MAKE_CONS(cons, value);
+		MAKE_BINOP_EXPR(cond, attr, cons, OP_COMP_EQUAL);
+		TEST_CHECK(startScan(table, sc, cond));
+		while((rc = next(sc, r)) == RC_OK)
+			matches++;
+		TEST_CHECK(closeScan(sc));
+		freeExpr(cond);
+	}
+	plainSeconds = elapsedSeconds(&start) / numHeapScans;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	TEST_CHECK(createIndex(table, 1, byC, "by_c"));
+	BENCH_RESULT("createIndex on c of %d records: %.0f ms, %ld bytes",
+			numRecords, elapsedSeconds(&start) * 1e3, fileSize("bench_table.by_c.idx"));
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for(j = 0; j < numIndexScans; j++)
+	{
+		MAKE_ATTRREF(attr, 2);
+		MAKE_VALUE(value, DT_INT, rand() % numValues);
+		MAKE_CONS(cons, value);
+		MAKE_BINOP_EXPR(cond, attr, cons, OP_COMP_EQUAL);
+		TEST_CHECK(startScan(table, sc, cond));
+		TEST_CHECK(getScanAccessPath(sc, &path));
+		while((rc = next(sc, r)) == RC_OK)
+			matches++;
+		TEST_CHECK(closeScan(sc));
+		freeExpr(cond);
+	}
+	indexSeconds = elapsedSeconds(&start) / numIndexScans;
+	ASSERT_EQUALS_INT(RM_ACCESS_SECONDARY_INDEX, path, "c = k uses the index");
+	BENCH_RESULT("c = k with %d matches: heap scan %.0f us, index %.0f us per scan (%.0fx), %d matches",
+			numRecords / numValues, plainSeconds * 1e6, indexSeconds * 1e6,
+			plainSeconds / indexSeconds, matches);
+
+	// moving records to other values of c updates their entries
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for(j = 0; j < numUpdates; j++)
+	{
+		MAKE_VALUE(value, DT_INT, rand() % numRecords);
+		TEST_CHECK(getRecordByKey(table, &value, r));
+		freeVal(value);
+		MAKE_VALUE(value, DT_INT, rand() % numValues);
+		TEST_CHECK(setAttr(r, schema, 2, value));
+		freeVal(value);
+		TEST_CHECK(updateRecord(table, r));
+	}
+	indexSeconds = elapsedSeconds(&start) / numUpdates;
+	TEST_CHECK(dropIndex(table, "by_c"));
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for(j = 0; j < numUpdates; j++)
+	{
+		MAKE_VALUE(value, DT_INT, rand() % numRecords);
+		TEST_CHECK(getRecordByKey(table, &value, r));
+		freeVal(value);
+		MAKE_VALUE(value, DT_INT, rand() % numValues);
+		TEST_CHECK(setAttr(r, schema, 2, value));
+		freeVal(value);
+		TEST_CHECK(updateRecord(table, r));
+	}
+	plainSeconds = elapsedSeconds(&start) / numUpdates;
+	BENCH_RESULT("update of c: %.1f us without, %.1f us with the index",
+			plainSeconds * 1e6, indexSeconds * 1e6);
+
+	freeRecord(r);
+	TEST_CHECK(closeTable(table));
+	TEST_CHECK(deleteTable("bench_table"));
+	TEST_CHECK(shutdownRecordManager());
+	freeSchema(schema);
+	free(sc);
+	free(table);
+}
+
+// range scans over c which grows with the insert order like a timestamp, the
+// zone maps skip the pages outside of the range. the baseline adds OR a < 0,
+// which matches nothing but leaves c unbounded, so it reads every page.
+void
+benchZoneMaps (void)
+{
+	RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+	RM_ScanHandle *sc = (RM_ScanHandle *) malloc(sizeof(RM_ScanHandle));
+	int numRecords = 100000, rangeSize = 1000, numScans = 50;
+	int matches[2] = {0, 0}, pagesRead[2] = {0, 0}, pagesSkipped, pages, i, j, k;
+	double seconds[2];
+	Record *r;
+	Schema *schema;
+	Value *value;
+	Expr *attr, *cons, *lower, *upper, *range, *none, *cond;
+	struct timespec start;
+	RC rc;
+	testName = "zone maps";
+	schema = benchSchema();
+
+	TEST_CHECK(initRecordManager(NULL));
+	TEST_CHECK(createTable("bench_table", schema));
+	TEST_CHECK(openTable(table, "bench_table"));
+	for(i = 0; i < numRecords; i++)
+	{
+		r = benchRecord(schema, i, "aaaa", i);
+		TEST_CHECK(insertRecord(table, r));
+		freeRecord(r);
+	}
+
+	// k = 0 scans with the zone maps, k = 1 without
+	TEST_CHECK(createRecord(&r, schema));
+	for(k = 0; k < 2; k++)
+	{
+		srand(42);
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		for(j = 0; j < numScans; j++)
+		{
+			int low = rand() % (numRecords - rangeSize);
+			MAKE_ATTRREF(attr, 2);
+			MAKE_VALUE(value, DT_INT, low);
+			MAKE_CONS(cons, value);
+			MAKE_BINOP_EXPR(lower, attr, cons, OP_COMP_GREATER_EQUAL);
+			MAKE_ATTRREF(attr, 2);
+			MAKE_VALUE(value, DT_INT, low + rangeSize);
+			MAKE_CONS(cons, value);
+			MAKE_BINOP_EXPR(upper, attr, cons, OP_COMP_SMALLER);
+			MAKE_BINOP_EXPR(range, lower, upper, OP_BOOL_AND);
+			cond = range;
+			if(k == 1)
+			{
+				MAKE_ATTRREF(attr, 0);
+				MAKE_VALUE(value, DT_INT, 0);
+				MAKE_CONS(cons, value);
+				MAKE_BINOP_EXPR(none, attr, cons, OP_COMP_SMALLER);
+				MAKE_BINOP_EXPR(cond, range, none, OP_BOOL_OR);
+			}
+			TEST_CHECK(startScan(table, sc, cond));
+			while((rc = next(sc, r)) == RC_OK)
+				matches[k]++;
+			TEST_CHECK(getScanPageCounts(sc, &pages, &pagesSkipped));
+			pagesRead[k] += pages;
+			TEST_CHECK(closeScan(sc));
+			freeExpr(cond);
+		}
+		seconds[k] = elapsedSeconds(&start) / numScans;
+	}
+	ASSERT_EQUALS_INT(matches[1], matches[0], "same matches with and without zone maps");
+	BENCH_RESULT("c in a range of %d of %d records: %.0f of %.0f pages read, %.0f us with, %.0f us without zone maps (%.0fx)",
+			rangeSize, numRecords, (double) pagesRead[0] / numScans,
+			(double) pagesRead[1] / numScans, seconds[0] * 1e6, seconds[1] * 1e6,
+			seconds[1] / seconds[0]);
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	TEST_CHECK(closeTable(table));
+	BENCH_RESULT("closeTable storing the zone maps: %.1f ms, %ld bytes",
+			elapsedSeconds(&start) * 1e3, fileSize("bench_table.zone"));
+	TEST_CHECK(unlink("bench_table.zone") == 0 ? RC_OK : RC_ERROR);
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	TEST_CHECK(openTable(table, "bench_table"));
+	BENCH_RESULT("openTable rebuilding the zone maps of %d records: %.0f ms",
+			numRecords, elapsedSeconds(&start) * 1e3);
+
+	freeRecord(r);
+	TEST_CHECK(closeTable(table));
+	TEST_CHECK(deleteTable("bench_table"));
+	TEST_CHECK(shutdownRecordManager());
+	freeSchema(schema);
+	free(sc);
+	free(table);
+}
+
+Schema *
+benchSchema (void)
+{
+	char *names[] = { "a", "b", "c" };
+	DataType dt[] = { DT_INT, DT_STRING, DT_INT };
+	int sizes[] = { 0, 4, 0 };
+	int keys[] = {0};
+	int i;
+	char **cpNames = (char **) malloc(sizeof(char*) * 3);
+	DataType *cpDt = (DataType *) malloc(sizeof(DataType) * 3);
+	int *cpSizes = (int *) malloc(sizeof(int) * 3);
+	int *cpKeys = (int *) malloc(sizeof(int));
+
+	for(i = 0; i < 3; i++)
+	{
+		cpNames[i] = (char *) malloc(2);
+		strcpy(cpNames[i], names[i]);
+	}
+	memcpy(cpDt, dt, sizeof(DataType) * 3);
+	memcpy(cpSizes, sizes, sizeof(int) * 3);
+	memcpy(cpKeys, keys, sizeof(int));
+
+	return createSchema(3, cpNames, cpDt, cpSizes, 1, cpKeys);
+}
+
+Record *
+benchRecord (Schema *schema, int a, char *b, int c)
+{
+	Record *result;
+	Value *value;
+
+	TEST_CHECK(createRecord(&result, schema));
+
+	MAKE_VALUE(value, DT_INT, a);
+	TEST_CHECK(setAttr(result, schema, 0, value));
+	freeVal(value);
+
+	MAKE_STRING_VALUE(value, b);
+	TEST_CHECK(setAttr(result, schema, 1, value));
+	freeVal(value);
+
+	MAKE_VALUE(value, DT_INT, c);
+	TEST_CHECK(setAttr(result, schema, 2, value));
+	freeVal(value);
+
+	return result;
+}
+
+void
+setBenchKey (Record *record, Schema *schema, int a)
+{
+	Value *value;
+	MAKE_VALUE(value, DT_INT, a);
+	TEST_CHECK(setAttr(record, schema, 0, value));
+	freeVal(value);
+}
+
+// the keys of a worker are spread over the whole tree
+void *
+insertIndexKeys (void *arg)
+{
+	IndexWorker *worker = (IndexWorker *) arg;
+	Value *key;
+	RID rid;
+
+	for(int i = worker->first; i < worker->numKeys; i += worker->step)
+	{
+		MAKE_VALUE(key, DT_INT, (int) ((long) i * 7919 % worker->numKeys));
+		rid.page = i / 100;
+		rid.slot = i % 100;
+		worker->errors += insertKey(worker->tree, key, rid) != RC_OK;
+		freeVal(key);
+	}
+	return NULL;
+}
+
+void *
+lookupIndexKeys (void *arg)
+{
+	IndexWorker *worker = (IndexWorker *) arg;
+	unsigned int seed = worker->first + 1;
+	Value *key;
+	RID rid;
+
+	for(int i = 0; i < worker->numLookups; i++)
+	{
+		MAKE_VALUE(key, DT_INT, rand_r(&seed) % worker->numKeys);
+		worker->errors += findKey(worker->tree, key, &rid) != RC_OK;
+		freeVal(key);
+	}
+	return NULL;
+}
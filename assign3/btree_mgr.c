@@ -0,0 +1,2623 @@
+#define _GNU_SOURCE // qsort_r
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include "dberror.h"
+#include "btree_mgr.h"
+#include "buffer_mgr.h"
+#include "storage_mgr.h"
+#include "expr.h"
+#include "tables.h"
+#include "rm_serializer.h"
+
+// page 0 of an index file holds the header of the tree, every other page is
+// a node or on the list of free pages
+#define HDR_KEY_TYPE 0
+#define HDR_KEY_LENGTH 4
+#define HDR_LEAF_CAPACITY 8
+#define HDR_INNER_CAPACITY 12
+#define HDR_ROOT 16
+#define HDR_HEIGHT 20
+#define HDR_NUM_NODES 24
+#define HDR_NUM_ENTRIES 28
+#define HDR_FREE_PAGE 32
+#define HDR_NEXT_PAGE 36
+#define HDR_PAYLOAD_LENGTH 40
+#define HDR_LEAF_LIMIT 44
+#define HDR_INNER_LIMIT 48
+
+// a node starts with its kind, its number of keys and the next leaf, a free
+// page keeps the next free page there. a leaf holds (key, rid, payload)
+// entries, where the payload is a fixed number of bytes stored with the key
+// that is not part of it and often empty. an inner node holds its first child
+// followed by (key, child) entries where the keys of a child are at least the
+// key before it and smaller than the key after it.
+//
+// the keys of a node are compressed: the prefix all of them share is stored
+// once, after the header of a leaf or the first child of an inner node, and
+// each entry keeps only the next width bytes of its key, all bytes after them
+// are zero. the entries of a node still have a fixed size and are searched
+// without unpacking them. separators are cut to the shortest key between
+// their children, so that they end in zeros and take only a few bytes.
+#define NODE_IS_LEAF 0
+#define NODE_NUM_KEYS 4
+#define NODE_NEXT 8
+#define NODE_PREFIX_LENGTH 12
+#define NODE_KEY_WIDTH 16
+#define NODE_HEADER_SIZE 20
+#define RID_SIZE 8
+
+// the pages of a tree are cached in their own pool. a change of the structure
+// pins at most three of them at once and every other operation one, so the
+// pool is shared by up to 28 threads. a pin that finds every page of the pool
+// pinned does not wait for one to be unpinned, it fails with RC_IM_POOL_FULL
+#define BTREE_POOL_SIZE 32
+#define BTREE_MAX_HEIGHT 32
+
+// every page has a version latch kept in memory, in chunks allocated on first
+// use. bit 0 is set while a writer holds the page and every release by a
+// writer adds one more, so a version tells whether a page changed
+#define LATCH_CHUNK_SIZE 1024
+#define LATCH_CHUNKS 4096
+
+// a page of the pool. while a thread reads a page into a frame, the frame
+// stays loading and still names the dirty page it writes back first
+typedef struct TreeFrame {
+	int pageNum;
+	int oldPage;
+	int pinCount;
+	bool dirty;
+	bool loading;
+	bool referenced;
+	char *data;
+} TreeFrame;
+
+typedef struct BTreeMgmt {
+	SM_FileHandle file;
+	TreeFrame frames[BTREE_POOL_SIZE];
+	char *frameData; // the pages of all frames in one block
+	int clockHand;
+	int keyLength;
+	int payloadLength;
+	int leafEntrySize; // the key, the rid and the payload of an unpacked entry
+	int leafCapacity; // the entries of a node whose keys are not compressed
+	int innerCapacity;
+	int leafLimit; // the most entries of a node with compressed keys
+	int innerLimit;
+	int root;
+	int height;
+	int numNodes;
+	int numEntries;
+	int freePage;
+	int nextPage;
+	pthread_mutex_t poolLock; // guards the frames, never held during I/O
+	pthread_mutex_t ioLock; // the page file is not thread-safe
+	pthread_cond_t loaded; // a frame finished loading
+	pthread_mutex_t changeLock; // held by the writer changing the structure
+	int latched[2 * BTREE_MAX_HEIGHT + 1]; // the pages that writer holds
+	int numLatched;
+	uint64_t *latches[LATCH_CHUNKS];
+} BTreeMgmt;
+
+// the inner nodes passed on the way down to a leaf and the child taken in each
+typedef struct TreePath {
+	int depth;
+	int pages[BTREE_MAX_HEIGHT];
+	int childPos[BTREE_MAX_HEIGHT];
+} TreePath;
+
+// a scan works on a copy of its current leaf and goes on to the next leaf as
+// long as the current one has not changed since it was copied. otherwise the
+// tree is searched again for the key after the last one returned
+typedef struct TreeScan {
+	char *leaf;
+	int pageNum; // the page of the copy, NO_PAGE once the scan is done
+	uint64_t version; // the version of the page when it was copied
+	int pos;
+	int first; // the first entry of the copy that belongs to the scan
+	char *resume; // the key a new search starts from
+	bool resumeSet; // false to start from the first leaf
+	bool resumeAfter; // whether resume itself was returned already
+	char *high;
+	char *key; // the key of the current entry
+} TreeScan;
+
+// ************************************************************
+// key encoding
+
+int
+keyLength (DataType keyType, int typeLength)
+{
+	switch(keyType) {
+	case DT_INT:
+	case DT_FLOAT:
+	case DT_DATE:
+		return 4;
+	case DT_LONG:
+	case DT_DOUBLE:
+	case DT_TIMESTAMP:
+		return 8;
+	case DT_BOOL:
+		return 1;
+	case DT_STRING:
+	case DT_VARCHAR:
+		return typeLength;
+	default:
+		return -1;
+	}
+}
+
+static void
+writeBigEndian32 (char *out, uint32_t bits)
+{
+	int i;
+	for(i = 0; i < 4; i++)
+		out[i] = (char) (bits >> (24 - 8 * i));
+}
+
+static uint32_t
+readBigEndian32 (const char *in)
+{
+	uint32_t bits = 0;
+	int i;
+	for(i = 0; i < 4; i++)
+		bits = (bits << 8) | (unsigned char) in[i];
+	return bits;
+}
+
+static void
+writeBigEndian64 (char *out, uint64_t bits)
+{
+	writeBigEndian32(out, (uint32_t) (bits >> 32));
+	writeBigEndian32(out + 4, (uint32_t) bits);
+}
+
+static uint64_t
+readBigEndian64 (const char *in)
+{
+	return ((uint64_t) readBigEndian32(in) << 32) | readBigEndian32(in + 4);
+}
+
+// signed numbers get their sign bit flipped and are written most significant
+// byte first, negative floating point numbers have all bits flipped so that
+// larger magnitudes sort first. -0.0 is encoded as 0.0, which it equals, and
+// every NaN as the same quiet NaN sorting after infinity, so a key decodes
+// to the canonical value.
+RC
+encodeKey (DataType keyType, int length, Value *key, char *out)
+{
+	uint32_t bits32;
+	uint64_t bits64;
+	int size;
+
+	if(key == NULL || out == NULL)
+		return RC_PARAMS_ERROR;
+	if(key->dt != keyType && !(keyType == DT_VARCHAR && key->dt == DT_STRING))
+		THROW(RC_DATATYPE_MISMATCH, "key has a different datatype than the index");
+
+	switch(keyType) {
+	case DT_INT:
+	case DT_DATE:
+		writeBigEndian32(out, (uint32_t) key->v.intV ^ 0x80000000u);
+		break;
+	case DT_FLOAT:
+		memcpy(&bits32, &key->v.floatV, sizeof(bits32));
+		if(key->v.floatV == 0)
+			bits32 = 0;
+		else if(key->v.floatV != key->v.floatV)
+			bits32 = 0x7fc00000u;
+		writeBigEndian32(out, (bits32 & 0x80000000u) ? ~bits32 : bits32 | 0x80000000u);
+		break;
+	case DT_LONG:
+	case DT_TIMESTAMP:
+		writeBigEndian64(out, (uint64_t) key->v.longV ^ 0x8000000000000000ull);
+		break;
+	case DT_DOUBLE:
+		memcpy(&bits64, &key->v.doubleV, sizeof(bits64));
+		if(key->v.doubleV == 0)
+			bits64 = 0;
+		else if(key->v.doubleV != key->v.doubleV)
+			bits64 = 0x7ff8000000000000ull;
+		writeBigEndian64(out, (bits64 & 0x8000000000000000ull)
+				? ~bits64 : bits64 | 0x8000000000000000ull);
+		break;
+	case DT_BOOL:
+		out[0] = key->v.boolV ? 1 : 0;
+		break;
+	case DT_STRING:
+	case DT_VARCHAR:
+		// zero padding sorts a string before all of its extensions
+		size = strlen(key->v.stringV);
+		if(size > length)
+			THROW(RC_PARAMS_ERROR, "string key is longer than the key of the index");
+		memcpy(out, key->v.stringV, size);
+		memset(out + size, 0, length - size);
+		break;
+	default:
+		THROW(RC_RM_UNKOWN_DATATYPE, "unknown datatype");
+	}
+	return RC_OK;
+}
+
+RC
+decodeKey (DataType keyType, int length, char *in, Value **key)
+{
+	uint32_t bits32;
+	uint64_t bits64;
+	Value *result;
+
+	if(in == NULL || key == NULL)
+		return RC_PARAMS_ERROR;
+
+	result = (Value *) malloc(sizeof(Value));
+	result->dt = keyType;
+	switch(keyType) {
+	case DT_INT:
+	case DT_DATE:
+		result->v.intV = (int) (readBigEndian32(in) ^ 0x80000000u);
+		break;
+	case DT_FLOAT:
+		bits32 = readBigEndian32(in);
+		bits32 = (bits32 & 0x80000000u) ? bits32 & ~0x80000000u : ~bits32;
+		memcpy(&result->v.floatV, &bits32, sizeof(bits32));
+		break;
+	case DT_LONG:
+	case DT_TIMESTAMP:
+		result->v.longV = (int64_t) (readBigEndian64(in) ^ 0x8000000000000000ull);
+		break;
+	case DT_DOUBLE:
+		bits64 = readBigEndian64(in);
+		bits64 = (bits64 & 0x8000000000000000ull) ? bits64 & ~0x8000000000000000ull : ~bits64;
+		memcpy(&result->v.doubleV, &bits64, sizeof(bits64));
+		break;
+	case DT_BOOL:
+		result->v.boolV = in[0] != 0;
+		break;
+	case DT_STRING:
+	case DT_VARCHAR:
+		result->dt = DT_STRING;
+		result->v.stringV = (char *) malloc(length + 1);
+		memcpy(result->v.stringV, in, length);
+		result->v.stringV[length] = '\0';
+		break;
+	default:
+		free(result);
+		THROW(RC_RM_UNKOWN_DATATYPE, "unknown datatype");
+	}
+	*key = result;
+	return RC_OK;
+}
+
+// ************************************************************
+// nodes
+
+static inline bool
+nodeIsLeaf (char *node)
+{
+	return readAttrInt(node + NODE_IS_LEAF) != 0;
+}
+
+static inline int
+nodeNumKeys (char *node)
+{
+	return readAttrInt(node + NODE_NUM_KEYS);
+}
+
+static inline int
+nodePrefixLength (char *node)
+{
+	return readAttrInt(node + NODE_PREFIX_LENGTH);
+}
+
+static inline int
+nodeKeyWidth (char *node)
+{
+	return readAttrInt(node + NODE_KEY_WIDTH);
+}
+
+static inline char *
+nodePrefix (char *node)
+{
+	return node + NODE_HEADER_SIZE + (nodeIsLeaf(node) ? 0 : sizeof(int));
+}
+
+static inline int
+leafSlotSize (BTreeMgmt *mgmt, char *node)
+{
+	return nodeKeyWidth(node) + RID_SIZE + mgmt->payloadLength;
+}
+
+static inline char *
+leafEntry (BTreeMgmt *mgmt, char *node, int i)
+{
+	return node + NODE_HEADER_SIZE + nodePrefixLength(node) + i * leafSlotSize(mgmt, node);
+}
+
+static inline int
+innerSlotSize (char *node)
+{
+	return nodeKeyWidth(node) + sizeof(int);
+}
+
+static inline char *
+innerEntry (char *node, int i)
+{
+	return node + NODE_HEADER_SIZE + sizeof(int) + nodePrefixLength(node) + i * innerSlotSize(node);
+}
+
+// child i of an inner node, the child after key i - 1
+static inline int
+innerChild (char *node, int i)
+{
+	if(i == 0)
+		return readAttrInt(node + NODE_HEADER_SIZE);
+	return readAttrInt(innerEntry(node, i - 1) + nodeKeyWidth(node));
+}
+
+static inline void
+readLeafRID (char *node, char *entry, RID *rid)
+{
+	int width = nodeKeyWidth(node);
+	rid->page = readAttrInt(entry + width);
+	rid->slot = readAttrInt(entry + width + sizeof(int));
+}
+
+static inline char *
+leafPayload (char *node, char *entry)
+{
+	return entry + nodeKeyWidth(node) + RID_SIZE;
+}
+
+// an unpacked (key, rid, payload) entry, a NULL payload is stored as zeros
+static inline void
+writeLeafEntry (BTreeMgmt *mgmt, char *entry, char *key, RID rid, char *payload)
+{
+	memcpy(entry, key, mgmt->keyLength);
+	writeAttrInt(entry + mgmt->keyLength, rid.page);
+	writeAttrInt(entry + mgmt->keyLength + sizeof(int), rid.slot);
+	if(payload != NULL)
+		memcpy(entry + mgmt->keyLength + RID_SIZE, payload, mgmt->payloadLength);
+	else
+		memset(entry + mgmt->keyLength + RID_SIZE, 0, mgmt->payloadLength);
+}
+
+// the same into the slot of a leaf whose prefix and width hold key
+static inline void
+writeLeafSlot (BTreeMgmt *mgmt, char *node, char *slot, char *key, RID rid, char *payload)
+{
+	int width = nodeKeyWidth(node);
+
+	memcpy(slot, key + nodePrefixLength(node), width);
+	writeAttrInt(slot + width, rid.page);
+	writeAttrInt(slot + width + sizeof(int), rid.slot);
+	if(payload != NULL)
+		memcpy(slot + width + RID_SIZE, payload, mgmt->payloadLength);
+	else
+		memset(slot + width + RID_SIZE, 0, mgmt->payloadLength);
+}
+
+// ************************************************************
+// key compression
+
+// the length of a key without the zeros at its end
+static inline int
+significantLength (char *key, int length)
+{
+	while(length > 0 && key[length - 1] == 0)
+		length--;
+	return length;
+}
+
+// the number of bytes two keys share at their start, at most length
+static inline int
+commonLength (char *a, char *b, int length)
+{
+	int i = 0;
+	while(i < length && a[i] == b[i])
+		i++;
+	return i;
+}
+
+// the key of an entry of a node with its prefix and zeros
+static void
+nodeKey (BTreeMgmt *mgmt, char *node, char *entry, char *out)
+{
+	int prefixLength = nodePrefixLength(node), width = nodeKeyWidth(node);
+
+	memcpy(out, nodePrefix(node), prefixLength);
+	memcpy(out + prefixLength, entry, width);
+	memset(out + prefixLength + width, 0, mgmt->keyLength - prefixLength - width);
+}
+
+// the shortest key padded with zeros that is larger than left and not larger
+// than right, it separates both in their parent
+static void
+separatorKey (BTreeMgmt *mgmt, char *left, char *right, char *out)
+{
+	int length = commonLength(left, right, mgmt->keyLength) + 1;
+
+	if(length > mgmt->keyLength)
+		length = mgmt->keyLength;
+	memcpy(out, right, length);
+	memset(out + length, 0, mgmt->keyLength - length);
+}
+
+// the bytes of a node with count keys that share their first common bytes
+// and have only zeros after end
+static int
+nodeSize (BTreeMgmt *mgmt, bool leaf, int count, int common, int end)
+{
+	int prefixLength = common < end ? common : end;
+	int slotSize = end - prefixLength + (leaf ? RID_SIZE + mgmt->payloadLength : (int) sizeof(int));
+
+	return NODE_HEADER_SIZE + (leaf ? 0 : sizeof(int)) + prefixLength + count * slotSize;
+}
+
+// the shared start and the end of count sorted unpacked entries, which are
+// stride bytes apart. the first and the last key share what all of them share
+static void
+keyLayout (BTreeMgmt *mgmt, char *entries, int count, int stride, int *common, int *end)
+{
+	*common = count > 0 ? commonLength(entries, entries + (count - 1) * stride, mgmt->keyLength) : 0;
+	*end = 0;
+	for(int i = 0; i < count; i++)
+	{
+		int length = significantLength(entries + i * stride, mgmt->keyLength);
+		if(length > *end)
+			*end = length;
+	}
+}
+
+// the bytes of a node holding sorted unpacked entries
+static int
+entriesSize (BTreeMgmt *mgmt, bool leaf, char *entries, int count)
+{
+	int common, end;
+
+	keyLayout(mgmt, entries, count, leaf ? mgmt->leafEntrySize : mgmt->keyLength + (int) sizeof(int),
+			&common, &end);
+	return nodeSize(mgmt, leaf, count, common, end);
+}
+
+static bool
+entriesFit (BTreeMgmt *mgmt, bool leaf, char *entries, int count)
+{
+	return count <= (leaf ? mgmt->leafLimit : mgmt->innerLimit)
+			&& entriesSize(mgmt, leaf, entries, count) <= PAGE_SIZE;
+}
+
+// write the number of keys, the prefix and the width of a node for its
+// sorted unpacked entries and return the width
+static int
+writeLayout (BTreeMgmt *mgmt, char *node, char *entries, int count, int stride)
+{
+	int common, end, prefixLength;
+
+	keyLayout(mgmt, entries, count, stride, &common, &end);
+	prefixLength = common < end ? common : end;
+	writeAttrInt(node + NODE_NUM_KEYS, count);
+	writeAttrInt(node + NODE_PREFIX_LENGTH, prefixLength);
+	writeAttrInt(node + NODE_KEY_WIDTH, end - prefixLength);
+	memcpy(nodePrefix(node), entries, prefixLength);
+	return end - prefixLength;
+}
+
+// store sorted unpacked (key, rid, payload) entries in a leaf, which has to
+// have room for them
+static void
+packLeaf (BTreeMgmt *mgmt, char *node, char *entries, int count)
+{
+	int width = writeLayout(mgmt, node, entries, count, mgmt->leafEntrySize);
+	int prefixLength = nodePrefixLength(node);
+
+	for(int i = 0; i < count; i++)
+	{
+		char *entry = entries + i * mgmt->leafEntrySize, *slot = leafEntry(mgmt, node, i);
+		memcpy(slot, entry + prefixLength, width);
+		memcpy(slot + width, entry + mgmt->keyLength, RID_SIZE + mgmt->payloadLength);
+	}
+}
+
+// store the first child and sorted unpacked (key, child) entries in an inner node
+static void
+packInner (BTreeMgmt *mgmt, char *node, int firstChild, char *entries, int count)
+{
+	int entrySize = mgmt->keyLength + sizeof(int);
+	int width = writeLayout(mgmt, node, entries, count, entrySize);
+	int prefixLength = nodePrefixLength(node);
+
+	writeAttrInt(node + NODE_HEADER_SIZE, firstChild);
+	for(int i = 0; i < count; i++)
+	{
+		char *entry = entries + i * entrySize, *slot = innerEntry(node, i);
+		memcpy(slot, entry + prefixLength, width);
+		memcpy(slot + width, entry + mgmt->keyLength, sizeof(int));
+	}
+}
+
+static void
+unpackLeaf (BTreeMgmt *mgmt, char *node, char *entries)
+{
+	int numKeys = nodeNumKeys(node), width = nodeKeyWidth(node);
+
+	for(int i = 0; i < numKeys; i++)
+	{
+		char *entry = entries + i * mgmt->leafEntrySize, *slot = leafEntry(mgmt, node, i);
+		nodeKey(mgmt, node, slot, entry);
+		memcpy(entry + mgmt->keyLength, slot + width, RID_SIZE + mgmt->payloadLength);
+	}
+}
+
+// returns the first child of the node
+static int
+unpackInner (BTreeMgmt *mgmt, char *node, char *entries)
+{
+	int numKeys = nodeNumKeys(node), width = nodeKeyWidth(node);
+	int entrySize = mgmt->keyLength + sizeof(int);
+
+	for(int i = 0; i < numKeys; i++)
+	{
+		char *entry = entries + i * entrySize, *slot = innerEntry(node, i);
+		nodeKey(mgmt, node, slot, entry);
+		memcpy(entry + mgmt->keyLength, slot + width, sizeof(int));
+	}
+	return readAttrInt(node + NODE_HEADER_SIZE);
+}
+
+// whether key can be stored in a node without changing its prefix or width
+static bool
+keyFitsLayout (BTreeMgmt *mgmt, char *node, char *key)
+{
+	int prefixLength = nodePrefixLength(node);
+
+	return memcmp(key, nodePrefix(node), prefixLength) == 0
+			&& significantLength(key, mgmt->keyLength) <= prefixLength + nodeKeyWidth(node);
+}
+
+// compare key with the prefix of a node. tail tells whether key has bytes
+// other than zero after the prefix and width of the node
+static int
+comparePrefix (BTreeMgmt *mgmt, char *node, char *key, bool *tail)
+{
+	int prefixLength = nodePrefixLength(node);
+
+	*tail = significantLength(key, mgmt->keyLength) > prefixLength + nodeKeyWidth(node);
+	return memcmp(key, nodePrefix(node), prefixLength);
+}
+
+// the position of the first key of a leaf that is not smaller than key. a key
+// outside of the prefix of the leaf comes before or after all of its entries,
+// otherwise the entries are compared with the part of key after the prefix
+static int
+searchLeaf (BTreeMgmt *mgmt, char *node, char *key, bool *found)
+{
+	int low = 0, high = nodeNumKeys(node);
+	int width = nodeKeyWidth(node), slotSize = leafSlotSize(mgmt, node);
+	char *first = leafEntry(mgmt, node, 0), *rest = key + nodePrefixLength(node);
+	bool tail;
+	int cmp = comparePrefix(mgmt, node, key, &tail);
+
+	*found = false;
+	if(cmp != 0)
+		return cmp < 0 ? 0 : high;
+	while(low < high)
+	{
+		int mid = (low + high) / 2;
+		cmp = memcmp(first + mid * slotSize, rest, width);
+		// the entry ends in zeros where key goes on
+		if(cmp == 0 && tail)
+			cmp = -1;
+		if(cmp < 0)
+			low = mid + 1;
+		else
+		{
+			*found = *found || cmp == 0;
+			high = mid;
+		}
+	}
+	return low;
+}
+
+// the child of an inner node whose subtree holds key, the number of keys of
+// the node that are not larger than key
+static int
+searchInner (BTreeMgmt *mgmt, char *node, char *key)
+{
+	int low = 0, high = nodeNumKeys(node);
+	int width = nodeKeyWidth(node), slotSize = innerSlotSize(node);
+	char *first = innerEntry(node, 0), *rest = key + nodePrefixLength(node);
+	bool tail;
+	int cmp = comparePrefix(mgmt, node, key, &tail);
+
+	if(cmp != 0)
+		return cmp < 0 ? 0 : high;
+	while(low < high)
+	{
+		int mid = (low + high) / 2;
+		if(memcmp(first + mid * slotSize, rest, width) <= 0)
+			low = mid + 1;
+		else
+			high = mid;
+	}
+	return low;
+}
+
+// ************************************************************
+// latches
+
+// the pool is shared by all threads working on the tree, pages are pinned and
+// unpinned under its lock. what happens to a page in between is guarded by
+// its latch. the lock is released while a page is read or written, a thread
+// asking for a page that is being loaded waits for the load to finish
+static TreeFrame *
+findFrame (BTreeMgmt *mgmt, int pageNum)
+{
+	for(int i = 0; i < BTREE_POOL_SIZE; i++)
+	{
+		TreeFrame *frame = &mgmt->frames[i];
+		if(frame->pageNum == pageNum || (frame->loading && frame->oldPage == pageNum))
+			return frame;
+	}
+	return NULL;
+}
+
+// a clock over the unpinned frames, a page pinned since the hand passed it
+// gets a second chance
+static TreeFrame *
+chooseVictim (BTreeMgmt *mgmt)
+{
+	for(int i = 0; i < 2 * BTREE_POOL_SIZE; i++)
+	{
+		TreeFrame *frame = &mgmt->frames[mgmt->clockHand];
+		mgmt->clockHand = (mgmt->clockHand + 1) % BTREE_POOL_SIZE;
+		if(frame->pinCount > 0 || frame->loading)
+			continue;
+		if(!frame->referenced)
+			return frame;
+		frame->referenced = false;
+	}
+	return NULL;
+}
+
+static RC
+pinNode (BTreeMgmt *mgmt, BM_PageHandle *page, int pageNum)
+{
+	TreeFrame *frame;
+	bool written;
+	RC rc = RC_OK;
+
+	pthread_mutex_lock(&mgmt->poolLock);
+	// a dirty page is written back before its frame is reused, it is read
+	// again only once it is on disk
+	while((frame = findFrame(mgmt, pageNum)) != NULL && frame->pageNum != pageNum)
+		pthread_cond_wait(&mgmt->loaded, &mgmt->poolLock);
+	if(frame != NULL)
+	{
+		frame->pinCount++;
+		frame->referenced = true;
+		while(frame->loading)
+			pthread_cond_wait(&mgmt->loaded, &mgmt->poolLock);
+		if(frame->pageNum != pageNum)
+		{
+			frame->pinCount--;
+			pthread_mutex_unlock(&mgmt->poolLock);
+			THROW(RC_READ_NON_EXISTING_PAGE, "page of the index could not be read");
+		}
+		pthread_mutex_unlock(&mgmt->poolLock);
+		page->pageNum = pageNum;
+		page->data = frame->data;
+		return RC_OK;
+	}
+
+	if((frame = chooseVictim(mgmt)) == NULL)
+	{
+		pthread_mutex_unlock(&mgmt->poolLock);
+		THROW(RC_IM_POOL_FULL, "every page of the pool of the index is pinned");
+	}
+	frame->oldPage = frame->dirty ? frame->pageNum : NO_PAGE;
+	frame->pageNum = pageNum;
+	frame->pinCount = 1;
+	frame->referenced = true;
+	frame->loading = true;
+	written = frame->oldPage == NO_PAGE;
+	pthread_mutex_unlock(&mgmt->poolLock);
+
+	pthread_mutex_lock(&mgmt->ioLock);
+	if(!written)
+		written = (rc = writeBlock(frame->oldPage, &mgmt->file, frame->data)) == RC_OK;
+	if(rc == RC_OK)
+		rc = ensureCapacity(pageNum + 1, &mgmt->file);
+	if(rc == RC_OK)
+		rc = readBlock(pageNum, &mgmt->file, frame->data);
+	pthread_mutex_unlock(&mgmt->ioLock);
+
+	pthread_mutex_lock(&mgmt->poolLock);
+	// the old page stays in the frame if it could not be written back
+	if(rc != RC_OK)
+	{
+		frame->pageNum = written ? NO_PAGE : frame->oldPage;
+		frame->pinCount--;
+	}
+	if(written)
+		frame->dirty = false;
+	frame->oldPage = NO_PAGE;
+	frame->loading = false;
+	pthread_cond_broadcast(&mgmt->loaded);
+	pthread_mutex_unlock(&mgmt->poolLock);
+
+	if(rc != RC_OK)
+		return rc;
+	page->pageNum = pageNum;
+	page->data = frame->data;
+	return RC_OK;
+}
+
+static TreeFrame *
+pageFrame (BTreeMgmt *mgmt, BM_PageHandle *page)
+{
+	return &mgmt->frames[(page->data - mgmt->frameData) / PAGE_SIZE];
+}
+
+static RC
+unpinNode (BTreeMgmt *mgmt, BM_PageHandle *page)
+{
+	TreeFrame *frame = pageFrame(mgmt, page);
+
+	pthread_mutex_lock(&mgmt->poolLock);
+	frame->pinCount--;
+	pthread_mutex_unlock(&mgmt->poolLock);
+	return RC_OK;
+}
+
+// dirty pages are written back when their frame is reused or the tree closed
+static RC
+markNodeDirty (BTreeMgmt *mgmt, BM_PageHandle *page)
+{
+	TreeFrame *frame = pageFrame(mgmt, page);
+
+	pthread_mutex_lock(&mgmt->poolLock);
+	frame->dirty = true;
+	pthread_mutex_unlock(&mgmt->poolLock);
+	return RC_OK;
+}
+
+// the latch of a page, page 0 holds the header and its latch guards the root
+static uint64_t *
+nodeLatch (BTreeMgmt *mgmt, int pageNum)
+{
+	uint64_t **slot = &mgmt->latches[pageNum / LATCH_CHUNK_SIZE];
+	uint64_t *chunk = __atomic_load_n(slot, __ATOMIC_ACQUIRE);
+
+	// threads that need the same chunk at once keep the first one allocated
+	if(chunk == NULL)
+	{
+		uint64_t *fresh = (uint64_t *) calloc(LATCH_CHUNK_SIZE, sizeof(uint64_t));
+		if(__atomic_compare_exchange_n(slot, &chunk, fresh, false, __ATOMIC_ACQ_REL,
+				__ATOMIC_ACQUIRE))
+			chunk = fresh;
+		else
+			free(fresh);
+	}
+	return chunk + pageNum % LATCH_CHUNK_SIZE;
+}
+
+// the version of a page once no writer holds it
+static uint64_t
+awaitVersion (uint64_t *latch)
+{
+	uint64_t version;
+
+	while((version = __atomic_load_n(latch, __ATOMIC_ACQUIRE)) & 1)
+		sched_yield();
+	return version;
+}
+
+// whether a page still has the version it had before it was read
+static bool
+checkVersion (uint64_t *latch, uint64_t version)
+{
+	__atomic_thread_fence(__ATOMIC_ACQUIRE);
+	return __atomic_load_n(latch, __ATOMIC_RELAXED) == version;
+}
+
+// latch a page for a writer if it still has version
+static bool
+tryLatch (uint64_t *latch, uint64_t version)
+{
+	return __atomic_compare_exchange_n(latch, &version, version | 1, false, __ATOMIC_ACQUIRE,
+			__ATOMIC_RELAXED);
+}
+
+// release a latched page, a page that was not changed gets its old version
+// back so that readers which copied it before need not start over
+static void
+unlatch (uint64_t *latch, bool changed)
+{
+	if(changed)
+		__atomic_fetch_add(latch, 1, __ATOMIC_RELEASE);
+	else
+		__atomic_fetch_sub(latch, 1, __ATOMIC_RELEASE);
+}
+
+// latch a page for the writer changing the structure, which waits for the
+// writers of single leaves to finish. these never wait for a latch while they
+// hold one, and there is only one writer changing the structure at a time
+static void
+latchNode (BTreeMgmt *mgmt, int pageNum)
+{
+	uint64_t *latch = nodeLatch(mgmt, pageNum);
+
+	for(int i = 0; i < mgmt->numLatched; i++)
+		if(mgmt->latched[i] == pageNum)
+			return;
+	while(!tryLatch(latch, awaitVersion(latch)))
+		;
+	mgmt->latched[mgmt->numLatched++] = pageNum;
+}
+
+// a change of the structure of the tree runs alone and releases all pages
+// it latched at its end
+static void
+beginChange (BTreeMgmt *mgmt)
+{
+	pthread_mutex_lock(&mgmt->changeLock);
+	mgmt->numLatched = 0;
+}
+
+static void
+endChange (BTreeMgmt *mgmt)
+{
+	for(int i = 0; i < mgmt->numLatched; i++)
+		unlatch(nodeLatch(mgmt, mgmt->latched[i]), true);
+	mgmt->numLatched = 0;
+	pthread_mutex_unlock(&mgmt->changeLock);
+}
+
+// the bytes of a node in use. a writer may change the node while its header
+// is read, a header that makes no sense covers the whole page
+static int
+usedSize (BTreeMgmt *mgmt, char *node)
+{
+	bool leaf = nodeIsLeaf(node);
+	int numKeys = nodeNumKeys(node), prefixLength = nodePrefixLength(node);
+	int end = prefixLength + nodeKeyWidth(node);
+
+	if(numKeys < 0 || numKeys > (leaf ? mgmt->leafLimit : mgmt->innerLimit) || prefixLength < 0
+			|| end < prefixLength || end > mgmt->keyLength)
+		return PAGE_SIZE;
+	int size = nodeSize(mgmt, leaf, numKeys, prefixLength, end);
+	return size < PAGE_SIZE ? size : PAGE_SIZE;
+}
+
+// copy a page without latching it, valid tells whether no writer changed it
+// meanwhile and version is the version the copy belongs to
+static RC
+readNode (BTreeMgmt *mgmt, int pageNum, char *copy, uint64_t *version, bool *valid)
+{
+	uint64_t *latch = nodeLatch(mgmt, pageNum);
+	BM_PageHandle page;
+	RC rc;
+
+	*version = awaitVersion(latch);
+	if((rc = pinNode(mgmt, &page, pageNum)) != RC_OK)
+		return rc;
+	memcpy(copy, page.data, NODE_HEADER_SIZE);
+	memcpy(copy + NODE_HEADER_SIZE, page.data + NODE_HEADER_SIZE, usedSize(mgmt, copy) - NODE_HEADER_SIZE);
+	unpinNode(mgmt, &page);
+	*valid = checkVersion(latch, *version);
+	return RC_OK;
+}
+
+static void
+initNode (char *node, bool leaf)
+{
+	memset(node, 0, PAGE_SIZE);
+	writeAttrInt(node + NODE_IS_LEAF, leaf ? 1 : 0);
+	writeAttrInt(node + NODE_NUM_KEYS, 0);
+	writeAttrInt(node + NODE_NEXT, NO_PAGE);
+}
+
+// pin an empty node on a free page or at the end of the file
+static RC
+allocNode (BTreeMgmt *mgmt, BM_PageHandle *page, bool leaf)
+{
+	RC rc;
+
+	if(mgmt->freePage != NO_PAGE)
+	{
+		if((rc = pinNode(mgmt, page, mgmt->freePage)) != RC_OK)
+			return rc;
+		mgmt->freePage = readAttrInt(page->data + NODE_NEXT);
+	}
+	else
+	{
+		if(mgmt->nextPage >= LATCH_CHUNKS * LATCH_CHUNK_SIZE)
+			THROW(RC_IM_N_TO_LAGE, "index has as many pages as it can latch");
+		if((rc = pinNode(mgmt, page, mgmt->nextPage)) != RC_OK)
+			return rc;
+		mgmt->nextPage++;
+	}
+	initNode(page->data, leaf);
+	mgmt->numNodes++;
+	return RC_OK;
+}
+
+// put a pinned node on the free list and unpin it
+static RC
+freeNode (BTreeMgmt *mgmt, BM_PageHandle *page)
+{
+	writeAttrInt(page->data + NODE_NEXT, mgmt->freePage);
+	mgmt->freePage = page->pageNum;
+	mgmt->numNodes--;
+	markNodeDirty(mgmt, page);
+	return unpinNode(mgmt, page);
+}
+
+// copy the leaf that holds key, or the first leaf for a NULL key, without
+// latching any node on the way down. a node is only used if its copy is
+// valid and its parent still has the version it had when the child was
+// taken from it, otherwise the descent starts over. depth tells how far
+// below the root the leaf is.
+static RC
+readLeaf (BTreeMgmt *mgmt, char *key, char *copy, int *pageNum, uint64_t *version, int *depth)
+{
+	uint64_t parentVersion;
+	int parent;
+	bool valid;
+	RC rc;
+
+	while(true)
+	{
+		parent = 0;
+		parentVersion = awaitVersion(nodeLatch(mgmt, 0));
+		*pageNum = __atomic_load_n(&mgmt->root, __ATOMIC_ACQUIRE);
+		*depth = 0;
+		while(true)
+		{
+			if((rc = readNode(mgmt, *pageNum, copy, version, &valid)) != RC_OK)
+				return rc;
+			if(!valid || !checkVersion(nodeLatch(mgmt, parent), parentVersion))
+				break;
+			if(nodeIsLeaf(copy))
+				return RC_OK;
+			if(*depth == BTREE_MAX_HEIGHT)
+				THROW(RC_ERROR, "index is deeper than expected");
+
+			parent = *pageNum;
+			parentVersion = *version;
+			*pageNum = innerChild(copy, key == NULL ? 0 : searchInner(mgmt, copy, key));
+			(*depth)++;
+		}
+	}
+}
+
+// latch the leaf that holds key for a writer that only changes this leaf
+// and leave it pinned
+static RC
+latchLeaf (BTreeMgmt *mgmt, char *key, BM_PageHandle *leaf, int *depth)
+{
+	char copy[PAGE_SIZE];
+	uint64_t version;
+	int pageNum;
+	RC rc;
+
+	while(true)
+	{
+		if((rc = readLeaf(mgmt, key, copy, &pageNum, &version, depth)) != RC_OK)
+			return rc;
+		if((rc = pinNode(mgmt, leaf, pageNum)) != RC_OK)
+			return rc;
+		if(tryLatch(nodeLatch(mgmt, pageNum), version))
+			return RC_OK;
+		unpinNode(mgmt, leaf);
+	}
+}
+
+// whether an inner node takes another key of any kind without being split
+static bool
+innerHasRoom (BTreeMgmt *mgmt, char *node)
+{
+	int count = nodeNumKeys(node) + 1;
+
+	return count <= mgmt->innerLimit && nodeSize(mgmt, false, count, 0, mgmt->keyLength) <= PAGE_SIZE;
+}
+
+// descend from the root to the leaf that holds key for a change of the
+// structure, latch the nodes on the way and leave the leaf pinned. path
+// records the inner nodes passed and the child taken in each. an insert does
+// not reach above an inner node that has room for another key, so the nodes
+// above it are released again
+static RC
+lockPath (BTreeMgmt *mgmt, char *key, bool insert, TreePath *path, BM_PageHandle *leaf)
+{
+	int pageNum = mgmt->root;
+	RC rc;
+
+	path->depth = 0;
+	while(true)
+	{
+		latchNode(mgmt, pageNum);
+		if((rc = pinNode(mgmt, leaf, pageNum)) != RC_OK)
+			return rc;
+		if(nodeIsLeaf(leaf->data))
+			return RC_OK;
+
+		if(insert && innerHasRoom(mgmt, leaf->data))
+		{
+			for(int i = 0; i < mgmt->numLatched - 1; i++)
+				unlatch(nodeLatch(mgmt, mgmt->latched[i]), false);
+			mgmt->latched[0] = pageNum;
+			mgmt->numLatched = 1;
+		}
+		int pos = searchInner(mgmt, leaf->data, key);
+		if(path->depth == BTREE_MAX_HEIGHT)
+		{
+			unpinNode(mgmt, leaf);
+			THROW(RC_ERROR, "index is deeper than expected");
+		}
+		path->pages[path->depth] = pageNum;
+		path->childPos[path->depth++] = pos;
+		pageNum = innerChild(leaf->data, pos);
+		unpinNode(mgmt, leaf);
+	}
+}
+
+// ************************************************************
+// insertion
+
+// pack sorted unpacked entries into a pinned inner node and unpin it. entries
+// that do not fit are split around the middle key, which is copied to key and
+// moves up to the next level, the upper half goes to a new node stored in right
+static RC
+storeInner (BTreeMgmt *mgmt, BM_PageHandle *node, int firstChild, char *entries, int count,
+		char *key, int *right, bool *split)
+{
+	int entrySize = mgmt->keyLength + sizeof(int);
+	BM_PageHandle sibling;
+	RC rc;
+
+	*split = !entriesFit(mgmt, false, entries, count);
+	if(*split)
+	{
+		int mid = count / 2;
+		char *middle = entries + mid * entrySize;
+		if((rc = allocNode(mgmt, &sibling, false)) != RC_OK)
+		{
+			unpinNode(mgmt, node);
+			return rc;
+		}
+		packInner(mgmt, sibling.data, readAttrInt(middle + mgmt->keyLength), middle + entrySize,
+				count - mid - 1);
+		memcpy(key, middle, mgmt->keyLength);
+		*right = sibling.pageNum;
+		count = mid;
+		markNodeDirty(mgmt, &sibling);
+		unpinNode(mgmt, &sibling);
+	}
+	packInner(mgmt, node->data, firstChild, entries, count);
+	markNodeDirty(mgmt, node);
+	return unpinNode(mgmt, node);
+}
+
+// link the new node right after its left neighbour into the parent on path,
+// splitting inner nodes up to the root as long as they are full. key is
+// overwritten with the separators passed on.
+static RC
+insertIntoParent (BTreeMgmt *mgmt, TreePath *path, int left, char *key, int right)
+{
+	int entrySize = mgmt->keyLength + sizeof(int);
+	char *entries = (char *) malloc((mgmt->innerLimit + 1) * entrySize);
+	BM_PageHandle parent;
+	bool split;
+	RC rc;
+
+	while(path->depth > 0)
+	{
+		int pos = path->childPos[--path->depth];
+		if((rc = pinNode(mgmt, &parent, path->pages[path->depth])) != RC_OK)
+		{
+			free(entries);
+			return rc;
+		}
+
+		int numKeys = nodeNumKeys(parent.data);
+		int firstChild = unpackInner(mgmt, parent.data, entries);
+		char *entry = entries + pos * entrySize;
+		memmove(entry + entrySize, entry, (numKeys - pos) * entrySize);
+		memcpy(entry, key, mgmt->keyLength);
+		writeAttrInt(entry + mgmt->keyLength, right);
+		rc = storeInner(mgmt, &parent, firstChild, entries, numKeys + 1, key, &right, &split);
+		if(rc != RC_OK || !split)
+		{
+			free(entries);
+			return rc;
+		}
+		left = parent.pageNum;
+	}
+
+	// the root was split, the tree grows by one level
+	if((rc = allocNode(mgmt, &parent, false)) == RC_OK)
+	{
+		memcpy(entries, key, mgmt->keyLength);
+		writeAttrInt(entries + mgmt->keyLength, right);
+		packInner(mgmt, parent.data, left, entries, 1);
+		latchNode(mgmt, 0);
+		__atomic_store_n(&mgmt->root, parent.pageNum, __ATOMIC_RELEASE);
+		mgmt->height++;
+		markNodeDirty(mgmt, &parent);
+		rc = unpinNode(mgmt, &parent);
+	}
+	free(entries);
+	return rc;
+}
+
+// split a leaf whose unpacked entries do not fit into it anymore, the upper
+// half moves to a new leaf and the shortest key between both halves goes up
+// to the parent. a compressed node holds at most twice the entries of an
+// uncompressed one, so both halves fit even if their keys share nothing.
+static RC
+splitLeaf (BTreeMgmt *mgmt, TreePath *path, BM_PageHandle *leaf, char *entries, int total)
+{
+	int entrySize = mgmt->leafEntrySize, leftKeys = (total + 1) / 2;
+	char *separator;
+	BM_PageHandle right;
+	RC rc;
+
+	if((rc = allocNode(mgmt, &right, true)) != RC_OK)
+	{
+		unpinNode(mgmt, leaf);
+		return rc;
+	}
+	packLeaf(mgmt, leaf->data, entries, leftKeys);
+	packLeaf(mgmt, right.data, entries + leftKeys * entrySize, total - leftKeys);
+	writeAttrInt(right.data + NODE_NEXT, readAttrInt(leaf->data + NODE_NEXT));
+	writeAttrInt(leaf->data + NODE_NEXT, right.pageNum);
+
+	// the separator is reused for the splits further up
+	separator = (char *) malloc(mgmt->keyLength);
+	separatorKey(mgmt, entries + (leftKeys - 1) * entrySize, entries + leftKeys * entrySize,
+			separator);
+	markNodeDirty(mgmt, leaf);
+	markNodeDirty(mgmt, &right);
+	unpinNode(mgmt, leaf);
+	unpinNode(mgmt, &right);
+
+	rc = insertIntoParent(mgmt, path, leaf->pageNum, separator, right.pageNum);
+	free(separator);
+	return rc;
+}
+
+// ************************************************************
+// deletion
+
+// unpack the entries of two neighbouring nodes in order and return their
+// number, inner nodes take the separator between them from the parent as the
+// key before the first child of right
+static int
+unpackSiblings (BTreeMgmt *mgmt, char *left, char *right, char *separator, char *entries,
+		int *firstChild)
+{
+	int leftKeys = nodeNumKeys(left), rightKeys = nodeNumKeys(right);
+
+	if(nodeIsLeaf(left))
+	{
+		unpackLeaf(mgmt, left, entries);
+		unpackLeaf(mgmt, right, entries + leftKeys * mgmt->leafEntrySize);
+		return leftKeys + rightKeys;
+	}
+
+	int entrySize = mgmt->keyLength + sizeof(int);
+	char *middle = entries + leftKeys * entrySize;
+	*firstChild = unpackInner(mgmt, left, entries);
+	memcpy(middle, separator, mgmt->keyLength);
+	writeAttrInt(middle + mgmt->keyLength, unpackInner(mgmt, right, middle + entrySize));
+	return leftKeys + 1 + rightKeys;
+}
+
+// refill a pinned node that fell below half of its capacity from a sibling,
+// or merge both and continue with the parent that lost an entry. the entries
+// of both nodes are unpacked and distributed again. a node this small fits
+// into a page uncompressed, but the new separator may not fit into a full
+// parent, which is split then.
+static RC
+rebalance (BTreeMgmt *mgmt, TreePath *path, BM_PageHandle *node)
+{
+	int innerSize = mgmt->keyLength + sizeof(int);
+	BM_PageHandle parent, sibling;
+	RC rc;
+
+	while(true)
+	{
+		bool leaf = nodeIsLeaf(node->data);
+		int numKeys = nodeNumKeys(node->data);
+		int minKeys = (leaf ? mgmt->leafCapacity : mgmt->innerCapacity) / 2;
+
+		if(path->depth == 0)
+		{
+			// an inner root left with a single child is replaced by it
+			if(!leaf && numKeys == 0)
+			{
+				latchNode(mgmt, 0);
+				__atomic_store_n(&mgmt->root, innerChild(node->data, 0), __ATOMIC_RELEASE);
+				mgmt->height--;
+				return freeNode(mgmt, node);
+			}
+			markNodeDirty(mgmt, node);
+			return unpinNode(mgmt, node);
+		}
+		if(numKeys >= minKeys)
+		{
+			markNodeDirty(mgmt, node);
+			return unpinNode(mgmt, node);
+		}
+
+		int pos = path->childPos[--path->depth];
+		if((rc = pinNode(mgmt, &parent, path->pages[path->depth])) != RC_OK)
+		{
+			unpinNode(mgmt, node);
+			return rc;
+		}
+		bool fromLeft = pos > 0;
+		int sepPos = fromLeft ? pos - 1 : pos;
+		int siblingPage = innerChild(parent.data, fromLeft ? pos - 1 : pos + 1);
+		latchNode(mgmt, siblingPage);
+		if((rc = pinNode(mgmt, &sibling, siblingPage)) != RC_OK)
+		{
+			unpinNode(mgmt, &parent);
+			unpinNode(mgmt, node);
+			return rc;
+		}
+
+		BM_PageHandle *left = fromLeft ? &sibling : node;
+		BM_PageHandle *right = fromLeft ? node : &sibling;
+		bool borrow = nodeNumKeys(sibling.data) > minKeys;
+		int leftKeys = nodeNumKeys(left->data), parentKeys = nodeNumKeys(parent.data);
+		int entrySize = leaf ? mgmt->leafEntrySize : innerSize, firstChild = 0;
+		char *entries = (char *) malloc((leftKeys + nodeNumKeys(right->data) + 1) * entrySize);
+		char *parentEntries = (char *) malloc(parentKeys * innerSize);
+		int parentFirst = unpackInner(mgmt, parent.data, parentEntries);
+		char *separator = parentEntries + sepPos * innerSize;
+		int total = unpackSiblings(mgmt, left->data, right->data, separator, entries, &firstChild);
+
+		if(borrow)
+		{
+			// one entry moves over from the sibling, leaves get a new
+			// separator and inner nodes rotate a key through the parent
+			int newLeftKeys = fromLeft ? leftKeys - 1 : leftKeys + 1;
+			char *middle = entries + newLeftKeys * entrySize;
+			char *key = (char *) malloc(mgmt->keyLength);
+			bool split;
+			int newRight;
+
+			if(leaf)
+			{
+				packLeaf(mgmt, left->data, entries, newLeftKeys);
+				packLeaf(mgmt, right->data, middle, total - newLeftKeys);
+				separatorKey(mgmt, middle - entrySize, middle, separator);
+			}
+			else
+			{
+				packInner(mgmt, left->data, firstChild, entries, newLeftKeys);
+				packInner(mgmt, right->data, readAttrInt(middle + mgmt->keyLength), middle + entrySize,
+						total - newLeftKeys - 1);
+				memcpy(separator, middle, mgmt->keyLength);
+			}
+			markNodeDirty(mgmt, node);
+			markNodeDirty(mgmt, &sibling);
+			unpinNode(mgmt, node);
+			unpinNode(mgmt, &sibling);
+
+			rc = storeInner(mgmt, &parent, parentFirst, parentEntries, parentKeys, key, &newRight, &split);
+			if(rc == RC_OK && split)
+				rc = insertIntoParent(mgmt, path, parent.pageNum, key, newRight);
+			free(key);
+			free(entries);
+			free(parentEntries);
+			return rc;
+		}
+
+		// merge the right one of both into the left one and drop the
+		// separator and the pointer to the right node from the parent
+		if(leaf)
+		{
+			packLeaf(mgmt, left->data, entries, total);
+			writeAttrInt(left->data + NODE_NEXT, readAttrInt(right->data + NODE_NEXT));
+		}
+		else
+			packInner(mgmt, left->data, firstChild, entries, total);
+		memmove(separator, separator + innerSize, (parentKeys - sepPos - 1) * innerSize);
+		packInner(mgmt, parent.data, parentFirst, parentEntries, parentKeys - 1);
+		free(entries);
+		free(parentEntries);
+
+		markNodeDirty(mgmt, left);
+		unpinNode(mgmt, left);
+		freeNode(mgmt, right);
+		*node = parent;
+	}
+}
+
+// ************************************************************
+// index manager
+
+RC
+initIndexManager (void *mgmtData)
+{
+	initStorageManager();
+	return RC_OK;
+}
+
+RC
+shutdownIndexManager ()
+{
+	return RC_OK;
+}
+
+RC
+createBtree (char *idxId, DataType keyType, int n)
+{
+	return createBtreeWithLength(idxId, keyType, keyLength(keyType, 0), n);
+}
+
+RC
+createBtreeWithLength (char *idxId, DataType keyType, int length, int n)
+{
+	return createBtreeWithPayload(idxId, keyType, length, 0, n);
+}
+
+RC
+createBtreeWithPayload (char *idxId, DataType keyType, int length, int payloadLength, int n)
+{
+	SM_FileHandle fHandle;
+	char *data;
+	RC rc;
+
+	if(idxId == NULL || keyLength(keyType, length) <= 0 || length < keyLength(keyType, length)
+			|| payloadLength < 0 || n < 0 || n == 1)
+		return RC_PARAMS_ERROR;
+
+	// a node has to hold at least two uncompressed keys. compressed nodes
+	// take up to twice as many when n is 0, so that the halves of a split
+	// still fit when their keys cannot be compressed
+	int leafMax = (PAGE_SIZE - NODE_HEADER_SIZE) / (length + RID_SIZE + payloadLength);
+	int innerMax = (PAGE_SIZE - NODE_HEADER_SIZE - sizeof(int)) / (length + sizeof(int));
+	if(leafMax < 2 || innerMax < 2 || n > leafMax || n > innerMax)
+		THROW(RC_IM_N_TO_LAGE, "nodes of this size do not fit into a page");
+
+	if((rc = createPageFile(idxId)) != RC_OK)
+		return rc;
+	if((rc = openPageFile(idxId, &fHandle)) != RC_OK)
+		return rc;
+
+	data = (char *) calloc(PAGE_SIZE, sizeof(char));
+	writeAttrInt(data + HDR_KEY_TYPE, keyType);
+	writeAttrInt(data + HDR_KEY_LENGTH, length);
+	writeAttrInt(data + HDR_LEAF_CAPACITY, n == 0 ? leafMax : n);
+	writeAttrInt(data + HDR_INNER_CAPACITY, n == 0 ? innerMax : n);
+	writeAttrInt(data + HDR_ROOT, 1);
+	writeAttrInt(data + HDR_HEIGHT, 1);
+	writeAttrInt(data + HDR_NUM_NODES, 1);
+	writeAttrInt(data + HDR_NUM_ENTRIES, 0);
+	writeAttrInt(data + HDR_FREE_PAGE, NO_PAGE);
+	writeAttrInt(data + HDR_NEXT_PAGE, 2);
+	writeAttrInt(data + HDR_PAYLOAD_LENGTH, payloadLength);
+	writeAttrInt(data + HDR_LEAF_LIMIT, n == 0 ? 2 * leafMax - 1 : n);
+	writeAttrInt(data + HDR_INNER_LIMIT, n == 0 ? 2 * innerMax - 1 : n);
+	rc = writeBlock(0, &fHandle, data);
+
+	// the root starts as an empty leaf
+	if(rc == RC_OK)
+	{
+		initNode(data, true);
+		if((rc = ensureCapacity(2, &fHandle)) == RC_OK)
+			rc = writeBlock(1, &fHandle, data);
+	}
+	free(data);
+	closePageFile(&fHandle);
+	return rc;
+}
+
+// writes the dirty pages of the pool back
+static RC
+flushPool (BTreeMgmt *mgmt)
+{
+	RC rc = RC_OK;
+
+	for(int i = 0; i < BTREE_POOL_SIZE && rc == RC_OK; i++)
+	{
+		TreeFrame *frame = &mgmt->frames[i];
+		if(frame->dirty && frame->pageNum != NO_PAGE)
+			if((rc = writeBlock(frame->pageNum, &mgmt->file, frame->data)) == RC_OK)
+				frame->dirty = false;
+	}
+	return rc;
+}
+
+static void
+freeMgmt (BTreeMgmt *mgmt)
+{
+	for(int i = 0; i < LATCH_CHUNKS; i++)
+		free(mgmt->latches[i]);
+	free(mgmt->frameData);
+	pthread_mutex_destroy(&mgmt->poolLock);
+	pthread_mutex_destroy(&mgmt->ioLock);
+	pthread_mutex_destroy(&mgmt->changeLock);
+	pthread_cond_destroy(&mgmt->loaded);
+	free(mgmt);
+}
+
+RC
+openBtree (BTreeHandle **tree, char *idxId)
+{
+	BM_PageHandle page;
+	BTreeHandle *result;
+	BTreeMgmt *mgmt;
+	RC rc;
+
+	if(tree == NULL || idxId == NULL)
+		return RC_PARAMS_ERROR;
+
+	result = (BTreeHandle *) malloc(sizeof(BTreeHandle));
+	mgmt = (BTreeMgmt *) calloc(1, sizeof(BTreeMgmt));
+	result->idxId = strdup(idxId);
+	result->mgmtData = mgmt;
+	pthread_mutex_init(&mgmt->poolLock, NULL);
+	pthread_mutex_init(&mgmt->ioLock, NULL);
+	pthread_mutex_init(&mgmt->changeLock, NULL);
+	pthread_cond_init(&mgmt->loaded, NULL);
+	mgmt->frameData = (char *) calloc(BTREE_POOL_SIZE, PAGE_SIZE);
+	for(int i = 0; i < BTREE_POOL_SIZE; i++)
+	{
+		mgmt->frames[i].pageNum = NO_PAGE;
+		mgmt->frames[i].oldPage = NO_PAGE;
+		mgmt->frames[i].data = mgmt->frameData + i * PAGE_SIZE;
+	}
+
+	if((rc = openPageFile(result->idxId, &mgmt->file)) == RC_OK
+			&& (rc = pinNode(mgmt, &page, 0)) != RC_OK)
+		closePageFile(&mgmt->file);
+	if(rc != RC_OK)
+	{
+		freeMgmt(mgmt);
+		free(result->idxId);
+		free(result);
+		return rc;
+	}
+
+	result->keyType = (DataType) readAttrInt(page.data + HDR_KEY_TYPE);
+	mgmt->keyLength = readAttrInt(page.data + HDR_KEY_LENGTH);
+	mgmt->payloadLength = readAttrInt(page.data + HDR_PAYLOAD_LENGTH);
+	mgmt->leafEntrySize = mgmt->keyLength + RID_SIZE + mgmt->payloadLength;
+	mgmt->leafCapacity = readAttrInt(page.data + HDR_LEAF_CAPACITY);
+	mgmt->innerCapacity = readAttrInt(page.data + HDR_INNER_CAPACITY);
+	mgmt->leafLimit = readAttrInt(page.data + HDR_LEAF_LIMIT);
+	mgmt->innerLimit = readAttrInt(page.data + HDR_INNER_LIMIT);
+	mgmt->root = readAttrInt(page.data + HDR_ROOT);
+	mgmt->height = readAttrInt(page.data + HDR_HEIGHT);
+	mgmt->numNodes = readAttrInt(page.data + HDR_NUM_NODES);
+	mgmt->numEntries = readAttrInt(page.data + HDR_NUM_ENTRIES);
+	mgmt->freePage = readAttrInt(page.data + HDR_FREE_PAGE);
+	mgmt->nextPage = readAttrInt(page.data + HDR_NEXT_PAGE);
+	unpinNode(mgmt, &page);
+
+	*tree = result;
+	return RC_OK;
+}
+
+RC
+closeBtree (BTreeHandle *tree)
+{
+	BTreeMgmt *mgmt;
+	BM_PageHandle page;
+	RC rc;
+
+	if(tree == NULL)
+		return RC_PARAMS_ERROR;
+	mgmt = (BTreeMgmt *) tree->mgmtData;
+
+	// the header is kept in memory while the tree is open
+	if((rc = pinNode(mgmt, &page, 0)) == RC_OK)
+	{
+		writeAttrInt(page.data + HDR_ROOT, mgmt->root);
+		writeAttrInt(page.data + HDR_HEIGHT, mgmt->height);
+		writeAttrInt(page.data + HDR_NUM_NODES, mgmt->numNodes);
+		writeAttrInt(page.data + HDR_NUM_ENTRIES, mgmt->numEntries);
+		writeAttrInt(page.data + HDR_FREE_PAGE, mgmt->freePage);
+		writeAttrInt(page.data + HDR_NEXT_PAGE, mgmt->nextPage);
+		markNodeDirty(mgmt, &page);
+		unpinNode(mgmt, &page);
+	}
+	if(rc == RC_OK)
+		rc = flushPool(mgmt);
+	if(rc == RC_OK)
+		rc = closePageFile(&mgmt->file);
+	else
+		closePageFile(&mgmt->file);
+
+	freeMgmt(mgmt);
+	free(tree->idxId);
+	free(tree);
+	return rc;
+}
+
+RC
+deleteBtree (char *idxId)
+{
+	if(idxId == NULL)
+		return RC_PARAMS_ERROR;
+	return destroyPageFile(idxId);
+}
+
+RC
+getNumNodes (BTreeHandle *tree, int *result)
+{
+	*result = ((BTreeMgmt *) tree->mgmtData)->numNodes;
+	return RC_OK;
+}
+
+RC
+getNumEntries (BTreeHandle *tree, int *result)
+{
+	*result = __atomic_load_n(&((BTreeMgmt *) tree->mgmtData)->numEntries, __ATOMIC_RELAXED);
+	return RC_OK;
+}
+
+RC
+getKeyType (BTreeHandle *tree, DataType *result)
+{
+	*result = tree->keyType;
+	return RC_OK;
+}
+
+RC
+getKeyLength (BTreeHandle *tree, int *result)
+{
+	*result = ((BTreeMgmt *) tree->mgmtData)->keyLength;
+	return RC_OK;
+}
+
+RC
+getTreeHeight (BTreeHandle *tree, int *result)
+{
+	*result = ((BTreeMgmt *) tree->mgmtData)->height;
+	return RC_OK;
+}
+
+RC
+getPayloadLength (BTreeHandle *tree, int *result)
+{
+	*result = ((BTreeMgmt *) tree->mgmtData)->payloadLength;
+	return RC_OK;
+}
+
+// ************************************************************
+// index access
+
+RC
+findEncodedKey (BTreeHandle *tree, char *key, RID *result)
+{
+	return findEncodedEntry(tree, key, result, NULL);
+}
+
+// readers work on copies of the nodes, they never latch a node or wait for
+// anything but a writer that holds a node they need
+RC
+findEncodedEntry (BTreeHandle *tree, char *key, RID *result, char *payload)
+{
+	BTreeMgmt *mgmt = (BTreeMgmt *) tree->mgmtData;
+	char leaf[PAGE_SIZE];
+	uint64_t version;
+	int pageNum, depth;
+	bool found;
+	RC rc;
+
+	if((rc = readLeaf(mgmt, key, leaf, &pageNum, &version, &depth)) != RC_OK)
+		return rc;
+	int pos = searchLeaf(mgmt, leaf, key, &found);
+	if(found)
+	{
+		char *entry = leafEntry(mgmt, leaf, pos);
+		readLeafRID(leaf, entry, result);
+		if(payload != NULL)
+			memcpy(payload, leafPayload(leaf, entry), mgmt->payloadLength);
+	}
+	return found ? RC_OK : RC_IM_KEY_NOT_FOUND;
+}
+
+RC
+insertEncodedKey (BTreeHandle *tree, char *key, RID rid)
+{
+	return insertEncodedEntry(tree, key, rid, NULL);
+}
+
+// whether a leaf takes key without being split. the keys of the leaf and key
+// share at least what key shares with the prefix of the leaf
+static bool
+leafHasRoom (BTreeMgmt *mgmt, char *node, char *key)
+{
+	int numKeys = nodeNumKeys(node), prefixLength = nodePrefixLength(node);
+	int end = prefixLength + nodeKeyWidth(node), length = significantLength(key, mgmt->keyLength);
+
+	return numKeys < mgmt->leafLimit && nodeSize(mgmt, true, numKeys + 1,
+			commonLength(key, nodePrefix(node), prefixLength), length > end ? length : end) <= PAGE_SIZE;
+}
+
+// add an entry to a pinned leaf and unpin it, a leaf that is full is split
+// into the parents on path
+static RC
+insertIntoLeaf (BTreeMgmt *mgmt, TreePath *path, BM_PageHandle *leaf, char *key, RID rid,
+		char *payload)
+{
+	bool found;
+	RC rc;
+
+	int pos = searchLeaf(mgmt, leaf->data, key, &found);
+	if(found)
+	{
+		unpinNode(mgmt, leaf);
+		return RC_IM_KEY_ALREADY_EXISTS;
+	}
+
+	__atomic_fetch_add(&mgmt->numEntries, 1, __ATOMIC_RELAXED);
+	int numKeys = nodeNumKeys(leaf->data);
+	int prefixLength = nodePrefixLength(leaf->data), end = prefixLength + nodeKeyWidth(leaf->data);
+
+	// a key that shares the prefix of the leaf and is not wider than its
+	// entries is added in place
+	if(numKeys < mgmt->leafLimit && keyFitsLayout(mgmt, leaf->data, key)
+			&& nodeSize(mgmt, true, numKeys + 1, prefixLength, end) <= PAGE_SIZE)
+	{
+		int slotSize = leafSlotSize(mgmt, leaf->data);
+		char *entry = leafEntry(mgmt, leaf->data, pos);
+		memmove(entry + slotSize, entry, (numKeys - pos) * slotSize);
+		writeLeafSlot(mgmt, leaf->data, entry, key, rid, payload);
+		writeAttrInt(leaf->data + NODE_NUM_KEYS, numKeys + 1);
+		markNodeDirty(mgmt, leaf);
+		return unpinNode(mgmt, leaf);
+	}
+
+	// otherwise the leaf is packed again, or split if the entries do not fit
+	int entrySize = mgmt->leafEntrySize;
+	char *entries = (char *) malloc((numKeys + 1) * entrySize);
+	unpackLeaf(mgmt, leaf->data, entries);
+	memmove(entries + (pos + 1) * entrySize, entries + pos * entrySize, (numKeys - pos) * entrySize);
+	writeLeafEntry(mgmt, entries + pos * entrySize, key, rid, payload);
+	if(entriesFit(mgmt, true, entries, numKeys + 1))
+	{
+		packLeaf(mgmt, leaf->data, entries, numKeys + 1);
+		markNodeDirty(mgmt, leaf);
+		rc = unpinNode(mgmt, leaf);
+	}
+	else
+		rc = splitLeaf(mgmt, path, leaf, entries, numKeys + 1);
+	free(entries);
+	return rc;
+}
+
+// most inserts only change their leaf and latch nothing else. an insert that
+// splits the leaf starts over and latches the nodes the split may reach
+RC
+insertEncodedEntry (BTreeHandle *tree, char *key, RID rid, char *payload)
+{
+	BTreeMgmt *mgmt = (BTreeMgmt *) tree->mgmtData;
+	BM_PageHandle leaf;
+	TreePath path;
+	int depth;
+	bool found;
+	RC rc;
+
+	if((rc = latchLeaf(mgmt, key, &leaf, &depth)) != RC_OK)
+		return rc;
+	uint64_t *latch = nodeLatch(mgmt, leaf.pageNum);
+	searchLeaf(mgmt, leaf.data, key, &found);
+	if(found || leafHasRoom(mgmt, leaf.data, key))
+	{
+		rc = insertIntoLeaf(mgmt, NULL, &leaf, key, rid, payload);
+		unlatch(latch, !found);
+		return rc;
+	}
+	unpinNode(mgmt, &leaf);
+	unlatch(latch, false);
+
+	beginChange(mgmt);
+	if((rc = lockPath(mgmt, key, true, &path, &leaf)) == RC_OK)
+		rc = insertIntoLeaf(mgmt, &path, &leaf, key, rid, payload);
+	endChange(mgmt);
+	return rc;
+}
+
+// remove an entry from a pinned leaf and unpin it, a leaf that falls below
+// half of its capacity is refilled or merged through the parents on path
+static RC
+deleteFromLeaf (BTreeMgmt *mgmt, TreePath *path, BM_PageHandle *leaf, char *key)
+{
+	bool found;
+
+	int pos = searchLeaf(mgmt, leaf->data, key, &found);
+	if(!found)
+	{
+		unpinNode(mgmt, leaf);
+		return RC_IM_KEY_NOT_FOUND;
+	}
+
+	// separators equal to the key may stay in the inner nodes, they still
+	// route every other key to the right leaf
+	int numKeys = nodeNumKeys(leaf->data);
+	int slotSize = leafSlotSize(mgmt, leaf->data);
+	char *entry = leafEntry(mgmt, leaf->data, pos);
+	memmove(entry, entry + slotSize, (numKeys - pos - 1) * slotSize);
+	writeAttrInt(leaf->data + NODE_NUM_KEYS, numKeys - 1);
+	__atomic_fetch_sub(&mgmt->numEntries, 1, __ATOMIC_RELAXED);
+
+	return rebalance(mgmt, path, leaf);
+}
+
+// a delete that leaves its leaf at least half full, or empties the root,
+// only latches the leaf. it is passed an empty path so that the leaf is
+// treated like the root and not rebalanced
+RC
+deleteEncodedKey (BTreeHandle *tree, char *key)
+{
+	BTreeMgmt *mgmt = (BTreeMgmt *) tree->mgmtData;
+	BM_PageHandle leaf;
+	TreePath path;
+	int depth;
+	RC rc;
+
+	if((rc = latchLeaf(mgmt, key, &leaf, &depth)) != RC_OK)
+		return rc;
+	uint64_t *latch = nodeLatch(mgmt, leaf.pageNum);
+	if(depth == 0 || nodeNumKeys(leaf.data) > mgmt->leafCapacity / 2)
+	{
+		path.depth = 0;
+		rc = deleteFromLeaf(mgmt, &path, &leaf, key);
+		unlatch(latch, rc == RC_OK);
+		return rc;
+	}
+	unpinNode(mgmt, &leaf);
+	unlatch(latch, false);
+
+	beginChange(mgmt);
+	if((rc = lockPath(mgmt, key, false, &path, &leaf)) == RC_OK)
+		rc = deleteFromLeaf(mgmt, &path, &leaf, key);
+	endChange(mgmt);
+	return rc;
+}
+
+RC
+updateEncodedPayload (BTreeHandle *tree, char *key, char *payload)
+{
+	BTreeMgmt *mgmt = (BTreeMgmt *) tree->mgmtData;
+	BM_PageHandle leaf;
+	int depth;
+	bool found, changed = false;
+	RC rc;
+
+	if((rc = latchLeaf(mgmt, key, &leaf, &depth)) != RC_OK)
+		return rc;
+	int pos = searchLeaf(mgmt, leaf.data, key, &found);
+	if(found)
+	{
+		char *stored = leafPayload(leaf.data, leafEntry(mgmt, leaf.data, pos));
+		changed = memcmp(stored, payload, mgmt->payloadLength) != 0;
+		if(changed)
+		{
+			memcpy(stored, payload, mgmt->payloadLength);
+			markNodeDirty(mgmt, &leaf);
+		}
+	}
+	rc = unpinNode(mgmt, &leaf);
+	unlatch(nodeLatch(mgmt, leaf.pageNum), changed);
+	return found ? rc : RC_IM_KEY_NOT_FOUND;
+}
+
+// position a scan on the first entry of the leaf that holds resume which
+// belongs to the scan
+static RC
+seekScan (BTreeMgmt *mgmt, TreeScan *scan)
+{
+	char *key = scan->resumeSet ? scan->resume : NULL;
+	int depth;
+	bool found = false;
+	RC rc;
+
+	if((rc = readLeaf(mgmt, key, scan->leaf, &scan->pageNum, &scan->version, &depth)) != RC_OK)
+	{
+		scan->pageNum = NO_PAGE;
+		return rc;
+	}
+	scan->pos = key == NULL ? 0 : searchLeaf(mgmt, scan->leaf, key, &found);
+	if(found && scan->resumeAfter)
+		scan->pos++;
+	scan->first = scan->pos;
+	return RC_OK;
+}
+
+RC
+openTreeRangeScanEncoded (BTreeHandle *tree, char *low, char *high, BT_ScanHandle **handle)
+{
+	BTreeMgmt *mgmt = (BTreeMgmt *) tree->mgmtData;
+	TreeScan *scan = (TreeScan *) malloc(sizeof(TreeScan));
+	RC rc;
+
+	scan->leaf = (char *) malloc(PAGE_SIZE);
+	scan->resume = (char *) malloc(mgmt->keyLength);
+	scan->resumeSet = low != NULL;
+	scan->resumeAfter = false;
+	if(low != NULL)
+		memcpy(scan->resume, low, mgmt->keyLength);
+	if((rc = seekScan(mgmt, scan)) != RC_OK)
+	{
+		free(scan->leaf);
+		free(scan->resume);
+		free(scan);
+		return rc;
+	}
+	scan->high = NULL;
+	scan->key = (char *) malloc(mgmt->keyLength);
+	if(high != NULL)
+	{
+		scan->high = (char *) malloc(mgmt->keyLength);
+		memcpy(scan->high, high, mgmt->keyLength);
+	}
+
+	*handle = (BT_ScanHandle *) malloc(sizeof(BT_ScanHandle));
+	(*handle)->tree = tree;
+	(*handle)->mgmtData = scan;
+	return RC_OK;
+}
+
+// the Value interface encodes the keys and calls the functions above
+#define WITH_ENCODED_KEY(tree, key, buf, call)				\
+		do {									\
+			BTreeMgmt *_mgmt = (BTreeMgmt *) (tree)->mgmtData;		\
+			char *buf = (char *) malloc(_mgmt->keyLength);			\
+			RC _rc = encodeKey((tree)->keyType, _mgmt->keyLength, key, buf);	\
+			if(_rc == RC_OK)						\
+				_rc = (call);						\
+			free(buf);							\
+			return _rc;							\
+		} while(0)
+
+RC
+findKey (BTreeHandle *tree, Value *key, RID *result)
+{
+	WITH_ENCODED_KEY(tree, key, buf, findEncodedKey(tree, buf, result));
+}
+
+RC
+insertKey (BTreeHandle *tree, Value *key, RID rid)
+{
+	WITH_ENCODED_KEY(tree, key, buf, insertEncodedKey(tree, buf, rid));
+}
+
+RC
+deleteKey (BTreeHandle *tree, Value *key)
+{
+	WITH_ENCODED_KEY(tree, key, buf, deleteEncodedKey(tree, buf));
+}
+
+RC
+openTreeScan (BTreeHandle *tree, BT_ScanHandle **handle)
+{
+	return openTreeRangeScanEncoded(tree, NULL, NULL, handle);
+}
+
+RC
+openTreeRangeScan (BTreeHandle *tree, Value *low, Value *high, BT_ScanHandle **handle)
+{
+	BTreeMgmt *mgmt = (BTreeMgmt *) tree->mgmtData;
+	char *lowKey = NULL, *highKey = NULL;
+	RC rc = RC_OK;
+
+	if(low != NULL)
+	{
+		lowKey = (char *) malloc(mgmt->keyLength);
+		rc = encodeKey(tree->keyType, mgmt->keyLength, low, lowKey);
+	}
+	if(rc == RC_OK && high != NULL)
+	{
+		highKey = (char *) malloc(mgmt->keyLength);
+		rc = encodeKey(tree->keyType, mgmt->keyLength, high, highKey);
+	}
+	if(rc == RC_OK)
+		rc = openTreeRangeScanEncoded(tree, lowKey, highKey, handle);
+
+	free(lowKey);
+	free(highKey);
+	return rc;
+}
+
+RC
+nextEntry (BT_ScanHandle *handle, RID *result)
+{
+	return nextEncodedEntry(handle, NULL, result, NULL);
+}
+
+RC
+nextEncodedEntry (BT_ScanHandle *handle, char *key, RID *result, char *payload)
+{
+	BTreeMgmt *mgmt = (BTreeMgmt *) handle->tree->mgmtData;
+	TreeScan *scan = (TreeScan *) handle->mgmtData;
+	uint64_t version;
+	bool valid;
+	RC rc;
+
+	while(scan->pageNum != NO_PAGE)
+	{
+		if(scan->pos < nodeNumKeys(scan->leaf))
+		{
+			char *entry = leafEntry(mgmt, scan->leaf, scan->pos);
+			if(scan->high != NULL || key != NULL)
+				nodeKey(mgmt, scan->leaf, entry, scan->key);
+			if(scan->high != NULL && memcmp(scan->key, scan->high, mgmt->keyLength) > 0)
+				break;
+			readLeafRID(scan->leaf, entry, result);
+			if(key != NULL)
+				memcpy(key, scan->key, mgmt->keyLength);
+			if(payload != NULL)
+				memcpy(payload, leafPayload(scan->leaf, entry), mgmt->payloadLength);
+			scan->pos++;
+			return RC_OK;
+		}
+
+		// remember the last key returned before the copy is replaced
+		if(scan->pos > scan->first)
+		{
+			nodeKey(mgmt, scan->leaf, leafEntry(mgmt, scan->leaf, scan->pos - 1), scan->resume);
+			scan->resumeSet = scan->resumeAfter = true;
+		}
+		int current = scan->pageNum, next = readAttrInt(scan->leaf + NODE_NEXT);
+		if(next == NO_PAGE)
+			break;
+
+		// the next leaf follows the current one if that did not change
+		if((rc = readNode(mgmt, next, scan->leaf, &version, &valid)) != RC_OK)
+		{
+			scan->pageNum = NO_PAGE;
+			return rc;
+		}
+		if(valid && checkVersion(nodeLatch(mgmt, current), scan->version))
+		{
+			scan->pageNum = next;
+			scan->version = version;
+			scan->pos = scan->first = 0;
+		}
+		else if((rc = seekScan(mgmt, scan)) != RC_OK)
+			return rc;
+	}
+
+	scan->pageNum = NO_PAGE;
+	return RC_IM_NO_MORE_ENTRIES;
+}
+
+RC
+closeTreeScan (BT_ScanHandle *handle)
+{
+	TreeScan *scan;
+
+	if(handle == NULL)
+		return RC_PARAMS_ERROR;
+	scan = (TreeScan *) handle->mgmtData;
+
+	free(scan->leaf);
+	free(scan->resume);
+	free(scan->high);
+	free(scan->key);
+	free(scan);
+	free(handle);
+	return RC_OK;
+}
+
+// ************************************************************
+// bulk loading
+
+// entries are sorted in runs that fill sortPages pages of memory, runs that do
+// not fit are written to <idxId>.sort and merged when the load is finished
+#define BULK_SORT_PAGES 1024
+
+typedef struct BulkLoad {
+	int fillPercent;
+	int keyLength;
+	int entrySize;
+	char *run;
+	int runCapacity;
+	int runCount;
+	int numRuns;
+	int *runStart;
+	int *runLength;
+	int numEntries;
+	char *sortFileName;
+	SM_FileHandle sortFile;
+	bool sortFileOpen;
+} BulkLoad;
+
+// the sorted entries of a run, read one page at a time from the sort file or
+// all at once from memory
+typedef struct RunReader {
+	char *page;
+	int nextPage;
+	int remaining;
+	int pos;
+	int pageEntries;
+} RunReader;
+
+// the nodes of one level of a tree being built and the separator before each,
+// the first node keeps the first key below it
+typedef struct TreeLevel {
+	int *pages;
+	char *keys;
+	int count;
+} TreeLevel;
+
+// qsort_r hands the key length of the tree to the comparison
+static int
+compareEntries (const void *a, const void *b, void *keyLength)
+{
+	return memcmp(a, b, *(int *) keyLength);
+}
+
+// sort the entries collected in memory by their keys
+static void
+sortRun (BulkLoad *load)
+{
+	qsort_r(load->run, load->runCount, load->entrySize, compareEntries, &load->keyLength);
+}
+
+// sort the entries collected in memory and append them to the sort file
+static RC
+writeRun (BulkLoad *load)
+{
+	int perPage = PAGE_SIZE / load->entrySize;
+	char *page;
+	RC rc;
+
+	if(!load->sortFileOpen)
+	{
+		if((rc = createPageFile(load->sortFileName)) != RC_OK
+				|| (rc = openPageFile(load->sortFileName, &load->sortFile)) != RC_OK)
+			return rc;
+		load->sortFileOpen = true;
+	}
+
+	sortRun(load);
+	load->runStart = (int *) realloc(load->runStart, (load->numRuns + 1) * sizeof(int));
+	load->runLength = (int *) realloc(load->runLength, (load->numRuns + 1) * sizeof(int));
+	load->runStart[load->numRuns] = load->numRuns == 0 ? 0 : load->sortFile.totalNumPages;
+	load->runLength[load->numRuns] = load->runCount;
+
+	page = (char *) calloc(PAGE_SIZE, sizeof(char));
+	int pageNum = load->runStart[load->numRuns];
+	rc = RC_OK;
+	for(int i = 0; rc == RC_OK && i < load->runCount; i += perPage, pageNum++)
+	{
+		int count = load->runCount - i < perPage ? load->runCount - i : perPage;
+		memcpy(page, load->run + i * load->entrySize, count * load->entrySize);
+		if((rc = ensureCapacity(pageNum + 1, &load->sortFile)) == RC_OK)
+			rc = writeBlock(pageNum, &load->sortFile, page);
+	}
+	free(page);
+	load->numRuns++;
+	load->runCount = 0;
+	return rc;
+}
+
+static RC
+readRunPage (BulkLoad *load, RunReader *reader)
+{
+	int perPage = PAGE_SIZE / load->entrySize;
+
+	reader->pos = 0;
+	reader->pageEntries = reader->remaining < perPage ? reader->remaining : perPage;
+	return readBlock(reader->nextPage++, &load->sortFile, reader->page);
+}
+
+static inline char *
+readerEntry (BulkLoad *load, RunReader *reader)
+{
+	return reader->page + reader->pos * load->entrySize;
+}
+
+// restore the order of a heap of runs below position i, the run with the
+// smallest next key on top
+static void
+siftDown (BulkLoad *load, RunReader *readers, int *heap, int size, int i)
+{
+	while(true)
+	{
+		int smallest = i;
+		for(int child = 2 * i + 1; child <= 2 * i + 2 && child < size; child++)
+			if(memcmp(readerEntry(load, &readers[heap[child]]),
+					readerEntry(load, &readers[heap[smallest]]), load->keyLength) < 0)
+				smallest = child;
+		if(smallest == i)
+			return;
+		int tmp = heap[i];
+		heap[i] = heap[smallest];
+		heap[smallest] = tmp;
+		i = smallest;
+	}
+}
+
+// pack the entries collected for the next leaf into a new page linked after
+// the pinned leaf before it and add it to level, the first leaf is the empty
+// root of the tree
+static RC
+appendLeaf (BTreeMgmt *mgmt, BM_PageHandle *leaf, TreeLevel *level, int *levelSize,
+		char *entries, int count, char *separator)
+{
+	BM_PageHandle next;
+	RC rc;
+
+	if(level->count == 0)
+	{
+		if((rc = pinNode(mgmt, &next, mgmt->root)) != RC_OK)
+			return rc;
+		initNode(next.data, true);
+	}
+	else
+	{
+		if((rc = allocNode(mgmt, &next, true)) != RC_OK)
+			return rc;
+		writeAttrInt(leaf->data + NODE_NEXT, next.pageNum);
+		markNodeDirty(mgmt, leaf);
+		unpinNode(mgmt, leaf);
+	}
+	packLeaf(mgmt, next.data, entries, count);
+	*leaf = next;
+
+	if(level->count == *levelSize)
+	{
+		*levelSize = *levelSize == 0 ? 64 : *levelSize * 2;
+		level->pages = (int *) realloc(level->pages, *levelSize * sizeof(int));
+		level->keys = (char *) realloc(level->keys, *levelSize * mgmt->keyLength);
+	}
+	level->pages[level->count] = next.pageNum;
+	memcpy(level->keys + level->count * mgmt->keyLength, separator, mgmt->keyLength);
+	level->count++;
+	return RC_OK;
+}
+
+// merge the runs into leaves written from left to right. a leaf takes entries
+// as long as they fit into fillPercent of a page compressed, the last leaf
+// shares the entries of the one before if it would be left nearly empty. the
+// entries of the previous leaf are kept in front of those of the current one.
+static RC
+buildLeaves (BTreeMgmt *mgmt, BulkLoad *load, RunReader *readers, TreeLevel *level)
+{
+	int maxKeys = mgmt->leafLimit * load->fillPercent / 100;
+	int maxBytes = NODE_HEADER_SIZE + (PAGE_SIZE - NODE_HEADER_SIZE) * load->fillPercent / 100;
+	int entrySize = load->entrySize, keyLength = mgmt->keyLength;
+	int heapSize = 0, prevCount = 0, count = 0, common = 0, end = 0, levelSize = 0;
+	int *heap = (int *) malloc(load->numRuns * sizeof(int));
+	char *separator = (char *) malloc(keyLength);
+	char *entries, *current;
+	BM_PageHandle leaf;
+	RC rc = RC_OK;
+
+	if(maxKeys < 1)
+		maxKeys = 1;
+	entries = (char *) malloc(2 * maxKeys * entrySize);
+	level->pages = NULL;
+	level->keys = NULL;
+	level->count = 0;
+
+	for(int i = 0; i < load->numRuns; i++)
+		if(readers[i].remaining > 0)
+			heap[heapSize++] = i;
+	for(int i = heapSize / 2 - 1; i >= 0; i--)
+		siftDown(load, readers, heap, heapSize, i);
+
+	for(int done = 0; rc == RC_OK && done < load->numEntries; done++)
+	{
+		RunReader *reader = &readers[heap[0]];
+		char *entry = readerEntry(load, reader);
+
+		current = entries + prevCount * entrySize;
+		if(done > 0 && memcmp(current + (count - 1) * entrySize, entry, keyLength) == 0)
+		{
+			rc = RC_IM_KEY_ALREADY_EXISTS;
+			break;
+		}
+
+		// write the leaf once the entry does not fit into it anymore
+		if(count > 0)
+		{
+			int newCommon = commonLength(current, entry, common);
+			int length = significantLength(entry, keyLength);
+			int newEnd = length > end ? length : end;
+			if(count < maxKeys && nodeSize(mgmt, true, count + 1, newCommon, newEnd) <= maxBytes)
+			{
+				common = newCommon;
+				end = newEnd;
+			}
+			else
+			{
+				if(prevCount == 0)
+					memcpy(separator, current, keyLength);
+				else
+					separatorKey(mgmt, current - entrySize, current, separator);
+				if((rc = appendLeaf(mgmt, &leaf, level, &levelSize, current, count, separator)) != RC_OK)
+					break;
+				memmove(entries, current, count * entrySize);
+				prevCount = count;
+				count = 0;
+			}
+		}
+		if(count == 0)
+		{
+			common = keyLength;
+			end = significantLength(entry, keyLength);
+		}
+		memcpy(entries + (prevCount + count++) * entrySize, entry, entrySize);
+
+		// move on in the run of the entry
+		reader->pos++;
+		if(--reader->remaining == 0)
+			heap[0] = heap[--heapSize];
+		else if(reader->pos == reader->pageEntries)
+			rc = readRunPage(load, reader);
+		siftDown(load, readers, heap, heapSize, 0);
+	}
+
+	if(rc == RC_OK && count > 0)
+	{
+		// the first half of both stays in the previous leaf, which still fits
+		if(prevCount > 0 && count < prevCount / 2)
+		{
+			int total = prevCount + count, leftKeys = (total + 1) / 2;
+			if(entriesSize(mgmt, true, entries + leftKeys * entrySize, total - leftKeys) <= maxBytes)
+			{
+				packLeaf(mgmt, leaf.data, entries, leftKeys);
+				prevCount = leftKeys;
+				count = total - leftKeys;
+			}
+		}
+		current = entries + prevCount * entrySize;
+		if(prevCount == 0)
+			memcpy(separator, current, keyLength);
+		else
+			separatorKey(mgmt, current - entrySize, current, separator);
+		rc = appendLeaf(mgmt, &leaf, level, &levelSize, current, count, separator);
+	}
+	if(level->count > 0)
+	{
+		markNodeDirty(mgmt, &leaf);
+		unpinNode(mgmt, &leaf);
+	}
+	free(heap);
+	free(entries);
+	free(separator);
+	return rc;
+}
+
+// the number of children from first on that the next inner node of a level
+// takes: at least three, and more as long as their separators fit into
+// maxBytes compressed
+static int
+innerShare (BTreeMgmt *mgmt, TreeLevel *level, int first, int maxChildren, int maxBytes)
+{
+	int keyLength = mgmt->keyLength, common = keyLength, end = 0, share = 1;
+	char *firstKey = level->keys + (first + 1) * keyLength;
+
+	while(first + share < level->count && share < maxChildren)
+	{
+		char *key = level->keys + (first + share) * keyLength;
+		int newCommon = commonLength(firstKey, key, common);
+		int length = significantLength(key, keyLength);
+		int newEnd = length > end ? length : end;
+		if(share >= 3 && nodeSize(mgmt, false, share, newCommon, newEnd) > maxBytes)
+			break;
+		common = newCommon;
+		end = newEnd;
+		share++;
+	}
+	return share;
+}
+
+// build the inner nodes above the nodes of level and replace them by it
+static RC
+buildInnerLevel (BTreeMgmt *mgmt, BulkLoad *load, TreeLevel *level)
+{
+	int maxChildren = mgmt->innerLimit * load->fillPercent / 100 + 1;
+	int maxBytes = NODE_HEADER_SIZE + (PAGE_SIZE - NODE_HEADER_SIZE) * load->fillPercent / 100;
+	int keyLength = mgmt->keyLength, entrySize = keyLength + sizeof(int);
+	TreeLevel above;
+	BM_PageHandle node;
+	RC rc = RC_OK;
+
+	// an inner node needs two children even at a low fill factor
+	if(maxChildren < 3)
+		maxChildren = 3;
+	if(maxChildren > mgmt->innerLimit + 1)
+		maxChildren = mgmt->innerLimit + 1;
+	char *entries = (char *) malloc(maxChildren * entrySize);
+	above.pages = (int *) malloc(level->count * sizeof(int));
+	above.keys = (char *) malloc(level->count * keyLength);
+	above.count = 0;
+
+	for(int first = 0; rc == RC_OK && first < level->count; above.count++)
+	{
+		int share = innerShare(mgmt, level, first, maxChildren, maxBytes);
+		int rest = level->count - first - share;
+
+		// the children of the last two nodes are spread evenly if the last
+		// one would get less than half of a node, so it never gets a single
+		// child
+		if(rest > 0 && 2 * rest < share)
+		{
+			int even = (share + rest + 1) / 2;
+			if(rest == 1 || innerShare(mgmt, level, first + even, maxChildren, maxBytes)
+					== share + rest - even)
+				share = even;
+		}
+		if((rc = allocNode(mgmt, &node, false)) != RC_OK)
+			break;
+
+		// the first key below a node goes up, the others separate its children
+		for(int i = 1; i < share; i++)
+		{
+			char *entry = entries + (i - 1) * entrySize;
+			memcpy(entry, level->keys + (first + i) * keyLength, keyLength);
+			writeAttrInt(entry + keyLength, level->pages[first + i]);
+		}
+		packInner(mgmt, node.data, level->pages[first], entries, share - 1);
+		above.pages[above.count] = node.pageNum;
+		memcpy(above.keys + above.count * keyLength, level->keys + first * keyLength, keyLength);
+		markNodeDirty(mgmt, &node);
+		unpinNode(mgmt, &node);
+		first += share;
+	}
+
+	free(entries);
+	free(level->pages);
+	free(level->keys);
+	*level = above;
+	return rc;
+}
+
+static void
+freeBulkLoad (BT_LoadHandle *handle)
+{
+	BulkLoad *load = (BulkLoad *) handle->mgmtData;
+
+	if(load->sortFileOpen)
+	{
+		closePageFile(&load->sortFile);
+		destroyPageFile(load->sortFileName);
+	}
+	free(load->run);
+	free(load->runStart);
+	free(load->runLength);
+	free(load->sortFileName);
+	free(load);
+	free(handle);
+}
+
+RC
+startBulkLoad (BTreeHandle *tree, int fillPercent, int sortPages, BT_LoadHandle **handle)
+{
+	BTreeMgmt *mgmt;
+	BulkLoad *load;
+
+	if(tree == NULL || handle == NULL || fillPercent < 1 || fillPercent > 100 || sortPages < 0)
+		return RC_PARAMS_ERROR;
+	mgmt = (BTreeMgmt *) tree->mgmtData;
+	if(mgmt->numEntries > 0)
+		THROW(RC_ERROR, "bulk loading needs an empty index");
+
+	load = (BulkLoad *) calloc(1, sizeof(BulkLoad));
+	load->fillPercent = fillPercent;
+	load->keyLength = mgmt->keyLength;
+	load->entrySize = mgmt->leafEntrySize;
+	load->runCapacity = (sortPages == 0 ? BULK_SORT_PAGES : sortPages) * (PAGE_SIZE / load->entrySize);
+	load->run = (char *) malloc(load->runCapacity * load->entrySize);
+	load->sortFileName = (char *) malloc(strlen(tree->idxId) + 6);
+	sprintf(load->sortFileName, "%s.sort", tree->idxId);
+
+	*handle = (BT_LoadHandle *) malloc(sizeof(BT_LoadHandle));
+	(*handle)->tree = tree;
+	(*handle)->mgmtData = load;
+	return RC_OK;
+}
+
+RC
+bulkLoadEncodedKey (BT_LoadHandle *handle, char *key, RID rid)
+{
+	return bulkLoadEncodedEntry(handle, key, rid, NULL);
+}
+
+RC
+bulkLoadEncodedEntry (BT_LoadHandle *handle, char *key, RID rid, char *payload)
+{
+	BTreeMgmt *mgmt = (BTreeMgmt *) handle->tree->mgmtData;
+	BulkLoad *load = (BulkLoad *) handle->mgmtData;
+	RC rc;
+
+	if(load->runCount == load->runCapacity && (rc = writeRun(load)) != RC_OK)
+		return rc;
+	writeLeafEntry(mgmt, load->run + load->runCount * load->entrySize, key, rid, payload);
+	load->runCount++;
+	load->numEntries++;
+	return RC_OK;
+}
+
+RC
+bulkLoadKey (BT_LoadHandle *handle, Value *key, RID rid)
+{
+	BTreeMgmt *mgmt = (BTreeMgmt *) handle->tree->mgmtData;
+	char *buf = (char *) malloc(mgmt->keyLength);
+	RC rc = encodeKey(handle->tree->keyType, mgmt->keyLength, key, buf);
+
+	if(rc == RC_OK)
+		rc = bulkLoadEncodedKey(handle, buf, rid);
+	free(buf);
+	return rc;
+}
+
+RC
+finishBulkLoad (BT_LoadHandle *handle)
+{
+	BTreeMgmt *mgmt;
+	BulkLoad *load;
+	RunReader *readers;
+	TreeLevel level;
+	RC rc = RC_OK;
+
+	if(handle == NULL)
+		return RC_PARAMS_ERROR;
+	mgmt = (BTreeMgmt *) handle->tree->mgmtData;
+	load = (BulkLoad *) handle->mgmtData;
+	if(load->numEntries == 0)
+	{
+		freeBulkLoad(handle);
+		return RC_OK;
+	}
+
+	// a load that fit into memory is a single run that is never written
+	if(!load->sortFileOpen)
+	{
+		sortRun(load);
+		readers = (RunReader *) malloc(sizeof(RunReader));
+		readers[0].page = load->run;
+		readers[0].pos = 0;
+		readers[0].remaining = load->runCount;
+		readers[0].pageEntries = load->runCount;
+		load->numRuns = 1;
+	}
+	else
+	{
+		if(load->runCount > 0)
+			rc = writeRun(load);
+		free(load->run);
+		load->run = NULL;
+		readers = (RunReader *) malloc(load->numRuns * sizeof(RunReader));
+		for(int i = 0; i < load->numRuns; i++)
+		{
+			readers[i].page = (char *) malloc(PAGE_SIZE);
+			readers[i].nextPage = load->runStart[i];
+			readers[i].remaining = load->runLength[i];
+			if(rc == RC_OK)
+				rc = readRunPage(load, &readers[i]);
+		}
+	}
+
+	// the leaves and then each level of inner nodes up to a single root
+	level.pages = NULL;
+	level.keys = NULL;
+	if(rc == RC_OK && (rc = buildLeaves(mgmt, load, readers, &level)) == RC_OK)
+	{
+		int height = 1;
+		while(rc == RC_OK && level.count > 1)
+		{
+			rc = buildInnerLevel(mgmt, load, &level);
+			height++;
+		}
+		if(rc == RC_OK)
+		{
+			mgmt->root = level.pages[0];
+			mgmt->height = height;
+			mgmt->numEntries = load->numEntries;
+		}
+	}
+
+	if(load->sortFileOpen)
+		for(int i = 0; i < load->numRuns; i++)
+			free(readers[i].page);
+	free(readers);
+	free(level.pages);
+	free(level.keys);
+	freeBulkLoad(handle);
+	return rc;
+}
+
+RC
+cancelBulkLoad (BT_LoadHandle *handle)
+{
+	if(handle == NULL)
+		return RC_PARAMS_ERROR;
+	freeBulkLoad(handle);
+	return RC_OK;
+}
+
+// ************************************************************
+// debug and test functions
+
+// print a node as (page)[child,key,child] or (page)[rid,key,...,next] and
+// then its children, keys of composite indexes show their first attribute
+static RC
+printNode (BTreeHandle *tree, int pageNum, VarString *result)
+{
+	BTreeMgmt *mgmt = (BTreeMgmt *) tree->mgmtData;
+	BM_PageHandle node;
+	int *children = NULL;
+	int numKeys, i;
+	char *key;
+	RC rc;
+
+	if((rc = pinNode(mgmt, &node, pageNum)) != RC_OK)
+		return rc;
+	key = (char *) malloc(mgmt->keyLength);
+	bool leaf = nodeIsLeaf(node.data);
+	numKeys = nodeNumKeys(node.data);
+
+	APPEND(result, "(%d)[", pageNum);
+	if(!leaf)
+	{
+		children = (int *) malloc((numKeys + 1) * sizeof(int));
+		children[0] = innerChild(node.data, 0);
+		APPEND(result, "%d", children[0]);
+	}
+	for(i = 0; i < numKeys; i++)
+	{
+		char *entry = leaf ? leafEntry(mgmt, node.data, i) : innerEntry(node.data, i);
+		Value *value;
+		char *text;
+		RID rid;
+
+		nodeKey(mgmt, node.data, entry, key);
+		if(leaf)
+		{
+			readLeafRID(node.data, entry, &rid);
+			APPEND(result, "%s%d.%d,", i > 0 ? "," : "", rid.page, rid.slot);
+		}
+		else
+			APPEND_STRING(result, ",");
+		if(decodeKey(tree->keyType, mgmt->keyLength, key, &value) == RC_OK)
+		{
+			text = serializeValue(value);
+			APPEND_STRING(result, text);
+			free(text);
+			freeVal(value);
+		}
+		if(!leaf)
+		{
+			children[i + 1] = innerChild(node.data, i + 1);
+			APPEND(result, ",%d", children[i + 1]);
+		}
+	}
+	if(leaf)
+		APPEND(result, "%s%d", numKeys > 0 ? "," : "", readAttrInt(node.data + NODE_NEXT));
+	APPEND_STRING(result, "]\n");
+	unpinNode(mgmt, &node);
+	free(key);
+
+	for(i = 0; !leaf && i <= numKeys && rc == RC_OK; i++)
+		rc = printNode(tree, children[i], result);
+	free(children);
+	return rc;
+}
+
+char *
+printTree (BTreeHandle *tree)
+{
+	VarString *result;
+
+	MAKE_VARSTRING(result);
+	printNode(tree, ((BTreeMgmt *) tree->mgmtData)->root, result);
+	RETURN_STRING(result);
+}
@@ -0,0 +1,100 @@
+#ifndef BTREE_MGR_H
+#define BTREE_MGR_H
+
+#include "dberror.h"
+#include "tables.h"
+
+// structure for accessing btrees
+typedef struct BTreeHandle {
+	DataType keyType;
+	char *idxId;
+	void *mgmtData;
+} BTreeHandle;
+
+typedef struct BT_ScanHandle {
+	BTreeHandle *tree;
+	void *mgmtData;
+} BT_ScanHandle;
+
+typedef struct BT_LoadHandle {
+	BTreeHandle *tree;
+	void *mgmtData;
+} BT_LoadHandle;
+
+// keys are stored in an order preserving binary form and compared as byte
+// strings, so a composite key is the concatenation of its encoded values.
+// numbers take their natural size, strings the length of their attribute.
+extern int keyLength (DataType keyType, int typeLength);
+extern RC encodeKey (DataType keyType, int length, Value *key, char *out);
+extern RC decodeKey (DataType keyType, int length, char *in, Value **key);
+
+// init and shutdown index manager
+extern RC initIndexManager (void *mgmtData);
+extern RC shutdownIndexManager ();
+
+// create, destroy, open, and close an btree index. n is the maximum number
+// of keys per node, 0 fills every page, which holds more keys when they share
+// a prefix or end in zeros. createBtree uses the natural key
+// length of keyType, createBtreeWithLength takes any length for strings and
+// composite keys. createBtreeWithPayload stores payloadLength bytes with every
+// key in the leaves, which are returned along with the rid
+extern RC createBtree (char *idxId, DataType keyType, int n);
+extern RC createBtreeWithLength (char *idxId, DataType keyType, int length, int n);
+extern RC createBtreeWithPayload (char *idxId, DataType keyType, int length,
+		int payloadLength, int n);
+extern RC openBtree (BTreeHandle **tree, char *idxId);
+extern RC closeBtree (BTreeHandle *tree);
+extern RC deleteBtree (char *idxId);
+
+// access information about a b-tree
+extern RC getNumNodes (BTreeHandle *tree, int *result);
+extern RC getNumEntries (BTreeHandle *tree, int *result);
+extern RC getKeyType (BTreeHandle *tree, DataType *result);
+extern RC getKeyLength (BTreeHandle *tree, int *result);
+extern RC getTreeHeight (BTreeHandle *tree, int *result);
+extern RC getPayloadLength (BTreeHandle *tree, int *result);
+
+// index access. threads may share an open tree for lookups, scans, inserts,
+// deletes and payload updates, bulk loading and printTree are not concurrent
+extern RC findKey (BTreeHandle *tree, Value *key, RID *result);
+extern RC insertKey (BTreeHandle *tree, Value *key, RID rid);
+extern RC deleteKey (BTreeHandle *tree, Value *key);
+extern RC openTreeScan (BTreeHandle *tree, BT_ScanHandle **handle);
+extern RC openTreeRangeScan (BTreeHandle *tree, Value *low, Value *high,
+		BT_ScanHandle **handle);
+extern RC nextEntry (BT_ScanHandle *handle, RID *result);
+extern RC closeTreeScan (BT_ScanHandle *handle);
+
+// the same on keys already encoded to the key length of the tree, the bounds
+// of a range scan are inclusive and NULL for an open end
+extern RC findEncodedKey (BTreeHandle *tree, char *key, RID *result);
+extern RC insertEncodedKey (BTreeHandle *tree, char *key, RID rid);
+extern RC deleteEncodedKey (BTreeHandle *tree, char *key);
+extern RC openTreeRangeScanEncoded (BTreeHandle *tree, char *low, char *high,
+		BT_ScanHandle **handle);
+
+// the same with the payload of the entries, the keys and payloads returned
+// are copied to buffers of the caller and skipped if those are NULL. the
+// entries inserted by the functions above have a payload of zeros.
+extern RC findEncodedEntry (BTreeHandle *tree, char *key, RID *result, char *payload);
+extern RC insertEncodedEntry (BTreeHandle *tree, char *key, RID rid, char *payload);
+extern RC updateEncodedPayload (BTreeHandle *tree, char *key, char *payload);
+extern RC nextEncodedEntry (BT_ScanHandle *handle, char *key, RID *result, char *payload);
+
+// bulk loading of an empty tree. the entries are added in any order, sorted
+// in runs of sortPages pages of memory (0 for the default) spilled to
+// <idxId>.sort and built bottom up into nodes filled to fillPercent of their
+// capacity by finishBulkLoad. duplicate keys fail the load and leave a tree
+// that has to be deleted.
+extern RC startBulkLoad (BTreeHandle *tree, int fillPercent, int sortPages,
+		BT_LoadHandle **handle);
+extern RC bulkLoadKey (BT_LoadHandle *handle, Value *key, RID rid);
+extern RC bulkLoadEncodedKey (BT_LoadHandle *handle, char *key, RID rid);
+extern RC bulkLoadEncodedEntry (BT_LoadHandle *handle, char *key, RID rid, char *payload);
+extern RC finishBulkLoad (BT_LoadHandle *handle);
+extern RC cancelBulkLoad (BT_LoadHandle *handle);
+
+// debug and test functions
+extern char *printTree (BTreeHandle *tree);
+
+#endif // BTREE_MGR_H
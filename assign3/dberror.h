@@ -31,11 +31,16 @@ typedef int RC;
 #define RC_RM_NO_MORE_TUPLES 203
 #define RC_RM_NO_PRINT_FOR_DATATYPE 204
 #define RC_RM_UNKOWN_DATATYPE 205
+#define RC_RM_TABLE_FULL 206
 
 #define RC_IM_KEY_NOT_FOUND 300
 #define RC_IM_KEY_ALREADY_EXISTS 301
 #define RC_IM_N_TO_LAGE 302
 #define RC_IM_NO_MORE_ENTRIES 303
+#define RC_IM_BUCKET_FULL 304
+#define RC_IM_INDEX_EXISTS 305
+#define RC_IM_INDEX_NOT_FOUND 306
+#define RC_IM_POOL_FULL 307
 
 /* holder for error messages */
 extern char *RC_message;
@@ -1,13 +1,20 @@
 #include <string.h>
 #include <stdlib.h>
+#include <stdint.h>
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#include <immintrin.h>
+#define EXPR_X86_SIMD
+#endif
 
 #include "dberror.h"
 #include "record_mgr.h"
 #include "expr.h"
 #include "tables.h"
+#include "rm_serializer.h"
 
 // implementations
-RC 
+RC
 valueEquals (Value *left, Value *right, Value *result)
 {
 	if(left->dt != right->dt)
@@ -28,12 +35,24 @@ valueEquals (Value *left, Value *right, Value *result)
 	case DT_STRING:
 		result->v.boolV = (strcmp(left->v.stringV, right->v.stringV) == 0);
 		break;
+	case DT_DATE:
+		result->v.boolV = (left->v.intV == right->v.intV);
+		break;
+	case DT_LONG:
+	case DT_TIMESTAMP:
+		result->v.boolV = (left->v.longV == right->v.longV);
+		break;
+	case DT_DOUBLE:
+		result->v.boolV = (left->v.doubleV == right->v.doubleV);
+		break;
+	default:
+		THROW(RC_RM_UNKOWN_DATATYPE, "unknown datatype");
 	}
 
 	return RC_OK;
 }
 
-RC 
+RC
 valueSmaller (Value *left, Value *right, Value *result)
 {
 	if(left->dt != right->dt)
@@ -50,15 +69,101 @@ valueSmaller (Value *left, Value *right, Value *result)
 		break;
 	case DT_BOOL:
 		result->v.boolV = (left->v.boolV < right->v.boolV);
+		break;
 	case DT_STRING:
 		result->v.boolV = (strcmp(left->v.stringV, right->v.stringV) < 0);
 		break;
+	case DT_DATE:
+		result->v.boolV = (left->v.intV < right->v.intV);
+		break;
+	case DT_LONG:
+	case DT_TIMESTAMP:
+		result->v.boolV = (left->v.longV < right->v.longV);
+		break;
+	case DT_DOUBLE:
+		result->v.boolV = (left->v.doubleV < right->v.doubleV);
+		break;
+	default:
+		THROW(RC_RM_UNKOWN_DATATYPE, "unknown datatype");
+	}
+
+	return RC_OK;
+}
+
+// apply a comparison operator to two values of the same datatype
+RC
+valueCompare (Value *left, Value *right, OpType type, Value *result)
+{
+	int cmp = 0;
+
+	if(left->dt != right->dt)
+		THROW(RC_RM_COMPARE_VALUE_OF_DIFFERENT_DATATYPE, "comparison only supported for values of the same datatype");
+
+	result->dt = DT_BOOL;
+
+	// unordered floats only differ
+	if ((left->dt == DT_FLOAT && (left->v.floatV != left->v.floatV || right->v.floatV != right->v.floatV))
+			|| (left->dt == DT_DOUBLE && (left->v.doubleV != left->v.doubleV
+					|| right->v.doubleV != right->v.doubleV)))
+	{
+		result->v.boolV = (type == OP_COMP_NOT_EQUAL);
+		return RC_OK;
+	}
+
+	switch(left->dt) {
+	case DT_INT:
+		cmp = (left->v.intV > right->v.intV) - (left->v.intV < right->v.intV);
+		break;
+	case DT_FLOAT:
+		cmp = (left->v.floatV > right->v.floatV) - (left->v.floatV < right->v.floatV);
+		break;
+	case DT_BOOL:
+		cmp = (left->v.boolV > right->v.boolV) - (left->v.boolV < right->v.boolV);
+		break;
+	case DT_STRING:
+		cmp = strcmp(left->v.stringV, right->v.stringV);
+		break;
+	case DT_DATE:
+		cmp = (left->v.intV > right->v.intV) - (left->v.intV < right->v.intV);
+		break;
+	case DT_LONG:
+	case DT_TIMESTAMP:
+		cmp = (left->v.longV > right->v.longV) - (left->v.longV < right->v.longV);
+		break;
+	case DT_DOUBLE:
+		cmp = (left->v.doubleV > right->v.doubleV) - (left->v.doubleV < right->v.doubleV);
+		break;
+	default:
+		THROW(RC_RM_UNKOWN_DATATYPE, "unknown datatype");
+	}
+
+	switch(type) {
+	case OP_COMP_EQUAL:
+		result->v.boolV = (cmp == 0);
+		break;
+	case OP_COMP_NOT_EQUAL:
+		result->v.boolV = (cmp != 0);
+		break;
+	case OP_COMP_SMALLER:
+		result->v.boolV = (cmp < 0);
+		break;
+	case OP_COMP_SMALLER_EQUAL:
+		result->v.boolV = (cmp <= 0);
+		break;
+	case OP_COMP_GREATER:
+		result->v.boolV = (cmp > 0);
+		break;
+	case OP_COMP_GREATER_EQUAL:
+		result->v.boolV = (cmp >= 0);
+		break;
+	default:
+		return RC_PARAMS_ERROR;
 	}
 
 	return RC_OK;
 }
 
-RC 
+RC
 boolNot (Value *input, Value *result)
 {
 	if (input->dt != DT_BOOL)
@@ -74,6 +179,7 @@ boolAnd (Value *left, Value *right, Value *result)
 {
 	if (left->dt != DT_BOOL || right->dt != DT_BOOL)
 		THROW(RC_RM_BOOLEAN_EXPR_ARG_IS_NOT_BOOLEAN, "boolean AND requires boolean inputs");
+	result->dt = DT_BOOL;
 	result->v.boolV = (left->v.boolV && right->v.boolV);
 
 	return RC_OK;
@@ -84,89 +190,1775 @@ boolOr (Value *left, Value *right, Value *result)
 {
 	if (left->dt != DT_BOOL || right->dt != DT_BOOL)
 		THROW(RC_RM_BOOLEAN_EXPR_ARG_IS_NOT_BOOLEAN, "boolean OR requires boolean inputs");
+	result->dt = DT_BOOL;
 	result->v.boolV = (left->v.boolV || right->v.boolV);
 
 	return RC_OK;
 }
 
+static int compareStrings (ExprReg *left, ExprReg *right);
+static bool matchComparison (int cmp, OpType type);
+
+// apply a comparison to two evaluated values, strings are compared as views
+// of the given lengths
+static RC
+compareViews (Value *left, int lLen, Value *right, int rLen, OpType type, bool *match)
+{
+	Value cmp;
+	RC rc;
+
+	if (left->dt == DT_STRING && right->dt == DT_STRING)
+	{
+		ExprReg l, r;
+		l.stringV = left->v.stringV;
+		l.length = lLen;
+		r.stringV = right->v.stringV;
+		r.length = rLen;
+		*match = matchComparison(compareStrings(&l, &r), type);
+		return RC_OK;
+	}
+	rc = valueCompare(left, right, type, &cmp);
+	if (rc != RC_OK)
+		return rc;
+	*match = cmp.v.boolV;
+	return RC_OK;
+}
+
+// evaluate an expression into the given value without allocating, a string
+// result is a view of *length bytes into the record or into a constant
+static RC
+evalView (Record *record, Schema *schema, Expr *expr, Value *result, int *length)
+{
+	Value left, right;
+	int lLen = 0, rLen = 0, i;
+	RC rc;
+
+	switch(expr->type)
+	{
+	case EXPR_CONST:
+		*result = *expr->expr.cons;
+		if (result->dt == DT_STRING)
+			*length = strlen(result->v.stringV);
+		return RC_OK;
+	case EXPR_ATTRREF:
+		return getAttrView(record, schema, expr->expr.attrRef, result, length);
+	default:
+		break;
+	}
+
+	Operator *op = expr->expr.op;
+	rc = evalView(record, schema, op->args[0], &left, &lLen);
+	if (rc != RC_OK)
+		return rc;
+
+	switch(op->type)
+	{
+	case OP_BOOL_NOT:
+		return boolNot(&left, result);
+	case OP_BOOL_AND:
+	case OP_BOOL_OR:
+		// AND and OR do not evaluate their right side once the left side
+		// decides them
+		if (left.dt == DT_BOOL && left.v.boolV == (op->type == OP_BOOL_OR))
+		{
+			result->dt = DT_BOOL;
+			result->v.boolV = left.v.boolV;
+			return RC_OK;
+		}
+		rc = evalView(record, schema, op->args[1], &right, &rLen);
+		if (rc != RC_OK)
+			return rc;
+		if (op->type == OP_BOOL_AND)
+			return boolAnd(&left, &right, result);
+		return boolOr(&left, &right, result);
+	default:
+		break;
+	}
+
+	// a comparison holds if every comparison with the other arguments holds,
+	// IN if any of its values is equal. the remaining arguments are only
+	// evaluated until the result is known.
+	result->dt = DT_BOOL;
+	result->v.boolV = (op->type != OP_COMP_IN);
+	for(i = 1; i < op->numArgs; i++)
+	{
+		OpType type = op->type;
+		bool match;
+		if (op->type == OP_COMP_IN)
+			type = OP_COMP_EQUAL;
+		else if (op->type == OP_COMP_BETWEEN)
+			type = i == 1 ? OP_COMP_GREATER_EQUAL : OP_COMP_SMALLER_EQUAL;
+
+		rc = evalView(record, schema, op->args[i], &right, &rLen);
+		if (rc == RC_OK)
+			rc = compareViews(&left, lLen, &right, rLen, type, &match);
+		if (rc != RC_OK)
+			return rc;
+		if (match == (op->type == OP_COMP_IN))
+		{
+			result->v.boolV = match;
+			break;
+		}
+	}
+	return RC_OK;
+}
+
+// the intermediate values of evalExpr live on the stack and strings are
+// compared in place, only the result is allocated
 RC
 evalExpr (Record *record, Schema *schema, Expr *expr, Value **result)
 {
-	Value *lIn;
-	Value *rIn;
-	MAKE_VALUE(*result, DT_INT, -1);
+	Value value;
+	int length = 0;
+
+	*result = NULL;
+	RC rc = evalView(record, schema, expr, &value, &length);
+	if (rc != RC_OK)
+		return rc;
+
+	*result = (Value *) malloc(sizeof(Value));
+	**result = value;
+	if (value.dt == DT_STRING)
+	{
+		(*result)->v.stringV = (char *) malloc(length + 1);
+		memcpy((*result)->v.stringV, value.v.stringV, length);
+		(*result)->v.stringV[length] = '\0';
+	}
+	return RC_OK;
+}
+
+// same as evalExpr but the result is allocated from the arena, it stays valid
+// until the arena is reset and must not be freed with freeVal
+RC
+evalExprArena (Record *record, Schema *schema, Expr *expr, ExprArena *arena, Value **result)
+{
+	Value value;
+	int length = 0;
+
+	if (arena == NULL || result == NULL)
+		return RC_PARAMS_ERROR;
+	*result = NULL;
+	RC rc = evalView(record, schema, expr, &value, &length);
+	if (rc != RC_OK)
+		return rc;
+
+	Value *copy = (Value *) allocExprArena(arena, sizeof(Value));
+	if (copy == NULL)
+		return RC_ALLOC_MEM_FAIL;
+	*copy = value;
+	// a view into the record is not terminated
+	if (value.dt == DT_STRING)
+	{
+		copy->v.stringV = (char *) allocExprArena(arena, length + 1);
+		if (copy->v.stringV == NULL)
+			return RC_ALLOC_MEM_FAIL;
+		memcpy(copy->v.stringV, value.v.stringV, length);
+		copy->v.stringV[length] = '\0';
+	}
+	*result = copy;
+	return RC_OK;
+}
+
+// create an arena whose block has the given size
+RC
+createExprArena (ExprArena **arena, size_t size)
+{
+	if (arena == NULL)
+		return RC_PARAMS_ERROR;
+	if (size == 0)
+		size = EXPR_ARENA_SIZE;
+
+	ExprArena *result = (ExprArena *) calloc(1, sizeof(ExprArena));
+	if (result == NULL)
+		return RC_ALLOC_MEM_FAIL;
+	result->data = (char *) malloc(size);
+	if (result->data == NULL)
+	{
+		free(result);
+		return RC_ALLOC_MEM_FAIL;
+	}
+	result->size = size;
+	*arena = result;
+	return RC_OK;
+}
+
+// hand out size bytes aligned for any value, NULL if out of memory
+void *
+allocExprArena (ExprArena *arena, size_t size)
+{
+	size = (size + sizeof(double) - 1) & ~(sizeof(double) - 1);
+	if (arena->used + size <= arena->size)
+	{
+		void *result = arena->data + arena->used;
+		arena->used += size;
+		return result;
+	}
+
+	// the block is full, the link to the previous allocation comes first
+	void **extra = (void **) malloc(sizeof(double) + size);
+	if (extra == NULL)
+		return NULL;
+	*extra = arena->extra;
+	arena->extra = extra;
+	arena->spilled += size;
+	return (char *) extra + sizeof(double);
+}
+
+// release everything allocated from the arena
+RC
+resetExprArena (ExprArena *arena)
+{
+	if (arena == NULL)
+		return RC_PARAMS_ERROR;
+
+	while(arena->extra != NULL)
+	{
+		void **extra = (void **) arena->extra;
+		arena->extra = *extra;
+		free(extra);
+	}
+	// grow the block so that the same amount fits without spilling
+	if (arena->spilled > 0)
+	{
+		char *data = (char *) malloc(arena->size + arena->spilled);
+		if (data != NULL)
+		{
+			free(arena->data);
+			arena->data = data;
+			arena->size += arena->spilled;
+		}
+	}
+	arena->used = 0;
+	arena->spilled = 0;
+	return RC_OK;
+}
+
+RC
+freeExprArena (ExprArena *arena)
+{
+	if (arena == NULL)
+		return RC_OK;
+	resetExprArena(arena);
+	free(arena->data);
+	free(arena);
+	return RC_OK;
+}
+
+// mark every attribute the expression refers to in attrs
+RC
+collectAttrRefs (Expr *expr, bool *attrs)
+{
+	int i;
 
 	switch(expr->type)
 	{
 	case EXPR_OP:
 	{
 		Operator *op = expr->expr.op;
-		bool twoArgs = (op->type != OP_BOOL_NOT);
-		//      lIn = (Value *) malloc(sizeof(Value));
-		//    rIn = (Value *) malloc(sizeof(Value));
+		for(i = 0; i < op->numArgs; i++)
+			collectAttrRefs(op->args[i], attrs);
+	}
+	break;
+	case EXPR_CONST:
+		break;
+	case EXPR_ATTRREF:
+		attrs[expr->expr.attrRef] = true;
+		break;
+	}
 
-		CHECK(evalExpr(record, schema, op->args[0], &lIn));
-		if (twoArgs)
-			CHECK(evalExpr(record, schema, op->args[1], &rIn));
+	return RC_OK;
+}
 
-		switch(op->type)
+// the comparison with swapped arguments, x < y is y > x
+static OpType
+swapComparison (OpType type)
+{
+	switch(type)
+	{
+	case OP_COMP_SMALLER:
+		return OP_COMP_GREATER;
+	case OP_COMP_SMALLER_EQUAL:
+		return OP_COMP_GREATER_EQUAL;
+	case OP_COMP_GREATER:
+		return OP_COMP_SMALLER;
+	case OP_COMP_GREATER_EQUAL:
+		return OP_COMP_SMALLER_EQUAL;
+	default:
+		return type;
+	}
+}
+
+// tighten one bound of the range, a bound replaces the old one if it
+// excludes more values
+static void
+tightenBound (KeyRange *range, bool low, Value *value, bool inclusive)
+{
+	Value *bound = low ? &range->low : &range->high;
+	bool *hasBound = low ? &range->hasLow : &range->hasHigh;
+	bool *boundInclusive = low ? &range->lowInclusive : &range->highInclusive;
+	Value cmp;
+
+	if (*hasBound)
+	{
+		// bounds of another datatype cannot be compared
+		if (valueCompare(value, bound, low ? OP_COMP_GREATER : OP_COMP_SMALLER, &cmp) != RC_OK)
+			return;
+		if (!cmp.v.boolV)
 		{
-		case OP_BOOL_NOT:
-			CHECK(boolNot(lIn, *result));
-			break;
-		case OP_BOOL_AND:
-			CHECK(boolAnd(lIn, rIn, *result));
-			break;
-		case OP_BOOL_OR:
-			CHECK(boolOr(lIn, rIn, *result));
-			break;
-		case OP_COMP_EQUAL:
-			CHECK(valueEquals(lIn, rIn, *result));
-			break;
-		case OP_COMP_SMALLER:
-			CHECK(valueSmaller(lIn, rIn, *result));
-			break;
-		default:
-			break;
+			valueEquals(value, bound, &cmp);
+			if (!cmp.v.boolV || inclusive)
+				return;
 		}
+	}
+	*hasBound = true;
+	*bound = *value;
+	*boundInclusive = inclusive;
+}
 
-		// cleanup
-		freeVal(lIn);
-		if (twoArgs)
-			freeVal(rIn);
+// narrow the range by a conjunct of the condition
+static void
+narrowKeyRange (Expr *expr, int attrNum, KeyRange *range)
+{
+	int i;
+
+	if (expr->type == EXPR_CONST)
+	{
+		if (expr->expr.cons->dt == DT_BOOL && !expr->expr.cons->v.boolV)
+			range->empty = true;
+		return;
+	}
+	if (expr->type != EXPR_OP)
+		return;
+
+	Operator *op = expr->expr.op;
+	Expr **args = op->args;
+	switch(op->type)
+	{
+	case OP_BOOL_AND:
+		narrowKeyRange(args[0], attrNum, range);
+		narrowKeyRange(args[1], attrNum, range);
+		return;
+	case OP_COMP_EQUAL:
+	case OP_COMP_SMALLER:
+	case OP_COMP_SMALLER_EQUAL:
+	case OP_COMP_GREATER:
+	case OP_COMP_GREATER_EQUAL:
+	{
+		OpType type = op->type;
+		Value *value;
+		// bring the attribute to the left
+		if (args[0]->type == EXPR_ATTRREF && args[0]->expr.attrRef == attrNum
+				&& args[1]->type == EXPR_CONST)
+			value = args[1]->expr.cons;
+		else if (args[1]->type == EXPR_ATTRREF && args[1]->expr.attrRef == attrNum
+				&& args[0]->type == EXPR_CONST)
+		{
+			value = args[0]->expr.cons;
+			type = swapComparison(type);
+		}
+		else
+			return;
+
+		if (type != OP_COMP_SMALLER && type != OP_COMP_SMALLER_EQUAL)
+			tightenBound(range, true, value, type != OP_COMP_GREATER);
+		if (type != OP_COMP_GREATER && type != OP_COMP_GREATER_EQUAL)
+			tightenBound(range, false, value, type != OP_COMP_SMALLER);
+		return;
+	}
+	case OP_COMP_BETWEEN:
+		if (args[0]->type != EXPR_ATTRREF || args[0]->expr.attrRef != attrNum)
+			return;
+		if (args[1]->type == EXPR_CONST)
+			tightenBound(range, true, args[1]->expr.cons, true);
+		if (args[2]->type == EXPR_CONST)
+			tightenBound(range, false, args[2]->expr.cons, true);
+		return;
+	case OP_COMP_IN:
+	{
+		// the smallest and the largest value of the list
+		Value *min = NULL, *max = NULL;
+		Value cmp;
+		if (args[0]->type != EXPR_ATTRREF || args[0]->expr.attrRef != attrNum)
+			return;
+		for(i = 1; i < op->numArgs; i++)
+		{
+			Value *value = args[i]->expr.cons;
+			if (args[i]->type != EXPR_CONST)
+				return;
+			if (min == NULL)
+			{
+				min = max = value;
+				continue;
+			}
+			if (valueCompare(value, min, OP_COMP_SMALLER, &cmp) != RC_OK)
+				return;
+			if (cmp.v.boolV)
+				min = value;
+			valueCompare(value, max, OP_COMP_GREATER, &cmp);
+			if (cmp.v.boolV)
+				max = value;
+		}
+		if (min != NULL)
+		{
+			tightenBound(range, true, min, true);
+			tightenBound(range, false, max, true);
+		}
+		return;
+	}
+	default:
+		// OR, NOT and != do not bound a single range
+		return;
+	}
+}
+
+// find the range of values of an attribute that can fulfill a condition, so
+// an access path only has to visit this range. only comparisons of the
+// attribute with constants that are combined by AND narrow the range.
+RC
+extractKeyRange (Expr *expr, int attrNum, KeyRange *range)
+{
+	Value cmp;
+
+	if (range == NULL)
+		return RC_PARAMS_ERROR;
+	memset(range, 0, sizeof(KeyRange));
+	if (expr == NULL)
+		return RC_OK;
+
+	narrowKeyRange(expr, attrNum, range);
+	if (range->hasLow && range->hasHigh
+			&& valueCompare(&range->low, &range->high, OP_COMP_GREATER_EQUAL, &cmp) == RC_OK
+			&& cmp.v.boolV)
+	{
+		valueEquals(&range->low, &range->high, &cmp);
+		if (!cmp.v.boolV || !range->lowInclusive || !range->highInclusive)
+			range->empty = true;
+	}
+	return RC_OK;
+}
+
+// count the nodes and constants of an expression
+static void
+countExpr (Expr *expr, int *numNodes, int *numConsts)
+{
+	int i;
+
+	*numNodes = *numNodes + 1;
+	switch(expr->type)
+	{
+	case EXPR_OP:
+	{
+		Operator *op = expr->expr.op;
+		for(i = 0; i < op->numArgs; i++)
+			countExpr(op->args[i], numNodes, numConsts);
+		// the skip instruction between the arguments of AND and OR, and the
+		// two comparisons of BETWEEN
+		if (op->type == OP_BOOL_AND || op->type == OP_BOOL_OR)
+			*numNodes = *numNodes + 1;
+		else if (op->type == OP_COMP_BETWEEN)
+			*numNodes = *numNodes + 2;
 	}
 	break;
 	case EXPR_CONST:
-		CPVAL(*result,expr->expr.cons);
+		*numConsts = *numConsts + 1;
 		break;
 	case EXPR_ATTRREF:
-		free(*result);
-		CHECK(getAttr(record, schema, expr->expr.attrRef, result));
 		break;
 	}
+}
 
-	return RC_OK;
+// default selectivities of comparisons when nothing is known about the data
+#define EQUAL_SELECTIVITY 0.1
+#define SMALLER_SELECTIVITY (1.0 / 3.0)
+#define BETWEEN_SELECTIVITY 0.25
+
+// an operator expression with room for numArgs arguments
+static Expr *
+makeOpExpr (OpType type, int numArgs)
+{
+	Expr *result = (Expr *) malloc(sizeof(Expr));
+	Operator *op = (Operator *) malloc(sizeof(Operator));
+	result->type = EXPR_OP;
+	result->expr.op = op;
+	op->type = type;
+	op->numArgs = numArgs;
+	op->args = (Expr **) malloc(numArgs * sizeof(Expr*));
+	return result;
 }
 
-RC
-freeExpr (Expr *expr)
+// deep copy of an expression, constants are copied as well
+static Expr *
+copyExpr (Expr *expr)
 {
+	Expr *result;
+	int i;
+
 	switch(expr->type)
 	{
 	case EXPR_OP:
 	{
 		Operator *op = expr->expr.op;
-		switch(op->type)
+		result = makeOpExpr(op->type, op->numArgs);
+		for(i = 0; i < op->numArgs; i++)
+			result->expr.op->args[i] = copyExpr(op->args[i]);
+	}
+	break;
+	case EXPR_CONST:
+	{
+		Value *cons = (Value *) malloc(sizeof(Value));
+		CPVAL(cons, expr->expr.cons);
+		MAKE_CONS(result, cons);
+	}
+	break;
+	default:
+		MAKE_ATTRREF(result, expr->expr.attrRef);
+		break;
+	}
+	return result;
+}
+
+// free an operator node but not its arguments
+static void
+freeOpNode (Expr *expr)
+{
+	free(expr->expr.op->args);
+	free(expr->expr.op);
+	free(expr);
+}
+
+static bool
+isBoolConst (Expr *expr)
+{
+	return expr->type == EXPR_CONST && expr->expr.cons->dt == DT_BOOL;
+}
+
+// the comparison accepting exactly the values the given one rejects, or -1
+// if there is none
+static int
+negateComparison (OpType type)
+{
+	switch(type)
+	{
+	case OP_COMP_EQUAL:
+		return OP_COMP_NOT_EQUAL;
+	case OP_COMP_NOT_EQUAL:
+		return OP_COMP_EQUAL;
+	case OP_COMP_SMALLER:
+		return OP_COMP_GREATER_EQUAL;
+	case OP_COMP_GREATER_EQUAL:
+		return OP_COMP_SMALLER;
+	case OP_COMP_GREATER:
+		return OP_COMP_SMALLER_EQUAL;
+	case OP_COMP_SMALLER_EQUAL:
+		return OP_COMP_GREATER;
+	default:
+		return -1;
+	}
+}
+
+// whether an operand may be a floating point NaN, which is unordered, so
+// NOT x < y is not x >= y. attributes outside the schema are assumed to be.
+static bool
+mayBeNaN (Expr *expr, Schema *schema)
+{
+	DataType dt;
+	switch(expr->type)
+	{
+	case EXPR_CONST:
+		dt = expr->expr.cons->dt;
+		break;
+	case EXPR_ATTRREF:
+		if (schema == NULL || expr->expr.attrRef >= schema->numAttr)
+			return true;
+		dt = schema->dataTypes[expr->expr.attrRef];
+		break;
+	default:
+		return false;
+	}
+	return dt == DT_FLOAT || dt == DT_DOUBLE;
+}
+
+// push negations down to the comparisons and fold the subtrees whose result
+// does not depend on the record, the expression is rewritten in place
+static Expr *
+simplifyExpr (Expr *expr, Schema *schema, bool negate)
+{
+	Expr *result;
+	int i;
+
+	switch(expr->type)
+	{
+	case EXPR_CONST:
+		if (negate && expr->expr.cons->dt == DT_BOOL)
+			expr->expr.cons->v.boolV = !expr->expr.cons->v.boolV;
+		return expr;
+	case EXPR_ATTRREF:
+		if (!negate)
+			return expr;
+		MAKE_UNOP_EXPR(result, expr, OP_BOOL_NOT);
+		return result;
+	default:
+		break;
+	}
+
+	Operator *op = expr->expr.op;
+	switch(op->type)
+	{
+	case OP_BOOL_NOT:
+		// NOT NOT x is x
+		result = simplifyExpr(op->args[0], schema, !negate);
+		freeOpNode(expr);
+		return result;
+	case OP_BOOL_AND:
+	case OP_BOOL_OR:
+	{
+		Expr *left = simplifyExpr(op->args[0], schema, negate);
+		Expr *right = simplifyExpr(op->args[1], schema, negate);
+		// De Morgan: NOT (x AND y) is NOT x OR NOT y
+		if (negate)
+			op->type = op->type == OP_BOOL_AND ? OP_BOOL_OR : OP_BOOL_AND;
+		op->args[0] = left;
+		op->args[1] = right;
+
+		// a constant operand either decides the result or can be dropped
+		bool decides = op->type == OP_BOOL_OR;
+		if (isBoolConst(left) || isBoolConst(right))
 		{
-		case OP_BOOL_NOT:
-			freeExpr(op->args[0]);
+			Expr *cons = isBoolConst(left) ? left : right;
+			Expr *other = cons == left ? right : left;
+			freeOpNode(expr);
+			if (cons->expr.cons->v.boolV == decides)
+			{
+				freeExpr(other);
+				return cons;
+			}
+			freeExpr(cons);
+			return other;
+		}
+		return expr;
+	}
+	default:
+	{
+		bool constant = true;
+		for(i = 0; i < op->numArgs; i++)
+		{
+			op->args[i] = simplifyExpr(op->args[i], schema, false);
+			constant = constant && op->args[i]->type == EXPR_CONST;
+		}
+		// compare constants once, a comparison of different datatypes is
+		// kept so that compiling reports it
+		if (constant)
+		{
+			Value *cmp;
+			if (evalExpr(NULL, NULL, expr, &cmp) == RC_OK)
+			{
+				cmp->v.boolV = cmp->v.boolV != negate;
+				MAKE_CONS(result, cmp);
+				freeExpr(expr);
+				return result;
+			}
+		}
+		if (!negate)
+			return expr;
+		// NOT x < y is x >= y, but NaN is neither. NOT x = y is x != y even
+		// for NaN.
+		if (negateComparison(op->type) >= 0
+				&& (op->type == OP_COMP_EQUAL || op->type == OP_COMP_NOT_EQUAL
+						|| (!mayBeNaN(op->args[0], schema) && !mayBeNaN(op->args[1], schema))))
+		{
+			op->type = negateComparison(op->type);
+			return expr;
+		}
+		MAKE_UNOP_EXPR(result, expr, OP_BOOL_NOT);
+		return result;
+	}
+	}
+}
+
+// estimate the fraction of records an expression accepts and the cost of
+// evaluating it, AND and OR only evaluate their right side if needed
+static void
+estimateExpr (Expr *expr, Schema *schema, double *selectivity, double *cost)
+{
+	double lSel, lCost, rSel, rCost;
+	int i;
+
+	switch(expr->type)
+	{
+	case EXPR_CONST:
+		*selectivity = expr->expr.cons->dt == DT_BOOL && !expr->expr.cons->v.boolV ? 0 : 1;
+		*cost = 0;
+		return;
+	case EXPR_ATTRREF:
+		*selectivity = 0.5;
+		// strings are compared byte by byte
+		*cost = schema != NULL && expr->expr.attrRef < schema->numAttr
+				&& (schema->dataTypes[expr->expr.attrRef] == DT_STRING
+					|| schema->dataTypes[expr->expr.attrRef] == DT_VARCHAR) ? 4 : 1;
+		return;
+	default:
+		break;
+	}
+
+	Operator *op = expr->expr.op;
+	estimateExpr(op->args[0], schema, &lSel, &lCost);
+	if (op->type == OP_BOOL_NOT)
+	{
+		*selectivity = 1 - lSel;
+		*cost = lCost;
+		return;
+	}
+	estimateExpr(op->args[1], schema, &rSel, &rCost);
+	switch(op->type)
+	{
+	case OP_BOOL_AND:
+		*selectivity = lSel * rSel;
+		*cost = lCost + lSel * rCost;
+		break;
+	case OP_BOOL_OR:
+		*selectivity = 1 - (1 - lSel) * (1 - rSel);
+		*cost = lCost + (1 - lSel) * rCost;
+		break;
+	case OP_COMP_EQUAL:
+		*selectivity = EQUAL_SELECTIVITY;
+		*cost = lCost + rCost + 1;
+		break;
+	case OP_COMP_NOT_EQUAL:
+		*selectivity = 1 - EQUAL_SELECTIVITY;
+		*cost = lCost + rCost + 1;
+		break;
+	case OP_COMP_BETWEEN:
+		*selectivity = BETWEEN_SELECTIVITY;
+		*cost = lCost + 2;
+		break;
+	case OP_COMP_IN:
+	{
+		// long lists are hashed
+		int numValues = op->numArgs - 1;
+		*selectivity = numValues * EQUAL_SELECTIVITY < 0.5 ? numValues * EQUAL_SELECTIVITY : 0.5;
+		*cost = lCost + (numValues > EXPR_IN_HASH_MIN ? 2 : numValues / 2.0 + 1);
+	}
+	break;
+	default:
+		*selectivity = SMALLER_SELECTIVITY;
+		*cost = lCost + rCost + 1;
+		break;
+	}
+	for(i = 2; i < op->numArgs; i++)
+		if (op->type != OP_COMP_IN)
+		{
+			estimateExpr(op->args[i], schema, &rSel, &rCost);
+			*cost = *cost + rCost;
+		}
+}
+
+// the order of the arguments of AND and OR, cheap arguments that decide the
+// result most of the time come first
+static double
+rankExpr (Expr *expr, Schema *schema, OpType type)
+{
+	double selectivity, cost;
+	estimateExpr(expr, schema, &selectivity, &cost);
+	double decides = type == OP_BOOL_AND ? 1 - selectivity : selectivity;
+	if (decides <= 0)
+		return cost * 1e9;
+	return cost / decides;
+}
+
+// collect the arguments and the nodes of a chain of the same operator
+static void
+collectChain (Expr *expr, OpType type, Expr **terms, int *numTerms,
+		Expr **nodes, int *numNodes)
+{
+	if (expr->type == EXPR_OP && expr->expr.op->type == type)
+	{
+		nodes[(*numNodes)++] = expr;
+		collectChain(expr->expr.op->args[0], type, terms, numTerms, nodes, numNodes);
+		collectChain(expr->expr.op->args[1], type, terms, numTerms, nodes, numNodes);
+	}
+	else
+		terms[(*numTerms)++] = expr;
+}
+
+// sort the arguments of every chain of ANDs and ORs by their rank
+static Expr *
+reorderExpr (Expr *expr, Schema *schema)
+{
+	int i, j;
+
+	if (expr->type != EXPR_OP)
+		return expr;
+	Operator *op = expr->expr.op;
+	if (op->type != OP_BOOL_AND && op->type != OP_BOOL_OR)
+	{
+		for(i = 0; i < op->numArgs; i++)
+			op->args[i] = reorderExpr(op->args[i], schema);
+		return expr;
+	}
+
+	int numNodes = 0, numTerms = 0, size = 0;
+	countExpr(expr, &size, &numTerms);
+	Expr *nodes[size];
+	Expr *terms[size];
+	double ranks[size];
+	numTerms = 0;
+	collectChain(expr, op->type, terms, &numTerms, nodes, &numNodes);
+
+	for(i = 0; i < numTerms; i++)
+	{
+		terms[i] = reorderExpr(terms[i], schema);
+		ranks[i] = rankExpr(terms[i], schema, op->type);
+	}
+	// insertion sort keeps equally ranked arguments in their order
+	for(i = 1; i < numTerms; i++)
+	{
+		Expr *term = terms[i];
+		double rank = ranks[i];
+		for(j = i; j > 0 && ranks[j - 1] > rank; j--)
+		{
+			terms[j] = terms[j - 1];
+			ranks[j] = ranks[j - 1];
+		}
+		terms[j] = term;
+		ranks[j] = rank;
+	}
+
+	// rebuild the chain as x1 op (x2 op (... op xn))
+	for(i = 0; i < numNodes; i++)
+	{
+		nodes[i]->expr.op->args[0] = terms[i];
+		nodes[i]->expr.op->args[1] = i + 1 < numNodes ? nodes[i + 1] : terms[i + 1];
+	}
+	return nodes[0];
+}
+
+// rewrite a copy of an expression so that it is cheaper to evaluate: NOTs are
+// pushed down to the comparisons, subtrees that do not depend on the record
+// are folded into constants and the arguments of AND and OR are ordered by
+// their estimated selectivity and cost. the caller frees the result.
+RC
+optimizeExpr (Expr *expr, Schema *schema, Expr **result)
+{
+	if (expr == NULL || result == NULL)
+		return RC_PARAMS_ERROR;
+
+	*result = reorderExpr(simplifyExpr(copyExpr(expr), schema, false), schema);
+	return RC_OK;
+}
+
+// the register form of a constant
+static void
+makeConstReg (Value *cons, ExprReg *reg)
+{
+	memset(reg, 0, sizeof(ExprReg));
+	if (cons->dt == DT_STRING)
+	{
+		reg->stringV = cons->v.stringV;
+		reg->length = strlen(cons->v.stringV);
+	}
+	else if (cons->dt == DT_INT || cons->dt == DT_DATE)
+		reg->v.intV = cons->v.intV;
+	else if (cons->dt == DT_FLOAT)
+		reg->v.floatV = cons->v.floatV;
+	else if (cons->dt == DT_LONG || cons->dt == DT_TIMESTAMP)
+		reg->v.longV = cons->v.longV;
+	else if (cons->dt == DT_DOUBLE)
+		reg->v.doubleV = cons->v.doubleV;
+	else
+		reg->v.boolV = cons->v.boolV;
+}
+
+// whether values of the datatype take 8 bytes and are loaded with
+// EXPR_LOAD_WIDE
+static bool
+isWideType (DataType dt)
+{
+	return dt == DT_LONG || dt == DT_DOUBLE || dt == DT_TIMESTAMP;
+}
+
+// the instruction comparing two values of the datatype
+static ExprOpcode
+compareOpcode (DataType dt)
+{
+	switch(dt)
+	{
+	case DT_STRING:
+		return EXPR_COMPARE_STRING;
+	case DT_FLOAT:
+		return EXPR_COMPARE_FLOAT;
+	case DT_LONG:
+	case DT_TIMESTAMP:
+		return EXPR_COMPARE_LONG;
+	case DT_DOUBLE:
+		return EXPR_COMPARE_DOUBLE;
+	default:
+		return EXPR_COMPARE_INT;
+	}
+}
+
+// hash a register of the given datatype, equal values hash alike
+static unsigned
+hashReg (DataType dt, ExprReg *reg)
+{
+	unsigned hash = 2166136261u;
+	int i, length;
+
+	if (isWideType(dt))
+	{
+		union reg bits;
+		bits.longV = reg->v.longV;
+		if (dt == DT_DOUBLE)
+			bits.doubleV = reg->v.doubleV + 0.0;
+		return ((unsigned) bits.longV ^ (unsigned) ((uint64_t) bits.longV >> 32)) * 2654435761u;
+	}
+	if (dt != DT_STRING)
+	{
+		union reg bits;
+		bits.intV = reg->v.intV;
+		// 0.0 and -0.0 are equal
+		if (dt == DT_FLOAT)
+			bits.floatV = reg->v.floatV + 0.0f;
+		return ((unsigned) bits.intV) * 2654435761u;
+	}
+	length = strnlen(reg->stringV, reg->length);
+	for(i = 0; i < length; i++)
+		hash = (hash ^ (unsigned char) reg->stringV[i]) * 16777619u;
+	return hash;
+}
+
+// compile the constants of an IN list into a set of the program
+static RC
+compileSet (Operator *op, DataType dt, ExprProgram *program, int *set)
+{
+	ExprSet *result = &program->sets[program->numSets];
+	int i;
+
+	memset(result, 0, sizeof(ExprSet));
+	result->dt = dt;
+	result->values = (ExprReg *) malloc((op->numArgs - 1) * sizeof(ExprReg));
+	if (result->values == NULL)
+		return RC_ALLOC_MEM_FAIL;
+	*set = program->numSets++;
+
+	for(i = 1; i < op->numArgs; i++)
+	{
+		Expr *arg = op->args[i];
+		if (arg->type != EXPR_CONST)
+			return RC_PARAMS_ERROR;
+		if (arg->expr.cons->dt != dt)
+			THROW(RC_RM_COMPARE_VALUE_OF_DIFFERENT_DATATYPE, "IN only supported for values of the same datatype");
+		makeConstReg(arg->expr.cons, &result->values[result->numValues++]);
+	}
+
+	if (result->numValues <= EXPR_IN_HASH_MIN)
+		return RC_OK;
+	// at most half of the slots are used
+	result->numSlots = 1;
+	while(result->numSlots < 2 * result->numValues)
+		result->numSlots = result->numSlots * 2;
+	result->slots = (int *) malloc(result->numSlots * sizeof(int));
+	if (result->slots == NULL)
+		return RC_ALLOC_MEM_FAIL;
+	memset(result->slots, -1, result->numSlots * sizeof(int));
+	for(i = 0; i < result->numValues; i++)
+	{
+		unsigned slot = hashReg(dt, &result->values[i]) & (result->numSlots - 1);
+		while(result->slots[slot] >= 0)
+			slot = (slot + 1) & (result->numSlots - 1);
+		result->slots[slot] = i;
+	}
+	return RC_OK;
+}
+
+// append the instructions of an expression in post order, reg and dt receive
+// the register and datatype of its result
+static RC
+compileNode (Expr *expr, Schema *schema, ExprProgram *program, int *numConsts,
+		int *reg, DataType *dt)
+{
+	ExprInstr instr;
+	memset(&instr, 0, sizeof(ExprInstr));
+
+	switch(expr->type)
+	{
+	case EXPR_OP:
+	{
+		Operator *op = expr->expr.op;
+		bool twoArgs = (op->type != OP_BOOL_NOT && op->type != OP_COMP_IN);
+		DataType lDt, rDt = DT_BOOL;
+		int skip = -1;
+
+		RC rc = compileNode(op->args[0], schema, program, numConsts, &instr.left, &lDt);
+		if (rc != RC_OK)
+			return rc;
+		// AND and OR skip their right side once the left side decides them,
+		// the target is patched in after the right side
+		if (op->type == OP_BOOL_AND || op->type == OP_BOOL_OR)
+		{
+			ExprInstr *skipInstr = &program->instrs[program->numInstrs];
+			memset(skipInstr, 0, sizeof(ExprInstr));
+			skipInstr->code = op->type == OP_BOOL_AND ? EXPR_SKIP_IF_FALSE : EXPR_SKIP_IF_TRUE;
+			skipInstr->left = instr.left;
+			skip = program->numInstrs++;
+		}
+		if (twoArgs)
+		{
+			rc = compileNode(op->args[1], schema, program, numConsts, &instr.right, &rDt);
+			if (rc != RC_OK)
+				return rc;
+		}
+		if (skip >= 0)
+			program->instrs[skip].right = program->numInstrs;
+
+		switch(op->type)
+		{
+		case OP_BOOL_NOT:
+		case OP_BOOL_AND:
+		case OP_BOOL_OR:
+			if (lDt != DT_BOOL || rDt != DT_BOOL)
+				THROW(RC_RM_BOOLEAN_EXPR_ARG_IS_NOT_BOOLEAN, "boolean operators require boolean inputs");
+			instr.code = op->type == OP_BOOL_NOT ? EXPR_NOT
+					: op->type == OP_BOOL_AND ? EXPR_AND : EXPR_OR;
+			break;
+		case OP_COMP_IN:
+			instr.code = EXPR_IN;
+			rc = compileSet(op, lDt, program, &instr.right);
+			if (rc != RC_OK)
+				return rc;
+			break;
+		case OP_COMP_BETWEEN:
+		{
+			// value >= low AND value <= high
+			int high;
+			DataType hDt;
+			rc = compileNode(op->args[2], schema, program, numConsts, &high, &hDt);
+			if (rc != RC_OK)
+				return rc;
+			if (lDt != rDt || lDt != hDt)
+				THROW(RC_RM_COMPARE_VALUE_OF_DIFFERENT_DATATYPE, "comparison only supported for values of the same datatype");
+			instr.code = compareOpcode(lDt);
+			instr.cmp = OP_COMP_GREATER_EQUAL;
+			program->instrs[program->numInstrs++] = instr;
+			instr.cmp = OP_COMP_SMALLER_EQUAL;
+			instr.right = high;
+			program->instrs[program->numInstrs++] = instr;
+			instr.code = EXPR_AND;
+			instr.left = program->numInstrs - 2;
+			instr.right = program->numInstrs - 1;
+		}
+		break;
+		case OP_COMP_EQUAL:
+		case OP_COMP_SMALLER:
+		case OP_COMP_SMALLER_EQUAL:
+		case OP_COMP_GREATER:
+		case OP_COMP_GREATER_EQUAL:
+		case OP_COMP_NOT_EQUAL:
+			if (lDt != rDt)
+				THROW(RC_RM_COMPARE_VALUE_OF_DIFFERENT_DATATYPE, "comparison only supported for values of the same datatype");
+			instr.code = compareOpcode(lDt);
+			instr.cmp = op->type;
+			break;
+		default:
+			return RC_PARAMS_ERROR;
+		}
+		*dt = DT_BOOL;
+	}
+	break;
+	case EXPR_CONST:
+	{
+		Value *cons = expr->expr.cons;
+		makeConstReg(cons, &program->consts[*numConsts]);
+		instr.code = EXPR_LOAD_CONST;
+		instr.left = *numConsts;
+		// the lanes of a block have the width of the constant
+		instr.length = isWideType(cons->dt) ? 8 : 4;
+		*numConsts = *numConsts + 1;
+		*dt = cons->dt;
+	}
+	break;
+	case EXPR_ATTRREF:
+	{
+		int attrNum = expr->expr.attrRef;
+		if (schema == NULL || attrNum < 0 || attrNum >= schema->numAttr)
+			return RC_PARAMS_ERROR;
+		attrOffset(schema, attrNum, &instr.offset);
+		*dt = schema->dataTypes[attrNum];
+		// the same sizes getAttr reads
+		switch(*dt)
+		{
+		case DT_VARCHAR:
+			// its record data is a padded string
+			*dt = DT_STRING;
+			// fall through
+		case DT_STRING:
+			instr.code = EXPR_LOAD_STRING;
+			instr.length = schema->typeLength[attrNum];
+			break;
+		case DT_INT:
+			instr.code = EXPR_LOAD_NUM;
+			instr.length = sizeof(int);
+			break;
+		case DT_FLOAT:
+			instr.code = EXPR_LOAD_NUM;
+			instr.length = sizeof(float);
+			break;
+		case DT_BOOL:
+			instr.code = EXPR_LOAD_NUM;
+			instr.length = sizeof(bool);
+			break;
+		case DT_DATE:
+			instr.code = EXPR_LOAD_NUM;
+			instr.length = sizeof(int);
+			break;
+		case DT_LONG:
+		case DT_DOUBLE:
+		case DT_TIMESTAMP:
+			instr.code = EXPR_LOAD_WIDE;
+			instr.length = 8;
+			break;
+		}
+	}
+	break;
+	}
+
+	*reg = program->numInstrs;
+	program->instrs[program->numInstrs++] = instr;
+	return RC_OK;
+}
+
+// compile an expression into a flat program for the given schema, the
+// attribute offsets and datatypes are resolved once so that evaluating it
+// does not allocate. string constants are not copied, the expression has to
+// outlive the program.
+RC
+compileExpr (Expr *expr, Schema *schema, ExprProgram **program)
+{
+	int numNodes = 0, numConsts = 0, reg;
+	DataType dt;
+	ExprProgram *result;
+
+	if (expr == NULL || program == NULL)
+		return RC_PARAMS_ERROR;
+
+	countExpr(expr, &numNodes, &numConsts);
+	result = (ExprProgram *) calloc(1, sizeof(ExprProgram));
+	if (result == NULL)
+		return RC_ALLOC_MEM_FAIL;
+	result->instrs = (ExprInstr *) malloc(numNodes * sizeof(ExprInstr));
+	result->consts = (ExprReg *) malloc((numConsts + 1) * sizeof(ExprReg));
+	// there are less IN lists than nodes
+	result->sets = (ExprSet *) malloc(numNodes * sizeof(ExprSet));
+	if (result->instrs == NULL || result->consts == NULL || result->sets == NULL)
+	{
+		freeExprProgram(result);
+		return RC_ALLOC_MEM_FAIL;
+	}
+
+	numConsts = 0;
+	RC rc = compileNode(expr, schema, result, &numConsts, &reg, &dt);
+	if (rc == RC_OK && dt != DT_BOOL)
+		rc = RC_RM_EXPR_RESULT_IS_NOT_BOOLEAN;
+	if (rc != RC_OK)
+	{
+		freeExprProgram(result);
+		return rc;
+	}
+
+	*program = result;
+	return RC_OK;
+}
+
+// load a number attribute into a register, a single load of its binary form.
+// floats keep their bits and booleans become 0 or 1.
+static int
+loadNum (char *data, int length)
+{
+	if (length == sizeof(bool))
+		return data[0] != 0;
+	return readAttrInt(data);
+}
+
+// compare two strings of at most the given lengths like strcmp
+static int
+compareStrings (ExprReg *left, ExprReg *right)
+{
+	int lLen = strnlen(left->stringV, left->length);
+	int rLen = strnlen(right->stringV, right->length);
+	int cmp = memcmp(left->stringV, right->stringV, lLen < rLen ? lLen : rLen);
+	if (cmp != 0)
+		return cmp;
+	return lLen - rLen;
+}
+
+// whether the outcome of a three-way comparison fulfills the operator
+static bool
+matchComparison (int cmp, OpType type)
+{
+	switch(type)
+	{
+	case OP_COMP_EQUAL:
+		return cmp == 0;
+	case OP_COMP_NOT_EQUAL:
+		return cmp != 0;
+	case OP_COMP_SMALLER:
+		return cmp < 0;
+	case OP_COMP_SMALLER_EQUAL:
+		return cmp <= 0;
+	case OP_COMP_GREATER:
+		return cmp > 0;
+	default:
+		return cmp >= 0;
+	}
+}
+
+// floats are compared directly so that unordered values only differ
+static bool
+compareFloats (float left, float right, OpType type)
+{
+	switch(type)
+	{
+	case OP_COMP_EQUAL:
+		return left == right;
+	case OP_COMP_NOT_EQUAL:
+		return left != right;
+	case OP_COMP_SMALLER:
+		return left < right;
+	case OP_COMP_SMALLER_EQUAL:
+		return left <= right;
+	case OP_COMP_GREATER:
+		return left > right;
+	default:
+		return left >= right;
+	}
+}
+
+// doubles are compared directly so that unordered values only differ
+static bool
+compareDoubles (double left, double right, OpType type)
+{
+	switch(type)
+	{
+	case OP_COMP_EQUAL:
+		return left == right;
+	case OP_COMP_NOT_EQUAL:
+		return left != right;
+	case OP_COMP_SMALLER:
+		return left < right;
+	case OP_COMP_SMALLER_EQUAL:
+		return left <= right;
+	case OP_COMP_GREATER:
+		return left > right;
+	default:
+		return left >= right;
+	}
+}
+
+// whether two registers of the given datatype hold equal values
+static bool
+regsEqual (DataType dt, ExprReg *left, ExprReg *right)
+{
+	switch(dt)
+	{
+	case DT_STRING:
+		return compareStrings(left, right) == 0;
+	case DT_FLOAT:
+		return left->v.floatV == right->v.floatV;
+	case DT_LONG:
+	case DT_TIMESTAMP:
+		return left->v.longV == right->v.longV;
+	case DT_DOUBLE:
+		return left->v.doubleV == right->v.doubleV;
+	default:
+		return left->v.intV == right->v.intV;
+	}
+}
+
+// whether the register holds one of the values of the set
+static bool
+setContains (ExprSet *set, ExprReg *reg)
+{
+	int i;
+
+	if (set->numSlots == 0)
+	{
+		for(i = 0; i < set->numValues; i++)
+			if (regsEqual(set->dt, reg, &set->values[i]))
+				return true;
+		return false;
+	}
+	unsigned slot = hashReg(set->dt, reg) & (set->numSlots - 1);
+	while(set->slots[slot] >= 0)
+	{
+		if (regsEqual(set->dt, reg, &set->values[set->slots[slot]]))
+			return true;
+		slot = (slot + 1) & (set->numSlots - 1);
+	}
+	return false;
+}
+
+// evaluate a compiled expression on the data of a record, the registers live
+// on the stack so programs can be shared by concurrent scans
+RC
+evalExprProgram (ExprProgram *program, Record *record, bool *result)
+{
+	ExprReg regs[program->numInstrs];
+	int i;
+
+	for(i = 0; i < program->numInstrs; i++)
+	{
+		ExprInstr *instr = &program->instrs[i];
+		ExprReg *reg = &regs[i];
+		ExprReg *left = &regs[instr->left];
+		ExprReg *right = &regs[instr->right];
+
+		switch(instr->code)
+		{
+		case EXPR_LOAD_CONST:
+			*reg = program->consts[instr->left];
+			break;
+		case EXPR_LOAD_NUM:
+			reg->v.intV = loadNum(record->data + instr->offset, instr->length);
+			break;
+		case EXPR_LOAD_WIDE:
+			// doubles keep their bits
+			reg->v.longV = readAttrLong(record->data + instr->offset);
+			break;
+		case EXPR_LOAD_STRING:
+			reg->stringV = record->data + instr->offset;
+			reg->length = instr->length;
+			break;
+		case EXPR_COMPARE_INT:
+			reg->v.boolV = matchComparison((left->v.intV > right->v.intV)
+					- (left->v.intV < right->v.intV), instr->cmp);
+			break;
+		case EXPR_COMPARE_FLOAT:
+			reg->v.boolV = compareFloats(left->v.floatV, right->v.floatV, instr->cmp);
+			break;
+		case EXPR_COMPARE_LONG:
+			reg->v.boolV = matchComparison((left->v.longV > right->v.longV)
+					- (left->v.longV < right->v.longV), instr->cmp);
+			break;
+		case EXPR_COMPARE_DOUBLE:
+			reg->v.boolV = compareDoubles(left->v.doubleV, right->v.doubleV, instr->cmp);
+			break;
+		case EXPR_COMPARE_STRING:
+			reg->v.boolV = matchComparison(compareStrings(left, right), instr->cmp);
+			break;
+		case EXPR_IN:
+			reg->v.boolV = setContains(&program->sets[instr->right], left);
+			break;
+		case EXPR_NOT:
+			reg->v.boolV = !(left->v.boolV);
+			break;
+		case EXPR_AND:
+			reg->v.boolV = (left->v.boolV && right->v.boolV);
+			break;
+		case EXPR_OR:
+			reg->v.boolV = (left->v.boolV || right->v.boolV);
+			break;
+		case EXPR_SKIP_IF_FALSE:
+		case EXPR_SKIP_IF_TRUE:
+			if (left->v.boolV == (instr->code == EXPR_SKIP_IF_TRUE))
+			{
+				regs[instr->right].v.boolV = left->v.boolV;
+				i = instr->right;
+			}
+			break;
+		}
+	}
+
+	*result = regs[program->numInstrs - 1].v.boolV;
+	return RC_OK;
+}
+
+// a register of a block holds one value per record, numbers keep the bits of
+// the scalar registers and booleans are stored as 0 or 1
+typedef union ExprColumn {
+	int intV[EXPR_BLOCK_SIZE];
+	float floatV[EXPR_BLOCK_SIZE];
+	int64_t longV[EXPR_BLOCK_SIZE];
+	double doubleV[EXPR_BLOCK_SIZE];
+} ExprColumn;
+
+#ifdef EXPR_X86_SIMD
+// compare 8 lanes at a time, only used if the cpu supports it
+__attribute__((target("avx2"))) static uint64_t
+compareColumnsAVX2 (ExprOpcode code, OpType type, ExprColumn *left, ExprColumn *right, int lanes)
+{
+	uint64_t mask = 0;
+	int i;
+	for(i = 0; i < lanes; i += 8)
+	{
+		unsigned bits;
+		if (code == EXPR_COMPARE_FLOAT)
+		{
+			__m256 l = _mm256_loadu_ps(left->floatV + i);
+			__m256 r = _mm256_loadu_ps(right->floatV + i);
+			switch(type)
+			{
+			case OP_COMP_EQUAL:
+				bits = _mm256_movemask_ps(_mm256_cmp_ps(l, r, _CMP_EQ_OQ));
+				break;
+			case OP_COMP_NOT_EQUAL:
+				bits = _mm256_movemask_ps(_mm256_cmp_ps(l, r, _CMP_NEQ_UQ));
+				break;
+			case OP_COMP_SMALLER:
+				bits = _mm256_movemask_ps(_mm256_cmp_ps(l, r, _CMP_LT_OQ));
+				break;
+			case OP_COMP_SMALLER_EQUAL:
+				bits = _mm256_movemask_ps(_mm256_cmp_ps(l, r, _CMP_LE_OQ));
+				break;
+			case OP_COMP_GREATER:
+				bits = _mm256_movemask_ps(_mm256_cmp_ps(l, r, _CMP_GT_OQ));
+				break;
+			default:
+				bits = _mm256_movemask_ps(_mm256_cmp_ps(l, r, _CMP_GE_OQ));
+				break;
+			}
+		}
+		else
+		{
+			__m256i l = _mm256_loadu_si256((__m256i *) (left->intV + i));
+			__m256i r = _mm256_loadu_si256((__m256i *) (right->intV + i));
+			// <=, >= and != are the complements of >, < and =
+			switch(type)
+			{
+			case OP_COMP_EQUAL:
+			case OP_COMP_NOT_EQUAL:
+				bits = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(l, r)));
+				break;
+			case OP_COMP_SMALLER:
+			case OP_COMP_GREATER_EQUAL:
+				bits = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(r, l)));
+				break;
+			default:
+				bits = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(l, r)));
+				break;
+			}
+			if (type == OP_COMP_NOT_EQUAL || type == OP_COMP_GREATER_EQUAL
+					|| type == OP_COMP_SMALLER_EQUAL)
+				bits = ~bits & 0xff;
+		}
+		mask |= (uint64_t) bits << i;
+	}
+	return mask;
+}
+
+// compare 4 lanes at a time, SSE2 is part of every x86-64 cpu
+static uint64_t
+compareColumnsSSE2 (ExprOpcode code, OpType type, ExprColumn *left, ExprColumn *right, int lanes)
+{
+	uint64_t mask = 0;
+	int i;
+	for(i = 0; i < lanes; i += 4)
+	{
+		unsigned bits;
+		if (code == EXPR_COMPARE_FLOAT)
+		{
+			__m128 l = _mm_loadu_ps(left->floatV + i);
+			__m128 r = _mm_loadu_ps(right->floatV + i);
+			switch(type)
+			{
+			case OP_COMP_EQUAL:
+				bits = _mm_movemask_ps(_mm_cmpeq_ps(l, r));
+				break;
+			case OP_COMP_NOT_EQUAL:
+				bits = _mm_movemask_ps(_mm_cmpneq_ps(l, r));
+				break;
+			case OP_COMP_SMALLER:
+				bits = _mm_movemask_ps(_mm_cmplt_ps(l, r));
+				break;
+			case OP_COMP_SMALLER_EQUAL:
+				bits = _mm_movemask_ps(_mm_cmple_ps(l, r));
+				break;
+			case OP_COMP_GREATER:
+				bits = _mm_movemask_ps(_mm_cmpgt_ps(l, r));
+				break;
+			default:
+				bits = _mm_movemask_ps(_mm_cmpge_ps(l, r));
+				break;
+			}
+		}
+		else
+		{
+			__m128i l = _mm_loadu_si128((__m128i *) (left->intV + i));
+			__m128i r = _mm_loadu_si128((__m128i *) (right->intV + i));
+			switch(type)
+			{
+			case OP_COMP_EQUAL:
+			case OP_COMP_NOT_EQUAL:
+				bits = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(l, r)));
+				break;
+			case OP_COMP_SMALLER:
+			case OP_COMP_GREATER_EQUAL:
+				bits = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmplt_epi32(l, r)));
+				break;
+			default:
+				bits = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(l, r)));
+				break;
+			}
+			if (type == OP_COMP_NOT_EQUAL || type == OP_COMP_GREATER_EQUAL
+					|| type == OP_COMP_SMALLER_EQUAL)
+				bits = ~bits & 0xf;
+		}
+		mask |= (uint64_t) bits << i;
+	}
+	return mask;
+}
+#endif
+
+// compare the lanes of two number columns, lanes is a multiple of 8
+static uint64_t
+compareColumns (ExprOpcode code, OpType type, ExprColumn *left, ExprColumn *right, int lanes)
+{
+#ifdef EXPR_X86_SIMD
+	if (__builtin_cpu_supports("avx2"))
+		return compareColumnsAVX2(code, type, left, right, lanes);
+	return compareColumnsSSE2(code, type, left, right, lanes);
+#else
+	uint64_t mask = 0;
+	int i;
+	for(i = 0; i < lanes; i++)
+	{
+		bool match;
+		if (code == EXPR_COMPARE_FLOAT)
+			match = compareFloats(left->floatV[i], right->floatV[i], type);
+		else
+			match = matchComparison((left->intV[i] > right->intV[i])
+					- (left->intV[i] < right->intV[i]), type);
+		mask |= (uint64_t) match << i;
+	}
+	return mask;
+#endif
+}
+
+// one loop per operator so that the compiler can vectorize it
+#define COMPARE_LANES(_left, _right, _op)				\
+	do {								\
+		for(i = 0; i < count; i++)				\
+			mask |= (uint64_t) ((_left)[i] _op (_right)[i]) << i;	\
+	} while (0)
+
+// compare the lanes of two columns of 8-byte numbers
+static uint64_t
+compareWideColumns (ExprOpcode code, OpType type, ExprColumn *left, ExprColumn *right, int count)
+{
+	uint64_t mask = 0;
+	int i;
+
+	if (code == EXPR_COMPARE_DOUBLE)
+	{
+		double *l = left->doubleV, *r = right->doubleV;
+		switch(type)
+		{
+		case OP_COMP_EQUAL: COMPARE_LANES(l, r, ==); break;
+		case OP_COMP_NOT_EQUAL: COMPARE_LANES(l, r, !=); break;
+		case OP_COMP_SMALLER: COMPARE_LANES(l, r, <); break;
+		case OP_COMP_SMALLER_EQUAL: COMPARE_LANES(l, r, <=); break;
+		case OP_COMP_GREATER: COMPARE_LANES(l, r, >); break;
+		default: COMPARE_LANES(l, r, >=); break;
+		}
+		return mask;
+	}
+	int64_t *l = left->longV, *r = right->longV;
+	switch(type)
+	{
+	case OP_COMP_EQUAL: COMPARE_LANES(l, r, ==); break;
+	case OP_COMP_NOT_EQUAL: COMPARE_LANES(l, r, !=); break;
+	case OP_COMP_SMALLER: COMPARE_LANES(l, r, <); break;
+	case OP_COMP_SMALLER_EQUAL: COMPARE_LANES(l, r, <=); break;
+	case OP_COMP_GREATER: COMPARE_LANES(l, r, >); break;
+	default: COMPARE_LANES(l, r, >=); break;
+	}
+	return mask;
+}
+
+// the string operand of a comparison for the given record
+static void
+loadString (ExprProgram *program, int reg, Record *record, ExprReg *result)
+{
+	ExprInstr *instr = &program->instrs[reg];
+	if (instr->code == EXPR_LOAD_CONST)
+		*result = program->consts[instr->left];
+	else
+	{
+		result->stringV = record->data + instr->offset;
+		result->length = instr->length;
+	}
+}
+
+// evaluate a program on a block of at most EXPR_BLOCK_SIZE records, number
+// attributes are gathered into columns that are compared with SIMD
+// instructions, booleans are bitmaps combined a word at a time
+static uint64_t
+evalBlock (ExprProgram *program, Record *records, int count)
+{
+	ExprColumn cols[program->numInstrs];
+	uint64_t masks[program->numInstrs];
+	// the comparisons run on whole vectors, the padding lanes are zero
+	int lanes = (count + 7) & ~7;
+	uint64_t valid = count == EXPR_BLOCK_SIZE ? ~(uint64_t) 0 : ((uint64_t) 1 << count) - 1;
+	int i, j;
+
+	for(i = 0; i < program->numInstrs; i++)
+	{
+		ExprInstr *instr = &program->instrs[i];
+		ExprColumn *col = &cols[i];
+
+		switch(instr->code)
+		{
+		case EXPR_LOAD_CONST:
+		{
+			ExprReg *cons = &program->consts[instr->left];
+			if (instr->length == 8)
+				for(j = 0; j < lanes; j++)
+					col->longV[j] = cons->v.longV;
+			else
+				for(j = 0; j < lanes; j++)
+					col->intV[j] = cons->v.intV;
+			masks[i] = cons->v.boolV ? ~(uint64_t) 0 : 0;
+		}
+		break;
+		case EXPR_LOAD_WIDE:
+			masks[i] = 0;
+			for(j = 0; j < count; j++)
+				col->longV[j] = readAttrLong(records[j].data + instr->offset);
+			break;
+		case EXPR_COMPARE_LONG:
+		case EXPR_COMPARE_DOUBLE:
+			masks[i] = compareWideColumns(instr->code, instr->cmp, &cols[instr->left],
+					&cols[instr->right], count);
+			break;
+		case EXPR_LOAD_NUM:
+			masks[i] = 0;
+			for(j = 0; j < count; j++)
+			{
+				col->intV[j] = loadNum(records[j].data + instr->offset, instr->length);
+				// a boolean attribute may be an operand of AND, OR and NOT
+				masks[i] |= (uint64_t) (col->intV[j] != 0) << j;
+			}
+			for(; j < lanes; j++)
+				col->intV[j] = 0;
+			break;
+		case EXPR_LOAD_STRING:
+			// strings are compared in place
+			break;
+		case EXPR_COMPARE_STRING:
+			masks[i] = 0;
+			for(j = 0; j < count; j++)
+			{
+				ExprReg left, right;
+				loadString(program, instr->left, &records[j], &left);
+				loadString(program, instr->right, &records[j], &right);
+				if (matchComparison(compareStrings(&left, &right), instr->cmp))
+					masks[i] |= (uint64_t) 1 << j;
+			}
+			break;
+		case EXPR_IN:
+		{
+			ExprSet *set = &program->sets[instr->right];
+			masks[i] = 0;
+			for(j = 0; j < count; j++)
+			{
+				ExprReg value;
+				if (set->dt == DT_STRING)
+					loadString(program, instr->left, &records[j], &value);
+				else if (isWideType(set->dt))
+					value.v.longV = cols[instr->left].longV[j];
+				else
+					value.v.intV = cols[instr->left].intV[j];
+				if (setContains(set, &value))
+					masks[i] |= (uint64_t) 1 << j;
+			}
+		}
+		break;
+		case EXPR_NOT:
+			masks[i] = ~masks[instr->left];
+			break;
+		case EXPR_AND:
+			masks[i] = masks[instr->left] & masks[instr->right];
+			break;
+		case EXPR_OR:
+			masks[i] = masks[instr->left] | masks[instr->right];
+			break;
+		case EXPR_SKIP_IF_FALSE:
+			// no record of the block can fulfill the AND
+			if ((masks[instr->left] & valid) == 0)
+			{
+				masks[instr->right] = 0;
+				i = instr->right;
+			}
+			break;
+		case EXPR_SKIP_IF_TRUE:
+			if ((masks[instr->left] & valid) == valid)
+			{
+				masks[instr->right] = ~(uint64_t) 0;
+				i = instr->right;
+			}
 			break;
 		default:
-			freeExpr(op->args[0]);
-			freeExpr(op->args[1]);
+			masks[i] = compareColumns(instr->code, instr->cmp, &cols[instr->left],
+					&cols[instr->right], lanes);
 			break;
 		}
+	}
+
+	return masks[program->numInstrs - 1] & valid;
+}
+
+// evaluate a compiled expression on count records at once, bit i of the
+// selection is set if records[i] fulfills it. the selection needs a word
+// for every EXPR_BLOCK_SIZE records.
+RC
+evalExprProgramBatch (ExprProgram *program, Record *records, int count, uint64_t *selection)
+{
+	int i;
+
+	if (program == NULL || (count > 0 && (records == NULL || selection == NULL)))
+		return RC_PARAMS_ERROR;
+
+	for(i = 0; i < count; i += EXPR_BLOCK_SIZE)
+	{
+		int n = count - i < EXPR_BLOCK_SIZE ? count - i : EXPR_BLOCK_SIZE;
+		selection[i / EXPR_BLOCK_SIZE] = evalBlock(program, records + i, n);
+	}
+	return RC_OK;
+}
+
+RC
+freeExprProgram (ExprProgram *program)
+{
+	int i;
+
+	if (program == NULL)
+		return RC_OK;
+	for(i = 0; i < program->numSets; i++)
+	{
+		free(program->sets[i].values);
+		free(program->sets[i].slots);
+	}
+	free(program->sets);
+	free(program->instrs);
+	free(program->consts);
+	free(program);
+
+	return RC_OK;
+}
+
+RC
+freeExpr (Expr *expr)
+{
+	int i;
+
+	switch(expr->type)
+	{
+	case EXPR_OP:
+	{
+		Operator *op = expr->expr.op;
+		for(i = 0; i < op->numArgs; i++)
+			freeExpr(op->args[i]);
 		free(op->args);
+		free(op);
 	}
 	break;
 	case EXPR_CONST:
@@ -180,7 +1972,7 @@ freeExpr (Expr *expr)
 	return RC_OK;
 }
 
-void 
+void
 freeVal (Value *val)
 {
 	if (val->dt == DT_STRING)
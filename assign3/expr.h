@@ -1,6 +1,8 @@
 #ifndef EXPR_H
 #define EXPR_H
 
+#include <stdint.h>
+
 #include "dberror.h"
 #include "tables.h"
 
@@ -26,22 +28,140 @@ typedef enum OpType {
   OP_BOOL_OR,
   OP_BOOL_NOT,
   OP_COMP_EQUAL,
-  OP_COMP_SMALLER
+  OP_COMP_SMALLER,
+  OP_COMP_SMALLER_EQUAL,
+  OP_COMP_GREATER,
+  OP_COMP_GREATER_EQUAL,
+  OP_COMP_NOT_EQUAL,
+  OP_COMP_BETWEEN, // args[1] <= args[0] <= args[2]
+  OP_COMP_IN // args[0] equals one of the constants args[1..numArgs-1]
 } OpType;
 
 typedef struct Operator {
   OpType type;
+  int numArgs;
   Expr **args;
 } Operator;
 
+// instructions of a compiled expression, every instruction writes the
+// register with its own index
+typedef enum ExprOpcode {
+  EXPR_LOAD_CONST,
+  EXPR_LOAD_NUM,
+  EXPR_LOAD_WIDE, // an 8-byte number, LONG, DOUBLE or TIMESTAMP
+  EXPR_LOAD_STRING,
+  EXPR_COMPARE_INT, // booleans are compared as integers 0 and 1, dates as days
+  EXPR_COMPARE_FLOAT,
+  EXPR_COMPARE_LONG, // LONG and TIMESTAMP
+  EXPR_COMPARE_DOUBLE,
+  EXPR_COMPARE_STRING,
+  EXPR_IN, // look up left in the set with the index right
+  EXPR_NOT,
+  EXPR_AND,
+  EXPR_OR,
+  EXPR_SKIP_IF_FALSE, // set the AND in right to false and skip its right side
+  EXPR_SKIP_IF_TRUE // set the OR in right to true and skip its right side
+} ExprOpcode;
+
+// a register holds a value without owning it, strings point into the
+// record or the constant of the expression
+typedef struct ExprReg {
+  union reg {
+    int intV;
+    float floatV;
+    bool boolV;
+    int64_t longV;
+    double doubleV;
+  } v;
+  char *stringV;
+  int length;
+} ExprReg;
+
+typedef struct ExprInstr {
+  ExprOpcode code;
+  OpType cmp; // the comparison of a compare instruction
+  int left; // register of the first operand, or the constant to load
+  int right; // register of the second operand, or the target of a skip
+  int offset; // offset of the attribute to load in the record data
+  int length; // size of the attribute to load
+} ExprInstr;
+
+// the constants of an IN list, lists longer than EXPR_IN_HASH_MIN are found
+// through an open addressing hash table of indexes into values
+#define EXPR_IN_HASH_MIN 8
+
+typedef struct ExprSet {
+  DataType dt;
+  int numValues;
+  ExprReg *values;
+  int numSlots; // a power of two, 0 if the list is searched linearly
+  int *slots; // -1 marks an empty slot
+} ExprSet;
+
+// the number of records evalExprProgramBatch evaluates at once, the selection
+// of such a block is a single word
+#define EXPR_BLOCK_SIZE 64
+
+// a flat program evaluating an expression on the data of a record, the
+// result is in the register of the last instruction
+typedef struct ExprProgram {
+  int numInstrs;
+  ExprInstr *instrs;
+  ExprReg *consts;
+  int numSets;
+  ExprSet *sets;
+} ExprProgram;
+
+// the values of one attribute a condition can accept, a bound only applies
+// if it is set. strings of the bounds point into the constants of the
+// expression. empty is set if no value can fulfill the condition.
+typedef struct KeyRange {
+  bool hasLow;
+  bool lowInclusive;
+  Value low;
+  bool hasHigh;
+  bool highInclusive;
+  Value high;
+  bool empty;
+} KeyRange;
+
+// a bump allocator for the values of evalExprArena, everything allocated
+// from it is released at once by resetExprArena. requests that do not fit the
+// block are allocated on their own and the block grows by their size at the
+// next reset, so after a few resets nothing is allocated anymore.
+typedef struct ExprArena {
+  char *data; // the block
+  size_t size; // the size of the block
+  size_t used; // the bytes of the block handed out since the last reset
+  size_t spilled; // the bytes allocated outside the block since the last reset
+  void *extra; // the allocations outside the block, each starts with a link
+} ExprArena;
+
+#define EXPR_ARENA_SIZE 4096
+
 // expression evaluation methods
 extern RC valueEquals (Value *left, Value *right, Value *result);
 extern RC valueSmaller (Value *left, Value *right, Value *result);
+extern RC valueCompare (Value *left, Value *right, OpType type, Value *result);
 extern RC boolNot (Value *input, Value *result);
 extern RC boolAnd (Value *left, Value *right, Value *result);
 extern RC boolOr (Value *left, Value *right, Value *result);
 extern RC evalExpr (Record *record, Schema *schema, Expr *expr, Value **result);
+extern RC evalExprArena (Record *record, Schema *schema, Expr *expr, ExprArena *arena,
+    Value **result);
+extern RC createExprArena (ExprArena **arena, size_t size);
+extern void *allocExprArena (ExprArena *arena, size_t size);
+extern RC resetExprArena (ExprArena *arena);
+extern RC freeExprArena (ExprArena *arena);
 extern RC freeExpr (Expr *expr);
+extern RC collectAttrRefs (Expr *expr, bool *attrs);
+extern RC extractKeyRange (Expr *expr, int attrNum, KeyRange *range);
+extern RC optimizeExpr (Expr *expr, Schema *schema, Expr **result);
+extern RC compileExpr (Expr *expr, Schema *schema, ExprProgram **program);
+extern RC evalExprProgram (ExprProgram *program, Record *record, bool *result);
+extern RC evalExprProgramBatch (ExprProgram *program, Record *records, int count,
+    uint64_t *selection);
+extern RC freeExprProgram (ExprProgram *program);
 extern void freeVal(Value *val);
 
 
@@ -63,6 +183,18 @@ extern void freeVal(Value *val);
     case DT_BOOL:							\
       (_result)->v.boolV = _input->v.boolV;				\
       break;								\
+    case DT_DATE:							\
+      (_result)->v.intV = _input->v.intV;					\
+      break;								\
+    case DT_LONG:							\
+    case DT_TIMESTAMP:							\
+      (_result)->v.longV = _input->v.longV;				\
+      break;								\
+    case DT_DOUBLE:							\
+      (_result)->v.doubleV = _input->v.doubleV;				\
+      break;								\
+    default:								\
+      break;								\
     }									\
 } while(0)
 
@@ -73,6 +205,7 @@ extern void freeVal(Value *val);
       _result->type = EXPR_OP;						\
       _result->expr.op = _op;						\
       _op->type = _optype;						\
+      _op->numArgs = 2;							\
       _op->args = (Expr **) malloc(2 * sizeof(Expr*));			\
       _op->args[0] = _left;						\
       _op->args[1] = _right;						\
@@ -85,10 +218,39 @@ extern void freeVal(Value *val);
     _result->type = EXPR_OP;						\
     _result->expr.op = _op;						\
     _op->type = _optype;						\
+    _op->numArgs = 1;							\
     _op->args = (Expr **) malloc(sizeof(Expr*));			\
     _op->args[0] = _input;						\
   } while (0)
 
+#define MAKE_BETWEEN_EXPR(_result,_input,_low,_high)			\
+  do {									\
+    Operator *_op = (Operator *) malloc(sizeof(Operator));		\
+    _result = (Expr *) malloc(sizeof(Expr));				\
+    _result->type = EXPR_OP;						\
+    _result->expr.op = _op;						\
+    _op->type = OP_COMP_BETWEEN;					\
+    _op->numArgs = 3;							\
+    _op->args = (Expr **) malloc(3 * sizeof(Expr*));			\
+    _op->args[0] = _input;						\
+    _op->args[1] = _low;						\
+    _op->args[2] = _high;						\
+  } while (0)
+
+// the list is an array of _numValues constant expressions
+#define MAKE_IN_EXPR(_result,_input,_values,_numValues)			\
+  do {									\
+    Operator *_op = (Operator *) malloc(sizeof(Operator));		\
+    _result = (Expr *) malloc(sizeof(Expr));				\
+    _result->type = EXPR_OP;						\
+    _result->expr.op = _op;						\
+    _op->type = OP_COMP_IN;						\
+    _op->numArgs = (_numValues) + 1;					\
+    _op->args = (Expr **) malloc(_op->numArgs * sizeof(Expr*));	\
+    _op->args[0] = _input;						\
+    memcpy(_op->args + 1, _values, (_numValues) * sizeof(Expr*));	\
+  } while (0)
+
 #define MAKE_ATTRREF(_result,_attr)					\
   do {									\
     _result = (Expr *) malloc(sizeof(Expr));				\
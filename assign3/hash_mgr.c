@@ -0,0 +1,650 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "dberror.h"
+#include "hash_mgr.h"
+#include "btree_mgr.h"
+#include "buffer_mgr.h"
+#include "storage_mgr.h"
+#include "tables.h"
+#include "rm_serializer.h"
+
+// page 0 of a hash file holds the header of the index, the directory is
+// stored in a chain of pages starting at HDR_DIRECTORY, every other page is a
+// bucket or on the list of free pages
+#define HDR_KEY_TYPE 0
+#define HDR_KEY_LENGTH 4
+#define HDR_BUCKET_CAPACITY 8
+#define HDR_GLOBAL_DEPTH 12
+#define HDR_DIRECTORY 16
+#define HDR_NUM_BUCKETS 20
+#define HDR_NUM_ENTRIES 24
+#define HDR_FREE_PAGE 28
+#define HDR_NEXT_PAGE 32
+
+// a directory page starts with the next page of the chain followed by bucket
+// page numbers, a free page keeps the next free page at the same place
+#define DIR_NEXT 0
+#define DIR_HEADER_SIZE 4
+#define DIR_ENTRIES_PER_PAGE ((PAGE_SIZE - DIR_HEADER_SIZE) / (int) sizeof(int))
+#define FREE_NEXT 0
+
+// a bucket holds unordered (key, rid) entries whose hashes agree in their
+// lowest localDepth bits
+#define BUCKET_LOCAL_DEPTH 0
+#define BUCKET_NUM_KEYS 4
+#define BUCKET_HEADER_SIZE 8
+#define RID_SIZE 8
+
+// the operations never pin more than two pages at once. the directory has at
+// most 2^HASH_MAX_DEPTH entries, a bucket whose keys agree in that many bits
+// of their hash cannot be split
+#define HASH_POOL_SIZE 32
+#define HASH_MAX_DEPTH 20
+
+// the directory is kept in memory while the index is open, so a probe reads
+// only the page of its bucket
+typedef struct HashMgmt {
+	BM_BufferPool *bm;
+	int keyLength;
+	int bucketCapacity;
+	int globalDepth;
+	int *directory;
+	int *dirPages;
+	int numDirPages;
+	int numBuckets;
+	int numEntries;
+	int freePage;
+	int nextPage;
+} HashMgmt;
+
+// ************************************************************
+// buckets
+
+// fnv-1a followed by a finalizer that spreads every byte of the key over the
+// low bits that pick the bucket
+static uint32_t
+hashKey (char *key, int length)
+{
+	uint32_t hash = 2166136261u;
+	int i;
+
+	for(i = 0; i < length; i++)
+	{
+		hash ^= (unsigned char) key[i];
+		hash *= 16777619u;
+	}
+	hash ^= hash >> 16;
+	hash *= 0x85ebca6bu;
+	hash ^= hash >> 13;
+	hash *= 0xc2b2ae35u;
+	hash ^= hash >> 16;
+	return hash;
+}
+
+static inline int
+directoryIndex (HashMgmt *mgmt, uint32_t hash)
+{
+	return (int) (hash & ((1u << mgmt->globalDepth) - 1));
+}
+
+static inline int
+bucketLocalDepth (char *bucket)
+{
+	return readAttrInt(bucket + BUCKET_LOCAL_DEPTH);
+}
+
+static inline int
+bucketNumKeys (char *bucket)
+{
+	return readAttrInt(bucket + BUCKET_NUM_KEYS);
+}
+
+static inline char *
+bucketEntry (HashMgmt *mgmt, char *bucket, int i)
+{
+	return bucket + BUCKET_HEADER_SIZE + i * (mgmt->keyLength + RID_SIZE);
+}
+
+static int
+searchBucket (HashMgmt *mgmt, char *bucket, char *key)
+{
+	int numKeys = bucketNumKeys(bucket);
+	int i;
+
+	for(i = 0; i < numKeys; i++)
+		if(memcmp(bucketEntry(mgmt, bucket, i), key, mgmt->keyLength) == 0)
+			return i;
+	return -1;
+}
+
+static void
+initBucket (char *bucket, int localDepth)
+{
+	memset(bucket, 0, PAGE_SIZE);
+	writeAttrInt(bucket + BUCKET_LOCAL_DEPTH, localDepth);
+	writeAttrInt(bucket + BUCKET_NUM_KEYS, 0);
+}
+
+// pin a zeroed page taken from the free list or the end of the file
+static RC
+allocPage (HashMgmt *mgmt, BM_PageHandle *page)
+{
+	RC rc;
+
+	if(mgmt->freePage != NO_PAGE)
+	{
+		if((rc = pinPage(mgmt->bm, page, mgmt->freePage)) != RC_OK)
+			return rc;
+		mgmt->freePage = readAttrInt(page->data + FREE_NEXT);
+	}
+	else
+	{
+		if((rc = pinPage(mgmt->bm, page, mgmt->nextPage)) != RC_OK)
+			return rc;
+		mgmt->nextPage++;
+	}
+	memset(page->data, 0, PAGE_SIZE);
+	return RC_OK;
+}
+
+// put a pinned page on the free list and unpin it
+static RC
+releasePage (HashMgmt *mgmt, BM_PageHandle *page)
+{
+	writeAttrInt(page->data + FREE_NEXT, mgmt->freePage);
+	mgmt->freePage = page->pageNum;
+	markDirty(mgmt->bm, page);
+	return unpinPage(mgmt->bm, page);
+}
+
+// ************************************************************
+// directory
+
+static RC
+readDirectory (HashMgmt *mgmt, int pageNum)
+{
+	int size = 1 << mgmt->globalDepth;
+	int done = 0;
+	BM_PageHandle page;
+	RC rc;
+
+	mgmt->directory = (int *) malloc(size * sizeof(int));
+	mgmt->dirPages = NULL;
+	mgmt->numDirPages = 0;
+	while(pageNum != NO_PAGE)
+	{
+		if((rc = pinPage(mgmt->bm, &page, pageNum)) != RC_OK)
+			return rc;
+		int count = size - done < DIR_ENTRIES_PER_PAGE ? size - done : DIR_ENTRIES_PER_PAGE;
+		for(int i = 0; i < count; i++)
+			mgmt->directory[done + i] = readAttrInt(page.data + DIR_HEADER_SIZE + i * sizeof(int));
+		done += count;
+		mgmt->dirPages = (int *) realloc(mgmt->dirPages, (mgmt->numDirPages + 1) * sizeof(int));
+		mgmt->dirPages[mgmt->numDirPages++] = pageNum;
+		pageNum = readAttrInt(page.data + DIR_NEXT);
+		unpinPage(mgmt->bm, &page);
+	}
+	if(done != size)
+		THROW(RC_ERROR, "hash directory is shorter than its depth");
+	return RC_OK;
+}
+
+// write the directory to its chain of pages, which grows or shrinks with it
+static RC
+writeDirectory (HashMgmt *mgmt)
+{
+	int size = 1 << mgmt->globalDepth;
+	int needed = (size + DIR_ENTRIES_PER_PAGE - 1) / DIR_ENTRIES_PER_PAGE;
+	BM_PageHandle page;
+	int p;
+	RC rc;
+
+	if(needed > mgmt->numDirPages)
+		mgmt->dirPages = (int *) realloc(mgmt->dirPages, needed * sizeof(int));
+	for(p = mgmt->numDirPages; p < needed; p++)
+	{
+		if((rc = allocPage(mgmt, &page)) != RC_OK)
+			return rc;
+		mgmt->dirPages[p] = page.pageNum;
+		mgmt->numDirPages++;
+		unpinPage(mgmt->bm, &page);
+	}
+	for(p = needed; p < mgmt->numDirPages; p++)
+	{
+		if((rc = pinPage(mgmt->bm, &page, mgmt->dirPages[p])) != RC_OK)
+			return rc;
+		releasePage(mgmt, &page);
+	}
+	mgmt->numDirPages = needed;
+
+	for(p = 0; p < needed; p++)
+	{
+		if((rc = pinPage(mgmt->bm, &page, mgmt->dirPages[p])) != RC_OK)
+			return rc;
+		int first = p * DIR_ENTRIES_PER_PAGE;
+		int count = size - first < DIR_ENTRIES_PER_PAGE ? size - first : DIR_ENTRIES_PER_PAGE;
+		writeAttrInt(page.data + DIR_NEXT, p + 1 < needed ? mgmt->dirPages[p + 1] : NO_PAGE);
+		for(int i = 0; i < count; i++)
+			writeAttrInt(page.data + DIR_HEADER_SIZE + i * sizeof(int), mgmt->directory[first + i]);
+		markDirty(mgmt->bm, &page);
+		unpinPage(mgmt->bm, &page);
+	}
+	return RC_OK;
+}
+
+// split a full pinned bucket on the next bit of the hash, doubling the
+// directory first if the bucket is the only one for its slot. both buckets
+// are unpinned afterwards.
+static RC
+splitBucket (HashMgmt *mgmt, BM_PageHandle *bucket, uint32_t hash)
+{
+	int depth = bucketLocalDepth(bucket->data);
+	BM_PageHandle newBucket;
+	RC rc;
+
+	if(depth == mgmt->globalDepth)
+	{
+		if(mgmt->globalDepth == HASH_MAX_DEPTH)
+		{
+			unpinPage(mgmt->bm, bucket);
+			THROW(RC_IM_BUCKET_FULL, "too many keys share the bits of their hash");
+		}
+		int size = 1 << mgmt->globalDepth;
+		mgmt->directory = (int *) realloc(mgmt->directory, 2 * size * sizeof(int));
+		memcpy(mgmt->directory + size, mgmt->directory, size * sizeof(int));
+		mgmt->globalDepth++;
+	}
+
+	if((rc = allocPage(mgmt, &newBucket)) != RC_OK)
+	{
+		unpinPage(mgmt->bm, bucket);
+		return rc;
+	}
+	initBucket(newBucket.data, depth + 1);
+
+	// entries with the bit set move to the new bucket
+	uint32_t bit = 1u << depth;
+	int numKeys = bucketNumKeys(bucket->data);
+	int entrySize = mgmt->keyLength + RID_SIZE;
+	int kept = 0, moved = 0;
+	for(int i = 0; i < numKeys; i++)
+	{
+		char *entry = bucketEntry(mgmt, bucket->data, i);
+		if(hashKey(entry, mgmt->keyLength) & bit)
+			memcpy(bucketEntry(mgmt, newBucket.data, moved++), entry, entrySize);
+		else
+			memmove(bucketEntry(mgmt, bucket->data, kept++), entry, entrySize);
+	}
+	writeAttrInt(bucket->data + BUCKET_LOCAL_DEPTH, depth + 1);
+	writeAttrInt(bucket->data + BUCKET_NUM_KEYS, kept);
+	writeAttrInt(newBucket.data + BUCKET_NUM_KEYS, moved);
+
+	// the slots of the old bucket with the bit set now point to the new one
+	int size = 1 << mgmt->globalDepth;
+	for(int i = (int) ((hash & (bit - 1)) | bit); i < size; i += 2 * bit)
+		mgmt->directory[i] = newBucket.pageNum;
+	mgmt->numBuckets++;
+
+	markDirty(mgmt->bm, bucket);
+	markDirty(mgmt->bm, &newBucket);
+	unpinPage(mgmt->bm, bucket);
+	return unpinPage(mgmt->bm, &newBucket);
+}
+
+// fold an empty pinned bucket into its buddy if both have the same depth, and
+// go on with the merged bucket as long as one of the pair is empty. then halve
+// the directory as long as its halves are equal. the bucket is unpinned
+// afterwards.
+static RC
+mergeBucket (HashMgmt *mgmt, BM_PageHandle *bucket, uint32_t hash)
+{
+	BM_PageHandle buddy;
+	RC rc = RC_OK;
+
+	while(rc == RC_OK)
+	{
+		int depth = bucketLocalDepth(bucket->data);
+		if(depth == 0)
+			break;
+
+		uint32_t half = 1u << (depth - 1);
+		int slot = (int) (hash & ((half << 1) - 1));
+		if((rc = pinPage(mgmt->bm, &buddy, mgmt->directory[slot ^ half])) != RC_OK)
+			break;
+		if(bucketLocalDepth(buddy.data) != depth
+				|| (bucketNumKeys(bucket->data) > 0 && bucketNumKeys(buddy.data) > 0))
+		{
+			unpinPage(mgmt->bm, &buddy);
+			break;
+		}
+
+		// keep the bucket that has entries
+		if(bucketNumKeys(bucket->data) == 0)
+		{
+			BM_PageHandle empty = *bucket;
+			*bucket = buddy;
+			buddy = empty;
+		}
+		int size = 1 << mgmt->globalDepth;
+		for(int i = (int) (hash & (half - 1)); i < size; i += half)
+			mgmt->directory[i] = bucket->pageNum;
+		writeAttrInt(bucket->data + BUCKET_LOCAL_DEPTH, depth - 1);
+		markDirty(mgmt->bm, bucket);
+		mgmt->numBuckets--;
+		rc = releasePage(mgmt, &buddy);
+	}
+	unpinPage(mgmt->bm, bucket);
+
+	while(mgmt->globalDepth > 0)
+	{
+		int half = 1 << (mgmt->globalDepth - 1);
+		if(memcmp(mgmt->directory, mgmt->directory + half, half * sizeof(int)) != 0)
+			break;
+		mgmt->globalDepth--;
+	}
+	return rc;
+}
+
+// ************************************************************
+// hash index manager
+
+RC
+createHashIndex (char *idxId, DataType keyType, int n)
+{
+	return createHashIndexWithLength(idxId, keyType, keyLength(keyType, 0), n);
+}
+
+RC
+createHashIndexWithLength (char *idxId, DataType keyType, int length, int n)
+{
+	SM_FileHandle fHandle;
+	char *data;
+	RC rc;
+
+	if(idxId == NULL || keyLength(keyType, length) <= 0 || length < keyLength(keyType, length)
+			|| n < 0 || n == 1)
+		return RC_PARAMS_ERROR;
+
+	// a bucket has to hold at least two keys, otherwise any two keys whose
+	// hashes agree in HASH_MAX_DEPTH bits would not fit
+	int bucketMax = (PAGE_SIZE - BUCKET_HEADER_SIZE) / (length + RID_SIZE);
+	if(bucketMax < 2 || n > bucketMax)
+		THROW(RC_IM_N_TO_LAGE, "buckets of this size do not fit into a page");
+
+	if((rc = createPageFile(idxId)) != RC_OK)
+		return rc;
+	if((rc = openPageFile(idxId, &fHandle)) != RC_OK)
+		return rc;
+
+	data = (char *) calloc(PAGE_SIZE, sizeof(char));
+	writeAttrInt(data + HDR_KEY_TYPE, keyType);
+	writeAttrInt(data + HDR_KEY_LENGTH, length);
+	writeAttrInt(data + HDR_BUCKET_CAPACITY, n == 0 ? bucketMax : n);
+	writeAttrInt(data + HDR_GLOBAL_DEPTH, 0);
+	writeAttrInt(data + HDR_DIRECTORY, 1);
+	writeAttrInt(data + HDR_NUM_BUCKETS, 1);
+	writeAttrInt(data + HDR_NUM_ENTRIES, 0);
+	writeAttrInt(data + HDR_FREE_PAGE, NO_PAGE);
+	writeAttrInt(data + HDR_NEXT_PAGE, 3);
+	rc = writeBlock(0, &fHandle, data);
+
+	// a directory of one slot pointing to an empty bucket
+	if(rc == RC_OK && (rc = ensureCapacity(3, &fHandle)) == RC_OK)
+	{
+		memset(data, 0, PAGE_SIZE);
+		writeAttrInt(data + DIR_NEXT, NO_PAGE);
+		writeAttrInt(data + DIR_HEADER_SIZE, 2);
+		if((rc = writeBlock(1, &fHandle, data)) == RC_OK)
+		{
+			initBucket(data, 0);
+			rc = writeBlock(2, &fHandle, data);
+		}
+	}
+	free(data);
+	closePageFile(&fHandle);
+	return rc;
+}
+
+RC
+openHashIndex (HashHandle **index, char *idxId)
+{
+	BM_PageHandle page;
+	HashHandle *result;
+	HashMgmt *mgmt;
+	RC rc;
+
+	if(index == NULL || idxId == NULL)
+		return RC_PARAMS_ERROR;
+
+	result = (HashHandle *) malloc(sizeof(HashHandle));
+	mgmt = (HashMgmt *) malloc(sizeof(HashMgmt));
+	result->idxId = strdup(idxId);
+	result->mgmtData = mgmt;
+	mgmt->directory = NULL;
+	mgmt->dirPages = NULL;
+
+	// the pool is released by shutdownBufferPool once it was initialized
+	mgmt->bm = MAKE_POOL();
+	if((rc = initBufferPool(mgmt->bm, result->idxId, HASH_POOL_SIZE, RS_FIFO, NULL)) != RC_OK)
+		free(mgmt->bm);
+	else
+	{
+		if((rc = pinPage(mgmt->bm, &page, 0)) == RC_OK)
+		{
+			result->keyType = (DataType) readAttrInt(page.data + HDR_KEY_TYPE);
+			mgmt->keyLength = readAttrInt(page.data + HDR_KEY_LENGTH);
+			mgmt->bucketCapacity = readAttrInt(page.data + HDR_BUCKET_CAPACITY);
+			mgmt->globalDepth = readAttrInt(page.data + HDR_GLOBAL_DEPTH);
+			mgmt->numBuckets = readAttrInt(page.data + HDR_NUM_BUCKETS);
+			mgmt->numEntries = readAttrInt(page.data + HDR_NUM_ENTRIES);
+			mgmt->freePage = readAttrInt(page.data + HDR_FREE_PAGE);
+			mgmt->nextPage = readAttrInt(page.data + HDR_NEXT_PAGE);
+			int dirPage = readAttrInt(page.data + HDR_DIRECTORY);
+			unpinPage(mgmt->bm, &page);
+			rc = readDirectory(mgmt, dirPage);
+		}
+		if(rc != RC_OK)
+			shutdownBufferPool(mgmt->bm);
+	}
+	if(rc != RC_OK)
+	{
+		free(mgmt->directory);
+		free(mgmt->dirPages);
+		free(result->idxId);
+		free(mgmt);
+		free(result);
+		return rc;
+	}
+
+	*index = result;
+	return RC_OK;
+}
+
+RC
+closeHashIndex (HashHandle *index)
+{
+	HashMgmt *mgmt;
+	BM_PageHandle page;
+	RC rc;
+
+	if(index == NULL)
+		return RC_PARAMS_ERROR;
+	mgmt = (HashMgmt *) index->mgmtData;
+
+	// the header and the directory are kept in memory while the index is open
+	rc = writeDirectory(mgmt);
+	if(rc == RC_OK && (rc = pinPage(mgmt->bm, &page, 0)) == RC_OK)
+	{
+		writeAttrInt(page.data + HDR_GLOBAL_DEPTH, mgmt->globalDepth);
+		writeAttrInt(page.data + HDR_DIRECTORY, mgmt->dirPages[0]);
+		writeAttrInt(page.data + HDR_NUM_BUCKETS, mgmt->numBuckets);
+		writeAttrInt(page.data + HDR_NUM_ENTRIES, mgmt->numEntries);
+		writeAttrInt(page.data + HDR_FREE_PAGE, mgmt->freePage);
+		writeAttrInt(page.data + HDR_NEXT_PAGE, mgmt->nextPage);
+		markDirty(mgmt->bm, &page);
+		unpinPage(mgmt->bm, &page);
+	}
+	RC shutdownRc = shutdownBufferPool(mgmt->bm);
+	if(rc == RC_OK)
+		rc = shutdownRc;
+
+	free(mgmt->directory);
+	free(mgmt->dirPages);
+	free(index->idxId);
+	free(mgmt);
+	free(index);
+	return rc;
+}
+
+RC
+deleteHashIndex (char *idxId)
+{
+	if(idxId == NULL)
+		return RC_PARAMS_ERROR;
+	return destroyPageFile(idxId);
+}
+
+RC
+getHashNumBuckets (HashHandle *index, int *result)
+{
+	*result = ((HashMgmt *) index->mgmtData)->numBuckets;
+	return RC_OK;
+}
+
+RC
+getHashNumEntries (HashHandle *index, int *result)
+{
+	*result = ((HashMgmt *) index->mgmtData)->numEntries;
+	return RC_OK;
+}
+
+RC
+getHashGlobalDepth (HashHandle *index, int *result)
+{
+	*result = ((HashMgmt *) index->mgmtData)->globalDepth;
+	return RC_OK;
+}
+
+// ************************************************************
+// index access
+
+RC
+findEncodedHashKey (HashHandle *index, char *key, RID *result)
+{
+	HashMgmt *mgmt = (HashMgmt *) index->mgmtData;
+	uint32_t hash = hashKey(key, mgmt->keyLength);
+	BM_PageHandle bucket;
+	RC rc;
+
+	if((rc = pinPage(mgmt->bm, &bucket, mgmt->directory[directoryIndex(mgmt, hash)])) != RC_OK)
+		return rc;
+	int pos = searchBucket(mgmt, bucket.data, key);
+	if(pos >= 0)
+	{
+		char *entry = bucketEntry(mgmt, bucket.data, pos);
+		result->page = readAttrInt(entry + mgmt->keyLength);
+		result->slot = readAttrInt(entry + mgmt->keyLength + sizeof(int));
+	}
+	unpinPage(mgmt->bm, &bucket);
+
+	return pos >= 0 ? RC_OK : RC_IM_KEY_NOT_FOUND;
+}
+
+RC
+insertEncodedHashKey (HashHandle *index, char *key, RID rid)
+{
+	HashMgmt *mgmt = (HashMgmt *) index->mgmtData;
+	uint32_t hash = hashKey(key, mgmt->keyLength);
+	BM_PageHandle bucket;
+	RC rc;
+
+	// a split may leave every entry on one side, then split again
+	while(true)
+	{
+		if((rc = pinPage(mgmt->bm, &bucket, mgmt->directory[directoryIndex(mgmt, hash)])) != RC_OK)
+			return rc;
+		if(searchBucket(mgmt, bucket.data, key) >= 0)
+		{
+			unpinPage(mgmt->bm, &bucket);
+			return RC_IM_KEY_ALREADY_EXISTS;
+		}
+
+		int numKeys = bucketNumKeys(bucket.data);
+		if(numKeys < mgmt->bucketCapacity)
+		{
+			char *entry = bucketEntry(mgmt, bucket.data, numKeys);
+			memcpy(entry, key, mgmt->keyLength);
+			writeAttrInt(entry + mgmt->keyLength, rid.page);
+			writeAttrInt(entry + mgmt->keyLength + sizeof(int), rid.slot);
+			writeAttrInt(bucket.data + BUCKET_NUM_KEYS, numKeys + 1);
+			mgmt->numEntries++;
+			markDirty(mgmt->bm, &bucket);
+			return unpinPage(mgmt->bm, &bucket);
+		}
+		if((rc = splitBucket(mgmt, &bucket, hash)) != RC_OK)
+			return rc;
+	}
+}
+
+RC
+deleteEncodedHashKey (HashHandle *index, char *key)
+{
+	HashMgmt *mgmt = (HashMgmt *) index->mgmtData;
+	uint32_t hash = hashKey(key, mgmt->keyLength);
+	BM_PageHandle bucket;
+	RC rc;
+
+	if((rc = pinPage(mgmt->bm, &bucket, mgmt->directory[directoryIndex(mgmt, hash)])) != RC_OK)
+		return rc;
+	int pos = searchBucket(mgmt, bucket.data, key);
+	if(pos < 0)
+	{
+		unpinPage(mgmt->bm, &bucket);
+		return RC_IM_KEY_NOT_FOUND;
+	}
+
+	// the last entry fills the gap
+	int numKeys = bucketNumKeys(bucket.data) - 1;
+	int entrySize = mgmt->keyLength + RID_SIZE;
+	memmove(bucketEntry(mgmt, bucket.data, pos), bucketEntry(mgmt, bucket.data, numKeys), entrySize);
+	writeAttrInt(bucket.data + BUCKET_NUM_KEYS, numKeys);
+	mgmt->numEntries--;
+	markDirty(mgmt->bm, &bucket);
+
+	if(numKeys == 0)
+		return mergeBucket(mgmt, &bucket, hash);
+	return unpinPage(mgmt->bm, &bucket);
+}
+
+// the Value interface encodes the keys and calls the functions above
+#define WITH_ENCODED_HASH_KEY(index, key, buf, call)			\
+		do {									\
+			HashMgmt *_mgmt = (HashMgmt *) (index)->mgmtData;		\
+			char *buf = (char *) malloc(_mgmt->keyLength);			\
+			RC _rc = encodeKey((index)->keyType, _mgmt->keyLength, key, buf);	\
+			if(_rc == RC_OK)						\
+				_rc = (call);						\
+			free(buf);							\
+			return _rc;							\
+		} while(0)
+
+RC
+findHashKey (HashHandle *index, Value *key, RID *result)
+{
+	WITH_ENCODED_HASH_KEY(index, key, buf, findEncodedHashKey(index, buf, result));
+}
+
+RC
+insertHashKey (HashHandle *index, Value *key, RID rid)
+{
+	WITH_ENCODED_HASH_KEY(index, key, buf, insertEncodedHashKey(index, buf, rid));
+}
+
+RC
+deleteHashKey (HashHandle *index, Value *key)
+{
+	WITH_ENCODED_HASH_KEY(index, key, buf, deleteEncodedHashKey(index, buf));
+}
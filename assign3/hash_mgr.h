@@ -0,0 +1,40 @@
+#ifndef HASH_MGR_H
+#define HASH_MGR_H
+
+#include "dberror.h"
+#include "tables.h"
+
+// structure for accessing hash indexes
+typedef struct HashHandle {
+	DataType keyType;
+	char *idxId;
+	void *mgmtData;
+} HashHandle;
+
+// create, destroy, open, and close an extendible hash index on unique keys.
+// keys are encoded with encodeKey of btree_mgr.h. n is the maximum number of
+// entries per bucket, at least 2 or 0 to fill every page. createHashIndex uses the natural key
+// length of keyType, createHashIndexWithLength takes any length for strings and
+// composite keys
+extern RC createHashIndex (char *idxId, DataType keyType, int n);
+extern RC createHashIndexWithLength (char *idxId, DataType keyType, int length, int n);
+extern RC openHashIndex (HashHandle **index, char *idxId);
+extern RC closeHashIndex (HashHandle *index);
+extern RC deleteHashIndex (char *idxId);
+
+// access information about a hash index
+extern RC getHashNumBuckets (HashHandle *index, int *result);
+extern RC getHashNumEntries (HashHandle *index, int *result);
+extern RC getHashGlobalDepth (HashHandle *index, int *result);
+
+// index access
+extern RC findHashKey (HashHandle *index, Value *key, RID *result);
+extern RC insertHashKey (HashHandle *index, Value *key, RID rid);
+extern RC deleteHashKey (HashHandle *index, Value *key);
+
+// the same on keys already encoded to the key length of the index
+extern RC findEncodedHashKey (HashHandle *index, char *key, RID *result);
+extern RC insertEncodedHashKey (HashHandle *index, char *key, RID rid);
+extern RC deleteEncodedHashKey (HashHandle *index, char *key);
+
+#endif // HASH_MGR_H
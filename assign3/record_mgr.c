@@ -1,5 +1,7 @@
 // This file implements all interfaces defined in record_mgr.c file
 
+#include <limits.h>
+#include <pthread.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
@@ -7,30 +9,551 @@
 #include "tables.h"
 #include "rm_serializer.h"
 #include "record_mgr.h"
+#include "btree_mgr.h"
 #include "buffer_mgr.h"
 #include "storage_mgr.h"
 
 
+// the bounds a scan condition puts on the attributes with a zone map, encoded
+// at the offsets of the zone layout. a page whose zone lies outside of them
+// cannot hold a matching record.
+typedef struct ZoneFilter {
+    int numAttrs;
+    char *low;
+    char *high;
+    bool *hasLow; // whether an attribute is bounded from below
+    bool *hasHigh;
+} ZoneFilter;
+
 //stores scan data
 typedef struct ScanCond{
     int currentPage;
     int currentSlot;
     Expr *condition;
+    Expr *optimized; // the rewritten condition the program is compiled from
+    ExprProgram *program; // the compiled condition, NULL to match all records
+    bool *attrs; // the attributes to decode, NULL to decode all of them
+    ExprArena *arena; // the values of evalScanExpr, reset by next and nextBatch
+    RM_AccessPath path; // how the records are reached
+    RID *rids; // the RIDs an index scan visits, sorted by page and slot
+    int numRids;
+    int nextRid; // the position of an index scan in rids
+    struct IndexOnlyScan *indexOnly; // the state of an index-only scan
+    ZoneFilter *zoneFilter; // the pages a heap scan can skip, NULL to read all
+    int pagesRead; // the data pages a heap scan read and skipped so far
+    int pagesSkipped;
+    RC rc; // the error that ended the scan, returned by next and nextBatch
 } ScanCond;
 
+// an index-only scan reads the entries of the key index in chunks and keeps
+// no leaf pinned in between, the next chunk starts behind the last key read
+typedef struct IndexOnlyScan {
+    char *low; // the encoded key range still to read
+    char *high;
+    bool resume; // whether low is the last key of the previous chunk
+    bool done; // whether the range is exhausted
+    char *entries; // [key][RID][payload] entries of the current chunk
+    int count;
+    int next;
+} IndexOnlyScan;
+
+// the number of key index entries an index-only scan reads at a time
+#define INDEX_SCAN_CHUNK 256
+
+// the number of pages a parallel scan worker claims at a time
+#define MORSEL_PAGES 4
+
+// the size of a serialized page directory "[PPPP-CCCC-FFFF]\n"
+#define PAGE_DIRECTORY_SIZE 17
+
+// page numbers have four digits in page directories and slot headers, so the
+// records of a table are stored on pages up to this one
+#define MAX_DATA_PAGE 9999
+
+// an overflow page starts with the next page of its chain and the number of
+// bytes it holds, page 0 of the overflow file stores the head of the free list
+#define OVERFLOW_HEADER_SIZE 8
+#define OVERFLOW_PAGE_DATA (PAGE_SIZE - OVERFLOW_HEADER_SIZE)
+
+// a key index built from an existing table leaves some room in its nodes for
+// the inserts that follow
+#define KEY_INDEX_FILL_PERCENT 90
+
+// the most secondary indexes a table can have and the size of their names
+// including the terminating null character
+#define MAX_SECONDARY_INDEXES 8
+#define MAX_INDEX_NAME 32
+
+// the zone map of a string attribute keeps the first ZONE_PREFIX bytes of its
+// smallest and largest value
+#define ZONE_PREFIX 16
+
+// the characters of an index name, which becomes part of its file name
+#define INDEX_NAME_CHARS "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789_-"
+
+// a secondary index key ends in the RID of its record, page and slot are
+// encoded like INT keys so records with equal values are ordered by RID
+#define RID_KEY_LENGTH 8
+
+// a secondary index of the open table
+typedef struct SecondaryIndex {
+    char name[MAX_INDEX_NAME];
+    int numAttrs;
+    int *attrNums; // the indexed attributes in the order of their key
+    int length; // the size of an encoded key including the RID
+    BTreeHandle *tree;
+} SecondaryIndex;
+
+// shared state of a parallel scan, morsels are handed out under its lock
+typedef struct ParallelScan {
+    RM_TableData *rel;
+    ExprProgram *program; // the compiled condition shared by all workers
+    RM_ScanCallback callback;
+    void *context;
+    int nextPage; // the first page of the next morsel
+    int maxPage; // the last page holding records
+    ZoneFilter *zoneFilter; // the pages the workers can skip, NULL to read all
+    RC rc; // the first error raised by a worker or the callback
+    pthread_mutex_t lock;
+} ParallelScan;
+
+// a worker thread of a parallel scan
+typedef struct ScanWorker {
+    int id;
+    ParallelScan *scan;
+    pthread_t thread;
+} ScanWorker;
+
 
 // global variables
 SM_FileHandle fHandle; // handle file operation
 BM_BufferPool *bm; // handle buffer pool operation
 BM_PageHandle *page; // handle buffer pool page operation
-RecordNode *head = NULL;  // the header of the record nodes
 
 int numTuples = 0; // the total number of tuples in this table
-int sizeRecord; // the size of record
+int sizeRecord; // the size of a slot storing one serialized record
 int capacity; // the max number of slots that can be used in a single page
 int maxPageDiretories; // the max page directories that can be stored in a single page
 
+// the buffer pool is not thread-safe, workers of a parallel scan take turns
+pthread_mutex_t bmLock = PTHREAD_MUTEX_INITIALIZER;
+
+// the parts of long VARCHAR values that do not fit into their slot are stored
+// on chains of pages in the companion file "<table>.ovf"
+SM_FileHandle overflowHandle; // handle overflow file operation
+bool hasOverflow; // whether the open table has VARCHAR attributes
+int overflowFreePage; // the first free overflow page, 0 if there is none
+pthread_mutex_t overflowLock = PTHREAD_MUTEX_INITIALIZER;
+
+// the key attributes of a table are kept unique by a B+ tree in the companion
+// file "<table>.idx" which maps the encoded key of every record to its RID
+BTreeHandle *keyIndex = NULL; // NULL if the open table has no key
+int keyIndexLength; // the size of an encoded key
+int keyPayloadLength; // the size of the included attributes stored with a key
+bool *keyAttrs; // marks the key attributes to read only them from a slot
+Record keyRecord; // receives the key attributes read from a slot
+
+// secondary indexes map the encoded attributes of every record followed by
+// its RID to that RID, so any number of records may share their values. they
+// are listed behind the schema on page 0 and stored in "<table>.<name>.idx"
+SecondaryIndex secondaryIndexes[MAX_SECONDARY_INDEXES];
+int numSecondaryIndexes = 0;
+bool *indexAttrs; // marks the attributes of all secondary indexes, NULL without one
+Record indexRecord; // receives the old values of those attributes from a slot
+
+// the zone map of a data page holds the smallest and largest value of every
+// numeric and fixed length string attribute of its records, encoded like keys
+// so they compare with memcmp. a zone is an empty flag followed by the minimum
+// and maximum of each of these attributes. the zones of all pages are kept in
+// memory indexed by page number and stored in "<table>.zone" next to the page
+// directories when the table is closed.
+int zoneSize; // the size of a zone
+int *zoneOffsets; // the offset of the minimum of each attribute in a zone
+int *zoneWidths; // the size of the minimum of each attribute, 0 without a zone
+bool *zoneAttrs; // marks the attributes with a zone
+char *zones; // the zones of pages 0 to numZones - 1
+int numZones;
+bool zonesValid; // false once a zone could not be kept up to date
+
+
+// compute the slot layout of a table, every slot holds one serialized record
+// "[PPPP-SSSS](name:value,...)\n" whose values have the fixed size of their
+// attributes, see attrSlotSize
+static void initSlotLayout(Schema *schema)
+{
+    // the page and slot header, the parentheses and the line break
+    sizeRecord = 11 + 2 + 1;
+    hasOverflow = false;
+    for(int i = 0; i < schema->numAttr; i++) {
+        // the attribute name, the colon, the value and the separator
+        sizeRecord = sizeRecord + strlen(schema->attrNames[i]) + 1
+                        + attrSlotSize(schema, i) + (i > 0 ? 1 : 0);
+        if(schema->dataTypes[i] == DT_VARCHAR) {
+            hasOverflow = true;
+        }
+    }
+    capacity = PAGE_SIZE / sizeRecord;
+
+    // every page directory is serialized as "[PPPP-CCCC-FFFF]\n", leave room
+    // for the terminating null character
+    maxPageDiretories = (PAGE_SIZE - 1) / PAGE_DIRECTORY_SIZE;
+}
+
+// whether the page stores page directories instead of records
+static bool isDirectoryPage(int pageNum)
+{
+    return pageNum % (maxPageDiretories + 1) == 0;
+}
+
+// the page storing the chunk-th group of page directories, the first group is
+// stored on page 1 and the others on the pages skipped by isDirectoryPage
+static int directoryPageNum(int chunk)
+{
+    return chunk == 0 ? 1 : chunk * (maxPageDiretories + 1);
+}
+
+// read all page directories, a directory page is only followed by another one
+// when it is full
+static PageDirectoryCache *readPageDirectories()
+{
+    PageDirectoryCache *pageDirectoryCache = NULL;
+    BM_PageHandle handle;
+    char *pageData = (char *)calloc(PAGE_SIZE + 1, sizeof(char));
+    if(pageData == NULL) {
+        return NULL;
+    }
+    for(int chunk = 0; ; chunk++) {
+        if(pinPage(bm, &handle, directoryPageNum(chunk)) != RC_OK) {
+            break;
+        }
+        // parse a copy since the parser splits the string in place
+        memcpy(pageData, handle.data, PAGE_SIZE);
+        unpinPage(bm, &handle);
+        PageDirectoryCache *group = deserializePageDirectories(pageData);
+
+        if(pageDirectoryCache == NULL) {
+            pageDirectoryCache = group;
+        } else {
+            if(group->front != NULL) {
+                pageDirectoryCache->rear->next = group->front;
+                group->front->pre = pageDirectoryCache->rear;
+                pageDirectoryCache->rear = group->rear;
+                pageDirectoryCache->count = pageDirectoryCache->count + group->count;
+            }
+            free(group);
+        }
+        if(pageDirectoryCache->count < (chunk + 1) * maxPageDiretories) {
+            break;
+        }
+    }
+    free(pageData);
+    return pageDirectoryCache;
+}
+
+// write all page directories to their directory pages. the page after the
+// last full directory page is cleared so that it is not read back.
+static RC writePageDirectories(PageDirectoryCache *pageDirectoryCache)
+{
+    BM_PageHandle handle;
+    PageDirectory *p = pageDirectoryCache->front;
+    for(int chunk = 0; chunk <= pageDirectoryCache->count / maxPageDiretories; chunk++) {
+        if(pinPage(bm, &handle, directoryPageNum(chunk)) != RC_OK) {
+            return RC_WRITE_FAILED;
+        }
+        memset(handle.data, '\0', PAGE_SIZE);
+        for(int i = 0; i < maxPageDiretories && p != NULL; i++) {
+            char *pdInfo = serializePageDirectory(p);
+            memcpy(handle.data + i * PAGE_DIRECTORY_SIZE, pdInfo, PAGE_DIRECTORY_SIZE);
+            free(pdInfo);
+            p = p->next;
+        }
+        markDirty(bm, &handle);
+        unpinPage(bm, &handle);
+    }
+    return RC_OK;
+}
+
+// the name of the overflow file of a table, the caller has to free it
+static char *overflowFileName(char *name)
+{
+    char *fileName = (char *)malloc(strlen(name) + 5);
+    if(fileName != NULL) {
+        sprintf(fileName, "%s.ovf", name);
+    }
+    return fileName;
+}
+
+// whether the schema has attributes whose values may not fit into the slot
+static bool schemaHasOverflow(Schema *schema)
+{
+    for(int i = 0; i < schema->numAttr; i++) {
+        if(schema->dataTypes[i] == DT_VARCHAR) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// get the name of the key index file of a table
+static char *indexFileName(char *name)
+{
+    char *fileName = (char *)malloc(strlen(name) + 5);
+    if(fileName != NULL) {
+        sprintf(fileName, "%s.idx", name);
+    }
+    return fileName;
+}
+
+// get the name of the file of a secondary index of a table
+static char *secondaryIndexFileName(char *table, char *name)
+{
+    char *fileName = (char *)malloc(strlen(table) + strlen(name) + 6);
+    if(fileName != NULL) {
+        sprintf(fileName, "%s.%s.idx", table, name);
+    }
+    return fileName;
+}
+
+// the size of the encoded attributes, they are concatenated
+static int attrsKeyLength(Schema *schema, int numAttrs, int *attrNums)
+{
+    int length = 0;
+    for(int i = 0; i < numAttrs; i++) {
+        int attrNum = attrNums[i];
+        length = length + keyLength(schema->dataTypes[attrNum], schema->typeLength[attrNum]);
+    }
+    return length;
+}
+
+// the size of the encoded key of a schema
+static int schemaKeyLength(Schema *schema)
+{
+    return attrsKeyLength(schema, schema->keySize, schema->keyAttrs);
+}
+
+// the size of the attributes included in the leaves of the key index, they
+// are stored as they are laid out in the record
+static int schemaPayloadLength(Schema *schema)
+{
+    int length = 0;
+    for(int i = 0; i < schema->numIncluded; i++) {
+        int attrNum = schema->includedAttrs[i];
+        int offset, end;
+        attrOffset(schema, attrNum, &offset);
+        attrOffset(schema, attrNum + 1, &end);
+        length = length + end - offset;
+    }
+    return length;
+}
+
+// copy the included attributes of a record to the payload of its key
+static void encodeRecordPayload(Schema *schema, Record *record, char *payload)
+{
+    for(int i = 0; i < schema->numIncluded; i++) {
+        int attrNum = schema->includedAttrs[i];
+        int offset, end;
+        attrOffset(schema, attrNum, &offset);
+        attrOffset(schema, attrNum + 1, &end);
+        memcpy(payload, record->data + offset, end - offset);
+        payload = payload + end - offset;
+    }
+}
+
+// copy the included attributes marked in attrs from a payload to a record
+static void decodeRecordPayload(Schema *schema, char *payload, Record *record, bool *attrs)
+{
+    for(int i = 0; i < schema->numIncluded; i++) {
+        int attrNum = schema->includedAttrs[i];
+        int offset, end;
+        attrOffset(schema, attrNum, &offset);
+        attrOffset(schema, attrNum + 1, &end);
+        if(attrs[attrNum]) {
+            memcpy(record->data + offset, payload, end - offset);
+        }
+        payload = payload + end - offset;
+    }
+}
+
+// set the key attributes marked in attrs of a record from its encoded key
+static RC decodeRecordKey(Schema *schema, char *key, Record *record, bool *attrs)
+{
+    for(int i = 0; i < schema->keySize; i++) {
+        int attrNum = schema->keyAttrs[i];
+        int length = keyLength(schema->dataTypes[attrNum], schema->typeLength[attrNum]);
+        if(attrs[attrNum]) {
+            Value *value;
+            RC rc = decodeKey(schema->dataTypes[attrNum], length, key, &value);
+            if(rc == RC_OK) {
+                rc = setAttr(record, schema, attrNum, value);
+                freeVal(value);
+            }
+            if(rc != RC_OK) {
+                return rc;
+            }
+        }
+        key = key + length;
+    }
+    return RC_OK;
+}
+
+// encode the attributes attrNums of a record one after another
+static RC encodeAttrs(Schema *schema, int numAttrs, int *attrNums, Record *record, char *key)
+{
+    for(int i = 0; i < numAttrs; i++) {
+        int attrNum = attrNums[i];
+        int length = keyLength(schema->dataTypes[attrNum], schema->typeLength[attrNum]);
+        Value value;
+        int size;
+        getAttrView(record, schema, attrNum, &value, &size);
+        if(value.dt == DT_STRING) {
+            // the view is only terminated if it is shorter than the attribute
+            memcpy(key, value.v.stringV, size);
+            memset(key + size, 0, length - size);
+        } else {
+            RC rc = encodeKey(value.dt, length, &value, key);
+            if(rc != RC_OK) {
+                return rc;
+            }
+        }
+        key = key + length;
+    }
+    return RC_OK;
+}
+
+// encode the key attributes of a record for the key index
+static RC encodeRecordKey(Schema *schema, Record *record, char *key)
+{
+    return encodeAttrs(schema, schema->keySize, schema->keyAttrs, record, key);
+}
+
+// encode the key of a record for a secondary index, its attributes followed
+// by its RID
+static RC encodeIndexKey(Schema *schema, SecondaryIndex *index, Record *record, char *key)
+{
+    RC rc = encodeAttrs(schema, index->numAttrs, index->attrNums, record, key);
+    char *rid = key + index->length - RID_KEY_LENGTH;
+    Value value;
+    value.dt = DT_INT;
+    value.v.intV = record->id.page;
+    if(rc == RC_OK) {
+        rc = encodeKey(DT_INT, 4, &value, rid);
+    }
+    value.v.intV = record->id.slot;
+    if(rc == RC_OK) {
+        rc = encodeKey(DT_INT, 4, &value, rid + 4);
+    }
+    return rc;
+}
+
+// take an overflow page off the free list or append a new one, pageData is
+// used to read the link of the free page. the overflow lock must be held.
+static int allocOverflowPage(char *pageData)
+{
+    if(overflowFreePage != 0) {
+        int pageNum = overflowFreePage;
+        if(readBlock(pageNum, &overflowHandle, pageData) != RC_OK) {
+            return -1;
+        }
+        overflowFreePage = readAttrInt(pageData);
+        return pageNum;
+    }
+    if(appendEmptyBlock(&overflowHandle) != RC_OK) {
+        return -1;
+    }
+    return overflowHandle.totalNumPages - 1;
+}
+
+// store length bytes on a new chain of overflow pages and return its first page
+static RC writeOverflow(char *data, int length, int *firstPage)
+{
+    char pageData[PAGE_SIZE];
+    RC rc = RC_OK;
+
+    pthread_mutex_lock(&overflowLock);
+    int pageNum = allocOverflowPage(pageData);
+    *firstPage = pageNum;
+    while(rc == RC_OK && length > 0) {
+        int chunk = length < OVERFLOW_PAGE_DATA ? length : OVERFLOW_PAGE_DATA;
+        int nextPage = length > chunk ? allocOverflowPage(pageData) : 0;
+        if(pageNum < 0 || nextPage < 0) {
+            rc = RC_WRITE_FAILED;
+            break;
+        }
+        memset(pageData, '\0', PAGE_SIZE);
+        writeAttrInt(pageData, nextPage);
+        writeAttrInt(pageData + 4, chunk);
+        memcpy(pageData + OVERFLOW_HEADER_SIZE, data, chunk);
+        rc = writeBlock(pageNum, &overflowHandle, pageData);
+
+        data = data + chunk;
+        length = length - chunk;
+        pageNum = nextPage;
+    }
+    pthread_mutex_unlock(&overflowLock);
+    return rc;
+}
+
+// read length bytes from the chain of overflow pages starting at pageNum
+static RC readOverflow(int pageNum, char *data, int length)
+{
+    char pageData[PAGE_SIZE];
+    RC rc = RC_OK;
+
+    pthread_mutex_lock(&overflowLock);
+    while(rc == RC_OK && length > 0 && pageNum > 0) {
+        rc = readBlock(pageNum, &overflowHandle, pageData);
+        if(rc != RC_OK) {
+            break;
+        }
+        // a damaged header must not make the copy leave the page
+        int chunk = readAttrInt(pageData + 4);
+        if(chunk < 0 || chunk > OVERFLOW_PAGE_DATA) {
+            rc = RC_ERROR;
+            break;
+        }
+        if(chunk > length) {
+            chunk = length;
+        }
+        memcpy(data, pageData + OVERFLOW_HEADER_SIZE, chunk);
+        data = data + chunk;
+        length = length - chunk;
+        pageNum = readAttrInt(pageData);
+    }
+    pthread_mutex_unlock(&overflowLock);
+    return rc;
+}
+
+// put the chain of overflow pages starting at pageNum in front of the free list
+static RC freeOverflow(int pageNum)
+{
+    char pageData[PAGE_SIZE];
+    RC rc = RC_OK;
+
+    pthread_mutex_lock(&overflowLock);
+    int firstPage = pageNum;
+    while(rc == RC_OK && pageNum > 0) {
+        rc = readBlock(pageNum, &overflowHandle, pageData);
+        int nextPage = readAttrInt(pageData);
+        if(rc == RC_OK && nextPage == 0) {
+            // link the last page of the chain to the old free list
+            writeAttrInt(pageData, overflowFreePage);
+            rc = writeBlock(pageNum, &overflowHandle, pageData);
+            overflowFreePage = firstPage;
+        }
+        pageNum = nextPage;
+    }
+    pthread_mutex_unlock(&overflowLock);
+    return rc;
+}
 
+// store the head of the free list on page 0 of the overflow file
+static RC writeOverflowHeader()
+{
+    char pageData[PAGE_SIZE];
+    memset(pageData, '\0', PAGE_SIZE);
+    writeAttrInt(pageData, overflowFreePage);
+    return writeBlock(0, &overflowHandle, pageData);
+}
 
 // initialize a record manager
 RC initRecordManager (void *mgmtData) 
@@ -71,12 +594,15 @@ RC createTable (char *name, Schema *schema)
         return RC_ERROR;
     }
 
-    // get serialize schema data
+    // get serialize schema data, pages are always written as a whole
     char *schemaInfo = serializeSchema(schema);
+    char *pageData = (char *)calloc(PAGE_SIZE, sizeof(char));
+    strncpy(pageData, schemaInfo, PAGE_SIZE - 1);
 
     // write the schema data to page 0
-    if(writeBlock(0, &fHandle, schemaInfo) != RC_OK) {
+    if(writeBlock(0, &fHandle, pageData) != RC_OK) {
         free(schemaInfo);
+        free(pageData);
         return RC_WRITE_FAILED;
     }
 
@@ -84,216 +610,1262 @@ RC createTable (char *name, Schema *schema)
     PageDirectory *pd = createPageDirectoryNode(2);
     // store this page directory info to a reserved page(2)
     char *pdInfo = serializePageDirectory(pd);
+    memset(pageData, '\0', PAGE_SIZE);
+    strcpy(pageData, pdInfo);
 
     ensureCapacity(2, &fHandle);
-    if(writeBlock(1, &fHandle, pdInfo) != RC_OK) {
+    if(writeBlock(1, &fHandle, pageData) != RC_OK) {
         free(pdInfo);
+        free(pageData);
         return RC_WRITE_FAILED;
     }
 
     // after page initialize, close those page to flush
     closePageFile(&fHandle);
 
-    // initalize gloabl data
-    numTuples = 0;
+    // long VARCHAR values are stored in the overflow file, its first page
+    // holds the empty free list
+    if(schemaHasOverflow(schema)) {
+        char *fileName = overflowFileName(name);
+        RC rc = createPageFile(fileName);
+        free(fileName);
+        if(rc != RC_OK) {
+            free(schemaInfo);
+            free(pageData);
+            free(pd);
+            free(pdInfo);
+            return RC_TABLE_CREATES_FAILED;
+        }
+    }
 
-    // count the max slots that be used in a single page
-    sizeRecord = getRecordSize(schema) + sizeof(int) + sizeof(int) + 2 + 2 + 2 + 3 + 1 + 3 + 1; 
-    // set the capacity a little bit lower than the value PAGE_SIZE / sizeRecord to consider overhead
-    capacity = 110; 
-    
-    // get max page directories that can be stored in a signle page
-    maxPageDiretories = PAGE_SIZE / strlen(pdInfo);
+    // the key index starts empty
+    if(schema->keySize > 0) {
+        char *fileName = indexFileName(name);
+        RC rc = createBtreeWithPayload(fileName, schema->dataTypes[schema->keyAttrs[0]],
+                                        schemaKeyLength(schema), schemaPayloadLength(schema), 0);
+        free(fileName);
+        if(rc != RC_OK) {
+            free(schemaInfo);
+            free(pageData);
+            free(pd);
+            free(pdInfo);
+            deleteTable(name);
+            return rc;
+        }
+    }
 
     // release all resources
     free(schemaInfo);
+    free(pageData);
     free(pd);
     free(pdInfo);
     return RC_OK;
 }
 
-// opening a table is to open a table since all operations require the table to be open first
-// here we set the name of table is the same as the file name
-RC openTable (RM_TableData *rel, char *name)
+// close the key index of the open table
+static RC closeKeyIndex()
 {
-    // check validation of input parameters
-    if(rel == NULL || name == NULL) {
-        return RC_PARAMS_ERROR;
-    }
-    
-    // check if the file specified by the filename exists
-    if(access(name, F_OK) == -1) {
-        return RC_TABLE_NOT_EXISTS;
+    if(keyIndex == NULL) {
+        return RC_OK;
     }
-
-    // do preparations, initialize the buffer pool
-    bm = (BM_BufferPool *)malloc(sizeof(BM_BufferPool));
-    
-    page = (BM_PageHandle *)malloc(sizeof(BM_PageHandle));
-
-    initBufferPool(bm, name, 3, RS_FIFO, NULL);
-
-    // read data from the page 0 since it stores table and schema info
-    pinPage(bm, page, 0);
-
-    // get schema info
-    Schema *schema = deserializeSchema(page->data);
-    unpinPage(bm, page);
-
-    // read data from the page 1 since it stores all page directories info
-    pinPage(bm, page, 1);
-
-    // get all page directories 
-    PageDirectoryCache *pageDirectoryCache = deserializePageDirectories(page->data); 
-
-    // store filename
-    rel->name = name;
-
-    // store this schema
-    rel->schema = schema;
-   
-    // store pageDirectoryCache
-    rel->mgmtData = pageDirectoryCache;
-
-    unpinPage(bm, page);
-    
-    return RC_OK;
+    RC rc = closeBtree(keyIndex);
+    keyIndex = NULL;
+    free(keyAttrs);
+    free(keyRecord.data);
+    return rc;
 }
 
-// closing a table is to cause all outstanding changes to the table to be written to the page file
-RC closeTable (RM_TableData *rel)
+// open the key index of a table, a table that was created without one gets
+// it built from its records
+static RC openKeyIndex(RM_TableData *rel)
 {
-    // check the validation of rel
-    if(rel == NULL) {
-        return RC_PARAMS_ERROR;
+    Schema *schema = rel->schema;
+    keyIndex = NULL;
+    if(schema->keySize == 0) {
+        return RC_OK;
     }
 
-    // write all page directories info to page 1
-    pinPage(bm, page, 1);
-    PageCache *pageCache = bm->mgmtData;
-    Frame *frame = searchPageFromCache(pageCache, page->pageNum);
-
-    PageDirectoryCache *pageDirectoryCache = rel->mgmtData;
-    char *pdInfo = serializePageDirectories(pageDirectoryCache);
-    strcpy(frame->data, pdInfo);
-    markDirty(bm, page);
-    unpinPage(bm, page);
-    forcePage(bm, page);
-
-    // close the buffer pool
-    shutdownBufferPool(bm);
-
-    // release schema resource
-    freeSchema(rel->schema);
-
-    // release all pageDirectory nodes
-    PageDirectory *p = pageDirectoryCache->front;
-    while(p != NULL) {
-        PageDirectory *temp = p->next;
-        free(p);
-        p = temp;
+    char *fileName = indexFileName(rel->name);
+    bool exists = access(fileName, F_OK) == 0;
+    RC rc = RC_OK;
+    if(!exists) {
+        rc = createBtreeWithPayload(fileName, schema->dataTypes[schema->keyAttrs[0]],
+                                    schemaKeyLength(schema), schemaPayloadLength(schema), 0);
+    }
+    if(rc == RC_OK) {
+        rc = openBtree(&keyIndex, fileName);
+    }
+    if(rc != RC_OK) {
+        free(fileName);
+        return rc;
     }
-    free(pageDirectoryCache);
 
-    // free the page info
-    free(page);
-    
+    keyIndexLength = schemaKeyLength(schema);
+    keyPayloadLength = schemaPayloadLength(schema);
+    keyAttrs = (bool *)calloc(schema->numAttr, sizeof(bool));
+    for(int i = 0; i < schema->keySize; i++) {
+        keyAttrs[schema->keyAttrs[i]] = true;
+    }
+    keyRecord.data = (char *)calloc(getRecordSize(schema), sizeof(char));
+
+    if(!exists) {
+        // the keys of the table are sorted and loaded bottom up
+        BT_LoadHandle *load;
+        if((rc = startBulkLoad(keyIndex, KEY_INDEX_FILL_PERCENT, 0, &load)) == RC_OK) {
+            RM_ScanHandle scan;
+            Record *record;
+            char *key = (char *)malloc(keyIndexLength + keyPayloadLength);
+            createRecord(&record, schema);
+            rc = startScan(rel, &scan, NULL);
+            while(rc == RC_OK && (rc = next(&scan, record)) == RC_OK) {
+                rc = encodeRecordKey(schema, record, key);
+                if(rc == RC_OK) {
+                    encodeRecordPayload(schema, record, key + keyIndexLength);
+                    rc = bulkLoadEncodedEntry(load, key, record->id, key + keyIndexLength);
+                }
+            }
+            if(rc == RC_RM_NO_MORE_TUPLES) {
+                rc = RC_OK;
+            }
+            closeScan(&scan);
+            freeRecord(record);
+            free(key);
+            if(rc == RC_OK) {
+                rc = finishBulkLoad(load);
+            } else {
+                cancelBulkLoad(load);
+            }
+        }
 
-    return RC_OK;
+        // records with duplicate keys leave the table without an index
+        if(rc != RC_OK) {
+            closeKeyIndex();
+            destroyPageFile(fileName);
+        }
+    }
+    free(fileName);
+    return rc;
 }
 
-// deleting a table is to delete this table
-RC deleteTable (char *name)
+// find the next line "index <name> on {<attrs>}" of the list of secondary
+// indexes which follows the schema on page 0, name has to hold
+// MAX_INDEX_NAME characters and attrs PAGE_SIZE. return the position of the
+// line or NULL if there is none.
+static char *nextCatalogEntry(char *pos, char *name, char *attrs)
 {
-    // check the validation of input parameters
-    if(name == NULL) {
-        return RC_FILE_NOT_FOUND;
-    }
-    // check whether the file with given name exists
-    if(access(name, F_OK) == -1) {
-        return RC_TABLE_NOT_EXISTS;
+    char *line = strstr(pos, "\nindex ");
+    if(line == NULL || sscanf(line + 1, "index %31s on {%4095[^}]}", name, attrs) != 2) {
+        return NULL;
     }
-    return destroyPageFile(name);
+    return line + 1;
 }
 
-// get the number of tuples in the table 
-int getNumTuples (RM_TableData *rel)
+// read the list of secondary indexes from page 0, their trees are opened by
+// openSecondaryIndexes
+static void readIndexCatalog(Schema *schema, char *pageData)
 {
-    return numTuples;
+    char name[MAX_INDEX_NAME];
+    char attrs[PAGE_SIZE];
+    int attrNums[schema->numAttr];
+    char *pos = pageData;
+    numSecondaryIndexes = 0;
+    while(numSecondaryIndexes < MAX_SECONDARY_INDEXES
+            && (pos = nextCatalogEntry(pos, name, attrs)) != NULL) {
+        int numAttrs = parseAttrNames(schema, attrs, attrNums);
+        int *copy = (int *)malloc(numAttrs * sizeof(int));
+        if(numAttrs == 0 || copy == NULL) {
+            free(copy);
+            continue;
+        }
+        memcpy(copy, attrNums, numAttrs * sizeof(int));
+        SecondaryIndex *index = &secondaryIndexes[numSecondaryIndexes++];
+        strcpy(index->name, name);
+        index->numAttrs = numAttrs;
+        index->attrNums = copy;
+        index->length = attrsKeyLength(schema, numAttrs, copy) + RID_KEY_LENGTH;
+        index->tree = NULL;
+    }
 }
 
-RC flushDataToPage(char *data, int offset, int pageNum)
+// store the schema followed by the list of secondary indexes on page 0
+static RC writeIndexCatalog(Schema *schema)
 {
-    if(data == NULL) {
-        return RC_PARAMS_ERROR;
+    char pageData[PAGE_SIZE];
+    char *schemaInfo = serializeSchema(schema);
+    memset(pageData, '\0', PAGE_SIZE);
+    int used = snprintf(pageData, PAGE_SIZE, "%s", schemaInfo);
+    free(schemaInfo);
+    for(int i = 0; used < PAGE_SIZE && i < numSecondaryIndexes; i++) {
+        SecondaryIndex *index = &secondaryIndexes[i];
+        used = used + snprintf(pageData + used, PAGE_SIZE - used, "index %s on {", index->name);
+        for(int j = 0; used < PAGE_SIZE && j < index->numAttrs; j++) {
+            used = used + snprintf(pageData + used, PAGE_SIZE - used, "%s%s",
+                                    j > 0 ? "," : "", schema->attrNames[index->attrNums[j]]);
+        }
+        if(used < PAGE_SIZE) {
+            used = used + snprintf(pageData + used, PAGE_SIZE - used, "}\n");
+        }
+    }
+    // leave room for the terminating null character
+    if(used >= PAGE_SIZE) {
+        return RC_WRITE_FAILED;
     }
 
-    // find the frame to be written
-    pinPage(bm, page, pageNum);
-    PageCache* pageCache = bm->mgmtData;
-    Frame* frame = searchPageFromCache(pageCache, page->pageNum);
-
-    // copy this data to frame data
-    memset(frame->data + offset, '\0', strlen(data));
-    strcpy(frame->data + offset, data);
-
-    markDirty(bm, page);
-    unpinPage(bm, page);
-    forcePage(bm, page);
+    BM_PageHandle handle;
+    if(pinPage(bm, &handle, 0) != RC_OK) {
+        return RC_WRITE_FAILED;
+    }
+    memcpy(handle.data, pageData, PAGE_SIZE);
+    markDirty(bm, &handle);
+    unpinPage(bm, &handle);
     return RC_OK;
 }
 
-// handling records in a table
-// get all records in current page
-void getRecords(RM_TableData *rel, char *recordStr, int size)
+// mark the attributes of all secondary indexes, which delete and update read
+// from a slot to find the old entries of a record
+static RC markIndexAttrs(Schema *schema)
 {
-    head = deserializeRecords(rel->schema, recordStr, size);
+    free(indexAttrs);
+    free(indexRecord.data);
+    indexAttrs = NULL;
+    indexRecord.data = NULL;
+    if(numSecondaryIndexes == 0) {
+        return RC_OK;
+    }
+    indexAttrs = (bool *)calloc(schema->numAttr, sizeof(bool));
+    indexRecord.data = (char *)calloc(getRecordSize(schema), sizeof(char));
+    if(indexAttrs == NULL || indexRecord.data == NULL) {
+        return RC_ALLOC_MEM_FAIL;
+    }
+    for(int i = 0; i < numSecondaryIndexes; i++) {
+        for(int j = 0; j < secondaryIndexes[i].numAttrs; j++) {
+            indexAttrs[secondaryIndexes[i].attrNums[j]] = true;
+        }
+    }
+    return RC_OK;
 }
 
-
-// insert a new record to the table
-// when a new record is inserted, the record manager should assign an RID to 
-// this record and update the record parameter passed to insertRecord
-RC insertRecord (RM_TableData *rel, Record *record)
+// create the file of a secondary index and load the entries of all records of
+// the table into it bottom up
+static RC buildSecondaryIndex(RM_TableData *rel, SecondaryIndex *index)
 {
-    
-    // check the validation of input parameters
-    if(rel == NULL || record == NULL) {
-        return RC_PARAMS_ERROR;
-    }
-
-    // get the schema data in this table
     Schema *schema = rel->schema;
-
-    // get the page directory info
+    char *fileName = secondaryIndexFileName(rel->name, index->name);
+    if(fileName == NULL) {
+        return RC_ALLOC_MEM_FAIL;
+    }
+    RC rc = createBtreeWithLength(fileName, schema->dataTypes[index->attrNums[0]], index->length, 0);
+    if(rc == RC_OK) {
+        rc = openBtree(&index->tree, fileName);
+    }
+    if(rc != RC_OK) {
+        free(fileName);
+        return rc;
+    }
+
+    BT_LoadHandle *load;
+    if((rc = startBulkLoad(index->tree, KEY_INDEX_FILL_PERCENT, 0, &load)) == RC_OK) {
+        RM_ScanHandle scan;
+        Record *record;
+        char *key = (char *)malloc(index->length);
+        createRecord(&record, schema);
+        rc = startProjectedScan(rel, &scan, NULL, index->numAttrs, index->attrNums);
+        while(rc == RC_OK && (rc = next(&scan, record)) == RC_OK) {
+            rc = encodeIndexKey(schema, index, record, key);
+            if(rc == RC_OK) {
+                rc = bulkLoadEncodedKey(load, key, record->id);
+            }
+        }
+        if(rc == RC_RM_NO_MORE_TUPLES) {
+            rc = RC_OK;
+        }
+        closeScan(&scan);
+        freeRecord(record);
+        free(key);
+        if(rc == RC_OK) {
+            rc = finishBulkLoad(load);
+        } else {
+            cancelBulkLoad(load);
+        }
+    }
+    if(rc != RC_OK) {
+        closeBtree(index->tree);
+        index->tree = NULL;
+        deleteBtree(fileName);
+    }
+    free(fileName);
+    return rc;
+}
+
+// open the secondary indexes read from page 0, an index whose file is missing
+// is built again from the records
+static RC openSecondaryIndexes(RM_TableData *rel)
+{
+    RC rc = RC_OK;
+    for(int i = 0; rc == RC_OK && i < numSecondaryIndexes; i++) {
+        SecondaryIndex *index = &secondaryIndexes[i];
+        char *fileName = secondaryIndexFileName(rel->name, index->name);
+        if(fileName == NULL) {
+            return RC_ALLOC_MEM_FAIL;
+        }
+        if(access(fileName, F_OK) == 0) {
+            rc = openBtree(&index->tree, fileName);
+        } else {
+            rc = buildSecondaryIndex(rel, index);
+        }
+        free(fileName);
+    }
+    if(rc != RC_OK) {
+        return rc;
+    }
+    return markIndexAttrs(rel->schema);
+}
+
+// close the secondary indexes of the open table
+static RC closeSecondaryIndexes()
+{
+    RC rc = RC_OK;
+    for(int i = 0; i < numSecondaryIndexes; i++) {
+        if(secondaryIndexes[i].tree != NULL) {
+            RC closeRc = closeBtree(secondaryIndexes[i].tree);
+            rc = rc == RC_OK ? closeRc : rc;
+        }
+        free(secondaryIndexes[i].attrNums);
+    }
+    numSecondaryIndexes = 0;
+    free(indexAttrs);
+    free(indexRecord.data);
+    indexAttrs = NULL;
+    indexRecord.data = NULL;
+    return rc;
+}
+
+// get the name of the zone map file of a table
+static char *zoneFileName(char *name)
+{
+    char *fileName = (char *)malloc(strlen(name) + 6);
+    if(fileName != NULL) {
+        sprintf(fileName, "%s.zone", name);
+    }
+    return fileName;
+}
+
+// compute the zone layout of a table. BOOL attributes have too few values to
+// tell pages apart and VARCHAR values may be stored out of line, so only the
+// other attributes get a zone map.
+static RC initZoneLayout(Schema *schema)
+{
+    zoneOffsets = (int *)calloc(schema->numAttr, sizeof(int));
+    zoneWidths = (int *)calloc(schema->numAttr, sizeof(int));
+    zoneAttrs = (bool *)calloc(schema->numAttr, sizeof(bool));
+    zones = NULL;
+    numZones = 0;
+    zonesValid = false;
+    if(zoneOffsets == NULL || zoneWidths == NULL || zoneAttrs == NULL) {
+        return RC_ALLOC_MEM_FAIL;
+    }
+    zoneSize = 1;
+    for(int i = 0; i < schema->numAttr; i++) {
+        DataType dt = schema->dataTypes[i];
+        if(dt == DT_BOOL || dt == DT_VARCHAR) {
+            continue;
+        }
+        int width = keyLength(dt, schema->typeLength[i]);
+        if(dt == DT_STRING && width > ZONE_PREFIX) {
+            width = ZONE_PREFIX;
+        }
+        zoneOffsets[i] = zoneSize;
+        zoneWidths[i] = width;
+        zoneAttrs[i] = true;
+        zoneSize = zoneSize + 2 * width;
+    }
+    return RC_OK;
+}
+
+// release the zone maps of the open table
+static void freeZoneMaps()
+{
+    free(zoneOffsets);
+    free(zoneWidths);
+    free(zoneAttrs);
+    free(zones);
+    zoneOffsets = NULL;
+    zoneWidths = NULL;
+    zoneAttrs = NULL;
+    zones = NULL;
+    numZones = 0;
+    zonesValid = false;
+}
+
+// the zone of a page, the zones grow to reach it and new zones are empty.
+// return NULL if they cannot grow.
+static char *pageZone(int pageNum)
+{
+    if(pageNum >= numZones) {
+        int newNum = numZones < 16 ? 16 : numZones * 2;
+        if(newNum <= pageNum) {
+            newNum = pageNum + 1;
+        }
+        char *newZones = (char *)realloc(zones, (size_t)newNum * zoneSize);
+        if(newZones == NULL) {
+            return NULL;
+        }
+        for(int i = numZones; i < newNum; i++) {
+            newZones[(size_t)i * zoneSize] = 1;
+        }
+        zones = newZones;
+        numZones = newNum;
+    }
+    return zones + (size_t)pageNum * zoneSize;
+}
+
+// widen the zone of a page by the values of a record stored on it. a zone
+// only shrinks when its page is emptied, so it may cover values that are gone.
+static void widenZone(Schema *schema, Record *record, int pageNum)
+{
+    char *zone = pageZone(pageNum);
+    if(zone == NULL) {
+        zonesValid = false;
+        return;
+    }
+    bool empty = zone[0] != 0;
+    zone[0] = 0;
+    for(int i = 0; i < schema->numAttr; i++) {
+        int width = zoneWidths[i];
+        if(width == 0) {
+            continue;
+        }
+        char key[keyLength(schema->dataTypes[i], schema->typeLength[i])];
+        char *min = zone + zoneOffsets[i];
+        char *max = min + width;
+        if(encodeAttrs(schema, 1, &i, record, key) != RC_OK) {
+            // a value that cannot be encoded may be anything
+            memset(min, 0x00, width);
+            memset(max, 0xFF, width);
+            continue;
+        }
+        if(empty || memcmp(key, min, width) < 0) {
+            memcpy(min, key, width);
+        }
+        if(empty || memcmp(key, max, width) > 0) {
+            memcpy(max, key, width);
+        }
+    }
+}
+
+// derive the zones a condition can match, the bounds of each attribute with
+// a zone map are encoded and cut to the width of its zone. exclusive bounds
+// are made inclusive. return NULL if the zone maps are lost.
+static ZoneFilter *createZoneFilter(Schema *schema, Expr *cond)
+{
+    if(!zonesValid) {
+        return NULL;
+    }
+    // the filter and its arrays are allocated at once
+    ZoneFilter *filter = (ZoneFilter *)calloc(1, sizeof(ZoneFilter) + 2 * zoneSize
+                                                + 2 * schema->numAttr * sizeof(bool));
+    if(filter == NULL) {
+        return NULL;
+    }
+    filter->numAttrs = schema->numAttr;
+    filter->hasLow = (bool *)(filter + 1);
+    filter->hasHigh = filter->hasLow + schema->numAttr;
+    filter->low = (char *)(filter->hasHigh + schema->numAttr);
+    filter->high = filter->low + zoneSize;
+    for(int i = 0; cond != NULL && i < schema->numAttr; i++) {
+        int width = zoneWidths[i];
+        if(width == 0) {
+            continue;
+        }
+        DataType dt = schema->dataTypes[i];
+        int length = keyLength(dt, schema->typeLength[i]);
+        char key[length];
+        KeyRange range;
+        extractKeyRange(cond, i, &range);
+        // a bound that cannot be encoded, like a constant of another
+        // datatype, leaves that end open
+        if(range.hasLow && encodeKey(dt, length, &range.low, key) == RC_OK) {
+            memcpy(filter->low + zoneOffsets[i], key, width);
+            filter->hasLow[i] = true;
+        }
+        if(range.hasHigh && encodeKey(dt, length, &range.high, key) == RC_OK) {
+            memcpy(filter->high + zoneOffsets[i], key, width);
+            filter->hasHigh[i] = true;
+        }
+    }
+    return filter;
+}
+
+// whether a page may hold a record the filter accepts, empty pages never do.
+// the bounds and zones of strings are prefixes, which compare the same way as
+// long as the comparison is strict.
+static bool zoneMayMatch(ZoneFilter *filter, int pageNum)
+{
+    if(filter == NULL || pageNum >= numZones) {
+        return true;
+    }
+    char *zone = zones + (size_t)pageNum * zoneSize;
+    if(zone[0] != 0) {
+        return false;
+    }
+    for(int i = 0; i < filter->numAttrs; i++) {
+        char *min = zone + zoneOffsets[i];
+        char *max = min + zoneWidths[i];
+        if(filter->hasLow[i] && memcmp(filter->low + zoneOffsets[i], max, zoneWidths[i]) > 0) {
+            return false;
+        }
+        if(filter->hasHigh[i] && memcmp(filter->high + zoneOffsets[i], min, zoneWidths[i]) < 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// store the zones of pages 0 to count - 1 in the zone map file, page 0 holds
+// the size of a zone and their number and the zones follow from page 1 on.
+// lost zone maps are deleted so the next openTable rebuilds them.
+static RC writeZoneMaps(char *name, int count)
+{
+    char *fileName = zoneFileName(name);
+    if(fileName == NULL) {
+        return RC_ALLOC_MEM_FAIL;
+    }
+    if(!zonesValid || pageZone(count - 1) == NULL) {
+        if(access(fileName, F_OK) == 0) {
+            destroyPageFile(fileName);
+        }
+        free(fileName);
+        return RC_OK;
+    }
+
+    SM_FileHandle fh;
+    RC rc = createPageFile(fileName);
+    if(rc == RC_OK) {
+        rc = openPageFile(fileName, &fh);
+    }
+    if(rc != RC_OK) {
+        free(fileName);
+        return rc;
+    }
+    long bytes = (long)count * zoneSize;
+    int numPages = 1 + (int)((bytes + PAGE_SIZE - 1) / PAGE_SIZE);
+    char pageData[PAGE_SIZE];
+    memset(pageData, 0, PAGE_SIZE);
+    writeAttrInt(pageData, zoneSize);
+    writeAttrInt(pageData + 4, count);
+    rc = ensureCapacity(numPages, &fh);
+    if(rc == RC_OK) {
+        rc = writeBlock(0, &fh, pageData);
+    }
+    for(int i = 1; rc == RC_OK && i < numPages; i++) {
+        long offset = (long)(i - 1) * PAGE_SIZE;
+        memset(pageData, 0, PAGE_SIZE);
+        memcpy(pageData, zones + offset, bytes - offset < PAGE_SIZE ? bytes - offset : PAGE_SIZE);
+        rc = writeBlock(i, &fh, pageData);
+    }
+    closePageFile(&fh);
+    if(rc != RC_OK) {
+        destroyPageFile(fileName);
+    }
+    free(fileName);
+    return rc;
+}
+
+// compute the zone maps of the open table from its records
+static RC rebuildZoneMaps(RM_TableData *rel)
+{
+    Schema *schema = rel->schema;
+    PageDirectoryCache *pageDirectoryCache = rel->mgmtData;
+    free(zones);
+    zones = NULL;
+    numZones = 0;
+    zonesValid = false;
+    if(pageZone(pageDirectoryCache->rear->pageNum) == NULL) {
+        return RC_ALLOC_MEM_FAIL;
+    }
+
+    // only the attributes with a zone map are decoded
+    int numProj = 0;
+    int projAttrs[schema->numAttr];
+    for(int i = 0; i < schema->numAttr; i++) {
+        if(zoneAttrs[i]) {
+            projAttrs[numProj++] = i;
+        }
+    }
+    RM_ScanHandle scan;
+    Record *record;
+    RC rc = createRecord(&record, schema);
+    if(rc != RC_OK) {
+        return rc;
+    }
+    rc = startProjectedScan(rel, &scan, NULL, numProj, projAttrs);
+    while(rc == RC_OK && (rc = next(&scan, record)) == RC_OK) {
+        widenZone(schema, record, record->id.page);
+    }
+    if(rc == RC_RM_NO_MORE_TUPLES) {
+        rc = RC_OK;
+    }
+    closeScan(&scan);
+    freeRecord(record);
+    zonesValid = rc == RC_OK;
+    return rc;
+}
+
+// read the zone maps of the open table, they are rebuilt from its records if
+// their file is missing or belongs to another layout or number of pages
+static RC loadZoneMaps(RM_TableData *rel)
+{
+    PageDirectoryCache *pageDirectoryCache = rel->mgmtData;
+    int count = pageDirectoryCache->rear->pageNum + 1;
+    char *fileName = zoneFileName(rel->name);
+    if(fileName == NULL) {
+        return RC_ALLOC_MEM_FAIL;
+    }
+    SM_FileHandle fh;
+    bool loaded = false;
+    if(access(fileName, F_OK) == 0 && openPageFile(fileName, &fh) == RC_OK) {
+        char pageData[PAGE_SIZE];
+        loaded = readBlock(0, &fh, pageData) == RC_OK && readAttrInt(pageData) == zoneSize
+                    && readAttrInt(pageData + 4) == count && pageZone(count - 1) != NULL;
+        long bytes = (long)count * zoneSize;
+        for(int i = 1; loaded && (long)(i - 1) * PAGE_SIZE < bytes; i++) {
+            long offset = (long)(i - 1) * PAGE_SIZE;
+            loaded = readBlock(i, &fh, pageData) == RC_OK;
+            memcpy(zones + offset, pageData, bytes - offset < PAGE_SIZE ? bytes - offset : PAGE_SIZE);
+        }
+        closePageFile(&fh);
+    }
+    free(fileName);
+    if(loaded) {
+        zonesValid = true;
+        return RC_OK;
+    }
+    return rebuildZoneMaps(rel);
+}
+
+// opening a table is to open a table since all operations require the table to be open first
+// here we set the name of table is the same as the file name
+// release what openTable acquired before it failed, pageDirectoryCache is
+// NULL if the page directories were not read yet
+static void abortOpenTable(Schema *schema, PageDirectoryCache *pageDirectoryCache, bool overflowOpen)
+{
+    closeKeyIndex();
+    closeSecondaryIndexes();
+    freeZoneMaps();
+    if(overflowOpen) {
+        closePageFile(&overflowHandle);
+    }
+    hasOverflow = false;
+    if(pageDirectoryCache != NULL) {
+        PageDirectory *p = pageDirectoryCache->front;
+        while(p != NULL) {
+            PageDirectory *temp = p->next;
+            free(p);
+            p = temp;
+        }
+        free(pageDirectoryCache);
+    }
+    freeSchema(schema);
+    shutdownBufferPool(bm);
+    free(page);
+    bm = NULL;
+    page = NULL;
+}
+
+RC openTable (RM_TableData *rel, char *name)
+{
+    // check validation of input parameters
+    if(rel == NULL || name == NULL) {
+        return RC_PARAMS_ERROR;
+    }
+    
+    // check if the file specified by the filename exists
+    if(access(name, F_OK) == -1) {
+        return RC_TABLE_NOT_EXISTS;
+    }
+
+    // do preparations, initialize the buffer pool
+    bm = (BM_BufferPool *)malloc(sizeof(BM_BufferPool));
+    
+    page = (BM_PageHandle *)malloc(sizeof(BM_PageHandle));
+
+    initBufferPool(bm, name, 3, RS_FIFO, NULL);
+
+    // read data from the page 0 since it stores table and schema info
+    pinPage(bm, page, 0);
+
+    // get schema info and the secondary indexes listed behind it
+    Schema *schema = deserializeSchema(page->data);
+    readIndexCatalog(schema, page->data);
+    unpinPage(bm, page);
+
+    // the layout only depends on the schema, so any table can be reopened
+    initSlotLayout(schema);
+    if(initZoneLayout(schema) != RC_OK) {
+        abortOpenTable(schema, NULL, false);
+        return RC_ALLOC_MEM_FAIL;
+    }
+
+    // open the overflow file and read the head of its free list
+    if(hasOverflow) {
+        char *fileName = overflowFileName(name);
+        RC rc = openPageFile(fileName, &overflowHandle);
+        free(fileName);
+        if(rc != RC_OK) {
+            abortOpenTable(schema, NULL, false);
+            return RC_FILE_NOT_FOUND;
+        }
+        char pageData[PAGE_SIZE];
+        readBlock(0, &overflowHandle, pageData);
+        overflowFreePage = readAttrInt(pageData);
+    }
+
+    // get all page directories, the first ones are stored on page 1
+    PageDirectoryCache *pageDirectoryCache = readPageDirectories();
+    if(pageDirectoryCache == NULL) {
+        abortOpenTable(schema, NULL, hasOverflow);
+        return RC_ERROR;
+    }
+
+    // store filename
+    rel->name = name;
+
+    // store this schema
+    rel->schema = schema;
+   
+    // store pageDirectoryCache
+    rel->mgmtData = pageDirectoryCache;
+
+    numTuples = 0;
+    for(PageDirectory *p = pageDirectoryCache->front; p != NULL; p = p->next) {
+        numTuples = numTuples + p->count;
+    }
+
+    RC rc = loadZoneMaps(rel);
+    if(rc == RC_OK) {
+        rc = openKeyIndex(rel);
+    }
+    if(rc == RC_OK) {
+        rc = openSecondaryIndexes(rel);
+    }
+    if(rc != RC_OK) {
+        abortOpenTable(schema, pageDirectoryCache, hasOverflow);
+        rel->schema = NULL;
+        rel->mgmtData = NULL;
+    }
+    return rc;
+}
+
+// closing a table is to cause all outstanding changes to the table to be written to the page file
+RC closeTable (RM_TableData *rel)
+{
+    // check the validation of rel
+    if(rel == NULL) {
+        return RC_PARAMS_ERROR;
+    }
+
+    // write all page directories info starting at page 1
     PageDirectoryCache *pageDirectoryCache = rel->mgmtData;
+    writePageDirectories(pageDirectoryCache);
+    writeZoneMaps(rel->name, pageDirectoryCache->rear->pageNum + 1);
+    freeZoneMaps();
+
+    // close the buffer pool
+    shutdownBufferPool(bm);
+
+    // keep the free overflow pages for the next time the table is opened
+    if(hasOverflow) {
+        writeOverflowHeader();
+        closePageFile(&overflowHandle);
+        hasOverflow = false;
+    }
+    closeKeyIndex();
+    closeSecondaryIndexes();
+
+    // release schema resource
+    freeSchema(rel->schema);
+
+    // release all pageDirectory nodes
+    PageDirectory *p = pageDirectoryCache->front;
+    while(p != NULL) {
+        PageDirectory *temp = p->next;
+        free(p);
+        p = temp;
+    }
+    free(pageDirectoryCache);
+
+    // free the page info
+    free(page);
+    
+
+    return RC_OK;
+}
+
+// deleting a table is to delete this table
+RC deleteTable (char *name)
+{
+    // check the validation of input parameters
+    if(name == NULL) {
+        return RC_FILE_NOT_FOUND;
+    }
+    // check whether the file with given name exists
+    if(access(name, F_OK) == -1) {
+        return RC_TABLE_NOT_EXISTS;
+    }
+    char *fileName = overflowFileName(name);
+    if(fileName != NULL && access(fileName, F_OK) == 0) {
+        destroyPageFile(fileName);
+    }
+    free(fileName);
+    fileName = zoneFileName(name);
+    if(fileName != NULL && access(fileName, F_OK) == 0) {
+        destroyPageFile(fileName);
+    }
+    free(fileName);
+    fileName = indexFileName(name);
+    if(fileName != NULL && access(fileName, F_OK) == 0) {
+        deleteBtree(fileName);
+    }
+    free(fileName);
+
+    // the secondary indexes are listed on page 0
+    SM_FileHandle fh;
+    if(openPageFile(name, &fh) == RC_OK) {
+        char pageData[PAGE_SIZE + 1];
+        pageData[PAGE_SIZE] = '\0';
+        if(readBlock(0, &fh, pageData) == RC_OK) {
+            char indexName[MAX_INDEX_NAME];
+            char attrs[PAGE_SIZE];
+            char *pos = pageData;
+            while((pos = nextCatalogEntry(pos, indexName, attrs)) != NULL) {
+                fileName = secondaryIndexFileName(name, indexName);
+                if(fileName != NULL && access(fileName, F_OK) == 0) {
+                    deleteBtree(fileName);
+                }
+                free(fileName);
+            }
+        }
+        closePageFile(&fh);
+    }
+    return destroyPageFile(name);
+}
+
+// get the number of tuples in the table 
+int getNumTuples (RM_TableData *rel)
+{
+    if(rel == NULL)
+        return 0;
+    return numTuples;
+}
+
+// create a secondary index over the attributes attrNums of the open table,
+// any number of records may share their values. it is loaded from the records
+// of the table and kept up to date by insertRecord, updateRecord, deleteRecord
+// and compactTable, scans use it when their condition bounds its attributes.
+RC createIndex (RM_TableData *rel, int numAttrs, int *attrNums, char *name)
+{
+    if(rel == NULL || attrNums == NULL || name == NULL || numAttrs <= 0
+            || numAttrs > rel->schema->numAttr) {
+        return RC_PARAMS_ERROR;
+    }
+    // the name becomes part of the index file name and of page 0
+    size_t nameLength = strlen(name);
+    if(nameLength == 0 || nameLength >= MAX_INDEX_NAME
+            || strspn(name, INDEX_NAME_CHARS) != nameLength) {
+        return RC_PARAMS_ERROR;
+    }
+    Schema *schema = rel->schema;
+    for(int i = 0; i < numAttrs; i++) {
+        if(attrNums[i] < 0 || attrNums[i] >= schema->numAttr) {
+            return RC_PARAMS_ERROR;
+        }
+    }
+    for(int i = 0; i < numSecondaryIndexes; i++) {
+        if(strcmp(secondaryIndexes[i].name, name) == 0) {
+            return RC_IM_INDEX_EXISTS;
+        }
+    }
+    if(numSecondaryIndexes == MAX_SECONDARY_INDEXES) {
+        return RC_PARAMS_ERROR;
+    }
+
+    SecondaryIndex *index = &secondaryIndexes[numSecondaryIndexes];
+    index->attrNums = (int *)malloc(numAttrs * sizeof(int));
+    if(index->attrNums == NULL) {
+        return RC_ALLOC_MEM_FAIL;
+    }
+    strcpy(index->name, name);
+    index->numAttrs = numAttrs;
+    memcpy(index->attrNums, attrNums, numAttrs * sizeof(int));
+    index->length = attrsKeyLength(schema, numAttrs, attrNums) + RID_KEY_LENGTH;
+    index->tree = NULL;
+    RC rc = buildSecondaryIndex(rel, index);
+    if(rc != RC_OK) {
+        free(index->attrNums);
+        return rc;
+    }
+    numSecondaryIndexes++;
+    rc = writeIndexCatalog(schema);
+    if(rc == RC_OK) {
+        rc = markIndexAttrs(schema);
+    }
+    if(rc != RC_OK) {
+        dropIndex(rel, name);
+    }
+    return rc;
+}
+
+// drop a secondary index of the open table and delete its file
+RC dropIndex (RM_TableData *rel, char *name)
+{
+    if(rel == NULL || name == NULL) {
+        return RC_PARAMS_ERROR;
+    }
+    int i = 0;
+    while(i < numSecondaryIndexes && strcmp(secondaryIndexes[i].name, name) != 0) {
+        i++;
+    }
+    if(i == numSecondaryIndexes) {
+        return RC_IM_INDEX_NOT_FOUND;
+    }
+
+    SecondaryIndex *index = &secondaryIndexes[i];
+    char *fileName = secondaryIndexFileName(rel->name, index->name);
+    RC rc = closeBtree(index->tree);
+    if(fileName != NULL) {
+        deleteBtree(fileName);
+    }
+    free(fileName);
+    free(index->attrNums);
+    memmove(index, index + 1, (numSecondaryIndexes - i - 1) * sizeof(SecondaryIndex));
+    numSecondaryIndexes--;
+
+    RC catalogRc = writeIndexCatalog(rel->schema);
+    RC markRc = markIndexAttrs(rel->schema);
+    if(rc == RC_OK) {
+        rc = catalogRc != RC_OK ? catalogRc : markRc;
+    }
+    return rc;
+}
+
+// find the page directory of a data page
+static PageDirectory *findPageDirectory(PageDirectoryCache *pageDirectoryCache, int pageNum)
+{
+    PageDirectory *p = pageDirectoryCache->front;
+    while(p != NULL && p->pageNum != pageNum) {
+        p = p->next;
+    }
+    return p;
+}
+
+// whether the slot stores the record with the given RID
+static bool slotHoldsRecord(char *slotData, RID id)
+{
+    if(slotData[0] != '[') {
+        return false;
+    }
+    char data[5];
+    data[4] = '\0';
+    memcpy(data, slotData + 1, 4);
+    int pageNum = (int)strtol(data, NULL, 10);
+    memcpy(data, slotData + 6, 4);
+    int slot = (int)strtol(data, NULL, 10);
+    return pageNum == id.page && slot == id.slot;
+}
+
+// free the overflow pages of the first numAttr attributes of the record stored
+// in the slot
+static RC releaseOverflowAttrs(char *slotData, Schema *schema, int numAttr)
+{
+    RC rc = RC_OK;
+    for(int i = 0; rc == RC_OK && hasOverflow && i < numAttr; i++) {
+        if(schema->dataTypes[i] != DT_VARCHAR) {
+            continue;
+        }
+        int pos;
+        slotAttrOffset(schema, i, &pos);
+        if(readAttrInt(slotData + pos) > VARCHAR_INLINE_SIZE) {
+            rc = freeOverflow(readAttrInt(slotData + pos + 4));
+        }
+    }
+    return rc;
+}
+
+// free the overflow pages of the record stored in the slot before the slot
+// is overwritten
+static RC releaseSlot(char *slotData, Schema *schema)
+{
+    return releaseOverflowAttrs(slotData, schema, schema->numAttr);
+}
+
+// write a record into its slot, see serializeRecordSlot for the format. the
+// part of a long VARCHAR behind its inline prefix is written to a new chain of
+// overflow pages whose first page is stored in the slot. the chains written
+// before a failure are freed again.
+static RC writeSlot(char *slotData, Schema *schema, Record *record)
+{
+    serializeRecordSlot(record, schema, slotData, sizeRecord);
+    for(int i = 0; hasOverflow && i < schema->numAttr; i++) {
+        if(schema->dataTypes[i] != DT_VARCHAR) {
+            continue;
+        }
+        int pos;
+        slotAttrOffset(schema, i, &pos);
+        int length = readAttrInt(slotData + pos);
+        if(length <= VARCHAR_INLINE_SIZE) {
+            continue;
+        }
+        int offset;
+        int firstPage;
+        attrOffset(schema, i, &offset);
+        RC rc = writeOverflow(record->data + offset + VARCHAR_INLINE_SIZE,
+                                length - VARCHAR_INLINE_SIZE, &firstPage);
+        if(rc != RC_OK) {
+            releaseOverflowAttrs(slotData, schema, i);
+            return rc;
+        }
+        writeAttrInt(slotData + pos + 4, firstPage);
+    }
+    return RC_OK;
+}
+
+// read the attributes marked in attrs, all of them without attrs, from a slot
+// and complete the long VARCHAR values from their overflow pages
+static RC readSlot(char *slotData, Schema *schema, Record *record, bool *attrs)
+{
+    RC rc = deserializeRecordAttrs(schema, slotData, record, attrs);
+    for(int i = 0; rc == RC_OK && hasOverflow && i < schema->numAttr; i++) {
+        if(schema->dataTypes[i] != DT_VARCHAR || (attrs != NULL && !attrs[i])) {
+            continue;
+        }
+        int pos;
+        slotAttrOffset(schema, i, &pos);
+        int length = readAttrInt(slotData + pos);
+        if(length <= VARCHAR_INLINE_SIZE) {
+            continue;
+        }
+        int offset;
+        attrOffset(schema, i, &offset);
+        rc = readOverflow(readAttrInt(slotData + pos + 4),
+                            record->data + offset + VARCHAR_INLINE_SIZE,
+                            length - VARCHAR_INLINE_SIZE);
+    }
+    return rc;
+}
+
+// encode the key of the record stored in a slot
+static RC encodeSlotKey(Schema *schema, char *slotData, char *key)
+{
+    RC rc = readSlot(slotData, schema, &keyRecord, keyAttrs);
+    if(rc != RC_OK) {
+        return rc;
+    }
+    return encodeRecordKey(schema, &keyRecord, key);
+}
+
+// a deleted slot keeps the tombstone "[0000-NNNN]" where NNNN links to the next
+// free slot of the page. records are never stored on page 0, so a tombstone
+// cannot be mistaken for a record.
+static void writeTombstone(char *slotData, int nextFreeSlot)
+{
+    char data[5];
+    memset(data, '0', sizeof(char)*4);
+    PageInfoToString(3, nextFreeSlot, data);
+    memset(slotData, '\0', sizeRecord);
+    sprintf(slotData, "[0000-%s]", data);
+}
+
+// the free slot following a free slot, the free slots of a page form a chain
+// through their tombstones which ends at the first slot that was never used
+static int nextFreeSlot(char *slotData, int slot)
+{
+    if(slotData[0] != '[' || strncmp(slotData + 1, "0000", 4) != 0) {
+        return slot + 1;
+    }
+    char data[5];
+    memcpy(data, slotData + 6, 4);
+    data[4] = '\0';
+    return (int)strtol(data, NULL, 10);
+}
+
+// turn a slot of a page into the head of its free chain
+static void freeSlot(PageDirectory *pd, Schema *schema, char *slotData, int slot)
+{
+    releaseSlot(slotData, schema);
+    writeTombstone(slotData, pd->firstFreeSlot);
+    pd->firstFreeSlot = slot;
+    pd->count = pd->count - 1;
+    // an empty page holds no values, so its zone is reset
+    if(pd->count == 0 && pd->pageNum < numZones) {
+        zones[(size_t)pd->pageNum * zoneSize] = 1;
+    }
+}
+
+static RC deleteIndexEntries(Schema *schema, Record *record, int count);
+
+// add the entries of a record to the first count secondary indexes, the
+// entries added before a failure are removed again
+static RC insertIndexEntries(Schema *schema, Record *record, int count)
+{
+    for(int i = 0; i < count; i++) {
+        SecondaryIndex *index = &secondaryIndexes[i];
+        char key[index->length];
+        RC rc = encodeIndexKey(schema, index, record, key);
+        if(rc == RC_OK) {
+            rc = insertEncodedKey(index->tree, key, record->id);
+        }
+        if(rc != RC_OK) {
+            deleteIndexEntries(schema, record, i);
+            return rc;
+        }
+    }
+    return RC_OK;
+}
+
+// remove the entries of a record from the first count secondary indexes, the
+// entries removed before a failure are added again
+static RC deleteIndexEntries(Schema *schema, Record *record, int count)
+{
+    for(int i = 0; i < count; i++) {
+        SecondaryIndex *index = &secondaryIndexes[i];
+        char key[index->length];
+        RC rc = encodeIndexKey(schema, index, record, key);
+        if(rc == RC_OK) {
+            rc = deleteEncodedKey(index->tree, key);
+        }
+        if(rc != RC_OK) {
+            insertIndexEntries(schema, record, i);
+            return rc;
+        }
+    }
+    return RC_OK;
+}
+
+// move the entries of a record in the first count secondary indexes from the
+// values and RID of from to those of to, only the attributes of the indexes
+// have to be set. the entries moved before a failure are moved back.
+static RC moveIndexEntries(Schema *schema, Record *from, Record *to, int count)
+{
+    for(int i = 0; i < count; i++) {
+        SecondaryIndex *index = &secondaryIndexes[i];
+        char oldKey[index->length];
+        char newKey[index->length];
+        RC rc = encodeIndexKey(schema, index, from, oldKey);
+        if(rc == RC_OK) {
+            rc = encodeIndexKey(schema, index, to, newKey);
+        }
+        if(rc == RC_OK && memcmp(oldKey, newKey, index->length) != 0) {
+            rc = deleteEncodedKey(index->tree, oldKey);
+            if(rc == RC_OK && (rc = insertEncodedKey(index->tree, newKey, to->id)) != RC_OK) {
+                insertEncodedKey(index->tree, oldKey, from->id);
+            }
+        }
+        if(rc != RC_OK) {
+            moveIndexEntries(schema, to, from, i);
+            return rc;
+        }
+    }
+    return RC_OK;
+}
+
+// take a record stored by insertIntoPage out of its page again
+static void removeFromPage(PageDirectory *pd, Schema *schema, int slot)
+{
+    BM_PageHandle handle;
+    if(pinPage(bm, &handle, pd->pageNum) == RC_OK) {
+        freeSlot(pd, schema, handle.data + slot * sizeRecord, slot);
+        markDirty(bm, &handle);
+        unpinPage(bm, &handle);
+    }
+}
+
+// store the record in the first free slot of the page and assign its RID
+static RC insertIntoPage(PageDirectory *pd, Schema *schema, Record *record)
+{
+    BM_PageHandle handle;
+    if(pinPage(bm, &handle, pd->pageNum) != RC_OK) {
+        return RC_WRITE_FAILED;
+    }
+
+    // pop the first free slot off the free chain of this page
+    int slot = pd->firstFreeSlot;
+    char *slotData = handle.data + slot * sizeRecord;
+    pd->firstFreeSlot = nextFreeSlot(slotData, slot);
+
+    // set page and slot to current record
+    record->id.page = pd->pageNum;
+    record->id.slot = slot;
+
+    // store this record to its slot
+    RC rc = writeSlot(slotData, schema, record);
+    if(rc != RC_OK) {
+        // give the slot back to the free chain
+        writeTombstone(slotData, pd->firstFreeSlot);
+        pd->firstFreeSlot = slot;
+    }
+    markDirty(bm, &handle);
+    unpinPage(bm, &handle);
+    if(rc != RC_OK) {
+        return rc;
+    }
 
-    int lastPageNum;
-    int lastFreeSlot;
-    int lastPageCount;
-    PageDirectory *lastPD;
+    // update page directory cache
+    pd->count = pd->count + 1;
+    widenZone(schema, record, pd->pageNum);
+    return RC_OK;
+}
 
-    // if the page exists an empty slot
-    PageDirectory *p = pageDirectoryCache->front;
-    while(p != NULL) {
-        if(p->count < capacity) {
-            lastPD = p;
-            break;
+// handling records in a table
+
+// insert a new record to the table
+// when a new record is inserted, the record manager should assign an RID to 
+// this record and update the record parameter passed to insertRecord. once
+// the pages up to MAX_DATA_PAGE are full the table rejects it with
+// RC_RM_TABLE_FULL
+RC insertRecord (RM_TableData *rel, Record *record)
+{
+    // check the validation of input parameters
+    if(rel == NULL || record == NULL) {
+        return RC_PARAMS_ERROR;
+    }
+
+    // a record whose key is taken is rejected before it is stored
+    char *key = NULL;
+    if(keyIndex != NULL) {
+        RID existing;
+        key = (char *)malloc(keyIndexLength + keyPayloadLength);
+        RC rc = encodeRecordKey(rel->schema, record, key);
+        if(rc == RC_OK && findEncodedKey(keyIndex, key, &existing) == RC_OK) {
+            rc = RC_IM_KEY_ALREADY_EXISTS;
+        }
+        if(rc != RC_OK) {
+            free(key);
+            return rc;
         }
-        p = p->next;
     }
-    // if all pages are full
-    if(p == NULL) {
-        // get the last page directory and get its pageNum
-        lastPageNum = pageDirectoryCache->rear->pageNum + 1; 
 
-        // create a new page directory node
-        PageDirectory *pd = createPageDirectoryNode(lastPageNum);
-        if(pageDirectoryCache->count % maxPageDiretories == 0)  {
-            // this new page will store another page directories
-            lastPageNum = pageDirectoryCache->rear->pageNum + 1;
-            char *pdStr = serializePageDirectory(pd);
-            flushDataToPage(pdStr, 0, lastPageNum);
+    // get the page directory info
+    PageDirectoryCache *pageDirectoryCache = rel->mgmtData;
+
+    // find the first page with an empty slot
+    PageDirectory *pd = pageDirectoryCache->front;
+    while(pd != NULL && pd->count >= capacity) {
+        pd = pd->next;
+    }
+    // if all pages are full, append a new page skipping the directory pages
+    if(pd == NULL) {
+        int newPageNum = pageDirectoryCache->rear->pageNum + 1;
+        if(isDirectoryPage(newPageNum)) {
+            newPageNum++;
+        }
+        if(newPageNum > MAX_DATA_PAGE) {
+            free(key);
+            return RC_RM_TABLE_FULL;
+        }
+        pd = createPageDirectoryNode(newPageNum);
+        if(pd == NULL) {
+            free(key);
+            return RC_ALLOC_MEM_FAIL;
         }
 
         // update page directory cache
@@ -301,298 +1873,1241 @@ RC insertRecord (RM_TableData *rel, Record *record)
         pd->pre = pageDirectoryCache->rear;
         pageDirectoryCache->rear = pd;
         pageDirectoryCache->count = pageDirectoryCache->count + 1;
+    }
+
+    RC rc = insertIntoPage(pd, rel->schema, record);
+    if(rc != RC_OK) {
+        free(key);
+        return rc;
+    }
+
+    // the record is taken out of its page again when an index fails to add it
+    if(key != NULL) {
+        encodeRecordPayload(rel->schema, record, key + keyIndexLength);
+        rc = insertEncodedEntry(keyIndex, key, record->id, key + keyIndexLength);
+    }
+    if(rc == RC_OK) {
+        rc = insertIndexEntries(rel->schema, record, numSecondaryIndexes);
+        if(rc != RC_OK && key != NULL) {
+            deleteEncodedKey(keyIndex, key);
+        }
+    }
+    if(rc != RC_OK) {
+        removeFromPage(pd, rel->schema, record->id.slot);
+    }
+    free(key);
+    if(rc != RC_OK) {
+        return rc;
+    }
+    // update number of tuples
+    numTuples++;
+
+    return RC_OK;
+}
+
+// delete a record with a certain RID, its slot becomes the head of the free
+// chain of the page so the next insert into this page reuses it
+RC deleteRecord (RM_TableData *rel, RID id)
+{
+    if(rel == NULL) {
+        return RC_PARAMS_ERROR;
+    }
+    PageDirectory *pd = findPageDirectory(rel->mgmtData, id.page);
+    if(pd == NULL || id.slot < 0 || id.slot >= capacity) {
+        return RC_PARAMS_ERROR;
+    }
+
+    BM_PageHandle handle;
+    if(pinPage(bm, &handle, id.page) != RC_OK) {
+        return RC_READ_NON_EXISTING_PAGE;
+    }
+    char *slotData = handle.data + id.slot * sizeRecord;
+    if(!slotHoldsRecord(slotData, id)) {
+        unpinPage(bm, &handle);
+        return RC_ERROR;
+    }
+    RC rc = RC_OK;
+    if(numSecondaryIndexes > 0) {
+        rc = readSlot(slotData, rel->schema, &indexRecord, indexAttrs);
+        if(rc == RC_OK) {
+            rc = deleteIndexEntries(rel->schema, &indexRecord, numSecondaryIndexes);
+        }
+    }
+    if(rc == RC_OK && keyIndex != NULL) {
+        char *key = (char *)malloc(keyIndexLength);
+        rc = encodeSlotKey(rel->schema, slotData, key);
+        if(rc == RC_OK) {
+            rc = deleteEncodedKey(keyIndex, key);
+        }
+        free(key);
+        // the record stays, so do its entries in the secondary indexes
+        if(rc != RC_OK) {
+            insertIndexEntries(rel->schema, &indexRecord, numSecondaryIndexes);
+        }
+    }
+    if(rc != RC_OK) {
+        unpinPage(bm, &handle);
+        return rc;
+    }
+    freeSlot(pd, rel->schema, slotData, id.slot);
+    markDirty(bm, &handle);
+    unpinPage(bm, &handle);
+    numTuples--;
+    return RC_OK;
+}
+
+// move the entry of a record in the key index when an update changes its key,
+// the new key must not be taken by another record. the included attributes
+// stored with the key are refreshed either way.
+static RC updateKey(Schema *schema, char *slotData, Record *record)
+{
+    char *oldKey = (char *)malloc(keyIndexLength * 2 + keyPayloadLength);
+    char *newKey = oldKey + keyIndexLength;
+    char *payload = newKey + keyIndexLength;
+    RID existing;
+    RC rc = encodeSlotKey(schema, slotData, oldKey);
+    if(rc == RC_OK) {
+        rc = encodeRecordKey(schema, record, newKey);
+    }
+    encodeRecordPayload(schema, record, payload);
+    if(rc == RC_OK && memcmp(oldKey, newKey, keyIndexLength) != 0) {
+        if(findEncodedKey(keyIndex, newKey, &existing) == RC_OK) {
+            rc = RC_IM_KEY_ALREADY_EXISTS;
+        } else if((rc = deleteEncodedKey(keyIndex, oldKey)) == RC_OK) {
+            rc = insertEncodedEntry(keyIndex, newKey, record->id, payload);
+        }
+    } else if(rc == RC_OK && keyPayloadLength > 0) {
+        rc = updateEncodedPayload(keyIndex, newKey, payload);
+    }
+    free(oldKey);
+    return rc;
+}
+
+// update an existing record with new values
+RC updateRecord (RM_TableData *rel, Record *record)
+{
+    // check the validation of input parameters
+    if(rel == NULL || record == NULL) {
+        return RC_PARAMS_ERROR;
+    }
+    RID id = record->id;
+    if(findPageDirectory(rel->mgmtData, id.page) == NULL || id.slot < 0 || id.slot >= capacity) {
+        return RC_PARAMS_ERROR;
+    }
+
+    BM_PageHandle handle;
+    if(pinPage(bm, &handle, id.page) != RC_OK) {
+        return RC_READ_NON_EXISTING_PAGE;
+    }
+    char *slotData = handle.data + id.slot * sizeRecord;
+    if(!slotHoldsRecord(slotData, id)) {
+        unpinPage(bm, &handle);
+        return RC_ERROR;
+    }
+    // the new slot is written aside, so a failure leaves the record and its
+    // overflow pages untouched
+    char *newSlot = (char *)malloc(sizeRecord);
+    if(newSlot == NULL) {
+        unpinPage(bm, &handle);
+        return RC_ALLOC_MEM_FAIL;
+    }
+    RC rc = writeSlot(newSlot, rel->schema, record);
+    bool written = rc == RC_OK;
+    if(rc == RC_OK && numSecondaryIndexes > 0) {
+        rc = readSlot(slotData, rel->schema, &indexRecord, indexAttrs);
+        if(rc == RC_OK) {
+            rc = moveIndexEntries(rel->schema, &indexRecord, record, numSecondaryIndexes);
+        }
+    }
+    if(rc == RC_OK && keyIndex != NULL) {
+        rc = updateKey(rel->schema, slotData, record);
+        // a key taken by another record leaves the secondary indexes unchanged
+        if(rc != RC_OK) {
+            moveIndexEntries(rel->schema, record, &indexRecord, numSecondaryIndexes);
+        }
+    }
+    if(rc != RC_OK) {
+        if(written) {
+            releaseSlot(newSlot, rel->schema);
+        }
+        free(newSlot);
+        unpinPage(bm, &handle);
+        return rc;
+    }
+    // the old overflow pages are only freed once the update succeeded, an
+    // error freeing them is returned although the record is updated
+    rc = releaseSlot(slotData, rel->schema);
+    memcpy(slotData, newSlot, sizeRecord);
+    free(newSlot);
+    widenZone(rel->schema, record, id.page);
+    markDirty(bm, &handle);
+    unpinPage(bm, &handle);
+    return rc;
+}
+
+// remember that a record moved during compaction
+static RC addRIDMapping(RIDMapping **mapping, int *numMapping, int *maxMapping,
+                        RID from, RID to)
+{
+    if(*numMapping == *maxMapping) {
+        int newMax = *maxMapping == 0 ? 64 : *maxMapping * 2;
+        RIDMapping *newMapping = (RIDMapping *)realloc(*mapping, newMax * sizeof(RIDMapping));
+        if(newMapping == NULL) {
+            return RC_ALLOC_MEM_FAIL;
+        }
+        *mapping = newMapping;
+        *maxMapping = newMax;
+    }
+    (*mapping)[*numMapping].from = from;
+    (*mapping)[*numMapping].to = to;
+    *numMapping = *numMapping + 1;
+    return RC_OK;
+}
+
+// move the records of the page into the free slots of the pages in front of it
+// until it is empty or dest reaches it
+static RC moveRecordsForward(Schema *schema, PageDirectory *src, PageDirectory **dest,
+                        Record *record, RIDMapping **mapping, int *numMapping, int *maxMapping)
+{
+    BM_PageHandle handle;
+    if(pinPage(bm, &handle, src->pageNum) != RC_OK) {
+        return RC_READ_NON_EXISTING_PAGE;
+    }
+
+    RC rc = RC_OK;
+    for(int slot = 0; rc == RC_OK && slot < capacity && src->count > 0; slot++) {
+        char *slotData = handle.data + slot * sizeRecord;
+        RID from = { src->pageNum, slot };
+        if(!slotHoldsRecord(slotData, from)) {
+            continue;
+        }
+        if((rc = readSlot(slotData, schema, record, NULL)) != RC_OK) {
+            break;
+        }
+        while(*dest != src && (*dest)->count >= capacity) {
+            *dest = (*dest)->next;
+        }
+        if(*dest == src) {
+            break;
+        }
+
+        if((rc = insertIntoPage(*dest, schema, record)) != RC_OK) {
+            break;
+        }
+        // the key now points to the new RID, if anything fails after the copy
+        // it is taken out of dest again and the key points to from
+        char *key = NULL;
+        bool keyMoved = false;
+        if(keyIndex != NULL) {
+            key = (char *)malloc(keyIndexLength + keyPayloadLength);
+            rc = encodeRecordKey(schema, record, key);
+            encodeRecordPayload(schema, record, key + keyIndexLength);
+            if(rc == RC_OK && (rc = deleteEncodedKey(keyIndex, key)) == RC_OK) {
+                rc = insertEncodedEntry(keyIndex, key, record->id, key + keyIndexLength);
+                if(rc != RC_OK) {
+                    insertEncodedEntry(keyIndex, key, from, key + keyIndexLength);
+                }
+                keyMoved = rc == RC_OK;
+            }
+        }
+        if(rc == RC_OK && numSecondaryIndexes > 0) {
+            Record old = *record;
+            old.id = from;
+            rc = moveIndexEntries(schema, &old, record, numSecondaryIndexes);
+        }
+        if(rc != RC_OK) {
+            if(keyMoved && deleteEncodedKey(keyIndex, key) == RC_OK) {
+                insertEncodedEntry(keyIndex, key, from, key + keyIndexLength);
+            }
+            removeFromPage(*dest, schema, record->id.slot);
+            record->id = from;
+        }
+        free(key);
+        if(rc == RC_OK) {
+            // the moved record got its own copy of the overflow pages
+            freeSlot(src, schema, slotData, slot);
+            markDirty(bm, &handle);
+            if(mapping != NULL) {
+                rc = addRIDMapping(mapping, numMapping, maxMapping, from, record->id);
+            }
+        }
+    }
+    unpinPage(bm, &handle);
+    return rc;
+}
+
+// compacting a table moves the records of the last pages into the free slots
+// of the first pages, so all pages but the last one are full. the emptied
+// pages are dropped from the page directories and cut off the file, so scans
+// only visit pages holding live data again.
+// every moved record gets a new RID, if mapping is given it receives an array
+// of the old and new RIDs which the caller has to free. no scan may be open.
+RC compactTable (RM_TableData *rel, RIDMapping **mapping, int *numMapping)
+{
+    if(rel == NULL || (mapping != NULL && numMapping == NULL)) {
+        return RC_PARAMS_ERROR;
+    }
+    PageDirectoryCache *pageDirectoryCache = rel->mgmtData;
+    Schema *schema = rel->schema;
+    int count = 0;
+    int maxMapping = 0;
+    RIDMapping *moved = NULL;
+
+    Record record;
+    record.data = (char *)calloc(getRecordSize(schema), sizeof(char));
+    if(record.data == NULL) {
+        return RC_ALLOC_MEM_FAIL;
+    }
+
+    // fill the front pages with the records of the rear pages
+    RC rc = RC_OK;
+    PageDirectory *dest = pageDirectoryCache->front;
+    PageDirectory *src = pageDirectoryCache->rear;
+    while(rc == RC_OK && src != NULL && dest != src) {
+        rc = moveRecordsForward(schema, src, &dest, &record,
+                                mapping != NULL ? &moved : NULL, &count, &maxMapping);
+        // dest may have run into src, then the pages in front of it are full
+        if(dest == src) {
+            break;
+        }
+        src = src->pre;
+    }
+    free(record.data);
+    if(rc != RC_OK) {
+        free(moved);
+        return rc;
+    }
+
+    // drop the empty pages at the end but keep the first data page
+    while(pageDirectoryCache->rear != pageDirectoryCache->front
+            && pageDirectoryCache->rear->count == 0) {
+        PageDirectory *last = pageDirectoryCache->rear;
+        pageDirectoryCache->rear = last->pre;
+        pageDirectoryCache->rear->next = NULL;
+        pageDirectoryCache->count = pageDirectoryCache->count - 1;
+        free(last);
+    }
+    rc = writePageDirectories(pageDirectoryCache);
+
+    // the buffer pool must not keep frames of the cut pages, so restart it
+    // around the truncation
+    if(rc == RC_OK) {
+        shutdownBufferPool(bm);
+        if(openPageFile(rel->name, &fHandle) == RC_OK) {
+            truncatePageFile(pageDirectoryCache->rear->pageNum + 1, &fHandle);
+            closePageFile(&fHandle);
+        }
+        bm = (BM_BufferPool *)malloc(sizeof(BM_BufferPool));
+        rc = initBufferPool(bm, rel->name, 3, RS_FIFO, NULL);
+    }
+
+    if(mapping != NULL) {
+        *mapping = moved;
+        *numMapping = count;
+    }
+    return rc;
+}
+
+// retrieve a record with a certain RID
+RC getRecord (RM_TableData *rel, RID id, Record *record)
+{
+    // check validation of input parameters
+    if(rel == NULL || record == NULL) {
+        return RC_PARAMS_ERROR;
+    }
+
+    // a RID outside the data pages of the table is not found
+    if(findPageDirectory(rel->mgmtData, id.page) == NULL || id.slot < 0 || id.slot >= capacity) {
+        return RC_ERROR;
+    }
 
-        // get last page directory
-        lastPD = pageDirectoryCache->rear;   
+    // only parse the slot of this record instead of the whole page
+    BM_PageHandle handle;
+    if(pinPage(bm, &handle, id.page) != RC_OK) {
+        return RC_READ_NON_EXISTING_PAGE;
     }
+    RC rc = readSlot(handle.data + id.slot * sizeRecord, rel->schema, record, NULL);
+    unpinPage(bm, &handle);
 
-    if(lastPD == NULL) {
+    // deleted records keep a tombstone with page and slot 0
+    if(rc != RC_OK || record->id.page != id.page || record->id.slot != id.slot) {
         return RC_ERROR;
     }
+    return RC_OK;
+}
+
+// retrieve the record with the given key through the key index, key holds a
+// value for each key attribute of the schema in the order of keyAttrs
+RC getRecordByKey (RM_TableData *rel, Value **key, Record *record)
+{
+    if(rel == NULL || key == NULL || record == NULL) {
+        return RC_PARAMS_ERROR;
+    }
+    if(keyIndex == NULL) {
+        return RC_IM_KEY_NOT_FOUND;
+    }
+
+    Schema *schema = rel->schema;
+    char *encoded = (char *)malloc(keyIndexLength);
+    char *pos = encoded;
+    RC rc = RC_OK;
+    for(int i = 0; rc == RC_OK && i < schema->keySize; i++) {
+        int attrNum = schema->keyAttrs[i];
+        int length = keyLength(schema->dataTypes[attrNum], schema->typeLength[attrNum]);
+        rc = encodeKey(schema->dataTypes[attrNum], length, key[i], pos);
+        pos = pos + length;
+    }
+
+    RID id;
+    if(rc == RC_OK) {
+        rc = findEncodedKey(keyIndex, encoded, &id);
+    }
+    free(encoded);
+    if(rc != RC_OK) {
+        return rc;
+    }
+    return getRecord(rel, id, record);
+}
+
+// order RIDs by page and then by slot
+static int compareRIDs(const void *a, const void *b)
+{
+    const RID *x = (const RID *)a;
+    const RID *y = (const RID *)b;
+    if(x->page != y->page) {
+        return x->page < y->page ? -1 : 1;
+    }
+    return (x->slot > y->slot) - (x->slot < y->slot);
+}
+
+// derive the range of encoded keys of an index over attrNums a condition can
+// match, length is the size of its keys. equal attributes are copied to both
+// ends of the range and the first attribute with a range ends it, the
+// remaining bytes are 0x00 at the low end and 0xFF at the high end. exclusive
+// bounds are made inclusive since the condition is evaluated on every record
+// anyway. return the number of attributes that bound the range, 0 if it is
+// not bounded at all.
+static int indexRange(Schema *schema, int numAttrs, int *attrNums, int length,
+                        Expr *cond, char *low, char *high)
+{
+    int bounded = 0;
+    int pos = 0;
+    for(int i = 0; cond != NULL && i < numAttrs; i++) {
+        int attrNum = attrNums[i];
+        DataType dt = schema->dataTypes[attrNum];
+        int size = keyLength(dt, schema->typeLength[attrNum]);
+        KeyRange range;
+        extractKeyRange(cond, attrNum, &range);
+
+        // a bound that cannot be encoded, like a constant of another
+        // datatype, leaves that end open
+        bool hasLow = range.hasLow && encodeKey(dt, size, &range.low, low + pos) == RC_OK;
+        bool hasHigh = range.hasHigh && encodeKey(dt, size, &range.high, high + pos) == RC_OK;
+        if(!hasLow) {
+            memset(low + pos, 0x00, size);
+        }
+        if(!hasHigh) {
+            memset(high + pos, 0xFF, size);
+        }
+        if(hasLow || hasHigh) {
+            bounded = i + 1;
+        }
+        pos = pos + size;
+        if(!hasLow || !hasHigh || memcmp(low + pos - size, high + pos - size, size) != 0) {
+            break;
+        }
+    }
+    memset(low + pos, 0x00, length - pos);
+    memset(high + pos, 0xFF, length - pos);
+    return bounded;
+}
+
+// whether the key index holds every attribute a projected scan decodes, VARCHAR
+// attributes are never included since their values may be stored out of line
+static bool scanCovered(Schema *schema, bool *attrs)
+{
+    if(attrs == NULL) {
+        return false;
+    }
+    for(int i = 0; i < schema->numAttr; i++) {
+        if(!attrs[i]) {
+            continue;
+        }
+        bool stored = false;
+        for(int j = 0; j < schema->keySize; j++) {
+            stored = stored || schema->keyAttrs[j] == i;
+        }
+        for(int j = 0; j < schema->numIncluded; j++) {
+            stored = stored || schema->includedAttrs[j] == i;
+        }
+        if(!stored || schema->dataTypes[i] == DT_VARCHAR) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// collect the RIDs of a range of an index sorted by page, so each page is
+// read once and the records come back in the order of a heap scan
+static RC collectIndexRIDs(ScanCond *scanCond, BTreeHandle *tree, char *low, char *high)
+{
+    BT_ScanHandle *treeScan;
+    int maxRids = 0;
+    RID rid;
+    RC rc = openTreeRangeScanEncoded(tree, low, high, &treeScan);
+    if(rc != RC_OK) {
+        return rc;
+    }
+    while((rc = nextEntry(treeScan, &rid)) == RC_OK) {
+        if(scanCond->numRids == maxRids) {
+            maxRids = maxRids == 0 ? 64 : maxRids * 2;
+            RID *rids = (RID *)realloc(scanCond->rids, maxRids * sizeof(RID));
+            if(rids == NULL) {
+                rc = RC_ALLOC_MEM_FAIL;
+                break;
+            }
+            scanCond->rids = rids;
+        }
+        scanCond->rids[scanCond->numRids++] = rid;
+    }
+    RC closeRc = closeTreeScan(treeScan);
+    if(rc != RC_IM_NO_MORE_ENTRIES) {
+        return rc;
+    }
+    if(scanCond->numRids > 1) {
+        qsort(scanCond->rids, scanCond->numRids, sizeof(RID), compareRIDs);
+    }
+    return closeRc;
+}
+
+// choose how a scan reaches its records. a projected scan whose attributes are
+// all stored in the key index reads them from its leaves. otherwise a scan
+// reads the records at the RIDs of the range of the index whose leading
+// attributes its condition bounds the most, the key index wins a tie. any
+// other scan reads the heap.
+static RC planIndexScan(RM_TableData *rel, ScanCond *scanCond)
+{
+    Schema *schema = rel->schema;
+    if(keyIndex != NULL && scanCovered(schema, scanCond->attrs)) {
+        char *low = (char *)malloc(keyIndexLength);
+        char *high = (char *)malloc(keyIndexLength);
+        IndexOnlyScan *indexOnly = (IndexOnlyScan *)calloc(1, sizeof(IndexOnlyScan));
+        if(indexOnly != NULL) {
+            indexOnly->entries = (char *)malloc(INDEX_SCAN_CHUNK
+                                    * (keyIndexLength + sizeof(RID) + keyPayloadLength));
+        }
+        if(low == NULL || high == NULL || indexOnly == NULL || indexOnly->entries == NULL) {
+            if(indexOnly != NULL) {
+                free(indexOnly->entries);
+            }
+            free(indexOnly);
+            free(low);
+            free(high);
+            return RC_ALLOC_MEM_FAIL;
+        }
+        indexRange(schema, schema->keySize, schema->keyAttrs, keyIndexLength,
+                    scanCond->optimized, low, high);
+        indexOnly->low = low;
+        indexOnly->high = high;
+        scanCond->indexOnly = indexOnly;
+        scanCond->path = RM_ACCESS_INDEX_ONLY;
+        return RC_OK;
+    }
+
+    int length = keyIndex != NULL ? keyIndexLength : 0;
+    for(int i = 0; i < numSecondaryIndexes; i++) {
+        if(secondaryIndexes[i].length > length) {
+            length = secondaryIndexes[i].length;
+        }
+    }
+    if(scanCond->optimized == NULL || length == 0) {
+        return RC_OK;
+    }
+
+    // the range of the best index so far and the one of the next candidate
+    char *ranges = (char *)malloc(4 * length);
+    if(ranges == NULL) {
+        return RC_ALLOC_MEM_FAIL;
+    }
+    char *low = ranges;
+    char *high = ranges + length;
+    char *nextLow = ranges + 2 * length;
+    char *nextHigh = ranges + 3 * length;
+    BTreeHandle *tree = keyIndex;
+    RM_AccessPath path = RM_ACCESS_KEY_INDEX;
+    int best = 0;
+    if(keyIndex != NULL) {
+        best = indexRange(schema, schema->keySize, schema->keyAttrs, keyIndexLength,
+                            scanCond->optimized, low, high);
+    }
+    for(int i = 0; i < numSecondaryIndexes; i++) {
+        SecondaryIndex *index = &secondaryIndexes[i];
+        int bounded = indexRange(schema, index->numAttrs, index->attrNums, index->length,
+                                    scanCond->optimized, nextLow, nextHigh);
+        if(bounded > best) {
+            char *swap = low;
+            low = nextLow;
+            nextLow = swap;
+            swap = high;
+            high = nextHigh;
+            nextHigh = swap;
+            best = bounded;
+            tree = index->tree;
+            path = RM_ACCESS_SECONDARY_INDEX;
+        }
+    }
+
+    RC rc = RC_OK;
+    if(best > 0) {
+        rc = collectIndexRIDs(scanCond, tree, low, high);
+        if(rc == RC_OK) {
+            scanCond->path = path;
+        }
+    }
+    free(ranges);
+    return rc;
+}
+
+// scans: A client can initiate a scan to retrieve all tuples from a table
+// that fulfill a certain condition.
+
+// starting a scan initializes the RM_ScanHandle as an argument.
+RC startScan (RM_TableData *rel, RM_ScanHandle *scan, Expr *cond)
+{
+    return startProjectedScan(rel, scan, cond, 0, NULL);
+}
+
+// starting a projected scan only decodes the attributes in projAttrs and the
+// attributes cond refers to, the bytes of any other attribute of the returned
+// records are left untouched. without projAttrs all attributes are decoded.
+RC startProjectedScan (RM_TableData *rel, RM_ScanHandle *scan, Expr *cond,
+                        int numProj, int *projAttrs)
+{
+    if(rel == NULL || scan == NULL || (numProj > 0 && projAttrs == NULL)) {
+        return RC_PARAMS_ERROR;
+    }
+
+    scan->mgmtData = (ScanCond*)malloc(sizeof(ScanCond));
+    if(scan->mgmtData == NULL) {
+        return RC_ALLOC_MEM_FAIL;
+    }
+    //Initialize scan data
+    ScanCond *scanCond = (ScanCond*)scan->mgmtData;
+
+    //records are stored starting from page 2 of file
+    scanCond->currentPage = 2;
+    scanCond->currentSlot = 0;
+    scanCond->condition = cond;
+    scanCond->optimized = NULL;
+    scanCond->program = NULL;
+    scanCond->attrs = NULL;
+    scanCond->arena = NULL;
+    scanCond->path = RM_ACCESS_HEAP;
+    scanCond->rids = NULL;
+    scanCond->numRids = 0;
+    scanCond->nextRid = 0;
+    scanCond->indexOnly = NULL;
+    scanCond->zoneFilter = NULL;
+    scanCond->pagesRead = 0;
+    scanCond->pagesSkipped = 0;
+    scanCond->rc = RC_OK;
+
+    // the condition is optimized and compiled once instead of walking it for
+    // every record
+    if(cond != NULL) {
+        RC rc = optimizeExpr(cond, rel->schema, &scanCond->optimized);
+        if(rc == RC_OK) {
+            rc = compileExpr(scanCond->optimized, rel->schema, &scanCond->program);
+        }
+        if(rc != RC_OK) {
+            if(scanCond->optimized != NULL) {
+                freeExpr(scanCond->optimized);
+            }
+            free(scan->mgmtData);
+            scan->mgmtData = NULL;
+            return rc;
+        }
+    }
+
+    // mark the attributes to decode
+    if(numProj > 0) {
+        Schema *schema = rel->schema;
+        scanCond->attrs = (bool *)calloc(schema->numAttr, sizeof(bool));
+        if(scanCond->attrs == NULL) {
+            closeScan(scan);
+            return RC_ALLOC_MEM_FAIL;
+        }
+        for(int i = 0; i < numProj; i++) {
+            if(projAttrs[i] < 0 || projAttrs[i] >= schema->numAttr) {
+                closeScan(scan);
+                return RC_PARAMS_ERROR;
+            }
+            scanCond->attrs[projAttrs[i]] = true;
+        }
+        if(scanCond->optimized != NULL) {
+            collectAttrRefs(scanCond->optimized, scanCond->attrs);
+        }
+    }
+
+    // a condition that bounds an attribute to an empty range, like
+    // a > 5 AND a < 3, cannot match any record so the scan ends right away
+    for(int i = 0; scanCond->optimized != NULL && i < rel->schema->numAttr; i++) {
+        KeyRange range;
+        extractKeyRange(scanCond->optimized, i, &range);
+        if(range.empty) {
+            scanCond->currentPage = INT_MAX;
+            scanCond->path = RM_ACCESS_NONE;
+            break;
+        }
+    }
+
+    if(scanCond->path == RM_ACCESS_HEAP) {
+        RC rc = planIndexScan(rel, scanCond);
+        if(rc != RC_OK) {
+            closeScan(scan);
+            return rc;
+        }
+    }
+    // a heap scan skips the pages whose zone maps rule out the condition
+    if(scanCond->path == RM_ACCESS_HEAP) {
+        scanCond->zoneFilter = createZoneFilter(rel->schema, scanCond->optimized);
+    }
 
-    lastPageNum = lastPD->pageNum;
-    lastFreeSlot = lastPD->firstFreeSlot;
-    lastPageCount = lastPD->count;
-
-    // set page and slot to curretn record
-    record->id.page = lastPageNum;
-    record->id.slot = lastFreeSlot;
+    scan->rel = rel;
+    return RC_OK;
+}
 
-    // get current record offset
-    int offset = record->id.slot * sizeRecord;
+// return the access path startScan chose for a scan
+RC getScanAccessPath (RM_ScanHandle *scan, RM_AccessPath *path)
+{
+    if(scan == NULL || scan->mgmtData == NULL || path == NULL) {
+        return RC_PARAMS_ERROR;
+    }
+    *path = ((ScanCond *)scan->mgmtData)->path;
+    return RC_OK;
+}
 
-    // get this record serialization data
-    char *recordStr = serializeRecord(record, schema);
-   
-    // store this record string to page
-    flushDataToPage(recordStr, offset, lastPageNum);
-    
-    // update page directory cache
-    lastPD->count = lastPD->count + 1;
-    lastPD->firstFreeSlot = lastPD->firstFreeSlot + 1;
-    rel->mgmtData = pageDirectoryCache;
-    // update number of tuples
-    numTuples++;
-    
+// return the number of data pages a heap scan has read and skipped by their
+// zone maps so far
+RC getScanPageCounts (RM_ScanHandle *scan, int *pagesRead, int *pagesSkipped)
+{
+    if(scan == NULL || scan->mgmtData == NULL || pagesRead == NULL || pagesSkipped == NULL) {
+        return RC_PARAMS_ERROR;
+    }
+    ScanCond *scanCond = (ScanCond *)scan->mgmtData;
+    *pagesRead = scanCond->pagesRead;
+    *pagesSkipped = scanCond->pagesSkipped;
     return RC_OK;
 }
 
-// delete a record with a certain RID
-RC deleteRecord (RM_TableData *rel, RID id)
+// return the range of values of an attribute the records of the scan can have
+// according to its condition, an index or a zone map only has to visit this
+// range. string bounds point into the condition and live until closeScan.
+RC getScanKeyRange (RM_ScanHandle *scan, int attrNum, KeyRange *range)
 {
-    if(rel == NULL) {
+    if(scan == NULL || scan->mgmtData == NULL || range == NULL
+            || attrNum < 0 || attrNum >= scan->rel->schema->numAttr) {
         return RC_PARAMS_ERROR;
     }
-    PageDirectoryCache *pageDirectoryCache = rel->mgmtData;
-    PageDirectory *p = pageDirectoryCache->front;
-    Schema *schema = rel->schema;
-    while(p != NULL) {
-        if(p->pageNum == id.page) {
-           
-            pinPage(bm, page, p->pageNum);
+    ScanCond *scanCond = (ScanCond *)scan->mgmtData;
+    return extractKeyRange(scanCond->optimized, attrNum, range);
+}
+
+// move a decoded record to another slot of the output, only the decoded
+// attributes are copied so the other bytes of the target stay untouched
+static void moveRecord(Schema *schema, bool *attrs, Record *from, Record *to)
+{
+    to->id = from->id;
+    if(attrs == NULL) {
+        memcpy(to->data, from->data, getRecordSize(schema));
+        return;
+    }
+    for(int i = 0; i < schema->numAttr; i++) {
+        if(attrs[i]) {
+            int offset;
+            int end;
+            attrOffset(schema, i, &offset);
+            attrOffset(schema, i + 1, &end);
+            memcpy(to->data + offset, from->data + offset, end - offset);
+        }
+    }
+}
 
-            Record *newRecord = (Record *)malloc(sizeof(Record));
-            if(newRecord == NULL) {
-                return RC_ALLOC_MEM_FAIL;
+// evaluate the scan condition on a run of decoded records at once and move
+// the matching ones to the front, return how many of them match
+static int filterRecords(ScanCond *scanCond, Schema *schema, Record *records, int count)
+{
+    if(scanCond->program == NULL || count == 0) {
+        return count;
+    }
+    uint64_t selection[(count + EXPR_BLOCK_SIZE - 1) / EXPR_BLOCK_SIZE];
+    evalExprProgramBatch(scanCond->program, records, count, selection);
+
+    int kept = 0;
+    for(int i = 0; i < count; i++) {
+        if(selection[i / EXPR_BLOCK_SIZE] & ((uint64_t)1 << (i % EXPR_BLOCK_SIZE))) {
+            if(kept != i) {
+                moveRecord(schema, scanCond->attrs, &records[i], &records[kept]);
             }
+            kept++;
+        }
+    }
+    return kept;
+}
 
-            // initialize the page id and slot id
-            newRecord->id.page = -1;
-            newRecord->id.slot = -1;
-
-            // allocate memory to store the binary representation
-            char *recordData = (char*)calloc(sizeRecord, sizeof(char));
-            newRecord->data = recordData;
-
-            // create current record
-            getRecord(rel, id, newRecord);
-
-            // update its page and slot to 0
-            newRecord->id.page = 0;
-            newRecord->id.slot = 0;
-
-            char *recordStr = serializeRecord(newRecord, schema);
-
-            // get this record offset
-            int offset = sizeRecord * id.slot;
-
-            // find the frame to be written
-            pinPage(bm, page, p->pageNum);
-            PageCache* pageCache = bm->mgmtData;
-            Frame* frame = searchPageFromCache(pageCache, page->pageNum);
-            strncpy(frame->data + offset, recordStr, sizeRecord);
-            markDirty(bm, page);
-            unpinPage(bm, page);
-            forcePage(bm, page);
-
-            // after that, get all records in this page
-            getRecords(rel, page->data, sizeRecord);
-
-            // update page directory cache
-            p->count = p->count - 1;
-            
-            RecordNode *p1 = head;
-            int i = 0;
-            while(p1 != NULL) {
-                if(p1->page == 0 && p1->slot == 0) {
-                    p->firstFreeSlot = i;
+// the same as scanRecords for an index scan, the records at the sorted RIDs
+// are read page by page and the RIDs of one page are filtered as a run. a
+// record deleted since startScan leaves a tombstone and is skipped.
+static int scanIndexRecords(RM_ScanHandle *scan, Record *records, int max)
+{
+    RM_TableData *rel = scan->rel;
+    ScanCond *scanCond = (ScanCond *)scan->mgmtData;
+    BM_PageHandle handle;
+    int found = 0;
+
+    while(found < max && scanCond->rc == RC_OK && scanCond->nextRid < scanCond->numRids) {
+        int pageNum = scanCond->rids[scanCond->nextRid].page;
+        if((scanCond->rc = pinPage(bm, &handle, pageNum)) != RC_OK) {
+            break;
+        }
+        while(found < max && scanCond->rc == RC_OK && scanCond->nextRid < scanCond->numRids
+                && scanCond->rids[scanCond->nextRid].page == pageNum) {
+            int run = 0;
+            while(found + run < max && scanCond->nextRid < scanCond->numRids
+                    && scanCond->rids[scanCond->nextRid].page == pageNum) {
+                RID id = scanCond->rids[scanCond->nextRid++];
+                char *slotData = handle.data + id.slot * sizeRecord;
+                if(!slotHoldsRecord(slotData, id)) {
+                    continue;
+                }
+                scanCond->rc = readSlot(slotData, rel->schema, &records[found + run],
+                                        scanCond->attrs);
+                if(scanCond->rc != RC_OK) {
                     break;
                 }
-                i++;
-                p1++;
-                
+                run++;
             }
-            rel->mgmtData = pageDirectoryCache;
-            numTuples--;
+            found = found + filterRecords(scanCond, rel->schema, records + found, run);
+        }
+        unpinPage(bm, &handle);
+    }
+    return found;
+}
+
+// read the next chunk of entries of an index-only scan, a chunk after the
+// first one starts at the last key read before, which is skipped
+static RC readIndexChunk(IndexOnlyScan *indexOnly)
+{
+    int entrySize = keyIndexLength + sizeof(RID) + keyPayloadLength;
+    BT_ScanHandle *treeScan;
+    indexOnly->count = 0;
+    indexOnly->next = 0;
+    RC rc = openTreeRangeScanEncoded(keyIndex, indexOnly->low, indexOnly->high, &treeScan);
+    if(rc != RC_OK) {
+        return rc;
+    }
+    while(indexOnly->count < INDEX_SCAN_CHUNK) {
+        char *entry = indexOnly->entries + indexOnly->count * entrySize;
+        RID rid;
+        rc = nextEncodedEntry(treeScan, entry, &rid, entry + keyIndexLength + sizeof(RID));
+        if(rc != RC_OK) {
             break;
         }
-        p = p->next;
+        if(indexOnly->resume && memcmp(entry, indexOnly->low, keyIndexLength) == 0) {
+            continue;
+        }
+        memcpy(entry + keyIndexLength, &rid, sizeof(RID));
+        indexOnly->count++;
     }
-    return RC_OK;
+    indexOnly->done = rc == RC_IM_NO_MORE_ENTRIES;
+    RC closeRc = closeTreeScan(treeScan);
+    if(indexOnly->count > 0) {
+        memcpy(indexOnly->low, indexOnly->entries + (indexOnly->count - 1) * entrySize,
+                keyIndexLength);
+        indexOnly->resume = true;
+    }
+    return rc == RC_OK || rc == RC_IM_NO_MORE_ENTRIES ? closeRc : rc;
 }
 
-// update an existing record with new values
-RC updateRecord (RM_TableData *rel, Record *record)
+// the same as scanRecords for an index-only scan, the records are built from
+// the key and the included attributes stored in the leaves of the key index
+// and no heap page is read
+static int scanIndexOnlyRecords(RM_ScanHandle *scan, Record *records, int max)
 {
-    // check the validation of input parameters
-    if(rel == NULL || record == NULL) {
-        return RC_PARAMS_ERROR;
+    Schema *schema = scan->rel->schema;
+    ScanCond *scanCond = (ScanCond *)scan->mgmtData;
+    IndexOnlyScan *indexOnly = scanCond->indexOnly;
+    int entrySize = keyIndexLength + sizeof(RID) + keyPayloadLength;
+    int found = 0;
+
+    while(found < max) {
+        if(indexOnly->next == indexOnly->count) {
+            if(indexOnly->done || (scanCond->rc = readIndexChunk(indexOnly)) != RC_OK
+                    || indexOnly->count == 0) {
+                break;
+            }
+        }
+        int run = 0;
+        while(found + run < max && indexOnly->next < indexOnly->count) {
+            char *entry = indexOnly->entries + indexOnly->next++ * entrySize;
+            Record *record = &records[found + run];
+            memcpy(&record->id, entry + keyIndexLength, sizeof(RID));
+            if(decodeRecordKey(schema, entry, record, scanCond->attrs) != RC_OK) {
+                continue;
+            }
+            decodeRecordPayload(schema, entry + keyIndexLength + sizeof(RID), record,
+                                scanCond->attrs);
+            run++;
+        }
+        found = found + filterRecords(scanCond, schema, records + found, run);
     }
+    return found;
+}
 
-    // get page directories and schema information
+// copy the next records fulfilling the scan condition into the given records,
+// whose data is preallocated, until max records are found or the table is
+// exhausted. every data page is pinned once and its slots are parsed in place,
+// the condition is evaluated on runs of records with evalExprProgramBatch.
+static int scanRecords(RM_ScanHandle *scan, Record *records, int max)
+{
+    RM_TableData *rel = scan->rel;
+    ScanCond *scanCond = (ScanCond *)scan->mgmtData;
     PageDirectoryCache *pageDirectoryCache = rel->mgmtData;
-    PageDirectory *p = pageDirectoryCache->front;
-    Schema *schema = rel->schema;
+    int maxPageNum = pageDirectoryCache->rear->pageNum;
+    BM_PageHandle handle;
+    int found = 0;
 
-    // looking for this record
-    while(p != NULL) {
-        // find this record
-        if(p->pageNum == record->id.page) {
-            pinPage(bm, page, p->pageNum);
+    // the values of the previous records are released at once
+    if(scanCond->arena != NULL) {
+        resetExprArena(scanCond->arena);
+    }
+    // a scan ended by an error returns no more records
+    if(scanCond->rc != RC_OK) {
+        return 0;
+    }
+    if(scanCond->path == RM_ACCESS_KEY_INDEX || scanCond->path == RM_ACCESS_SECONDARY_INDEX) {
+        return scanIndexRecords(scan, records, max);
+    }
+    if(scanCond->path == RM_ACCESS_INDEX_ONLY) {
+        return scanIndexOnlyRecords(scan, records, max);
+    }
 
-            Record *newRecord = (Record *)malloc(sizeof(Record));
-            if(newRecord == NULL) {
-                return RC_ALLOC_MEM_FAIL;
+    while(found < max && scanCond->currentPage <= maxPageNum) {
+        // if all slots have been scanned on current page, move to the next page
+        if(scanCond->currentSlot >= capacity || isDirectoryPage(scanCond->currentPage)) {
+            scanCond->currentSlot = 0;
+            scanCond->currentPage++;
+            continue;
+        }
+        // a page whose zone cannot match the condition is not read at all
+        if(scanCond->currentSlot == 0) {
+            if(!zoneMayMatch(scanCond->zoneFilter, scanCond->currentPage)) {
+                scanCond->currentSlot = capacity;
+                scanCond->pagesSkipped++;
+                continue;
             }
-
-            // initialize the page id and slot id
-            newRecord->id.page = -1;
-            newRecord->id.slot = -1;
-
-            // allocate memory to store the binary representation
-            char *recordData = (char*)calloc(sizeRecord, sizeof(char));
-            newRecord->data = recordData;
-
-            // create current record
-            getRecord(rel, record->id, newRecord);
-            newRecord->id.page = record->id.page;
-            newRecord->id.slot = record->id.slot;
-            newRecord->data = strdup(record->data);
-
-            char *newRecordStr = serializeRecord(newRecord, schema); 
-            int offset = sizeRecord * newRecord->id.slot;
-            PageCache* pageCache = bm->mgmtData;
-            Frame* frame = searchPageFromCache(pageCache, page->pageNum);
-            strcpy(frame->data + offset, newRecordStr);
-
-            markDirty(bm, page);
-            unpinPage(bm, page);
-            forcePage(bm, page);
+            scanCond->pagesRead++;
+        }
+        if((scanCond->rc = pinPage(bm, &handle, scanCond->currentPage)) != RC_OK) {
+            break;
+        }
+        while(found < max && scanCond->rc == RC_OK && scanCond->currentSlot < capacity) {
+            // decode the live records of the page behind the ones found so
+            // far, then filter the whole run at once
+            int run = 0;
+            while(found + run < max && scanCond->currentSlot < capacity) {
+                RID id = { scanCond->currentPage, scanCond->currentSlot++ };
+                char *slotData = handle.data + id.slot * sizeRecord;
+                // skip empty slots and tombstones of deleted records
+                if(!slotHoldsRecord(slotData, id)) {
+                    continue;
+                }
+                scanCond->rc = readSlot(slotData, rel->schema, &records[found + run],
+                                        scanCond->attrs);
+                if(scanCond->rc != RC_OK) {
+                    break;
+                }
+                run++;
+            }
+            found = found + filterRecords(scanCond, rel->schema, records + found, run);
+        }
+        unpinPage(bm, &handle);
+        if(scanCond->rc != RC_OK) {
+            break;
         }
-        p = p->next;
     }
-    return RC_OK;
+    return found;
 }
 
+// the result of a scan that returns no more records, the error that ended it
+// or RC_RM_NO_MORE_TUPLES at the end of the table
+static RC scanEndRC(RM_ScanHandle *scan)
+{
+    ScanCond *scanCond = (ScanCond *)scan->mgmtData;
+    return scanCond->rc != RC_OK ? scanCond->rc : RC_RM_NO_MORE_TUPLES;
+}
 
+// return the next tuple that fulfills the scan condition.
+// --if scan condition == NULL, then all tuples of the table should be returned.
+// the function should return RC_RM_NO_MORE_TUPLES once the scan is completed 
+// and RC_OK otherwise (unless an error occurs of course).
+RC next (RM_ScanHandle *scan, Record *record)
+{
+    if(scan == NULL || record == NULL) {
+        return RC_ERROR;
+    }
+    if(scanRecords(scan, record, 1) == 0) {
+        return scanEndRC(scan);
+    }
+    return RC_OK;
+}
 
-// retrieve a record with a certain RID
-RC getRecord (RM_TableData *rel, RID id, Record *record)
+// return up to max tuples that fulfill the scan condition at once, they are
+// copied into the preallocated storage of the batch along with their RIDs.
+// it returns RC_RM_NO_MORE_TUPLES once the scan is completed, or the error of a
+// page or value that could not be read.
+RC nextBatch (RM_ScanHandle *scan, RecordBatch *out, int max)
 {
-    // check validation of input parameters
-    if(rel == NULL || record == NULL) {
+    if(scan == NULL || out == NULL) {
         return RC_PARAMS_ERROR;
     }
-  
-    int recordPageNum = id.page;
-    int recordSlot = id.slot;
-
-    record->id.page = id.page;
-    record->id.slot = id.slot;
-    Schema *schema = rel->schema;
-
-    pinPage(bm, page, recordPageNum);
-    getRecords(rel, page->data, sizeRecord);
-    RecordNode *p = head;
-    while(p != NULL) {
-        if(id.page == p->page && id.slot == p->slot) {
-            record->data = strdup(p->data);
-            break;
-        }
-        p = p->next;
+    if(max > out->capacity || max <= 0) {
+        max = out->capacity;
     }
-    if(record->data == NULL) {
-        return RC_ERROR;
+    out->count = scanRecords(scan, out->records, max);
+    if(out->count == 0) {
+        return scanEndRC(scan);
     }
     return RC_OK;
 }
 
-// scans: A client can initiate a scan to retrieve all tuples from a table
-// that fulfill a certain condition.
-
-// starting a scan initializes the RM_ScanHandle as an argument.
-RC startScan (RM_TableData *rel, RM_ScanHandle *scan, Expr *cond)
+// evaluate an expression on a record returned by the scan. the result is
+// allocated from an arena of the scan and released by the next call of next
+// or nextBatch, so it must not be freed with freeVal.
+RC evalScanExpr (RM_ScanHandle *scan, Record *record, Expr *expr, Value **result)
 {
-    if(rel==NULL || scan == NULL || cond == NULL){
+    if(scan == NULL || scan->mgmtData == NULL || record == NULL || expr == NULL) {
         return RC_PARAMS_ERROR;
     }
+    ScanCond *scanCond = (ScanCond *)scan->mgmtData;
+    if(scanCond->arena == NULL) {
+        RC rc = createExprArena(&scanCond->arena, EXPR_ARENA_SIZE);
+        if(rc != RC_OK) {
+            return rc;
+        }
+    }
+    return evalExprArena(record, scan->rel->schema, expr, scanCond->arena, result);
+}
 
-    scan->mgmtData=(ScanCond*)malloc(sizeof(ScanCond));
-    if(scan->mgmtData==NULL){
-        return RC_ALLOC_MEM_FAIL;
+// closing a scan is to indicate the record manager that all associated resources can be cleaned up.
+RC closeScan (RM_ScanHandle *scan)
+{
+    if(scan->mgmtData) {
+        ScanCond *scanCond = (ScanCond *)scan->mgmtData;
+        freeExprProgram(scanCond->program);
+        if(scanCond->optimized != NULL) {
+            freeExpr(scanCond->optimized);
+        }
+        free(scanCond->attrs);
+        free(scanCond->rids);
+        free(scanCond->zoneFilter);
+        if(scanCond->indexOnly != NULL) {
+            free(scanCond->indexOnly->low);
+            free(scanCond->indexOnly->high);
+            free(scanCond->indexOnly->entries);
+            free(scanCond->indexOnly);
+        }
+        freeExprArena(scanCond->arena);
+        free(scan->mgmtData);
+        scan->mgmtData = NULL;
     }
-    //Initialize scan data
-    ScanCond *scanCond=(ScanCond*)scan->mgmtData;
+    return RC_OK;
+}
 
-    //records are stored starting from page 2 of file
-    scanCond->currentPage=2; 
-    scanCond->currentSlot=0;
-    scanCond->condition=cond;
+// claim the next morsel of pages, return false once the table is exhausted
+// or another worker failed
+static bool nextMorsel(ParallelScan *ps, int *first, int *last)
+{
+    pthread_mutex_lock(&ps->lock);
+    bool found = ps->rc == RC_OK && ps->nextPage <= ps->maxPage;
+    if(found) {
+        *first = ps->nextPage;
+        *last = ps->nextPage + MORSEL_PAGES - 1;
+        if(*last > ps->maxPage) {
+            *last = ps->maxPage;
+        }
+        ps->nextPage = ps->nextPage + MORSEL_PAGES;
+    }
+    pthread_mutex_unlock(&ps->lock);
+    return found;
+}
 
-    scan->rel=rel;
+// evaluate the scan condition on every record of a private copy of the page
+static RC scanPageCopy(ParallelScan *ps, int workerId, int pageNum,
+                        char *pageData, Record *record)
+{
+    Schema *schema = ps->rel->schema;
+    for(int slot = 0; slot < capacity; slot++) {
+        RID id = { pageNum, slot };
+        // skip empty slots and tombstones of deleted records
+        if(!slotHoldsRecord(pageData + slot * sizeRecord, id)) {
+            continue;
+        }
+        RC rc = readSlot(pageData + slot * sizeRecord, schema, record, NULL);
+        if(rc != RC_OK) {
+            return rc;
+        }
+        if(ps->program != NULL) {
+            bool match = false;
+            rc = evalExprProgram(ps->program, record, &match);
+            if(rc != RC_OK) {
+                return rc;
+            }
+            if(!match) {
+                continue;
+            }
+        }
+        rc = ps->callback(workerId, record, ps->context);
+        if(rc != RC_OK) {
+            return rc;
+        }
+    }
     return RC_OK;
 }
 
-// return the next tuple that fulfills the scan condition.
-// --if scan condition == NULL, then all tuples of the table should be returned.
-// the function should return RC_RM_NO_MORE_TUPLES once the scan is completed 
-// and RC_OK otherwise (unless an error occurs of course).
-RC next (RM_ScanHandle *scan, Record *record)
+// a worker copies each page of its morsel out of the buffer pool, so the pool
+// lock is only held for the copy and the conditions are evaluated in parallel
+static void *parallelScanWorker(void *arg)
 {
-    
-    if(scan==NULL || record==NULL){
-        return RC_ERROR;
+    ScanWorker *worker = (ScanWorker *)arg;
+    ParallelScan *ps = worker->scan;
+    BM_PageHandle handle;
+    Record record;
+    char *pageData = (char *)malloc(PAGE_SIZE);
+    record.data = (char *)calloc(getRecordSize(ps->rel->schema), sizeof(char));
+    if(pageData == NULL || record.data == NULL) {
+        free(pageData);
+        free(record.data);
+        pthread_mutex_lock(&ps->lock);
+        ps->rc = RC_ALLOC_MEM_FAIL;
+        pthread_mutex_unlock(&ps->lock);
+        return NULL;
     }
 
-    RM_TableData *rel=(RM_TableData*)scan->rel;
-    //gets scan condition from mgmtData
-    ScanCond *scanCond=(ScanCond *)scan->mgmtData;
-    //gets current page and slot 
-    int currentPage= scanCond->currentPage;
-    int currentSlot=scanCond->currentSlot;
+    int first;
+    int last;
+    RC rc = RC_OK;
+    while(rc == RC_OK && nextMorsel(ps, &first, &last)) {
+        for(int pageNum = first; rc == RC_OK && pageNum <= last; pageNum++) {
+            if(isDirectoryPage(pageNum) || !zoneMayMatch(ps->zoneFilter, pageNum)) {
+                continue;
+            }
+            pthread_mutex_lock(&bmLock);
+            rc = pinPage(bm, &handle, pageNum);
+            if(rc == RC_OK) {
+                memcpy(pageData, handle.data, PAGE_SIZE);
+                unpinPage(bm, &handle);
+            }
+            pthread_mutex_unlock(&bmLock);
+            if(rc == RC_OK) {
+                rc = scanPageCopy(ps, worker->id, pageNum, pageData, &record);
+            }
+        }
+    }
 
-    PageDirectoryCache *pageDirectoryCache = rel->mgmtData;
-    int maxPageNum = pageDirectoryCache->rear->pageNum;
-    
+    if(rc != RC_OK) {
+        pthread_mutex_lock(&ps->lock);
+        if(ps->rc == RC_OK) {
+            ps->rc = rc;
+        }
+        pthread_mutex_unlock(&ps->lock);
+    }
+    free(pageData);
+    free(record.data);
+    return NULL;
+}
 
-    // Check if the current page and slot are within the valid range
-    if (currentPage > maxPageNum || (currentPage <= maxPageNum && currentSlot >= capacity )) {
-        // Unpin the current page before returning the RC_RM_NO_MORE_TUPLES
-        return RC_RM_NO_MORE_TUPLES;
+// scan the whole table with numWorkers threads (one per online core if it is
+// not positive), pages are split into morsels that idle workers claim, and
+// every record fulfilling cond is handed to the callback.
+// the table must not be modified while the scan runs.
+RC parallelScan (RM_TableData *rel, Expr *cond, int numWorkers,
+                    RM_ScanCallback callback, void *context)
+{
+    if(rel == NULL || callback == NULL) {
+        return RC_PARAMS_ERROR;
+    }
+    if(numWorkers <= 0) {
+        numWorkers = (int)sysconf(_SC_NPROCESSORS_ONLN);
+        if(numWorkers <= 0) {
+            numWorkers = 1;
+        }
     }
 
-    while(scanCond->currentPage<=maxPageNum){
-        //if all slots have been scanned on current page, move to the next page
-        if(scanCond->currentSlot>=capacity){
-            scanCond->currentSlot=0;
-            scanCond->currentPage++;
-            if(scanCond->currentPage % (maxPageDiretories + 1) == 0) {
-                scanCond->currentPage++;
-            }
-            continue;
+    PageDirectoryCache *pageDirectoryCache = rel->mgmtData;
+    ParallelScan ps;
+    ps.rel = rel;
+    ps.program = NULL;
+    Expr *optimized = NULL;
+    if(cond != NULL) {
+        RC rc = optimizeExpr(cond, rel->schema, &optimized);
+        if(rc == RC_OK) {
+            rc = compileExpr(optimized, rel->schema, &ps.program);
         }
-        RID rid;
-        rid.page=scanCond->currentPage;
-        rid.slot=scanCond->currentSlot;
-        getRecord(rel,rid,record);
-
-        scanCond->currentSlot++;
-        if(scanCond->condition==NULL){
-            return RC_OK;
-        }
-        else{
-            Value *result = (Value *) malloc(sizeof(Value));
-            evalExpr(record,rel->schema,scanCond->condition, &result);
-            if(result!=NULL && result->v.boolV!=0){
-                freeVal(result);
-                return RC_OK;
+        if(rc != RC_OK) {
+            if(optimized != NULL) {
+                freeExpr(optimized);
             }
-            freeVal(result);
+            return rc;
+        }
+    }
+    ps.callback = callback;
+    ps.context = context;
+    // records are stored starting from page 2 of file
+    ps.nextPage = 2;
+    ps.maxPage = pageDirectoryCache->rear->pageNum;
+    ps.zoneFilter = createZoneFilter(rel->schema, optimized);
+    ps.rc = RC_OK;
+    pthread_mutex_init(&ps.lock, NULL);
+
+    ScanWorker *workers = (ScanWorker *)malloc(numWorkers * sizeof(ScanWorker));
+    if(workers == NULL) {
+        free(ps.zoneFilter);
+        freeExprProgram(ps.program);
+        if(optimized != NULL) {
+            freeExpr(optimized);
         }
-        
+        pthread_mutex_destroy(&ps.lock);
+        return RC_ALLOC_MEM_FAIL;
     }
-    scanCond->currentSlot=-1;
 
-    return RC_RM_NO_MORE_TUPLES;
-}
+    int started = 0;
+    for(; started < numWorkers; started++) {
+        workers[started].id = started;
+        workers[started].scan = &ps;
+        if(pthread_create(&workers[started].thread, NULL, parallelScanWorker,
+                            &workers[started]) != 0) {
+            break;
+        }
+    }
+    // run on the calling thread if no worker could be started
+    if(started == 0) {
+        workers[0].id = 0;
+        workers[0].scan = &ps;
+        parallelScanWorker(&workers[0]);
+    }
+    for(int i = 0; i < started; i++) {
+        pthread_join(workers[i].thread, NULL);
+    }
 
-// closing a scan is to indicate the record manager that all associated resources can be cleaned up.
-RC closeScan (RM_ScanHandle *scan)
-{
-    if(scan->mgmtData) {
-        free(scan->mgmtData);
+    free(workers);
+    free(ps.zoneFilter);
+    freeExprProgram(ps.program);
+    if(optimized != NULL) {
+        freeExpr(optimized);
     }
-    return RC_OK;
+    pthread_mutex_destroy(&ps.lock);
+    return ps.rc;
 }
 
 // dealing with schemas
@@ -605,21 +3120,9 @@ int getRecordSize (Schema *schema)
         return 0;
     }
 
-    // get the size of a record
+    // the size is computed along with the offsets of the attributes
     int res = 0;
-    DataType *dt = schema->dataTypes;
-    int *typeLength = schema->typeLength;
-    for(int i = 0; i < schema->numAttr; i++) {
-        if (dt[i] == DT_INT) {
-            res = res + sizeof(int);
-        } else if(dt[i] == DT_STRING) {
-            res = res + (sizeof(char) * typeLength[i]);
-        } else if(dt[i] == DT_BOOL) {
-            res = res + sizeof(bool);
-        } else if(dt[i] == DT_FLOAT) {
-            res = res + sizeof(float);
-        }
-    }
+    attrOffset(schema, schema->numAttr, &res);
     return res;
 }
 
@@ -633,7 +3136,7 @@ Schema *createSchema (int numAttr, char **attrNames, DataType *dataTypes,
     }
 
     // allocate memory to a new schema
-    Schema *schema = (Schema*)malloc(sizeof(Schema));
+    Schema *schema = (Schema*)calloc(1, sizeof(Schema));
 
     if(schema == NULL) {
         // printf("the allocation memory to a schema is failed!\n");
@@ -646,10 +3149,73 @@ Schema *createSchema (int numAttr, char **attrNames, DataType *dataTypes,
     schema->typeLength = typeLength;
     schema->keyAttrs = keys;
     schema->keySize = keySize;
+    schema->attrOffsets = NULL;
+    schema->aligned = false;
+    schema->includedAttrs = NULL;
+    schema->numIncluded = 0;
+
+    // the offsets are looked up by every access to an attribute
+    if(initAttrOffsets(schema) != RC_OK) {
+        free(schema);
+        return NULL;
+    }
 
     return schema;
 }
 
+// pad the attributes of a schema so that numbers start at a multiple of their
+// size, which allows aligned loads from the record data. the layout of a
+// table is fixed by createTable, so this has to be called before.
+RC setSchemaAlignment (Schema *schema, bool aligned)
+{
+    if(schema == NULL) {
+        return RC_PARAMS_ERROR;
+    }
+    schema->aligned = aligned;
+    return initAttrOffsets(schema);
+}
+
+// store copies of the given attributes with every key in the leaves of the
+// key index, so scans that only need the key and these attributes never read
+// a heap page. like the alignment it has to be set before createTable.
+// key attributes and VARCHAR attributes cannot be included.
+RC setKeyIncludes (Schema *schema, int numAttrs, int *attrNums)
+{
+    if(schema == NULL || numAttrs < 0 || (numAttrs > 0 && attrNums == NULL)
+            || schema->keySize == 0) {
+        return RC_PARAMS_ERROR;
+    }
+    for(int i = 0; i < numAttrs; i++) {
+        int attrNum = attrNums[i];
+        if(attrNum < 0 || attrNum >= schema->numAttr || schema->dataTypes[attrNum] == DT_VARCHAR) {
+            return RC_PARAMS_ERROR;
+        }
+        for(int j = 0; j < schema->keySize; j++) {
+            if(schema->keyAttrs[j] == attrNum) {
+                return RC_PARAMS_ERROR;
+            }
+        }
+        for(int j = 0; j < i; j++) {
+            if(attrNums[j] == attrNum) {
+                return RC_PARAMS_ERROR;
+            }
+        }
+    }
+
+    int *includedAttrs = NULL;
+    if(numAttrs > 0) {
+        includedAttrs = (int *)malloc(numAttrs * sizeof(int));
+        if(includedAttrs == NULL) {
+            return RC_ALLOC_MEM_FAIL;
+        }
+        memcpy(includedAttrs, attrNums, numAttrs * sizeof(int));
+    }
+    free(schema->includedAttrs);
+    schema->includedAttrs = includedAttrs;
+    schema->numIncluded = numAttrs;
+    return RC_OK;
+}
+
 // release all resources assigned to the given schema
 RC freeSchema (Schema *schema)
 {
@@ -685,6 +3251,12 @@ RC freeSchema (Schema *schema)
         schema->keyAttrs = NULL;
     }
 
+    free(schema->attrOffsets);
+    schema->attrOffsets = NULL;
+
+    free(schema->includedAttrs);
+    schema->includedAttrs = NULL;
+
     free(schema);
     schema = NULL;
 
@@ -745,6 +3317,50 @@ RC freeRecord (Record *record)
     return RC_OK;
 }
 
+// create a batch that can hold up to capacity records of the schema, all
+// record data is stored in a single block
+RC createRecordBatch (RecordBatch **batch, Schema *schema, int capacity)
+{
+    // check validations of function parameters
+    if(batch == NULL || schema == NULL || capacity <= 0) {
+        return RC_PARAMS_ERROR;
+    }
+    RecordBatch *newBatch = (RecordBatch *)malloc(sizeof(RecordBatch));
+    if(newBatch == NULL) {
+        return RC_ALLOC_MEM_FAIL;
+    }
+    int recordSize = getRecordSize(schema);
+    newBatch->capacity = capacity;
+    newBatch->count = 0;
+    newBatch->records = (Record *)malloc(capacity * sizeof(Record));
+    newBatch->data = (char *)calloc(capacity, recordSize);
+    if(newBatch->records == NULL || newBatch->data == NULL) {
+        free(newBatch->records);
+        free(newBatch->data);
+        free(newBatch);
+        return RC_ALLOC_MEM_FAIL;
+    }
+    for(int i = 0; i < capacity; i++) {
+        newBatch->records[i].id.page = -1;
+        newBatch->records[i].id.slot = -1;
+        newBatch->records[i].data = newBatch->data + i * recordSize;
+    }
+    *batch = newBatch;
+    return RC_OK;
+}
+
+// free all resources assigned to the given batch
+RC freeRecordBatch (RecordBatch *batch)
+{
+    if(batch == NULL) {
+        return RC_OK;
+    }
+    free(batch->records);
+    free(batch->data);
+    free(batch);
+    return RC_OK;
+}
+
 // get string attribute value
 RC getStringAttr(Record *record, Schema *schema, int attrNum, Value *attrValue, int offset) 
 {
@@ -761,24 +3377,20 @@ RC getStringAttr(Record *record, Schema *schema, int attrNum, Value *attrValue,
 // get number attribute value
 RC getNumAttr(Record *record, Schema *schema, int attrNum, Value *attrValue, int offset)
 {
-
-    int attrSize = 0;
-    if(attrValue->dt == DT_INT) {
-        attrSize = sizeof(int);
+    // numbers are stored in binary, see readAttrInt
+    char *data = record->data + offset;
+    if(attrValue->dt == DT_INT || attrValue->dt == DT_DATE) {
+        attrValue->v.intV = readAttrInt(data);
     } else if(attrValue->dt == DT_FLOAT) {
-        attrSize = sizeof(float);
+        attrValue->v.floatV = readAttrFloat(data);
     } else if(attrValue->dt == DT_BOOL) {
-        attrSize = sizeof(bool);
+        attrValue->v.boolV = data[0] != 0;
+    } else if(attrValue->dt == DT_LONG || attrValue->dt == DT_TIMESTAMP) {
+        attrValue->v.longV = readAttrLong(data);
+    } else if(attrValue->dt == DT_DOUBLE) {
+        attrValue->v.doubleV = readAttrDouble(data);
     }
-    // allocate memory to store the record
-    char *data = malloc(attrSize + 1);
-    // copy data from record to current position
-    memcpy(data, record->data + offset, attrSize);
-    data[attrSize] = '\0';
-    attrValue->v.intV = (int)strtol(data, NULL, 10);
-    // release this resource
-    free(data);
-    data = NULL;
+    return RC_OK;
 }
 
 // get attribute values of a record
@@ -786,7 +3398,8 @@ RC getAttr (Record *record, Schema *schema, int attrNum, Value **value)
 {
     
     // check the validation of input parameters
-    if(record == NULL || schema == NULL || value == NULL) {
+    if(record == NULL || schema == NULL || value == NULL
+            || attrNum < 0 || attrNum >= schema->numAttr) {
         return RC_PARAMS_ERROR;
     }
  
@@ -802,15 +3415,17 @@ RC getAttr (Record *record, Schema *schema, int attrNum, Value **value)
     // get the attribute data type
     DataType dt = schema->dataTypes[attrNum];
 
-    // store data type
-    attrValue->dt = dt;
+    // store data type, a VARCHAR is read as a string
+    attrValue->dt = dt == DT_VARCHAR ? DT_STRING : dt;
 
     // get attribut value based on data type
-    if(dt == DT_STRING) {
+    if(dt == DT_STRING || dt == DT_VARCHAR) {
         getStringAttr(record, schema, attrNum, attrValue, offset);
-    } else if(dt == DT_INT || dt == DT_FLOAT || DT_BOOL) {
+    } else if(dt == DT_INT || dt == DT_FLOAT || dt == DT_BOOL || dt == DT_LONG
+                || dt == DT_DOUBLE || dt == DT_DATE || dt == DT_TIMESTAMP) {
         getNumAttr(record, schema, attrNum, attrValue, offset);
     } else {
+        free(attrValue);
         return RC_DATATYPE_UNDEFINE;
     }
 
@@ -819,36 +3434,39 @@ RC getAttr (Record *record, Schema *schema, int attrNum, Value **value)
     return RC_OK;
 }
 
-
-void intToString(int j,  int val,  char *data){
-    int r = 0;
-    int q = val;
-    int last = j;
-    while (q > 0 && j >= 0) {
-        r = q % 10;
-        q = q / 10;
-        data[j] = data[j] + r;
-        j--;
+// read an attribute into the given value without allocating. a string is a
+// view into the record data of *length bytes that is only terminated if it is
+// shorter than the attribute, so it is valid as long as the record is.
+RC getAttrView (Record *record, Schema *schema, int attrNum, Value *value, int *length)
+{
+    if(record == NULL || schema == NULL || value == NULL
+            || attrNum < 0 || attrNum >= schema->numAttr) {
+        return RC_PARAMS_ERROR;
+    }
+    int offset = 0;
+    attrOffset(schema, attrNum, &offset);
+    value->dt = schema->dataTypes[attrNum];
+    if(value->dt == DT_STRING || value->dt == DT_VARCHAR) {
+        value->dt = DT_STRING;
+        value->v.stringV = record->data + offset;
+        if(length != NULL) {
+            *length = strnlen(value->v.stringV, schema->typeLength[attrNum]);
+        }
+        return RC_OK;
     }
-    data[last+1] = '\0';
+    getNumAttr(record, schema, attrNum, value, offset);
+    return RC_OK;
 }
 
 // set attribute values of a record
 RC setAttr (Record *record, Schema *schema, int attrNum, Value *value)
 {
     // check the validation of input parameters
-    if(record == NULL || schema == NULL || value == NULL) {
+    if(record == NULL || schema == NULL || value == NULL
+            || attrNum < 0 || attrNum >= schema->numAttr) {
         return RC_PARAMS_ERROR;
     }
 
-    
-    // a temporary variable to store the size of integer
-    int attrSize = sizeof(int);
-
-    // a temporary variable to store the record data
-    char data[attrSize + 1];
-    memset(data, '0', sizeof(char)*4);
- 
     // get offset of attribute
     int offset = 0;
     if(attrOffset(schema, attrNum, &offset) != RC_OK) {
@@ -856,24 +3474,28 @@ RC setAttr (Record *record, Schema *schema, int attrNum, Value *value)
         return RC_ERROR;
     }
 
-    // check whether the given attrNum is the same data type as value
-    if(value->dt != schema->dataTypes[attrNum]) {
+    // check whether the given attrNum is the same data type as value, a
+    // VARCHAR is set from a string
+    DataType dt = schema->dataTypes[attrNum] == DT_VARCHAR ? DT_STRING : schema->dataTypes[attrNum];
+    if(value->dt != dt) {
         return RC_DATATYPE_MISMATCH;
     }
     
-    // save the value to this record
+    // save the value to this record, every attribute keeps its fixed size
+    char *data = record->data + offset;
     if(value->dt == DT_STRING) {
-        // copy data from the given value to the record
-        sprintf(record->data + offset, "%s", value->v.stringV);
-    } else if(value->dt == DT_INT) {
-        // change integer to string
-        intToString(3, value->v.intV, data);
-        sprintf(record->data + offset, "%s", data);
+        // a shorter string is padded with null characters, a longer one is cut
+        strncpy(data, value->v.stringV, schema->typeLength[attrNum]);
+    } else if(value->dt == DT_INT || value->dt == DT_DATE) {
+        writeAttrInt(data, value->v.intV);
     } else if(value->dt == DT_FLOAT) {
-        sprintf(record->data + offset,"%f" ,value->v.floatV);
+        writeAttrFloat(data, value->v.floatV);
     } else if(value->dt == DT_BOOL) {
-        intToString(1, value->v.boolV, data);
-        sprintf(record->data + offset,"%s" ,data);
+        data[0] = value->v.boolV ? 1 : 0;
+    } else if(value->dt == DT_LONG || value->dt == DT_TIMESTAMP) {
+        writeAttrLong(data, value->v.longV);
+    } else if(value->dt == DT_DOUBLE) {
+        writeAttrDouble(data, value->v.doubleV);
     }
 
     return RC_OK;
@@ -18,6 +18,38 @@ typedef struct RM_ScanHandle
 	void *mgmtData;
 } RM_ScanHandle;
 
+// the way startScan reaches the records of a scan
+typedef enum RM_AccessPath
+{
+	RM_ACCESS_NONE = 0, // the condition cannot match any record, no page is read
+	RM_ACCESS_HEAP = 1, // every data page is read
+	RM_ACCESS_KEY_INDEX = 2, // only the records of a range of the key index are read
+	RM_ACCESS_INDEX_ONLY = 3, // the records are built from the leaves of the key index
+	RM_ACCESS_SECONDARY_INDEX = 4 // only the records of a range of a secondary index are read
+} RM_AccessPath;
+
+// a batch of records returned by nextBatch, every record points into the
+// preallocated data block of the batch
+typedef struct RecordBatch
+{
+	int capacity; // the max number of records in this batch
+	int count; // the number of records returned by the last call
+	Record *records;
+	char *data;
+} RecordBatch;
+
+// the old and new RID of a record moved by compactTable
+typedef struct RIDMapping
+{
+	RID from;
+	RID to;
+} RIDMapping;
+
+// receives every record matched by a parallel scan, it is called concurrently
+// from the worker threads so each worker gets its own index in [0, numWorkers)
+// to keep private results, the record is only valid during the call
+typedef RC (*RM_ScanCallback) (int worker, Record *record, void *context);
+
 // table and manager
 extern RC initRecordManager (void *mgmtData);
 extern RC shutdownRecordManager ();
@@ -32,21 +64,43 @@ extern RC insertRecord (RM_TableData *rel, Record *record);
 extern RC deleteRecord (RM_TableData *rel, RID id);
 extern RC updateRecord (RM_TableData *rel, Record *record);
 extern RC getRecord (RM_TableData *rel, RID id, Record *record);
+extern RC getRecordByKey (RM_TableData *rel, Value **key, Record *record);
+extern RC compactTable (RM_TableData *rel, RIDMapping **mapping, int *numMapping);
+
+// secondary indexes over any attributes of the open table, records may share
+// their values. name is made of letters, digits, '_' and '-' and the index is
+// stored in the file "<table>.<name>.idx"
+extern RC createIndex (RM_TableData *rel, int numAttrs, int *attrNums, char *name);
+extern RC dropIndex (RM_TableData *rel, char *name);
 
 // scans
 extern RC startScan (RM_TableData *rel, RM_ScanHandle *scan, Expr *cond);
+extern RC startProjectedScan (RM_TableData *rel, RM_ScanHandle *scan, Expr *cond,
+		int numProj, int *projAttrs);
 extern RC next (RM_ScanHandle *scan, Record *record);
+extern RC nextBatch (RM_ScanHandle *scan, RecordBatch *out, int max);
 extern RC closeScan (RM_ScanHandle *scan);
+extern RC getScanKeyRange (RM_ScanHandle *scan, int attrNum, KeyRange *range);
+extern RC getScanAccessPath (RM_ScanHandle *scan, RM_AccessPath *path);
+extern RC getScanPageCounts (RM_ScanHandle *scan, int *pagesRead, int *pagesSkipped);
+extern RC evalScanExpr (RM_ScanHandle *scan, Record *record, Expr *expr, Value **result);
+extern RC parallelScan (RM_TableData *rel, Expr *cond, int numWorkers,
+		RM_ScanCallback callback, void *context);
 
 // dealing with schemas
 extern int getRecordSize (Schema *schema);
 extern Schema *createSchema (int numAttr, char **attrNames, DataType *dataTypes, int *typeLength, int keySize, int *keys);
 extern RC freeSchema (Schema *schema);
+extern RC setSchemaAlignment (Schema *schema, bool aligned);
+extern RC setKeyIncludes (Schema *schema, int numAttrs, int *attrNums);
 
 // dealing with records and attribute values
 extern RC createRecord (Record **record, Schema *schema);
 extern RC freeRecord (Record *record);
+extern RC createRecordBatch (RecordBatch **batch, Schema *schema, int capacity);
+extern RC freeRecordBatch (RecordBatch *batch);
 extern RC getAttr (Record *record, Schema *schema, int attrNum, Value **value);
+extern RC getAttrView (Record *record, Schema *schema, int attrNum, Value *value, int *length);
 extern RC setAttr (Record *record, Schema *schema, int attrNum, Value *value);
 
 // helper functions
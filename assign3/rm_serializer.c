@@ -133,6 +133,21 @@ serializeSchema(Schema *schema)
 		case DT_BOOL:
 			APPEND_STRING(result,"BOOL");
 			break;
+		case DT_VARCHAR:
+			APPEND(result,"VARCHAR[%i]", schema->typeLength[i]);
+			break;
+		case DT_LONG:
+			APPEND_STRING(result,"LONG");
+			break;
+		case DT_DOUBLE:
+			APPEND_STRING(result,"DOUBLE");
+			break;
+		case DT_DATE:
+			APPEND_STRING(result,"DATE");
+			break;
+		case DT_TIMESTAMP:
+			APPEND_STRING(result,"TIMESTAMP");
+			break;
 		}
 	}
 	APPEND_STRING(result,")");
@@ -142,7 +157,16 @@ serializeSchema(Schema *schema)
 	for(i = 0; i < schema->keySize; i++)
 		APPEND(result, "%s%s", ((i != 0) ? ",": ""), schema->attrNames[schema->keyAttrs[i]]);
 
-	APPEND_STRING(result,"}\n");
+	APPEND_STRING(result,"}");
+
+	if(schema->numIncluded > 0)
+	{
+		APPEND_STRING(result," including: {");
+		for(i = 0; i < schema->numIncluded; i++)
+			APPEND(result, "%s%s", ((i != 0) ? ",": ""), schema->attrNames[schema->includedAttrs[i]]);
+		APPEND_STRING(result,"}");
+	}
+	APPEND_STRING(result, schema->aligned ? " aligned\n" : "\n");
 
 	RETURN_STRING(result);
 }
@@ -153,7 +177,8 @@ serializeTableContent(RM_TableData *rel)
 	int i;
 	VarString *result;
 	RM_ScanHandle *sc = (RM_ScanHandle *) malloc(sizeof(RM_ScanHandle));
-	Record *r = (Record *) malloc(sizeof(Record));
+	Record *r;
+	createRecord(&r, rel->schema);
 	MAKE_VARSTRING(result);
 
 	for(i = 0; i < rel->schema->numAttr; i++)
@@ -167,6 +192,8 @@ serializeTableContent(RM_TableData *rel)
 		APPEND_STRING(result,"\n");
 	}
 	closeScan(sc);
+	free(sc);
+	freeRecord(r);
 
 	RETURN_STRING(result);
 }
@@ -193,7 +220,7 @@ substring(const char *s, const char start, const char end)
 Schema * 
 deserializeSchema(char *schemaData)
 {
-	Schema *schema = (Schema *) malloc(sizeof(Schema));
+	Schema *schema = (Schema *) calloc(1, sizeof(Schema));
 
 	char *numAttrStr = substring(schemaData, '<', '>');
 	int numAttr = atoi(numAttrStr);
@@ -210,6 +237,23 @@ deserializeSchema(char *schemaData)
     parseKeyInfo(schema, keyInfo);
 	free(keyInfo);
 
+    // get the attributes included in the key index
+    schema->includedAttrs = NULL;
+    schema->numIncluded = 0;
+    char *including = strstr(schemaData, " including: {");
+    if(including != NULL) {
+        char *includeInfo = substring(including, '{', '}');
+        parseIncludeInfo(schema, includeInfo);
+        free(includeInfo);
+    }
+
+	schema->aligned = strstr(schemaData, "} aligned") != NULL;
+	schema->attrOffsets = NULL;
+	if (initAttrOffsets(schema) != RC_OK) {
+		freeSchema(schema);
+		return NULL;
+	}
+
 	return schema;
 }
 
@@ -237,62 +281,84 @@ parseAttrInfo(Schema *schema, char *attrInfo)
         // get data type
         t1 = strtok(NULL, ", ");
 
-        // store string info
-        int tokenSize = strlen(t1);
+        // every string attribute has its own length, "STRING[4]"
+        char *length = strchr(t1, '[');
+        typeLength[i] = length != NULL ? atoi(length + 1) : 0;
 
         if (t1[0] == 'I'){
             dataTypes[i] = DT_INT;
-            typeLength[i] = 0;
         } else if (t1[0] == 'F'){
             dataTypes[i] = DT_FLOAT;
-            typeLength[i] = 0;
         } else if (t1[0] == 'B'){
             dataTypes[i] = DT_BOOL;
-            typeLength[i] = 0;
         } else if(t1[0] == 'S'){
             dataTypes[i] = DT_STRING;
-        }
-    }
-	char *length = substring(attrInfo, '[', ']');
-    int stringLength = atoi(length);
-    schema->attrNames = attrNames;
-    for(int i = 0; i < numAttr; i++) {
-        if(dataTypes[i] == DT_STRING){
-            typeLength[i] = stringLength;
+        } else if(t1[0] == 'V'){
+            dataTypes[i] = DT_VARCHAR;
+        } else if(t1[0] == 'L'){
+            dataTypes[i] = DT_LONG;
+        } else if(strncmp(t1, "DOUBLE", 6) == 0){
+            dataTypes[i] = DT_DOUBLE;
+        } else if(strncmp(t1, "DATE", 4) == 0){
+            dataTypes[i] = DT_DATE;
+        } else if(t1[0] == 'T'){
+            dataTypes[i] = DT_TIMESTAMP;
         }
     }
 
     schema->dataTypes = dataTypes;
     schema->attrNames = attrNames;
     schema->typeLength = typeLength;
-	free(length);
+}
+
+// look up a comma separated list of attribute names, return their number
+int
+parseAttrNames(Schema *schema, char *info, int *attrs)
+{
+	int numAttr = schema->numAttr;
+	int count = 0;
+
+	char *name = info;
+	while(*name != '\0' && count < numAttr) {
+		char *end = strchr(name, ',');
+		size_t length = end != NULL ? (size_t) (end - name) : strlen(name);
+
+		int index = -1;
+		for(int i = 0; i < numAttr; i++) {
+			if(strlen(schema->attrNames[i]) == length
+					&& strncmp(schema->attrNames[i], name, length) == 0) {
+				index = i;
+				break;
+			}
+		}
+		if(index == -1) {
+			printf("not valid attribute name\n");
+		} else {
+			attrs[count++] = index;
+		}
+		if(end == NULL) {
+			break;
+		}
+		name = end + 1;
+	}
+	return count;
 }
 
 void *
 parseKeyInfo(Schema *schema, char *keyInfo)
 {
-    
-	int numAttr = schema->numAttr;
-    int *keyAttrs = (int *) malloc(sizeof(int) * numAttr);
-
-    // find the key index
-    int index = -1;
-    for(int i = 0; i < numAttr; i++) {
-        if(strcmp(schema->attrNames[i], keyInfo) == 0) {
-            index = i;
-            break;
-        }
-    }
-    if(index == -1) {
-        printf("not valid attribute name\n");
-    }
-    for(int i= 0; i < numAttr; ++i)
-    {
-       keyAttrs[i] = index;
-        
-    }
-    schema->keyAttrs = keyAttrs;
-	schema->keySize = 1;
+	// the key attributes are listed by name and separated by commas
+	schema->keyAttrs = (int *) malloc(sizeof(int) * schema->numAttr);
+	schema->keySize = parseAttrNames(schema, keyInfo, schema->keyAttrs);
+	return NULL;
+}
+
+void *
+parseIncludeInfo(Schema *schema, char *includeInfo)
+{
+	schema->includedAttrs = (int *) malloc(sizeof(int) * schema->numAttr);
+	schema->numIncluded = parseAttrNames(schema, includeInfo, schema->includedAttrs);
+	return NULL;
 }
 
 void PageInfoToString(int j,  int val,  char *data){
@@ -336,30 +402,73 @@ serializeRecord(Record *record, Schema *schema)
 	RETURN_STRING(result);
 }
 
+// write a record into its slot as "[PPPP-SSSS](name:value,...)\n", the values
+// are the raw bytes of the attributes so they are copied instead of printed.
+// a VARCHAR is stored as its length, the first overflow page and the inline
+// prefix of its value. deserializeRecordAttrs reads this format, the rest of
+// the slot is zeroed.
+RC
+serializeRecordSlot(Record *record, Schema *schema, char *slotData, int size)
+{
+	char data[5];
+	char *p = slotData;
+	int i;
+
+	if(record == NULL || schema == NULL || slotData == NULL) {
+		return RC_PARAMS_ERROR;
+	}
+	memset(slotData, '\0', size);
+
+	memset(data, '0', sizeof(char) * 4);
+	PageInfoToString(3, record->id.page, data);
+	p += sprintf(p, "[%s", data);
+	memset(data, '0', sizeof(char) * 4);
+	PageInfoToString(3, record->id.slot, data);
+	p += sprintf(p, "-%s](", data);
+
+	for(i = 0; i < schema->numAttr; i++)
+	{
+		int offset, end;
+		attrOffset(schema, i, &offset);
+		attrOffset(schema, i + 1, &end);
+		if(i > 0) {
+			*p++ = ',';
+		}
+		p += sprintf(p, "%s:", schema->attrNames[i]);
+		if(schema->dataTypes[i] == DT_VARCHAR) {
+			// the overflow page is filled in by the record manager
+			int length = strnlen(record->data + offset, schema->typeLength[i]);
+			writeAttrInt(p, length);
+			writeAttrInt(p + 4, 0);
+			memcpy(p + VARCHAR_HEADER_SIZE, record->data + offset,
+					length < VARCHAR_INLINE_SIZE ? length : VARCHAR_INLINE_SIZE);
+		} else {
+			memcpy(p, record->data + offset, end - offset);
+		}
+		p += attrSlotSize(schema, i);
+	}
+	memcpy(p, ")\n", 2);
+	return RC_OK;
+}
+
 char * 
 serializeAttr(Record *record, Schema *schema, int attrNum)
 {
 	int offset;
-	char attrData[5];
+	char *attrData;
 	VarString *result;
 	MAKE_VARSTRING(result);
 
 	attrOffset(schema, attrNum, &offset);
-	// attrData = record->data + offset;
-	memcpy(attrData, record->data + offset, 4);
-	attrData[4] = '\0';
+	attrData = record->data + offset;
 
 	switch(schema->dataTypes[attrNum])
 	{
 	case DT_INT:
-	{
-		char val[5];
-		memset(val, '\0', sizeof(int));
-		memcpy(val, attrData, sizeof(int));
-		APPEND(result, "%s:%s", schema->attrNames[attrNum], val);
-	}
-	break;
+		APPEND(result, "%s:%i", schema->attrNames[attrNum], readAttrInt(attrData));
+		break;
 	case DT_STRING:
+	case DT_VARCHAR:
 	{
 		char *buf;
 		int len = schema->typeLength[attrNum];
@@ -372,17 +481,29 @@ serializeAttr(Record *record, Schema *schema, int attrNum)
 	}
 	break;
 	case DT_FLOAT:
+		APPEND(result, "%s:%f", schema->attrNames[attrNum], readAttrFloat(attrData));
+		break;
+	case DT_BOOL:
+		APPEND(result, "%s:%s", schema->attrNames[attrNum], attrData[0] ? "TRUE" : "FALSE");
+		break;
+	case DT_LONG:
+		APPEND(result, "%s:%lld", schema->attrNames[attrNum], (long long) readAttrLong(attrData));
+		break;
+	case DT_DOUBLE:
+		APPEND(result, "%s:%f", schema->attrNames[attrNum], readAttrDouble(attrData));
+		break;
+	case DT_DATE:
 	{
-		float val;
-		memcpy(&val,attrData, sizeof(float));
-		APPEND(result, "%s:%f", schema->attrNames[attrNum], val);
+		char buf[DATE_STRING_SIZE];
+		formatDate(readAttrInt(attrData), buf);
+		APPEND(result, "%s:%s", schema->attrNames[attrNum], buf);
 	}
 	break;
-	case DT_BOOL:
+	case DT_TIMESTAMP:
 	{
-		bool val;
-		memcpy(&val,attrData, sizeof(bool));
-		APPEND(result, "%s:%s", schema->attrNames[attrNum], val ? "TRUE" : "FALSE");
+		char buf[TIMESTAMP_STRING_SIZE];
+		formatTimestamp(readAttrLong(attrData), buf);
+		APPEND(result, "%s:%s", schema->attrNames[attrNum], buf);
 	}
 	break;
 	default:
@@ -412,6 +533,28 @@ serializeValue(Value *val)
 	case DT_BOOL:
 		APPEND_STRING(result, ((val->v.boolV) ? "true" : "false"));
 		break;
+	case DT_LONG:
+		APPEND(result,"%lld", (long long) val->v.longV);
+		break;
+	case DT_DOUBLE:
+		APPEND(result,"%f", val->v.doubleV);
+		break;
+	case DT_DATE:
+	{
+		char buf[DATE_STRING_SIZE];
+		formatDate(val->v.intV, buf);
+		APPEND_STRING(result, buf);
+	}
+	break;
+	case DT_TIMESTAMP:
+	{
+		char buf[TIMESTAMP_STRING_SIZE];
+		formatTimestamp(val->v.longV, buf);
+		APPEND_STRING(result, buf);
+	}
+	break;
+	default:
+		break;
 	}
 	RETURN_STRING(result);
 }
@@ -440,6 +583,25 @@ stringToValue(char *val)
 		result->dt = DT_BOOL;
 		result->v.boolV = (val[1] == 't') ? TRUE : FALSE;
 		break;
+	case 'l':
+		result->dt = DT_LONG;
+		result->v.longV = strtoll(val + 1, NULL, 10);
+		break;
+	case 'd':
+		result->dt = DT_DOUBLE;
+		result->v.doubleV = strtod(val + 1, NULL);
+		break;
+	// "D2024-02-29" and "T2024-02-29 12:30:00"
+	case 'D':
+		result->dt = DT_DATE;
+		if (parseDate(val + 1, &result->v.intV) != RC_OK)
+			result->v.intV = 0;
+		break;
+	case 'T':
+		result->dt = DT_TIMESTAMP;
+		if (parseTimestamp(val + 1, &result->v.longV) != RC_OK)
+			result->v.longV = 0;
+		break;
 	default:
 		result->dt = DT_INT;
 		result->v.intV = -1;
@@ -450,31 +612,249 @@ stringToValue(char *val)
 }
 
 
-RC 
-attrOffset (Schema *schema, int attrNum, int *result)
+// the size of an attribute in the record data and the multiple its offset
+// has to be if the schema is aligned
+static int
+attrLayout (Schema *schema, int attrNum, int *alignment)
 {
-	int offset = 0;
-	int attrPos = 0;
+	switch (schema->dataTypes[attrNum])
+	{
+	case DT_STRING:
+	case DT_VARCHAR:
+		*alignment = 1;
+		return schema->typeLength[attrNum];
+	case DT_INT:
+		*alignment = sizeof(int);
+		return sizeof(int);
+	case DT_FLOAT:
+		*alignment = sizeof(float);
+		return sizeof(float);
+	case DT_DATE:
+		*alignment = sizeof(int);
+		return sizeof(int);
+	case DT_LONG:
+	case DT_TIMESTAMP:
+		*alignment = sizeof(int64_t);
+		return sizeof(int64_t);
+	case DT_DOUBLE:
+		*alignment = sizeof(double);
+		return sizeof(double);
+	default:
+		*alignment = 1;
+		return sizeof(bool);
+	}
+}
+
+// the days since 1970-01-01 of a date of the proleptic Gregorian calendar
+static int
+daysFromCivil (int year, int month, int day)
+{
+	year -= month <= 2;
+	int era = (year >= 0 ? year : year - 399) / 400;
+	int yearOfEra = year - era * 400;
+	int dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+	int dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+	return era * 146097 + dayOfEra - 719468;
+}
+
+// the inverse of daysFromCivil
+static void
+civilFromDays (int days, int *year, int *month, int *day)
+{
+	days += 719468;
+	int era = (days >= 0 ? days : days - 146096) / 146097;
+	int dayOfEra = days - era * 146097;
+	int yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+	int dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+	int shifted = (5 * dayOfYear + 2) / 153;
+	*day = dayOfYear - (153 * shifted + 2) / 5 + 1;
+	*month = shifted < 10 ? shifted + 3 : shifted - 9;
+	*year = yearOfEra + era * 400 + (*month <= 2);
+}
+
+// parse the date at the start of text, consumed receives its length
+static RC
+parseDatePrefix (const char *text, int *days, int *consumed)
+{
+	int year, month, day, length = 0;
+	static const int monthDays[] = { 31, 29, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+
+	if (sscanf(text, "%d-%d-%d%n", &year, &month, &day, &length) != 3 || length == 0)
+		return RC_PARAMS_ERROR;
+	if (month < 1 || month > 12 || day < 1 || day > monthDays[month - 1])
+		return RC_PARAMS_ERROR;
+	bool leap = (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+	if (month == 2 && day == 29 && !leap)
+		return RC_PARAMS_ERROR;
+	*days = daysFromCivil(year, month, day);
+	*consumed = length;
+	return RC_OK;
+}
+
+RC
+parseDate (const char *text, int *days)
+{
+	int consumed;
+	if (text == NULL || days == NULL)
+		return RC_PARAMS_ERROR;
+	RC rc = parseDatePrefix(text, days, &consumed);
+	if (rc == RC_OK && text[consumed] != '\0')
+		return RC_PARAMS_ERROR;
+	return rc;
+}
 
-	for(attrPos = 0; attrPos < attrNum; attrPos++) {
-		switch (schema->dataTypes[attrPos])
+void
+formatDate (int days, char *buf)
+{
+	int year, month, day;
+	civilFromDays(days, &year, &month, &day);
+	snprintf(buf, DATE_STRING_SIZE, "%04d-%02d-%02d", year, month, day);
+}
+
+// the time of day is optional and may be separated by a space or a 'T', the
+// fraction of a second has up to six digits
+RC
+parseTimestamp (const char *text, int64_t *micros)
+{
+	int days, consumed, hour = 0, minute = 0, second = 0, length = 0;
+	int64_t fraction = 0;
+
+	if (text == NULL || micros == NULL)
+		return RC_PARAMS_ERROR;
+	RC rc = parseDatePrefix(text, &days, &consumed);
+	if (rc != RC_OK)
+		return rc;
+	text += consumed;
+	if (*text == ' ' || *text == 'T')
+	{
+		if (sscanf(text + 1, "%d:%d:%d%n", &hour, &minute, &second, &length) != 3
+				|| hour < 0 || hour > 23 || minute < 0 || minute > 59
+				|| second < 0 || second > 59)
+			return RC_PARAMS_ERROR;
+		text += 1 + length;
+		if (*text == '.')
 		{
-		case DT_STRING:
-			offset += schema->typeLength[attrPos];
-			break;
-		case DT_INT:
-			offset += sizeof(int);
-			break;
-		case DT_FLOAT:
-			offset += sizeof(float);
-			break;
-		case DT_BOOL:
-			offset += sizeof(bool);
-			break;
+			int digits = 0;
+			for(text++; *text >= '0' && *text <= '9'; text++, digits++)
+			{
+				if (digits >= 6)
+					return RC_PARAMS_ERROR;
+				fraction = fraction * 10 + (*text - '0');
+			}
+			for(; digits < 6; digits++)
+				fraction = fraction * 10;
+		}
+	}
+	if (*text != '\0')
+		return RC_PARAMS_ERROR;
+	*micros = ((int64_t) days * 86400 + hour * 3600 + minute * 60 + second) * 1000000 + fraction;
+	return RC_OK;
+}
+
+void
+formatTimestamp (int64_t micros, char *buf)
+{
+	// round towards the past so times before 1970 stay on their day
+	int64_t seconds = micros >= 0 ? micros / 1000000 : -((-micros + 999999) / 1000000);
+	int64_t fraction = micros - seconds * 1000000;
+	int64_t days = seconds >= 0 ? seconds / 86400 : -((-seconds + 86399) / 86400);
+	int secondOfDay = (int) (seconds - days * 86400);
+	int year, month, day;
+
+	civilFromDays((int) days, &year, &month, &day);
+	if (fraction == 0)
+		snprintf(buf, TIMESTAMP_STRING_SIZE, "%04d-%02d-%02d %02d:%02d:%02d", year, month, day,
+				secondOfDay / 3600, secondOfDay / 60 % 60, secondOfDay % 60);
+	else
+		snprintf(buf, TIMESTAMP_STRING_SIZE, "%04d-%02d-%02d %02d:%02d:%02d.%06d", year, month, day,
+				secondOfDay / 3600, secondOfDay / 60 % 60, secondOfDay % 60, (int) fraction);
+}
+
+// lay out the attributes in front of attrNum and return its offset, an
+// aligned schema pads the attributes and the end of the record to the
+// alignment of its numbers so they can be loaded directly. the offsets are
+// stored in offsets unless it is NULL.
+static int
+layoutAttrs (Schema *schema, int attrNum, int *offsets)
+{
+	int offset = 0, maxAlignment = 1, alignment, i;
+
+	for(i = 0; i < attrNum; i++) {
+		int size = attrLayout(schema, i, &alignment);
+		if (schema->aligned) {
+			offset = (offset + alignment - 1) / alignment * alignment;
+			maxAlignment = alignment > maxAlignment ? alignment : maxAlignment;
 		}
+		if (offsets != NULL)
+			offsets[i] = offset;
+		offset += size;
 	}
+	if (attrNum == schema->numAttr)
+		return (offset + maxAlignment - 1) / maxAlignment * maxAlignment;
+
+	if (schema->aligned) {
+		attrLayout(schema, attrNum, &alignment);
+		offset = (offset + alignment - 1) / alignment * alignment;
+	}
+	return offset;
+}
 
-	*result = offset;
+// compute the offsets of the attributes once when the schema is created
+RC
+initAttrOffsets (Schema *schema)
+{
+	int *offsets = (int *) malloc(sizeof(int) * (schema->numAttr + 1));
+	if (offsets == NULL)
+		return RC_ALLOC_MEM_FAIL;
+
+	offsets[schema->numAttr] = layoutAttrs(schema, schema->numAttr, offsets);
+
+	free(schema->attrOffsets);
+	schema->attrOffsets = offsets;
+	return RC_OK;
+}
+
+// the offset of an attribute in the record data, attrNum = numAttr gives the
+// size of the record. a schema that was not built by createSchema or
+// deserializeSchema has no cached offsets, its attrOffsets has to be NULL.
+RC 
+attrOffset (Schema *schema, int attrNum, int *result)
+{
+	if (schema->attrOffsets != NULL)
+		*result = schema->attrOffsets[attrNum];
+	else
+		*result = layoutAttrs(schema, attrNum, NULL);
+	return RC_OK;
+}
+
+// the bytes of an attribute in the slot of a record, a VARCHAR only keeps its
+// header and the inline prefix of its value
+int
+attrSlotSize (Schema *schema, int attrNum)
+{
+	int offset, end;
+
+	if (schema->dataTypes[attrNum] == DT_VARCHAR) {
+		int length = schema->typeLength[attrNum];
+		return VARCHAR_HEADER_SIZE + (length < VARCHAR_INLINE_SIZE ? length : VARCHAR_INLINE_SIZE);
+	}
+	attrOffset(schema, attrNum, &offset);
+	attrOffset(schema, attrNum + 1, &end);
+	return end - offset;
+}
+
+// the position of the value of an attribute in the slot of a record, behind
+// the header "[PPPP-SSSS](", the preceding attributes and its name
+RC
+slotAttrOffset (Schema *schema, int attrNum, int *result)
+{
+	int offset = 12;
+	int i;
+
+	for(i = 0; i < attrNum; i++) {
+		offset += strlen(schema->attrNames[i]) + 1 + attrSlotSize(schema, i) + 1;
+	}
+	*result = offset + strlen(schema->attrNames[attrNum]) + 1;
 	return RC_OK;
 }
 
@@ -537,3 +917,60 @@ deserializeRecords(Schema *schema, char *recordStr, int sizeRecord)
 	return head;
 }
 
+// parse one serialized record "[PPPP-SSSS](a:...,b:...)" into the given record
+// without touching the rest of the page, record->data must be large enough to
+// hold getRecordSize(schema) bytes
+RC
+deserializeRecord(Schema *schema, char *recordStr, Record *record)
+{
+	return deserializeRecordAttrs(schema, recordStr, record, NULL);
+}
+
+// same as deserializeRecord but only copies the attributes marked in attrs,
+// the others are skipped and keep their bytes in record->data
+RC
+deserializeRecordAttrs(Schema *schema, char *recordStr, Record *record, bool *attrs)
+{
+	if(schema == NULL || recordStr == NULL || record == NULL) {
+		return RC_PARAMS_ERROR;
+	}
+	// an empty slot was never written
+	if(recordStr[0] != '[') {
+		return RC_ERROR;
+	}
+
+	char num[5];
+	num[4] = '\0';
+	memcpy(num, recordStr + 1, 4);
+	record->id.page = (int)strtol(num, NULL, 10);
+	memcpy(num, recordStr + 6, 4);
+	record->id.slot = (int)strtol(num, NULL, 10);
+	// a tombstone of a deleted record
+	if(record->id.page == 0) {
+		return RC_ERROR;
+	}
+
+	// every attribute is stored as "name:value" with a value of fixed size
+	char *p = recordStr + 12;
+	for(int i = 0; i < schema->numAttr; i++) {
+		int offset;
+		int end;
+		attrOffset(schema, i, &offset);
+		attrOffset(schema, i + 1, &end);
+		p = p + strlen(schema->attrNames[i]) + 1;
+		if((attrs == NULL || attrs[i]) && schema->dataTypes[i] == DT_VARCHAR) {
+			// the rest of a long value is read from its overflow pages by
+			// the record manager
+			int length = readAttrInt(p);
+			memcpy(record->data + offset, p + VARCHAR_HEADER_SIZE,
+					length < VARCHAR_INLINE_SIZE ? length : VARCHAR_INLINE_SIZE);
+			if(length < schema->typeLength[i]) {
+				record->data[offset + length] = '\0';
+			}
+		} else if(attrs == NULL || attrs[i]) {
+			memcpy(record->data + offset, p, end - offset);
+		}
+		p = p + attrSlotSize(schema, i) + 1;
+	}
+	return RC_OK;
+}
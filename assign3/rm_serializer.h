@@ -1,6 +1,8 @@
 #ifndef RM_SERIALIZER_H
 #define RM_SERIALIZER_H
 
+#include <string.h>
+
 #include "dberror.h"
 #include "tables.h"
 
@@ -69,18 +71,118 @@ typedef struct VarString {
 			free(tmp);					\
 		} while(0)
 
+/************************************************************
+ *                    attribute encoding                    *
+ ************************************************************/
+// numbers are stored in the native binary form of their datatype with a
+// fixed byte order, little endian, so a table file can be read on any host.
+// booleans take a single byte holding 0 or 1.
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#define ATTR_SWAP32(x) __builtin_bswap32(x)
+#define ATTR_SWAP64(x) __builtin_bswap64(x)
+#else
+#define ATTR_SWAP32(x) (x)
+#define ATTR_SWAP64(x) (x)
+#endif
+
+static inline int
+readAttrInt(const char *data)
+{
+	unsigned int bits;
+	memcpy(&bits, data, sizeof(bits));
+	return (int) ATTR_SWAP32(bits);
+}
+
+static inline void
+writeAttrInt(char *data, int value)
+{
+	unsigned int bits = ATTR_SWAP32((unsigned int) value);
+	memcpy(data, &bits, sizeof(bits));
+}
+
+static inline float
+readAttrFloat(const char *data)
+{
+	unsigned int bits = (unsigned int) readAttrInt(data);
+	float value;
+	memcpy(&value, &bits, sizeof(value));
+	return value;
+}
+
+static inline void
+writeAttrFloat(char *data, float value)
+{
+	unsigned int bits;
+	memcpy(&bits, &value, sizeof(bits));
+	writeAttrInt(data, (int) bits);
+}
+
+// LONG, DOUBLE and TIMESTAMP take 8 bytes, DATE is stored like an INT
+static inline int64_t
+readAttrLong(const char *data)
+{
+	uint64_t bits;
+	memcpy(&bits, data, sizeof(bits));
+	return (int64_t) ATTR_SWAP64(bits);
+}
+
+static inline void
+writeAttrLong(char *data, int64_t value)
+{
+	uint64_t bits = ATTR_SWAP64((uint64_t) value);
+	memcpy(data, &bits, sizeof(bits));
+}
+
+static inline double
+readAttrDouble(const char *data)
+{
+	uint64_t bits = (uint64_t) readAttrLong(data);
+	double value;
+	memcpy(&value, &bits, sizeof(value));
+	return value;
+}
+
+static inline void
+writeAttrDouble(char *data, double value)
+{
+	uint64_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+	writeAttrLong(data, (int64_t) bits);
+}
+
+// a VARCHAR keeps its length, the first overflow page and this many bytes in
+// the slot of its record, the rest of a longer value is stored on a chain of
+// overflow pages
+#define VARCHAR_INLINE_SIZE 32
+#define VARCHAR_HEADER_SIZE 8
+
 /************************************************************
  *                    interface                             *
  ************************************************************/
 
 // get the offset of the given attribute
 extern RC attrOffset (Schema *schema, int attrNum, int *result);
+extern RC initAttrOffsets (Schema *schema);
+extern int attrSlotSize (Schema *schema, int attrNum);
+extern RC slotAttrOffset (Schema *schema, int attrNum, int *result);
+
+// convert dates "YYYY-MM-DD" and timestamps "YYYY-MM-DD HH:MM:SS[.ffffff]"
+// from and to their binary form, the buffers need DATE_STRING_SIZE and
+// TIMESTAMP_STRING_SIZE bytes. a timestamp buffer holds any int in each of
+// its seven fields, so formatTimestamp never truncates.
+#define DATE_STRING_SIZE 16
+#define TIMESTAMP_STRING_SIZE 64
+extern RC parseDate (const char *text, int *days);
+extern void formatDate (int days, char *buf);
+extern RC parseTimestamp (const char *text, int64_t *micros);
+extern void formatTimestamp (int64_t micros, char *buf);
 
 // serialize data involved in the record manager
 extern char * serializeTableInfo(RM_TableData *rel);
 extern char * serializeTableContent(RM_TableData *rel);
 extern char * serializeSchema(Schema *schema);
 extern char * serializeRecord(Record *record, Schema *schema);
+extern RC serializeRecordSlot(Record *record, Schema *schema, char *slotData, int size);
 extern char * serializeAttr(Record *record, Schema *schema, int attrNum);
 extern char * serializeValue(Value *val);
 extern char * serializePageDirectory(PageDirectory *pd);
@@ -93,12 +195,16 @@ extern Schema * deserializeSchema(char *schemaData);
 
 extern PageDirectoryCache * deserializePageDirectories(char *pdStr);
 extern RecordNode * deserializeRecords(Schema *schema, char *recordStr, int size);
+extern RC deserializeRecord(Schema *schema, char *recordStr, Record *record);
+extern RC deserializeRecordAttrs(Schema *schema, char *recordStr, Record *record, bool *attrs);
 extern Value * stringToValue(char *val);
 
 // help interface
 extern char * substring(const char *s, const char start, const char end);
 extern void * parseAttrInfo(Schema *schema, char *attrInfo);
 extern void * parseKeyInfo(Schema *schema, char *keyInfo);
+extern void * parseIncludeInfo(Schema *schema, char *includeInfo);
+extern int parseAttrNames(Schema *schema, char *info, int *attrs);
 extern PageDirectory * parsePageDirectory(char *t);
 void parseRecord(Schema *schema, Record *record, char *token);
 void PageInfoToString(int j,  int val,  char *data);
@@ -1,6 +1,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 
 #include "storage_mgr.h"
 #include "dberror.h"
@@ -264,8 +265,8 @@ RC writeBlock(int pageNum, SM_FileHandle *fHandle, SM_PageHandle memPage) {
     return RC_READ_NON_EXISTING_PAGE;
   }
 
-  // write data from memory, update page
-  fwrite(memPage, sizeof(char), strlen(memPage), fp);
+  // write the whole page, it may hold binary data past a null character
+  fwrite(memPage, sizeof(char), PAGE_SIZE, fp);
   fHandle->curPagePos = pageNum;
   return RC_OK;
 }
@@ -338,3 +339,32 @@ RC ensureCapacity(int numberOfPages, SM_FileHandle *fHandle) {
   }
   return RC_OK;
 }
+
+// The truncatePageFile method is to cut the page file down to its first
+// numberOfPages pages, giving the space of the pages behind back to the system.
+RC truncatePageFile(int numberOfPages, SM_FileHandle *fHandle) {
+  // validates parameters
+  if (fHandle == NULL) {
+    return RC_FILE_HANDLE_NOT_INIT;
+  }
+  if (numberOfPages < 1 || numberOfPages > fHandle->totalNumPages) {
+    return RC_READ_NON_EXISTING_PAGE;
+  }
+
+  // get the non-null file pointer
+  FILE *fp = fHandle->mgmtInfo;
+  if (fp == NULL) {
+    return RC_FILE_NOT_FOUND;
+  }
+
+  // write out buffered data before cutting the file
+  fflush(fp);
+  if (ftruncate(fileno(fp), (off_t) numberOfPages * PAGE_SIZE) != 0) {
+    return RC_WRITE_FAILED;
+  }
+  fHandle->totalNumPages = numberOfPages;
+  if (fHandle->curPagePos >= numberOfPages) {
+    fHandle->curPagePos = numberOfPages - 1;
+  }
+  return RC_OK;
+}
@@ -1,6 +1,8 @@
 #ifndef TABLES_H
 #define TABLES_H
 
+#include <stdint.h>
+
 #include "dt.h"
 
 // Data Types, Records, and Schemas
@@ -8,16 +10,23 @@ typedef enum DataType {
 	DT_INT = 0,
 	DT_STRING = 1,
 	DT_FLOAT = 2,
-	DT_BOOL = 3
+	DT_BOOL = 3,
+	DT_VARCHAR = 4, // a string of at most typeLength bytes, long values are stored out of line
+	DT_LONG = 5,
+	DT_DOUBLE = 6,
+	DT_DATE = 7, // the days since 1970-01-01
+	DT_TIMESTAMP = 8 // the microseconds since 1970-01-01 00:00:00
 } DataType;
 
 typedef struct Value {
 	DataType dt;
 	union v {
-		int intV;
+		int intV; // INT and DATE
 		char *stringV;
 		float floatV;
 		bool boolV;
+		int64_t longV; // LONG and TIMESTAMP
+		double doubleV;
 	} v;
 } Value;
 
@@ -41,6 +50,10 @@ typedef struct Schema
 	int *typeLength; // save the size of the strings if the attribute type is string
 	int *keyAttrs; // an array of integers that are the positions of the attributes of the key
 	int keySize; // the total number of keys
+	int *attrOffsets; // the offset of each attribute in the record data and the record size after the last one, NULL if not cached
+	bool aligned; // whether numbers start at a multiple of their size
+	int *includedAttrs; // the attributes stored with the key in the leaves of the key index
+	int numIncluded;
 } Schema;
 
 // TableData: Management Structure for a Record Manager to handle one relation
@@ -100,6 +113,18 @@ typedef struct RecordNode {
 			case DT_BOOL:							\
 			(result)->v.boolV = value;					\
 			break;								\
+			case DT_DATE:							\
+			(result)->v.intV = value;					\
+			break;								\
+			case DT_LONG:							\
+			case DT_TIMESTAMP:						\
+			(result)->v.longV = value;					\
+			break;								\
+			case DT_DOUBLE:							\
+			(result)->v.doubleV = value;					\
+			break;								\
+			default:							\
+			break;								\
 			}									\
 		} while(0)
 
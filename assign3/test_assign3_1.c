@@ -1,12 +1,16 @@
+#include <limits.h>
 #include <stdlib.h>
+#include <unistd.h>
 
 #include "dberror.h"
 
 #include "expr.h"
 #include "record_mgr.h"
+#include "btree_mgr.h"
 #include "tables.h"
 #include "test_helper.h"
 #include "rm_serializer.h"
+#include "storage_mgr.h"
 
 
 #define ASSERT_EQUALS_RECORDS(_l,_r, schema, message)			\
@@ -58,6 +62,22 @@ static void testScans (void);
 static void testScansTwo (void);
 static void testInsertManyRecords(void);
 static void testMultipleScans(void);
+static void testParallelScan(void);
+static void testScanBatch(void);
+static void testProjectedScan(void);
+static void testReuseDeletedSlots(void);
+static void testFullTable(void);
+static void testCompactTable(void);
+static void testRangeScan(void);
+static void testAttributeEncoding(void);
+static void testAlignedSchema(void);
+static void testVarchar(void);
+static void testWideTypes(void);
+static void testKeyIndex(void);
+static void testIndexScan(void);
+static void testCoveringScan(void);
+static void testSecondaryIndex(void);
+static void testZoneMaps(void);
 
 // struct for test records
 typedef struct TestRecord {
@@ -70,6 +90,15 @@ typedef struct TestRecord {
 Record *testRecord(Schema *schema, int a, char *b, int c);
 Schema *testSchema (void);
 Record *fromTestRecord (Schema *schema, TestRecord in);
+static void setKey (Record *record, Schema *schema, int a);
+static Schema *floatSchema (void);
+static Record *floatRecord (Schema *schema, int a, float f);
+static Expr *equalsExpr (int attrNum, char *value);
+static Expr *rangeExpr (int attrNum, char *low, char *high);
+static int countScan (RM_TableData *table, Expr *cond, RM_AccessPath *path, int *bad);
+static int countPagesScan (RM_TableData *table, Expr *cond, int *pagesRead, int *pagesSkipped);
+static int countProjectedScan (RM_TableData *table, Expr *cond, int numAttrs, int *attrs,
+		RM_AccessPath *path, int *sum);
 
 // test name
 char *testName;
@@ -86,7 +115,22 @@ main (void)
 	testScans();
 	testScansTwo();
 	testMultipleScans();
-	
+	testParallelScan();
+	testScanBatch();
+	testProjectedScan();
+	testReuseDeletedSlots();
+	testFullTable();
+	testCompactTable();
+	testRangeScan();
+	testAttributeEncoding();
+	testAlignedSchema();
+	testVarchar();
+	testWideTypes();
+	testKeyIndex();
+	testIndexScan();
+	testCoveringScan();
+	testSecondaryIndex();
+	testZoneMaps();
 
 	return 0;
 }
@@ -283,6 +327,1878 @@ testMultipleScans(void)
 	TEST_DONE();
 }
 
+// counts the records each worker of a parallel scan receives
+#define NUM_SCAN_WORKERS 4
+
+static RC
+countRecord (int worker, Record *record, void *context)
+{
+	int *counts = (int *) context;
+	// only records read from a slot of the table count
+	if(record->id.page >= 0 && record->id.slot >= 0)
+		counts[worker]++;
+	return RC_OK;
+}
+
+void
+testParallelScan(void)
+{
+	RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+	TestRecord inserts[] = {
+			{1, "aaaa", 3},
+			{2, "bbbb", 2},
+			{3, "cccc", 1},
+			{4, "dddd", 3},
+			{5, "eeee", 5},
+			{6, "ffff", 1},
+			{7, "gggg", 3},
+			{8, "hhhh", 3},
+			{9, "iiii", 2},
+			{10, "jjjj", 5},
+	};
+	int numInserts = 1000, i, total, expected = 0;
+	int counts[NUM_SCAN_WORKERS];
+	Record *r;
+	Schema *schema;
+	Expr *sel, *left, *right;
+	testName = "test parallel scan over multiple pages";
+	schema = testSchema();
+
+	TEST_CHECK(initRecordManager(NULL));
+	TEST_CHECK(createTable("test_table_r",schema));
+	TEST_CHECK(openTable(table, "test_table_r"));
+
+	// insert rows into table
+	for(i = 0; i < numInserts; i++)
+	{
+		TestRecord in = inserts[i % 10];
+		in.a = i;
+		if (in.c == 3)
+			expected++;
+		r = fromTestRecord(schema, in);
+		TEST_CHECK(insertRecord(table,r));
+		freeRecord(r);
+	}
+
+	// all tuples without a condition
+	memset(counts, 0, sizeof(counts));
+	TEST_CHECK(parallelScan(table, NULL, NUM_SCAN_WORKERS, countRecord, counts));
+	for(i = 0, total = 0; i < NUM_SCAN_WORKERS; i++)
+		total += counts[i];
+	ASSERT_EQUALS_INT(numInserts, total, "parallel scan returned all tuples");
+
+	// c = 3
+	MAKE_CONS(left, stringToValue("i3"));
+	MAKE_ATTRREF(right, 2);
+	MAKE_BINOP_EXPR(sel, left, right, OP_COMP_EQUAL);
+	memset(counts, 0, sizeof(counts));
+	TEST_CHECK(parallelScan(table, sel, NUM_SCAN_WORKERS, countRecord, counts));
+	for(i = 0, total = 0; i < NUM_SCAN_WORKERS; i++)
+		total += counts[i];
+	ASSERT_EQUALS_INT(expected, total, "parallel scan returned matching tuples");
+
+	TEST_CHECK(closeTable(table));
+	TEST_CHECK(deleteTable("test_table_r"));
+	TEST_CHECK(shutdownRecordManager());
+
+	freeExpr(sel);
+	free(table);
+	TEST_DONE();
+}
+
+void
+testScanBatch(void)
+{
+	RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+	TestRecord inserts[] = {
+			{1, "aaaa", 3},
+			{2, "bbbb", 2},
+			{3, "cccc", 1},
+			{4, "dddd", 3},
+			{5, "eeee", 5},
+			{6, "ffff", 1},
+			{7, "gggg", 3},
+			{8, "hhhh", 3},
+			{9, "iiii", 2},
+			{10, "jjjj", 5},
+	};
+	int numInserts = 1000, i, total = 0, expected = 0, rc;
+	Record *r;
+	RecordBatch *batch;
+	Schema *schema;
+	RM_ScanHandle *sc = (RM_ScanHandle *) malloc(sizeof(RM_ScanHandle));
+	Expr *sel, *left, *right;
+	Value *value;
+	testName = "test scanning tuples in batches";
+	schema = testSchema();
+
+	TEST_CHECK(initRecordManager(NULL));
+	TEST_CHECK(createTable("test_table_r",schema));
+	TEST_CHECK(openTable(table, "test_table_r"));
+
+	// insert rows into table
+	for(i = 0; i < numInserts; i++)
+	{
+		TestRecord in = inserts[i % 10];
+		in.a = i;
+		if (in.c == 3)
+			expected++;
+		r = fromTestRecord(schema, in);
+		TEST_CHECK(insertRecord(table,r));
+		freeRecord(r);
+	}
+
+	// c = 3 in batches smaller than a page
+	MAKE_CONS(left, stringToValue("i3"));
+	MAKE_ATTRREF(right, 2);
+	MAKE_BINOP_EXPR(sel, left, right, OP_COMP_EQUAL);
+	TEST_CHECK(createRecordBatch(&batch, schema, 64));
+	createRecord(&r, schema);
+	TEST_CHECK(startScan(table, sc, sel));
+	while((rc = nextBatch(sc, batch, 64)) == RC_OK)
+	{
+		for(i = 0; i < batch->count; i++)
+		{
+			getAttr(&batch->records[i], schema, 2, &value);
+			ASSERT_EQUALS_INT(3, value->v.intV, "batch record fulfills condition");
+			freeVal(value);
+			TEST_CHECK(getRecord(table, batch->records[i].id, r));
+			ASSERT_EQUALS_RECORDS(&batch->records[i], r, schema, "batch record has its RID");
+		}
+		total += batch->count;
+	}
+	if (rc != RC_RM_NO_MORE_TUPLES)
+		TEST_CHECK(rc);
+	TEST_CHECK(closeScan(sc));
+	ASSERT_EQUALS_INT(expected, total, "batches returned matching tuples");
+
+	TEST_CHECK(closeTable(table));
+	TEST_CHECK(deleteTable("test_table_r"));
+	TEST_CHECK(shutdownRecordManager());
+
+	freeRecord(r);
+	freeRecordBatch(batch);
+	freeExpr(sel);
+	free(sc);
+	free(table);
+	TEST_DONE();
+}
+
+void
+testProjectedScan(void)
+{
+	RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+	TestRecord inserts[] = {
+			{1, "aaaa", 3},
+			{2, "bbbb", 2},
+			{3, "cccc", 1},
+			{4, "dddd", 3},
+			{5, "eeee", 5},
+	};
+	int numInserts = 5, i, found = 0, rc;
+	int proj[] = {0};
+	int bOffset;
+	char empty[4] = {0};
+	Record *r;
+	Schema *schema;
+	RM_ScanHandle *sc = (RM_ScanHandle *) malloc(sizeof(RM_ScanHandle));
+	Expr *sel, *left, *right;
+	Value *value;
+	testName = "test scanning with a projection";
+	schema = testSchema();
+
+	TEST_CHECK(initRecordManager(NULL));
+	TEST_CHECK(createTable("test_table_r",schema));
+	TEST_CHECK(openTable(table, "test_table_r"));
+
+	// insert rows into table
+	for(i = 0; i < numInserts; i++)
+	{
+		r = fromTestRecord(schema, inserts[i]);
+		TEST_CHECK(insertRecord(table,r));
+		freeRecord(r);
+	}
+
+	// project a with condition c = 3, b is never decoded
+	MAKE_CONS(left, stringToValue("i3"));
+	MAKE_ATTRREF(right, 2);
+	MAKE_BINOP_EXPR(sel, left, right, OP_COMP_EQUAL);
+	attrOffset(schema, 1, &bOffset);
+	createRecord(&r, schema);
+	TEST_CHECK(startProjectedScan(table, sc, sel, 1, proj));
+	while((rc = next(sc, r)) == RC_OK)
+	{
+		getAttr(r, schema, 0, &value);
+		ASSERT_TRUE(value->v.intV == 1 || value->v.intV == 4, "projected attribute decoded");
+		freeVal(value);
+		ASSERT_TRUE(memcmp(r->data + bOffset, empty, 4) == 0, "other attribute not decoded");
+		found++;
+	}
+	if (rc != RC_RM_NO_MORE_TUPLES)
+		TEST_CHECK(rc);
+	TEST_CHECK(closeScan(sc));
+	ASSERT_EQUALS_INT(2, found, "projected scan returned matching tuples");
+
+	TEST_CHECK(closeTable(table));
+	TEST_CHECK(deleteTable("test_table_r"));
+	TEST_CHECK(shutdownRecordManager());
+
+	freeRecord(r);
+	freeExpr(sel);
+	free(sc);
+	free(table);
+	TEST_DONE();
+}
+
+void
+testReuseDeletedSlots(void)
+{
+	RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+	TestRecord inserts[] = {
+			{1, "aaaa", 3},
+			{2, "bbbb", 2},
+			{3, "cccc", 1},
+			{4, "dddd", 3},
+			{5, "eeee", 5},
+			{6, "ffff", 1},
+			{7, "gggg", 3},
+			{8, "hhhh", 3},
+			{9, "iiii", 2},
+			{10, "jjjj", 5},
+	};
+	int numInserts = 10, i;
+	Record *r;
+	RID rids[10], rid;
+	Schema *schema;
+	testName = "test reusing the slots of deleted records";
+	schema = testSchema();
+
+	TEST_CHECK(initRecordManager(NULL));
+	TEST_CHECK(createTable("test_table_r",schema));
+	TEST_CHECK(openTable(table, "test_table_r"));
+
+	// insert rows into table
+	for(i = 0; i < numInserts; i++)
+	{
+		r = fromTestRecord(schema, inserts[i]);
+		TEST_CHECK(insertRecord(table,r));
+		rids[i] = r->id;
+		freeRecord(r);
+	}
+
+	// the free chain survives closing the table
+	TEST_CHECK(deleteRecord(table, rids[3]));
+	TEST_CHECK(deleteRecord(table, rids[7]));
+	ASSERT_ERROR(deleteRecord(table, rids[7]), "record is already deleted");
+	TEST_CHECK(closeTable(table));
+	TEST_CHECK(openTable(table, "test_table_r"));
+	ASSERT_EQUALS_INT(8, getNumTuples(table), "deleted records are not counted");
+
+	createRecord(&r, schema);
+	ASSERT_ERROR(getRecord(table, rids[3], r), "deleted record is gone");
+	rid.page = rids[0].page;
+	rid.slot = 5000;
+	ASSERT_ERROR(getRecord(table, rid, r), "slot beyond the page");
+	rid.slot = -1;
+	ASSERT_ERROR(getRecord(table, rid, r), "negative slot");
+	rid.page = 1;
+	rid.slot = 0;
+	ASSERT_ERROR(getRecord(table, rid, r), "directory page holds no records");
+	rid.page = 100;
+	ASSERT_ERROR(getRecord(table, rid, r), "page beyond the table");
+	freeRecord(r);
+
+	// the last freed slot is reused first, every insert needs a new key
+	r = fromTestRecord(schema, inserts[0]);
+	ASSERT_EQUALS_INT(RC_IM_KEY_ALREADY_EXISTS, insertRecord(table, r), "key is taken");
+	setKey(r, schema, 100);
+	TEST_CHECK(insertRecord(table, r));
+	ASSERT_TRUE(r->id.page == rids[7].page && r->id.slot == rids[7].slot, "reuse last deleted slot");
+	setKey(r, schema, 101);
+	TEST_CHECK(insertRecord(table, r));
+	ASSERT_TRUE(r->id.page == rids[3].page && r->id.slot == rids[3].slot, "reuse first deleted slot");
+	setKey(r, schema, 102);
+	TEST_CHECK(insertRecord(table, r));
+	ASSERT_EQUALS_INT(numInserts, r->id.slot, "append after the free slots are used");
+	freeRecord(r);
+
+	// neighbours of reused slots are untouched
+	createRecord(&r, schema);
+	TEST_CHECK(getRecord(table, rids[4], r));
+	ASSERT_EQUALS_RECORDS(fromTestRecord(schema, inserts[4]), r, schema, "compare records");
+	TEST_CHECK(getRecord(table, rids[8], r));
+	ASSERT_EQUALS_RECORDS(fromTestRecord(schema, inserts[8]), r, schema, "compare records");
+	freeRecord(r);
+
+	TEST_CHECK(closeTable(table));
+	TEST_CHECK(deleteTable("test_table_r"));
+	TEST_CHECK(shutdownRecordManager());
+
+	free(table);
+	TEST_DONE();
+}
+
+// page numbers have four digits in the slot headers, a table of one record
+// per page fills up before it needs page 10000
+void
+testFullTable(void)
+{
+	RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+	char *names[] = { "a", "s" };
+	DataType dt[] = { DT_INT, DT_STRING };
+	int sizes[] = { 0, 3000 };
+	char **cpNames = (char **) malloc(sizeof(char*) * 2);
+	DataType *cpDt = (DataType *) malloc(sizeof(DataType) * 2);
+	int *cpSizes = (int *) malloc(sizeof(int) * 2);
+	int *cpKeys = (int *) calloc(1, sizeof(int));
+	int numInserts, found, bad, i;
+	RM_AccessPath path;
+	RID last;
+	RC rc;
+	Record *r;
+	Value *value;
+	Schema *schema;
+	testName = "test a table with all pages full";
+
+	for(i = 0; i < 2; i++)
+	{
+		cpNames[i] = (char *) malloc(2);
+		strcpy(cpNames[i], names[i]);
+	}
+	memcpy(cpDt, dt, sizeof(DataType) * 2);
+	memcpy(cpSizes, sizes, sizeof(int) * 2);
+	schema = createSchema(2, cpNames, cpDt, cpSizes, 1, cpKeys);
+
+	TEST_CHECK(initRecordManager(NULL));
+	TEST_CHECK(createTable("test_table_f", schema));
+	TEST_CHECK(openTable(table, "test_table_f"));
+	TEST_CHECK(createRecord(&r, schema));
+	MAKE_STRING_VALUE(value, "full");
+	TEST_CHECK(setAttr(r, schema, 1, value));
+	freeVal(value);
+	rc = RC_OK;
+	for(numInserts = 0; numInserts < 20000; numInserts++)
+	{
+		setKey(r, schema, numInserts);
+		if((rc = insertRecord(table, r)) != RC_OK)
+			break;
+		last = r->id;
+	}
+	ASSERT_EQUALS_INT(RC_RM_TABLE_FULL, rc, "table is full");
+	ASSERT_TRUE(numInserts > 9900, "records fill the pages up to 9999");
+	ASSERT_EQUALS_INT(9999, last.page, "last record is on page 9999");
+	ASSERT_EQUALS_INT(numInserts, getNumTuples(table), "rejected record is not counted");
+
+	found = countScan(table, NULL, &path, &bad);
+	ASSERT_EQUALS_INT(numInserts, found, "scan finds every record");
+	TEST_CHECK(getRecord(table, last, r));
+	ASSERT_EQUALS_INT(numInserts - 1, *(int *) r->data, "record on the last page");
+	TEST_CHECK(closeTable(table));
+	TEST_CHECK(openTable(table, "test_table_f"));
+	found = countScan(table, NULL, &path, &bad);
+	ASSERT_EQUALS_INT(numInserts, found, "scan finds every record after reopening");
+
+	// a deleted record makes room again
+	TEST_CHECK(deleteRecord(table, last));
+	setKey(r, schema, numInserts);
+	TEST_CHECK(insertRecord(table, r));
+	ASSERT_TRUE(r->id.page == last.page && r->id.slot == last.slot, "freed slot is reused");
+	setKey(r, schema, numInserts + 1);
+	ASSERT_EQUALS_INT(RC_RM_TABLE_FULL, insertRecord(table, r), "table is full again");
+	freeRecord(r);
+
+	TEST_CHECK(closeTable(table));
+	TEST_CHECK(deleteTable("test_table_f"));
+	TEST_CHECK(shutdownRecordManager());
+
+	freeSchema(schema);
+	free(table);
+	TEST_DONE();
+}
+
+void
+testCompactTable(void)
+{
+	RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+	TestRecord kept = {1, "aaaa", 3};
+	int numInserts = 1000, numKept = 0, i, j, numMapping;
+	Record *r, *r2;
+	RID *rids;
+	BTreeHandle *tree;
+	Value *value;
+	RIDMapping *mapping;
+	RM_ScanHandle *sc = (RM_ScanHandle *) malloc(sizeof(RM_ScanHandle));
+	Schema *schema;
+	long before;
+	FILE *file;
+	testName = "test compacting a table";
+	schema = testSchema();
+	rids = (RID *) malloc(sizeof(RID) * numInserts);
+
+	TEST_CHECK(initRecordManager(NULL));
+	TEST_CHECK(createTable("test_table_r",schema));
+	TEST_CHECK(openTable(table, "test_table_r"));
+
+	// keep every tenth record, its first attribute is the insert position
+	for(i = 0; i < numInserts; i++)
+	{
+		kept.a = i;
+		r = fromTestRecord(schema, kept);
+		TEST_CHECK(insertRecord(table,r));
+		rids[i] = r->id;
+		freeRecord(r);
+	}
+	for(i = 0; i < numInserts; i++)
+	{
+		if (i % 10 == 0)
+			numKept++;
+		else
+			TEST_CHECK(deleteRecord(table, rids[i]));
+	}
+
+	file = fopen("test_table_r", "r");
+	fseek(file, 0, SEEK_END);
+	before = ftell(file);
+	fclose(file);
+
+	TEST_CHECK(compactTable(table, &mapping, &numMapping));
+	ASSERT_EQUALS_INT(numKept, getNumTuples(table), "compaction keeps all records");
+	ASSERT_TRUE(numMapping > 0 && numMapping < numKept, "only records of the rear pages move");
+
+	file = fopen("test_table_r", "r");
+	fseek(file, 0, SEEK_END);
+	ASSERT_TRUE(ftell(file) < before, "emptied pages are cut off the file");
+	fclose(file);
+
+	// moved records are found under their new RID
+	for(i = 0; i < numMapping; i++)
+		for(j = 0; j < numInserts; j++)
+			if (rids[j].page == mapping[i].from.page && rids[j].slot == mapping[i].from.slot)
+				rids[j] = mapping[i].to;
+	free(mapping);
+
+	TEST_CHECK(closeTable(table));
+	TEST_CHECK(openTable(table, "test_table_r"));
+	createRecord(&r, schema);
+	for(i = 0; i < numInserts; i += 10)
+	{
+		kept.a = i;
+		TEST_CHECK(getRecord(table, rids[i], r));
+		ASSERT_EQUALS_RECORDS(fromTestRecord(schema, kept), r, schema, "compare records");
+	}
+
+	// a scan sees the same records
+	j = 0;
+	TEST_CHECK(startScan(table, sc, NULL));
+	while(next(sc, r) == RC_OK)
+		j++;
+	TEST_CHECK(closeScan(sc));
+	ASSERT_EQUALS_INT(numKept, j, "scan after compaction");
+	TEST_CHECK(closeTable(table));
+	TEST_CHECK(deleteTable("test_table_r"));
+
+	// a record whose key cannot be moved is taken out of its new page again,
+	// here the key index lost the keys of the records on the last page
+	TEST_CHECK(createTable("test_table_r",schema));
+	TEST_CHECK(openTable(table, "test_table_r"));
+	for(i = 0; i < numInserts; i++)
+	{
+		kept.a = i;
+		r2 = fromTestRecord(schema, kept);
+		TEST_CHECK(insertRecord(table,r2));
+		rids[i] = r2->id;
+		freeRecord(r2);
+	}
+	TEST_CHECK(closeTable(table));
+	TEST_CHECK(openBtree(&tree, "test_table_r.idx"));
+	for(i = 0; i < numInserts; i++)
+		if (rids[i].page == rids[numInserts - 1].page)
+		{
+			MAKE_VALUE(value, DT_INT, i);
+			TEST_CHECK(deleteKey(tree, value));
+			freeVal(value);
+		}
+	TEST_CHECK(closeBtree(tree));
+	TEST_CHECK(openTable(table, "test_table_r"));
+	TEST_CHECK(deleteRecord(table, rids[0]));
+	ASSERT_EQUALS_INT(RC_IM_KEY_NOT_FOUND, compactTable(table, &mapping, &numMapping),
+			"key of a moved record is missing");
+	ASSERT_EQUALS_INT(numInserts - 1, getNumTuples(table), "no record is lost or copied");
+	j = 0;
+	TEST_CHECK(startScan(table, sc, NULL));
+	while(next(sc, r) == RC_OK)
+		j++;
+	TEST_CHECK(closeScan(sc));
+	ASSERT_EQUALS_INT(numInserts - 1, j, "scan after the rejected compaction");
+	kept.a = numInserts - 1;
+	TEST_CHECK(getRecord(table, rids[numInserts - 1], r));
+	ASSERT_EQUALS_RECORDS(fromTestRecord(schema, kept), r, schema, "record stays on its page");
+	ASSERT_ERROR(getRecord(table, rids[0], r), "its copy is removed again");
+	MAKE_VALUE(value, DT_INT, 1);
+	TEST_CHECK(getRecordByKey(table, &value, r));
+	freeVal(value);
+	freeRecord(r);
+
+	TEST_CHECK(closeTable(table));
+	TEST_CHECK(deleteTable("test_table_r"));
+	TEST_CHECK(shutdownRecordManager());
+
+	free(rids);
+	free(sc);
+	free(table);
+	TEST_DONE();
+}
+
+void
+testRangeScan(void)
+{
+	RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+	TestRecord inserts = {1, "aaaa", 3};
+	int numInserts = 100, found, i;
+	Expr *a, *lower, *upper, *cons, *sel;
+	Record *r;
+	KeyRange range;
+	RM_ScanHandle *sc = (RM_ScanHandle *) malloc(sizeof(RM_ScanHandle));
+	Schema *schema;
+	testName = "test range scans";
+	schema = testSchema();
+
+	TEST_CHECK(initRecordManager(NULL));
+	TEST_CHECK(createTable("test_table_r",schema));
+	TEST_CHECK(openTable(table, "test_table_r"));
+	for(i = 0; i < numInserts; i++)
+	{
+		inserts.a = i;
+		r = fromTestRecord(schema, inserts);
+		TEST_CHECK(insertRecord(table,r));
+		freeRecord(r);
+	}
+
+	// a >= 20 AND a < 50
+	MAKE_ATTRREF(a, 0);
+	MAKE_CONS(cons, stringToValue("i20"));
+	MAKE_BINOP_EXPR(lower, a, cons, OP_COMP_GREATER_EQUAL);
+	MAKE_ATTRREF(a, 0);
+	MAKE_CONS(cons, stringToValue("i50"));
+	MAKE_BINOP_EXPR(upper, a, cons, OP_COMP_SMALLER);
+	MAKE_BINOP_EXPR(sel, lower, upper, OP_BOOL_AND);
+
+	createRecord(&r, schema);
+	TEST_CHECK(startScan(table, sc, sel));
+	TEST_CHECK(getScanKeyRange(sc, 0, &range));
+	ASSERT_TRUE(range.hasLow && range.lowInclusive && range.low.v.intV == 20, "scan range starts at 20");
+	ASSERT_TRUE(range.hasHigh && !range.highInclusive && range.high.v.intV == 50, "scan range ends before 50");
+	found = 0;
+	while(next(sc, r) == RC_OK)
+	{
+		Value *value;
+		getAttr(r, schema, 0, &value);
+		ASSERT_TRUE(value->v.intV >= 20 && value->v.intV < 50, "record in [20, 50)");
+		found++;
+		freeVal(value);
+		// values evaluated on the record live until the next call of next
+		TEST_CHECK(evalScanExpr(sc, r, upper, &value));
+		ASSERT_TRUE(value->dt == DT_BOOL && value->v.boolV, "a < 50 on the record");
+	}
+	TEST_CHECK(closeScan(sc));
+	ASSERT_EQUALS_INT(30, found, "all records in [20, 50)");
+
+	// AND a <= 10 leaves no value, the scan ends without reading a page
+	MAKE_ATTRREF(a, 0);
+	MAKE_CONS(cons, stringToValue("i10"));
+	MAKE_BINOP_EXPR(upper, a, cons, OP_COMP_SMALLER_EQUAL);
+	MAKE_BINOP_EXPR(lower, sel, upper, OP_BOOL_AND);
+	TEST_CHECK(startScan(table, sc, lower));
+	TEST_CHECK(getScanKeyRange(sc, 0, &range));
+	ASSERT_TRUE(range.empty, "contradicting bounds");
+	ASSERT_EQUALS_INT(RC_RM_NO_MORE_TUPLES, next(sc, r), "empty range scan");
+	TEST_CHECK(closeScan(sc));
+	freeExpr(lower);
+	freeRecord(r);
+
+	TEST_CHECK(closeTable(table));
+	TEST_CHECK(deleteTable("test_table_r"));
+	TEST_CHECK(shutdownRecordManager());
+
+	free(sc);
+	free(table);
+	TEST_DONE();
+}
+
+void
+testAttributeEncoding(void)
+{
+	RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+	int ints[] = { -5, 0, 10000, INT_MAX, INT_MIN, 0x01020304 };
+	float floats[] = { -1.5, 0, 3.25e10, 1e-20, 7, 0.1 };
+	char *strings[] = { "ab", "", "abcdef", "abcdefgh", "x", "yz" };
+	int numRecords = 6, found, i;
+	char *names[] = { "i", "f", "t", "s" };
+	DataType dt[] = { DT_INT, DT_FLOAT, DT_BOOL, DT_STRING };
+	int sizes[] = { 0, 0, 0, 6 };
+	char **cpNames = (char **) malloc(sizeof(char*) * 4);
+	DataType *cpDt = (DataType *) malloc(sizeof(DataType) * 4);
+	int *cpSizes = (int *) malloc(sizeof(int) * 4);
+	int *cpKeys = (int *) calloc(1, sizeof(int));
+	RID rids[6];
+	Expr *attr, *cons, *sel;
+	Record *r;
+	Value *value;
+	RM_ScanHandle *sc = (RM_ScanHandle *) malloc(sizeof(RM_ScanHandle));
+	Schema *schema;
+	testName = "test binary attribute encoding";
+
+	for(i = 0; i < 4; i++)
+	{
+		cpNames[i] = (char *) malloc(2);
+		strcpy(cpNames[i], names[i]);
+	}
+	memcpy(cpDt, dt, sizeof(DataType) * 4);
+	memcpy(cpSizes, sizes, sizeof(int) * 4);
+	schema = createSchema(4, cpNames, cpDt, cpSizes, 1, cpKeys);
+
+	TEST_CHECK(initRecordManager(NULL));
+	TEST_CHECK(createTable("test_table_r",schema));
+	TEST_CHECK(openTable(table, "test_table_r"));
+
+	// values that do not fit 4 digits, negative numbers and zero bytes
+	for(i = 0; i < numRecords; i++)
+	{
+		TEST_CHECK(createRecord(&r, schema));
+		MAKE_VALUE(value, DT_INT, ints[i]);
+		TEST_CHECK(setAttr(r, schema, 0, value));
+		freeVal(value);
+		MAKE_VALUE(value, DT_FLOAT, floats[i]);
+		TEST_CHECK(setAttr(r, schema, 1, value));
+		freeVal(value);
+		MAKE_VALUE(value, DT_BOOL, i % 2);
+		TEST_CHECK(setAttr(r, schema, 2, value));
+		freeVal(value);
+		MAKE_STRING_VALUE(value, strings[i]);
+		TEST_CHECK(setAttr(r, schema, 3, value));
+		freeVal(value);
+		if (i == 5)
+			ASSERT_TRUE(r->data[0] == 0x04 && r->data[3] == 0x01, "integers are stored little endian");
+		TEST_CHECK(insertRecord(table, r));
+		rids[i] = r->id;
+		freeRecord(r);
+	}
+	TEST_CHECK(closeTable(table));
+	TEST_CHECK(openTable(table, "test_table_r"));
+
+	createRecord(&r, schema);
+	for(i = 0; i < numRecords; i++)
+	{
+		TEST_CHECK(getRecord(table, rids[i], r));
+		getAttr(r, schema, 0, &value);
+		ASSERT_EQUALS_INT(ints[i], value->v.intV, "int attribute");
+		freeVal(value);
+		getAttr(r, schema, 1, &value);
+		ASSERT_TRUE(value->v.floatV == floats[i], "float attribute");
+		freeVal(value);
+		getAttr(r, schema, 2, &value);
+		ASSERT_TRUE(value->v.boolV == i % 2, "bool attribute");
+		freeVal(value);
+		getAttr(r, schema, 3, &value);
+		// a string longer than the attribute is cut
+		ASSERT_TRUE(strncmp(value->v.stringV, strings[i], 6) == 0 && strlen(value->v.stringV) <= 6, "string attribute");
+		freeVal(value);
+	}
+
+	// i < 0 finds the negative numbers
+	MAKE_ATTRREF(attr, 0);
+	MAKE_CONS(cons, stringToValue("i0"));
+	MAKE_BINOP_EXPR(sel, attr, cons, OP_COMP_SMALLER);
+	found = 0;
+	TEST_CHECK(startScan(table, sc, sel));
+	while(next(sc, r) == RC_OK)
+		found++;
+	TEST_CHECK(closeScan(sc));
+	ASSERT_EQUALS_INT(2, found, "negative numbers");
+	freeExpr(sel);
+	freeRecord(r);
+
+	TEST_CHECK(closeTable(table));
+	TEST_CHECK(deleteTable("test_table_r"));
+	TEST_CHECK(shutdownRecordManager());
+
+	freeSchema(schema);
+	free(sc);
+	free(table);
+	TEST_DONE();
+}
+
+void
+testAlignedSchema(void)
+{
+	RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+	char *names[] = { "t", "i", "s", "f" };
+	DataType dt[] = { DT_BOOL, DT_INT, DT_STRING, DT_FLOAT };
+	int sizes[] = { 0, 0, 3, 0 };
+	int packed[] = { 0, sizeof(bool), sizeof(bool) + 4, sizeof(bool) + 7, sizeof(bool) + 11 };
+	int aligned[] = { 0, 4, 8, 12, 16 };
+	char **cpNames = (char **) malloc(sizeof(char*) * 4);
+	DataType *cpDt = (DataType *) malloc(sizeof(DataType) * 4);
+	int *cpSizes = (int *) malloc(sizeof(int) * 4);
+	int *cpKeys = (int *) calloc(1, sizeof(int));
+	int offset, i;
+	Record *r;
+	Value *value;
+	Schema *schema, hand;
+	testName = "test aligned schemas";
+
+	for(i = 0; i < 4; i++)
+	{
+		cpNames[i] = (char *) malloc(2);
+		strcpy(cpNames[i], names[i]);
+	}
+	memcpy(cpDt, dt, sizeof(DataType) * 4);
+	memcpy(cpSizes, sizes, sizeof(int) * 4);
+	schema = createSchema(4, cpNames, cpDt, cpSizes, 1, cpKeys);
+
+	// the offsets are precomputed, the one after the last is the record size
+	for(i = 0; i <= 4; i++)
+	{
+		attrOffset(schema, i, &offset);
+		ASSERT_EQUALS_INT(packed[i], offset, "packed offset");
+	}
+	TEST_CHECK(setSchemaAlignment(schema, true));
+	for(i = 0; i <= 4; i++)
+	{
+		attrOffset(schema, i, &offset);
+		ASSERT_EQUALS_INT(aligned[i], offset, "aligned offset");
+	}
+	ASSERT_EQUALS_INT(16, getRecordSize(schema), "aligned record size");
+
+	// a schema built by hand without cached offsets is laid out the same way
+	hand = *schema;
+	hand.attrOffsets = NULL;
+	for(i = 0; i <= 4; i++)
+	{
+		attrOffset(&hand, i, &offset);
+		ASSERT_EQUALS_INT(aligned[i], offset, "aligned offset without cache");
+	}
+	hand.aligned = false;
+	ASSERT_EQUALS_INT(packed[4], getRecordSize(&hand), "packed size without cache");
+
+	// the alignment is part of the table
+	TEST_CHECK(initRecordManager(NULL));
+	TEST_CHECK(createTable("test_table_r",schema));
+	TEST_CHECK(openTable(table, "test_table_r"));
+	ASSERT_TRUE(table->schema->aligned, "reopened schema is aligned");
+	ASSERT_EQUALS_INT(16, getRecordSize(table->schema), "reopened record size");
+
+	TEST_CHECK(createRecord(&r, table->schema));
+	MAKE_VALUE(value, DT_INT, -7);
+	TEST_CHECK(setAttr(r, table->schema, 1, value));
+	freeVal(value);
+	MAKE_VALUE(value, DT_FLOAT, 0.5);
+	TEST_CHECK(setAttr(r, table->schema, 3, value));
+	freeVal(value);
+	TEST_CHECK(insertRecord(table, r));
+	memset(r->data, 0, 16);
+	TEST_CHECK(getRecord(table, r->id, r));
+	getAttr(r, table->schema, 1, &value);
+	ASSERT_EQUALS_INT(-7, value->v.intV, "aligned int");
+	freeVal(value);
+	getAttr(r, table->schema, 3, &value);
+	ASSERT_TRUE(value->v.floatV == 0.5, "aligned float");
+	freeVal(value);
+	freeRecord(r);
+
+	TEST_CHECK(closeTable(table));
+	TEST_CHECK(deleteTable("test_table_r"));
+	TEST_CHECK(shutdownRecordManager());
+
+	freeSchema(schema);
+	free(table);
+	TEST_DONE();
+}
+
+void
+testWideTypes(void)
+{
+	RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+	RM_ScanHandle *sc = (RM_ScanHandle *) malloc(sizeof(RM_ScanHandle));
+	char *names[] = { "id", "price", "day", "at" };
+	DataType dt[] = { DT_LONG, DT_DOUBLE, DT_DATE, DT_TIMESTAMP };
+	char **cpNames = (char **) malloc(sizeof(char*) * 4);
+	DataType *cpDt = (DataType *) malloc(sizeof(DataType) * 4);
+	int *cpSizes = (int *) calloc(4, sizeof(int));
+	int *cpKeys = (int *) calloc(1, sizeof(int));
+	int numInserts = 50, found, days, i;
+	int64_t start;
+	Expr *sel, *attr, *low, *high;
+	KeyRange range;
+	Record *r;
+	Value *value;
+	Schema *schema;
+	testName = "test LONG, DOUBLE, DATE and TIMESTAMP attributes";
+
+	for(i = 0; i < 4; i++)
+	{
+		cpNames[i] = (char *) malloc(strlen(names[i]) + 1);
+		strcpy(cpNames[i], names[i]);
+	}
+	memcpy(cpDt, dt, sizeof(DataType) * 4);
+	schema = createSchema(4, cpNames, cpDt, cpSizes, 1, cpKeys);
+	TEST_CHECK(setSchemaAlignment(schema, true));
+	TEST_CHECK(parseTimestamp("2024-03-01 08:00:00", &start));
+
+	TEST_CHECK(initRecordManager(NULL));
+	TEST_CHECK(createTable("test_table_r",schema));
+	TEST_CHECK(openTable(table, "test_table_r"));
+	for(i = 0; i < 4; i++)
+		ASSERT_EQUALS_INT(dt[i], table->schema->dataTypes[i], "type survives the schema page");
+	ASSERT_EQUALS_INT(32, getRecordSize(table->schema), "aligned record size");
+
+	// one event per hour with 64-bit ids
+	TEST_CHECK(createRecord(&r, table->schema));
+	for(i = 0; i < numInserts; i++)
+	{
+		MAKE_VALUE(value, DT_LONG, (int64_t) 1 << 40 | i);
+		TEST_CHECK(setAttr(r, table->schema, 0, value));
+		freeVal(value);
+		MAKE_VALUE(value, DT_DOUBLE, i * 0.01);
+		TEST_CHECK(setAttr(r, table->schema, 1, value));
+		freeVal(value);
+		MAKE_VALUE(value, DT_DATE, (int) ((start / 1000000 + i * 3600) / 86400));
+		TEST_CHECK(setAttr(r, table->schema, 2, value));
+		freeVal(value);
+		MAKE_VALUE(value, DT_TIMESTAMP, start + (int64_t) i * 3600 * 1000000);
+		TEST_CHECK(setAttr(r, table->schema, 3, value));
+		freeVal(value);
+		TEST_CHECK(insertRecord(table, r));
+	}
+	TEST_CHECK(closeTable(table));
+	TEST_CHECK(openTable(table, "test_table_r"));
+
+	// the events of March 2nd
+	MAKE_ATTRREF(attr, 3);
+	MAKE_CONS(low, stringToValue("T2024-03-02"));
+	MAKE_CONS(high, stringToValue("T2024-03-02 23:59:59.999999"));
+	MAKE_BETWEEN_EXPR(sel, attr, low, high);
+	TEST_CHECK(startScan(table, sc, sel));
+	TEST_CHECK(getScanKeyRange(sc, 3, &range));
+	ASSERT_TRUE(range.hasLow && range.low.dt == DT_TIMESTAMP
+			&& range.low.v.longV == start + (int64_t) 16 * 3600 * 1000000, "range starts at midnight");
+	TEST_CHECK(parseDate("2024-03-02", &days));
+	found = 0;
+	while(next(sc, r) == RC_OK)
+	{
+		getAttr(r, table->schema, 2, &value);
+		ASSERT_EQUALS_INT(days, value->v.intV, "event on March 2nd");
+		freeVal(value);
+		getAttr(r, table->schema, 0, &value);
+		ASSERT_TRUE(value->v.longV >> 40 == 1, "64-bit id");
+		freeVal(value);
+		found++;
+	}
+	ASSERT_EQUALS_INT(24, found, "one event per hour");
+	TEST_CHECK(closeScan(sc));
+	freeExpr(sel);
+	freeRecord(r);
+
+	TEST_CHECK(closeTable(table));
+	TEST_CHECK(deleteTable("test_table_r"));
+	TEST_CHECK(shutdownRecordManager());
+
+	freeSchema(schema);
+	free(sc);
+	free(table);
+	TEST_DONE();
+}
+
+void
+testVarchar(void)
+{
+	RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+	char *names[] = { "a", "v", "s" };
+	DataType dt[] = { DT_INT, DT_VARCHAR, DT_STRING };
+	int sizes[] = { 0, 10000, 4 };
+	int lengths[] = { 0, 5, VARCHAR_INLINE_SIZE, VARCHAR_INLINE_SIZE + 1, 9000 };
+	int numInserts = 5;
+	char **cpNames = (char **) malloc(sizeof(char*) * 3);
+	DataType *cpDt = (DataType *) malloc(sizeof(DataType) * 3);
+	int *cpSizes = (int *) malloc(sizeof(int) * 3);
+	int *cpKeys = (int *) calloc(1, sizeof(int));
+	char *strings[5];
+	char page[PAGE_SIZE], header[16];
+	RID rids[5];
+	int i, j, pages;
+	RM_AccessPath path;
+	RC rc;
+	Record *r;
+	Value *value;
+	Schema *schema;
+	RM_ScanHandle *sc = (RM_ScanHandle *) malloc(sizeof(RM_ScanHandle));
+	SM_FileHandle fh;
+	Expr *sel, *left, *right;
+	testName = "test VARCHAR attributes with overflow pages";
+
+	for(i = 0; i < 3; i++)
+	{
+		cpNames[i] = (char *) malloc(2);
+		strcpy(cpNames[i], names[i]);
+	}
+	memcpy(cpDt, dt, sizeof(DataType) * 3);
+	memcpy(cpSizes, sizes, sizeof(int) * 3);
+	schema = createSchema(3, cpNames, cpDt, cpSizes, 1, cpKeys);
+
+	// values from empty to spanning several overflow pages
+	for(i = 0; i < numInserts; i++)
+	{
+		strings[i] = (char *) malloc(lengths[i] + 1);
+		for(j = 0; j < lengths[i]; j++)
+			strings[i][j] = 'a' + (i + j) % 26;
+		strings[i][lengths[i]] = '\0';
+	}
+
+	TEST_CHECK(initRecordManager(NULL));
+	TEST_CHECK(createTable("test_table_v",schema));
+	TEST_CHECK(openTable(table, "test_table_v"));
+	TEST_CHECK(createRecord(&r, table->schema));
+	for(i = 0; i < numInserts; i++)
+	{
+		MAKE_VALUE(value, DT_INT, i);
+		TEST_CHECK(setAttr(r, table->schema, 0, value));
+		freeVal(value);
+		MAKE_STRING_VALUE(value, strings[i]);
+		TEST_CHECK(setAttr(r, table->schema, 1, value));
+		freeVal(value);
+		MAKE_STRING_VALUE(value, "xyz");
+		TEST_CHECK(setAttr(r, table->schema, 2, value));
+		freeVal(value);
+		TEST_CHECK(insertRecord(table, r));
+		rids[i] = r->id;
+	}
+
+	// the per-attribute lengths and the values survive reopening the table
+	TEST_CHECK(closeTable(table));
+	TEST_CHECK(openTable(table, "test_table_v"));
+	ASSERT_EQUALS_INT(DT_VARCHAR, table->schema->dataTypes[1], "varchar type");
+	ASSERT_EQUALS_INT(10000, table->schema->typeLength[1], "varchar length");
+	ASSERT_EQUALS_INT(4, table->schema->typeLength[2], "string length");
+	for(i = 0; i < numInserts; i++)
+	{
+		memset(r->data, 'x', getRecordSize(table->schema));
+		TEST_CHECK(getRecord(table, rids[i], r));
+		getAttr(r, table->schema, 1, &value);
+		ASSERT_EQUALS_INT(DT_STRING, value->dt, "varchar is read as a string");
+		ASSERT_TRUE(strcmp(strings[i], value->v.stringV) == 0, "varchar value");
+		freeVal(value);
+		getAttr(r, table->schema, 2, &value);
+		ASSERT_EQUALS_STRING("xyz", value->v.stringV, "string behind varchar");
+		freeVal(value);
+	}
+
+	// scans compare the whole value
+	MAKE_STRING_VALUE(value, strings[4]);
+	MAKE_CONS(left, value);
+	MAKE_ATTRREF(right, 1);
+	MAKE_BINOP_EXPR(sel, left, right, OP_COMP_EQUAL);
+	TEST_CHECK(startScan(table, sc, sel));
+	TEST_CHECK(next(sc, r));
+	ASSERT_EQUALS_INT(rids[4].slot, r->id.slot, "scan finds long value");
+	ASSERT_TRUE(next(sc, r) == RC_RM_NO_MORE_TUPLES, "only one match");
+	TEST_CHECK(closeScan(sc));
+	freeExpr(sel);
+
+	// overflow pages of updated and deleted values are reused
+	TEST_CHECK(getRecord(table, rids[4], r));
+	MAKE_STRING_VALUE(value, "short");
+	TEST_CHECK(setAttr(r, table->schema, 1, value));
+	freeVal(value);
+	TEST_CHECK(updateRecord(table, r));
+	TEST_CHECK(deleteRecord(table, rids[3]));
+	MAKE_STRING_VALUE(value, strings[4]);
+	TEST_CHECK(setAttr(r, table->schema, 1, value));
+	freeVal(value);
+	setKey(r, table->schema, numInserts);
+	TEST_CHECK(insertRecord(table, r));
+	setKey(r, table->schema, numInserts + 1);
+	TEST_CHECK(insertRecord(table, r));
+	TEST_CHECK(closeTable(table));
+	TEST_CHECK(openPageFile("test_table_v.ovf", &fh));
+	pages = fh.totalNumPages;
+	TEST_CHECK(closePageFile(&fh));
+	ASSERT_EQUALS_INT(1 + 3 + 3, pages, "two long values and the header");
+
+	TEST_CHECK(openTable(table, "test_table_v"));
+	TEST_CHECK(getRecord(table, rids[4], r));
+	getAttr(r, table->schema, 1, &value);
+	ASSERT_EQUALS_STRING("short", value->v.stringV, "updated varchar");
+	freeVal(value);
+	TEST_CHECK(getRecord(table, rids[3], r));
+	getAttr(r, table->schema, 1, &value);
+	ASSERT_TRUE(strcmp(strings[4], value->v.stringV) == 0, "reinserted varchar");
+	freeVal(value);
+
+	// an update that fails keeps the old value and frees the overflow pages
+	// written for the new one
+	TEST_CHECK(getRecord(table, rids[2], r));
+	MAKE_STRING_VALUE(value, strings[4]);
+	TEST_CHECK(setAttr(r, table->schema, 1, value));
+	freeVal(value);
+	setKey(r, table->schema, 1);
+	ASSERT_EQUALS_INT(RC_IM_KEY_ALREADY_EXISTS, updateRecord(table, r), "update to a taken key");
+	TEST_CHECK(getRecord(table, rids[2], r));
+	getAttr(r, table->schema, 1, &value);
+	ASSERT_EQUALS_STRING(strings[2], value->v.stringV, "value kept after rejected update");
+	freeVal(value);
+	MAKE_STRING_VALUE(value, strings[4]);
+	TEST_CHECK(setAttr(r, table->schema, 1, value));
+	freeVal(value);
+	setKey(r, table->schema, numInserts + 2);
+	TEST_CHECK(insertRecord(table, r));
+	freeRecord(r);
+	TEST_CHECK(closeTable(table));
+	TEST_CHECK(openPageFile("test_table_v.ovf", &fh));
+	ASSERT_EQUALS_INT(pages + 3, fh.totalNumPages, "pages of the rejected update are reused");
+	TEST_CHECK(closePageFile(&fh));
+
+	// a table whose overflow file is missing cannot be opened
+	TEST_CHECK(rename("test_table_v.ovf", "test_table_v.ovf.moved") == 0 ? RC_OK : RC_FILE_NOT_FOUND);
+	ASSERT_EQUALS_INT(RC_FILE_NOT_FOUND, openTable(table, "test_table_v"), "missing overflow file");
+	TEST_CHECK(rename("test_table_v.ovf.moved", "test_table_v.ovf") == 0 ? RC_OK : RC_FILE_NOT_FOUND);
+	TEST_CHECK(openTable(table, "test_table_v"));
+	ASSERT_EQUALS_INT(numInserts + 2, getNumTuples(table), "table opens again");
+	TEST_CHECK(closeTable(table));
+
+	// a value whose overflow pages cannot be read ends a scan with the error
+	// instead of RC_RM_NO_MORE_TUPLES
+	TEST_CHECK(openPageFile("test_table_v", &fh));
+	TEST_CHECK(readBlock(rids[3].page, &fh, page));
+	sprintf(header, "[%04d-%04d](", rids[3].page, rids[3].slot);
+	for(j = 0; memcmp(page + j, header, strlen(header)) != 0; j++)
+		;
+	for(j = j + strlen(header); memcmp(page + j, ",v:", 3) != 0; j++)
+		;
+	writeAttrInt(page + j + 3 + 4, 9999);
+	TEST_CHECK(writeBlock(rids[3].page, &fh, page));
+	TEST_CHECK(closePageFile(&fh));
+	TEST_CHECK(openTable(table, "test_table_v"));
+	TEST_CHECK(createRecord(&r, table->schema));
+	ASSERT_ERROR(getRecord(table, rids[3], r), "overflow page out of range");
+	TEST_CHECK(startScan(table, sc, NULL));
+	for(j = 0; (rc = next(sc, r)) == RC_OK; j++)
+		;
+	ASSERT_EQUALS_INT(RC_READ_NON_EXISTING_PAGE, rc, "scan reports the unreadable value");
+	ASSERT_TRUE(j < numInserts + 2, "scan stops at the unreadable value");
+	ASSERT_EQUALS_INT(RC_READ_NON_EXISTING_PAGE, next(sc, r), "error is kept");
+	TEST_CHECK(closeScan(sc));
+	sel = rangeExpr(0, "i0", "i100");
+	TEST_CHECK(startScan(table, sc, sel));
+	TEST_CHECK(getScanAccessPath(sc, &path));
+	ASSERT_EQUALS_INT(RM_ACCESS_KEY_INDEX, path, "a in [0, 100) uses the key index");
+	while((rc = next(sc, r)) == RC_OK)
+		;
+	ASSERT_EQUALS_INT(RC_READ_NON_EXISTING_PAGE, rc, "index scan reports the unreadable value");
+	TEST_CHECK(closeScan(sc));
+	freeExpr(sel);
+	freeRecord(r);
+
+	TEST_CHECK(closeTable(table));
+	TEST_CHECK(deleteTable("test_table_v"));
+	ASSERT_TRUE(access("test_table_v.ovf", F_OK) != 0, "overflow file is deleted");
+	TEST_CHECK(shutdownRecordManager());
+
+	for(i = 0; i < numInserts; i++)
+		free(strings[i]);
+	freeSchema(schema);
+	free(sc);
+	free(table);
+	TEST_DONE();
+}
+
+void
+testKeyIndex(void)
+{
+	RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+	char *names[] = { "a", "b", "c" };
+	DataType dt[] = { DT_INT, DT_STRING, DT_INT };
+	int sizes[] = { 0, 4, 0 };
+	int keys[] = { 1, 0 };
+	char **cpNames = (char **) malloc(sizeof(char*) * 3);
+	DataType *cpDt = (DataType *) malloc(sizeof(DataType) * 3);
+	int *cpSizes = (int *) malloc(sizeof(int) * 3);
+	int *cpKeys = (int *) malloc(sizeof(int) * 2);
+	int numInserts = 1000, numMapping, i, bad;
+	RIDMapping *mapping;
+	RID *rids = (RID *) malloc(sizeof(RID) * numInserts);
+	Value *key[2];
+	Value *value;
+	Record *r, *in;
+	Expr *a, *b, *cons, *upper, *sel, *both;
+	RM_AccessPath path;
+	Schema *schema;
+	testName = "test the unique key index";
+
+	for(i = 0; i < 3; i++)
+	{
+		cpNames[i] = (char *) malloc(2);
+		strcpy(cpNames[i], names[i]);
+	}
+	memcpy(cpDt, dt, sizeof(DataType) * 3);
+	memcpy(cpSizes, sizes, sizeof(int) * 3);
+	memcpy(cpKeys, keys, sizeof(int) * 2);
+	schema = createSchema(3, cpNames, cpDt, cpSizes, 2, cpKeys);
+
+	// composite key (b, a), b alone repeats
+	TEST_CHECK(initRecordManager(NULL));
+	TEST_CHECK(createTable("test_table_k",schema));
+	TEST_CHECK(openTable(table, "test_table_k"));
+	ASSERT_EQUALS_INT(2, table->schema->keySize, "key size is read back");
+	ASSERT_EQUALS_INT(1, table->schema->keyAttrs[0], "first key attribute");
+	for(i = 0; i < numInserts; i++)
+	{
+		in = testRecord(table->schema, i, (i % 2) ? "odd" : "even", i * 2);
+		TEST_CHECK(insertRecord(table, in));
+		rids[i] = in->id;
+		freeRecord(in);
+	}
+	in = testRecord(table->schema, 7, "odd", 0);
+	ASSERT_TRUE(insertRecord(table, in) == RC_IM_KEY_ALREADY_EXISTS, "duplicate key is rejected");
+	freeRecord(in);
+
+	// every record is found by its key
+	TEST_CHECK(createRecord(&r, table->schema));
+	bad = 0;
+	for(i = 0; i < numInserts; i++)
+	{
+		MAKE_STRING_VALUE(key[0], (i % 2) ? "odd" : "even");
+		MAKE_VALUE(key[1], DT_INT, i);
+		if(getRecordByKey(table, key, r) != RC_OK || r->id.page != rids[i].page
+				|| r->id.slot != rids[i].slot)
+			bad++;
+		freeVal(key[0]);
+		freeVal(key[1]);
+	}
+	if(bad)
+		ASSERT_TRUE(false, "lookup by key");
+	ASSERT_TRUE(true, "lookup by key");
+	MAKE_STRING_VALUE(key[0], "odd");
+	MAKE_VALUE(key[1], DT_INT, 8);
+	ASSERT_TRUE(getRecordByKey(table, key, r) == RC_IM_KEY_NOT_FOUND, "missing key");
+	freeVal(key[0]);
+	freeVal(key[1]);
+
+	// updates move the key and may not collide, deletes remove it
+	TEST_CHECK(getRecord(table, rids[2], r));
+	setKey(r, table->schema, 4);
+	ASSERT_TRUE(updateRecord(table, r) == RC_IM_KEY_ALREADY_EXISTS, "update to a used key");
+	setKey(r, table->schema, 5000);
+	TEST_CHECK(updateRecord(table, r));
+	TEST_CHECK(deleteRecord(table, rids[4]));
+	MAKE_STRING_VALUE(key[0], "even");
+	MAKE_VALUE(key[1], DT_INT, 2);
+	ASSERT_TRUE(getRecordByKey(table, key, r) == RC_IM_KEY_NOT_FOUND, "old key is gone");
+	key[1]->v.intV = 4;
+	ASSERT_TRUE(getRecordByKey(table, key, r) == RC_IM_KEY_NOT_FOUND, "deleted key is gone");
+	key[1]->v.intV = 5000;
+	TEST_CHECK(getRecordByKey(table, key, r));
+	ASSERT_EQUALS_INT(rids[2].slot, r->id.slot, "updated key");
+	getAttr(r, table->schema, 2, &value);
+	ASSERT_EQUALS_INT(4, value->v.intV, "record behind updated key");
+	freeVal(value);
+
+	// the index survives reopening and compaction
+	for(i = 0; i < numInserts; i += 3)
+		TEST_CHECK(deleteRecord(table, rids[i]));
+	TEST_CHECK(closeTable(table));
+	TEST_CHECK(openTable(table, "test_table_k"));
+	TEST_CHECK(compactTable(table, &mapping, &numMapping));
+	ASSERT_TRUE(numMapping > 0, "records were moved");
+	free(mapping);
+	TEST_CHECK(getRecordByKey(table, key, r));
+	freeVal(key[0]);
+	freeVal(key[1]);
+	bad = 0;
+	for(i = 0; i < numInserts; i++)
+	{
+		RC rc;
+		MAKE_STRING_VALUE(key[0], (i % 2) ? "odd" : "even");
+		MAKE_VALUE(key[1], DT_INT, i);
+		rc = getRecordByKey(table, key, r);
+		if(i % 3 == 0 || i == 2 || i == 4)
+			bad += rc != RC_IM_KEY_NOT_FOUND;
+		else
+		{
+			getAttr(r, table->schema, 2, &value);
+			bad += rc != RC_OK || value->v.intV != i * 2;
+			freeVal(value);
+		}
+		freeVal(key[0]);
+		freeVal(key[1]);
+	}
+	if(bad)
+		ASSERT_TRUE(false, "lookup after compaction");
+	ASSERT_TRUE(true, "lookup after compaction");
+
+	// a missing index is loaded from the table when it is opened
+	TEST_CHECK(closeTable(table));
+	ASSERT_TRUE(unlink("test_table_k.idx") == 0, "index file is removed");
+	TEST_CHECK(openTable(table, "test_table_k"));
+	bad = 0;
+	for(i = 1; i < numInserts; i += 3)
+	{
+		MAKE_STRING_VALUE(key[0], (i % 2) ? "odd" : "even");
+		MAKE_VALUE(key[1], DT_INT, i);
+		if(i != 4)
+		{
+			bad += getRecordByKey(table, key, r) != RC_OK;
+			getAttr(r, table->schema, 2, &value);
+			bad += value->v.intV != i * 2;
+			freeVal(value);
+		}
+		freeVal(key[0]);
+		freeVal(key[1]);
+	}
+	if(bad)
+		ASSERT_TRUE(false, "lookup in the rebuilt index");
+	ASSERT_TRUE(true, "lookup in the rebuilt index");
+	in = testRecord(table->schema, 7, "odd", 0);
+	ASSERT_TRUE(insertRecord(table, in) == RC_IM_KEY_ALREADY_EXISTS, "rebuilt index rejects duplicates");
+	freeRecord(in);
+	freeRecord(r);
+
+	// scans bound a prefix of the key, b = odd AND a < 100 narrows both
+	MAKE_ATTRREF(b, 1);
+	MAKE_CONS(cons, stringToValue("sodd"));
+	MAKE_BINOP_EXPR(sel, b, cons, OP_COMP_EQUAL);
+	i = countScan(table, sel, &path, &bad);
+	ASSERT_EQUALS_INT(333, i, "b = odd");
+	ASSERT_EQUALS_INT(RM_ACCESS_KEY_INDEX, path, "leading key attribute uses the index");
+	ASSERT_EQUALS_INT(0, bad, "b = odd in RID order");
+	MAKE_ATTRREF(a, 0);
+	MAKE_CONS(cons, stringToValue("i100"));
+	MAKE_BINOP_EXPR(upper, a, cons, OP_COMP_SMALLER);
+	MAKE_BINOP_EXPR(both, sel, upper, OP_BOOL_AND);
+	i = countScan(table, both, &path, &bad);
+	ASSERT_EQUALS_INT(33, i, "b = odd AND a < 100");
+	ASSERT_EQUALS_INT(0, bad, "b = odd AND a < 100 in RID order");
+	freeExpr(both);
+
+	TEST_CHECK(closeTable(table));
+	TEST_CHECK(deleteTable("test_table_k"));
+	ASSERT_TRUE(access("test_table_k.idx", F_OK) != 0, "index file is deleted");
+	TEST_CHECK(shutdownRecordManager());
+
+	freeSchema(schema);
+	free(rids);
+	free(table);
+	TEST_DONE();
+}
+
+void
+testIndexScan(void)
+{
+	RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+	RM_ScanHandle *sc = (RM_ScanHandle *) malloc(sizeof(RM_ScanHandle));
+	int numInserts = 2000, found, bad, i;
+	RM_AccessPath path;
+	RecordBatch *batch;
+	Expr *a, *c, *cons, *lower, *upper, *sel, *list[3];
+	Value *value;
+	Record *r;
+	Schema *schema;
+	testName = "test scans through the key index";
+	schema = testSchema();
+
+	// a is the key and inserted in random order, c is not indexed
+	TEST_CHECK(initRecordManager(NULL));
+	TEST_CHECK(createTable("test_table_i", schema));
+	TEST_CHECK(openTable(table, "test_table_i"));
+	for(i = 0; i < numInserts; i++)
+	{
+		r = testRecord(schema, (int) ((long) i * 7919 % numInserts), "aaaa", i);
+		TEST_CHECK(insertRecord(table, r));
+		freeRecord(r);
+	}
+
+	// a = 42 is a point lookup
+	MAKE_ATTRREF(a, 0);
+	MAKE_CONS(cons, stringToValue("i42"));
+	MAKE_BINOP_EXPR(sel, a, cons, OP_COMP_EQUAL);
+	found = countScan(table, sel, &path, &bad);
+	ASSERT_EQUALS_INT(1, found, "a = 42");
+	ASSERT_EQUALS_INT(RM_ACCESS_KEY_INDEX, path, "a = 42 uses the key index");
+	freeExpr(sel);
+
+	// a >= 100 AND a < 300, the records come back in heap order
+	MAKE_ATTRREF(a, 0);
+	MAKE_CONS(cons, stringToValue("i100"));
+	MAKE_BINOP_EXPR(lower, a, cons, OP_COMP_GREATER_EQUAL);
+	MAKE_ATTRREF(a, 0);
+	MAKE_CONS(cons, stringToValue("i300"));
+	MAKE_BINOP_EXPR(upper, a, cons, OP_COMP_SMALLER);
+	MAKE_BINOP_EXPR(sel, lower, upper, OP_BOOL_AND);
+	found = countScan(table, sel, &path, &bad);
+	ASSERT_EQUALS_INT(200, found, "a in [100, 300)");
+	ASSERT_EQUALS_INT(RM_ACCESS_KEY_INDEX, path, "range uses the key index");
+	ASSERT_EQUALS_INT(0, bad, "records sorted by RID");
+
+	// the same in batches, a record deleted after the start is skipped
+	TEST_CHECK(createRecordBatch(&batch, schema, 64));
+	TEST_CHECK(createRecord(&r, schema));
+	TEST_CHECK(startScan(table, sc, sel));
+	TEST_CHECK(nextBatch(sc, batch, 64));
+	ASSERT_EQUALS_INT(64, batch->count, "first batch is full");
+	found = batch->count;
+	for(i = 100; i < 300; i++)
+	{
+		RID last = batch->records[batch->count - 1].id;
+		MAKE_VALUE(value, DT_INT, i);
+		TEST_CHECK(getRecordByKey(table, &value, r));
+		freeVal(value);
+		if(r->id.page > last.page || (r->id.page == last.page && r->id.slot > last.slot))
+			break;
+	}
+	TEST_CHECK(deleteRecord(table, r->id));
+	freeRecord(r);
+	while(nextBatch(sc, batch, 64) == RC_OK)
+		found += batch->count;
+	TEST_CHECK(closeScan(sc));
+	ASSERT_EQUALS_INT(199, found, "deleted record is not returned");
+	TEST_CHECK(freeRecordBatch(batch));
+	freeExpr(sel);
+
+	// an exclusive bound with an open end
+	MAKE_ATTRREF(a, 0);
+	MAKE_CONS(cons, stringToValue("i1990"));
+	MAKE_BINOP_EXPR(sel, a, cons, OP_COMP_GREATER);
+	found = countScan(table, sel, &path, &bad);
+	ASSERT_EQUALS_INT(9, found, "a > 1990");
+	ASSERT_EQUALS_INT(RM_ACCESS_KEY_INDEX, path, "a > 1990 uses the key index");
+	freeExpr(sel);
+
+	// IN scans the range between its smallest and largest value
+	MAKE_CONS(list[0], stringToValue("i3"));
+	MAKE_CONS(list[1], stringToValue("i1000"));
+	MAKE_CONS(list[2], stringToValue("i5000"));
+	MAKE_ATTRREF(a, 0);
+	MAKE_IN_EXPR(sel, a, list, 3);
+	found = countScan(table, sel, &path, &bad);
+	ASSERT_EQUALS_INT(2, found, "a IN (3, 1000, 5000)");
+	ASSERT_EQUALS_INT(RM_ACCESS_KEY_INDEX, path, "IN uses the key index");
+	freeExpr(sel);
+
+	// conditions that do not bound the key read the heap
+	MAKE_ATTRREF(c, 2);
+	MAKE_CONS(cons, stringToValue("i10"));
+	MAKE_BINOP_EXPR(sel, c, cons, OP_COMP_SMALLER);
+	found = countScan(table, sel, &path, &bad);
+	ASSERT_EQUALS_INT(10, found, "c < 10");
+	ASSERT_EQUALS_INT(RM_ACCESS_HEAP, path, "c < 10 reads the heap");
+	freeExpr(sel);
+	MAKE_ATTRREF(a, 0);
+	MAKE_CONS(cons, stringToValue("i5"));
+	MAKE_BINOP_EXPR(lower, a, cons, OP_COMP_EQUAL);
+	MAKE_ATTRREF(a, 0);
+	MAKE_CONS(cons, stringToValue("i6"));
+	MAKE_BINOP_EXPR(upper, a, cons, OP_COMP_EQUAL);
+	MAKE_BINOP_EXPR(sel, lower, upper, OP_BOOL_OR);
+	found = countScan(table, sel, &path, &bad);
+	ASSERT_EQUALS_INT(2, found, "a = 5 OR a = 6");
+	ASSERT_EQUALS_INT(RM_ACCESS_HEAP, path, "OR reads the heap");
+	freeExpr(sel);
+	found = countScan(table, NULL, &path, &bad);
+	ASSERT_EQUALS_INT(numInserts - 1, found, "no condition");
+	ASSERT_EQUALS_INT(RM_ACCESS_HEAP, path, "no condition reads the heap");
+
+	// a contradiction reads nothing
+	MAKE_ATTRREF(a, 0);
+	MAKE_CONS(cons, stringToValue("i10"));
+	MAKE_BINOP_EXPR(lower, a, cons, OP_COMP_GREATER);
+	MAKE_ATTRREF(a, 0);
+	MAKE_CONS(cons, stringToValue("i5"));
+	MAKE_BINOP_EXPR(upper, a, cons, OP_COMP_SMALLER);
+	MAKE_BINOP_EXPR(sel, lower, upper, OP_BOOL_AND);
+	found = countScan(table, sel, &path, &bad);
+	ASSERT_EQUALS_INT(0, found, "a > 10 AND a < 5");
+	ASSERT_EQUALS_INT(RM_ACCESS_NONE, path, "empty range reads nothing");
+	freeExpr(sel);
+
+	// an updated key is seen by the next index scan
+	MAKE_ATTRREF(a, 0);
+	MAKE_CONS(cons, stringToValue("i4242"));
+	MAKE_BINOP_EXPR(sel, a, cons, OP_COMP_EQUAL);
+	found = countScan(table, sel, &path, &bad);
+	ASSERT_EQUALS_INT(0, found, "a = 4242 before the update");
+	TEST_CHECK(createRecord(&r, schema));
+	MAKE_VALUE(value, DT_INT, 42);
+	TEST_CHECK(getRecordByKey(table, &value, r));
+	freeVal(value);
+	setKey(r, schema, 4242);
+	TEST_CHECK(updateRecord(table, r));
+	freeRecord(r);
+	found = countScan(table, sel, &path, &bad);
+	ASSERT_EQUALS_INT(1, found, "a = 4242 after the update");
+	freeExpr(sel);
+
+	TEST_CHECK(closeTable(table));
+	TEST_CHECK(deleteTable("test_table_i"));
+	TEST_CHECK(shutdownRecordManager());
+
+	freeSchema(schema);
+	free(sc);
+	free(table);
+	TEST_DONE();
+}
+
+void
+testCoveringScan(void)
+{
+	RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+	int numInserts = 2000, found, sum, i;
+	int include[] = {2}, proj[] = {0, 2}, all[] = {0, 1, 2}, wrong[] = {0, 2, 2, 3};
+	RIDMapping *mapping;
+	int numMapping;
+	RM_AccessPath path;
+	Expr *a, *c, *cons, *sel;
+	Value *value;
+	Record *r;
+	Schema *schema, *other;
+	testName = "test index-only scans over included attributes";
+	schema = testSchema();
+
+	// the key index on a also stores c
+	other = testSchema();
+	ASSERT_ERROR(setKeyIncludes(other, 1, wrong), "key attribute cannot be included");
+	ASSERT_ERROR(setKeyIncludes(other, 2, wrong + 1), "attribute included twice");
+	ASSERT_ERROR(setKeyIncludes(other, 1, wrong + 3), "attribute out of range");
+	freeSchema(other);
+	TEST_CHECK(setKeyIncludes(schema, 1, include));
+	TEST_CHECK(initRecordManager(NULL));
+	TEST_CHECK(createTable("test_table_c", schema));
+	TEST_CHECK(openTable(table, "test_table_c"));
+	ASSERT_EQUALS_INT(1, table->schema->numIncluded, "included attribute is stored");
+	ASSERT_EQUALS_INT(2, table->schema->includedAttrs[0], "included attribute is stored");
+	for(i = 0; i < numInserts; i++)
+	{
+		int key = (int) ((long) i * 7919 % numInserts);
+		r = testRecord(schema, key, "bbbb", 3 * key);
+		TEST_CHECK(insertRecord(table, r));
+		freeRecord(r);
+	}
+
+	// a projection on a and c is answered by the index in key order
+	found = countProjectedScan(table, NULL, 2, proj, &path, &sum);
+	ASSERT_EQUALS_INT(numInserts, found, "all records from the index");
+	ASSERT_EQUALS_INT(RM_ACCESS_INDEX_ONLY, path, "no condition reads the index");
+	ASSERT_EQUALS_INT(3 * numInserts * (numInserts - 1) / 2, sum, "c is read from the index");
+
+	MAKE_ATTRREF(a, 0);
+	MAKE_CONS(cons, stringToValue("i1000"));
+	MAKE_BINOP_EXPR(sel, a, cons, OP_COMP_SMALLER);
+	found = countProjectedScan(table, sel, 2, proj, &path, &sum);
+	ASSERT_EQUALS_INT(1000, found, "a < 1000");
+	ASSERT_EQUALS_INT(RM_ACCESS_INDEX_ONLY, path, "key range reads the index");
+	freeExpr(sel);
+
+	// a condition on c filters the entries of the index
+	MAKE_ATTRREF(c, 2);
+	MAKE_CONS(cons, stringToValue("i30"));
+	MAKE_BINOP_EXPR(sel, c, cons, OP_COMP_SMALLER);
+	found = countProjectedScan(table, sel, 2, proj, &path, &sum);
+	ASSERT_EQUALS_INT(10, found, "c < 30");
+	ASSERT_EQUALS_INT(RM_ACCESS_INDEX_ONLY, path, "c < 30 reads the index");
+
+	// b is not in the index, so projecting it reads the heap
+	found = countProjectedScan(table, sel, 3, all, &path, &sum);
+	ASSERT_EQUALS_INT(10, found, "c < 30 with b");
+	ASSERT_EQUALS_INT(RM_ACCESS_HEAP, path, "projecting b reads the heap");
+
+	// updates of c are seen by the index, deleted records are gone
+	TEST_CHECK(createRecord(&r, schema));
+	for(i = 0; i < 10; i++)
+	{
+		MAKE_VALUE(value, DT_INT, i);
+		TEST_CHECK(getRecordByKey(table, &value, r));
+		freeVal(value);
+		if(i % 2)
+		{
+			TEST_CHECK(deleteRecord(table, r->id));
+		}
+		else
+		{
+			MAKE_VALUE(value, DT_INT, 1000 + i);
+			TEST_CHECK(setAttr(r, schema, 2, value));
+			freeVal(value);
+			TEST_CHECK(updateRecord(table, r));
+		}
+	}
+	freeRecord(r);
+	found = countProjectedScan(table, sel, 2, proj, &path, &sum);
+	ASSERT_EQUALS_INT(0, found, "c < 30 after the updates");
+	freeExpr(sel);
+	found = countProjectedScan(table, NULL, 2, proj, &path, &sum);
+	ASSERT_EQUALS_INT(numInserts - 5, found, "deleted records are not returned");
+	ASSERT_EQUALS_INT(3 * numInserts * (numInserts - 1) / 2 - 3 * 45 + 5 * 1004, sum,
+			"updated c is read from the index");
+
+	// the included attributes survive compaction and rebuilding the index
+	TEST_CHECK(compactTable(table, &mapping, &numMapping));
+	free(mapping);
+	TEST_CHECK(closeTable(table));
+	ASSERT_TRUE(unlink("test_table_c.idx") == 0, "index file is removed");
+	TEST_CHECK(openTable(table, "test_table_c"));
+	found = countProjectedScan(table, NULL, 2, proj, &path, &sum);
+	ASSERT_EQUALS_INT(numInserts - 5, found, "records from the rebuilt index");
+	ASSERT_EQUALS_INT(RM_ACCESS_INDEX_ONLY, path, "rebuilt index is read");
+	ASSERT_EQUALS_INT(3 * numInserts * (numInserts - 1) / 2 - 3 * 45 + 5 * 1004, sum,
+			"c is read from the rebuilt index");
+
+	TEST_CHECK(closeTable(table));
+	TEST_CHECK(deleteTable("test_table_c"));
+	TEST_CHECK(shutdownRecordManager());
+
+	freeSchema(schema);
+	free(table);
+	TEST_DONE();
+}
+
+void
+testSecondaryIndex(void)
+{
+	RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+	int numInserts = 2000, expected, found, bad, i;
+	int byC[] = {2}, byBC[] = {1, 2}, byF[] = {1}, wrong[] = {3};
+	int *cOf = (int *) malloc(sizeof(int) * numInserts);
+	bool *live = (bool *) malloc(sizeof(bool) * numInserts);
+	char *status[] = { "open", "paid", "sent", "done" };
+	RIDMapping *mapping;
+	int numMapping;
+	RM_AccessPath path;
+	Expr *c, *cons, *lower, *upper, *sel;
+	Value *value;
+	Record *r;
+	Schema *schema;
+	testName = "test secondary indexes";
+	schema = testSchema();
+
+	// a is the key, b takes 4 and c 50 values shared by many records
+	TEST_CHECK(initRecordManager(NULL));
+	TEST_CHECK(createTable("test_table_s", schema));
+	TEST_CHECK(openTable(table, "test_table_s"));
+	for(i = 0; i < numInserts; i++)
+	{
+		int a = (int) ((long) i * 7919 % numInserts);
+		r = testRecord(schema, a, status[a % 4], a % 50);
+		TEST_CHECK(insertRecord(table, r));
+		freeRecord(r);
+		cOf[a] = a % 50;
+		live[a] = true;
+	}
+
+	// indexes built from the records of the table
+	TEST_CHECK(createIndex(table, 1, byC, "by_c"));
+	TEST_CHECK(createIndex(table, 2, byBC, "by_b_c"));
+	ASSERT_EQUALS_INT(RC_IM_INDEX_EXISTS, createIndex(table, 1, byBC, "by_c"), "name is taken");
+	ASSERT_ERROR(createIndex(table, 1, byC, "by c"), "name with a blank");
+	ASSERT_ERROR(createIndex(table, 1, wrong, "by_d"), "attribute out of range");
+	ASSERT_TRUE(access("test_table_s.by_c.idx", F_OK) == 0, "index file exists");
+
+	sel = equalsExpr(2, "i7");
+	found = countScan(table, sel, &path, &bad);
+	ASSERT_EQUALS_INT(numInserts / 50, found, "c = 7");
+	ASSERT_EQUALS_INT(RM_ACCESS_SECONDARY_INDEX, path, "c = 7 uses the index on c");
+	ASSERT_EQUALS_INT(0, bad, "records sorted by RID");
+	freeExpr(sel);
+
+	MAKE_ATTRREF(c, 2);
+	MAKE_CONS(cons, stringToValue("i10"));
+	MAKE_BINOP_EXPR(lower, c, cons, OP_COMP_GREATER_EQUAL);
+	MAKE_ATTRREF(c, 2);
+	MAKE_CONS(cons, stringToValue("i12"));
+	MAKE_BINOP_EXPR(upper, c, cons, OP_COMP_SMALLER);
+	MAKE_BINOP_EXPR(sel, lower, upper, OP_BOOL_AND);
+	found = countScan(table, sel, &path, &bad);
+	ASSERT_EQUALS_INT(2 * numInserts / 50, found, "c in [10, 12)");
+	ASSERT_EQUALS_INT(RM_ACCESS_SECONDARY_INDEX, path, "range uses the index on c");
+	ASSERT_EQUALS_INT(0, bad, "records sorted by RID");
+	freeExpr(sel);
+
+	// b = 'paid' AND c = 5 bounds both attributes of the index on b, c
+	MAKE_BINOP_EXPR(sel, equalsExpr(1, "spaid"), equalsExpr(2, "i5"), OP_BOOL_AND);
+	found = countScan(table, sel, &path, &bad);
+	ASSERT_EQUALS_INT(numInserts / 100, found, "b = 'paid' AND c = 5");
+	ASSERT_EQUALS_INT(RM_ACCESS_SECONDARY_INDEX, path, "b, c uses an index");
+	ASSERT_EQUALS_INT(0, bad, "matching records");
+	freeExpr(sel);
+
+	// the key index wins a tie
+	MAKE_BINOP_EXPR(sel, equalsExpr(0, "i42"), equalsExpr(2, "i42"), OP_BOOL_AND);
+	found = countScan(table, sel, &path, &bad);
+	ASSERT_EQUALS_INT(1, found, "a = 42 AND c = 42");
+	ASSERT_EQUALS_INT(RM_ACCESS_KEY_INDEX, path, "a = 42 AND c = 42 uses the key index");
+	freeExpr(sel);
+
+	// updates move the entries, deleted records lose them, a new key keeps them
+	TEST_CHECK(createRecord(&r, schema));
+	for(i = 0; i < 210; i++)
+	{
+		MAKE_VALUE(value, DT_INT, i);
+		TEST_CHECK(getRecordByKey(table, &value, r));
+		freeVal(value);
+		if(i < 100)
+		{
+			MAKE_VALUE(value, DT_INT, 7);
+			TEST_CHECK(setAttr(r, schema, 2, value));
+			freeVal(value);
+			TEST_CHECK(updateRecord(table, r));
+			cOf[i] = 7;
+		}
+		else if(i < 200)
+		{
+			TEST_CHECK(deleteRecord(table, r->id));
+			live[i] = false;
+		}
+		else
+		{
+			setKey(r, schema, 5000 + i);
+			TEST_CHECK(updateRecord(table, r));
+		}
+	}
+
+	// a failed update or insert leaves the indexes as they were
+	MAKE_VALUE(value, DT_INT, 300);
+	TEST_CHECK(getRecordByKey(table, &value, r));
+	freeVal(value);
+	setKey(r, schema, 301);
+	MAKE_VALUE(value, DT_INT, 8);
+	TEST_CHECK(setAttr(r, schema, 2, value));
+	freeVal(value);
+	ASSERT_EQUALS_INT(RC_IM_KEY_ALREADY_EXISTS, updateRecord(table, r), "key is taken");
+	ASSERT_EQUALS_INT(RC_IM_KEY_ALREADY_EXISTS, insertRecord(table, r), "key is taken");
+	freeRecord(r);
+
+	for(expected = 0, i = 0; i < numInserts; i++)
+		expected += live[i] && cOf[i] == 7;
+	sel = equalsExpr(2, "i7");
+	found = countScan(table, sel, &path, &bad);
+	ASSERT_EQUALS_INT(expected, found, "c = 7 after the updates");
+	ASSERT_EQUALS_INT(0, bad, "matching records sorted by RID");
+	for(expected = 0, i = 0; i < numInserts; i++)
+		expected += live[i] && cOf[i] == 8;
+	freeExpr(sel);
+	sel = equalsExpr(2, "i8");
+	found = countScan(table, sel, &path, &bad);
+	ASSERT_EQUALS_INT(expected, found, "c = 8 is unchanged by the rejected update");
+	freeExpr(sel);
+
+	// the entries follow the records moved by compaction and the indexes are
+	// listed on page 0, a missing index file is built again
+	TEST_CHECK(compactTable(table, &mapping, &numMapping));
+	ASSERT_TRUE(numMapping > 0, "records were moved");
+	free(mapping);
+	TEST_CHECK(closeTable(table));
+	ASSERT_TRUE(unlink("test_table_s.by_c.idx") == 0, "index file is removed");
+	TEST_CHECK(openTable(table, "test_table_s"));
+	for(expected = 0, i = 0; i < numInserts; i++)
+		expected += live[i] && cOf[i] == 7;
+	sel = equalsExpr(2, "i7");
+	found = countScan(table, sel, &path, &bad);
+	ASSERT_EQUALS_INT(expected, found, "c = 7 after compaction and reopening");
+	ASSERT_EQUALS_INT(RM_ACCESS_SECONDARY_INDEX, path, "rebuilt index is used");
+	ASSERT_EQUALS_INT(0, bad, "matching records sorted by RID");
+
+	// a dropped index is gone for good
+	TEST_CHECK(dropIndex(table, "by_c"));
+	ASSERT_EQUALS_INT(RC_IM_INDEX_NOT_FOUND, dropIndex(table, "by_c"), "index is dropped");
+	ASSERT_TRUE(access("test_table_s.by_c.idx", F_OK) != 0, "index file is deleted");
+	found = countScan(table, sel, &path, &bad);
+	ASSERT_EQUALS_INT(expected, found, "c = 7 without the index");
+	ASSERT_EQUALS_INT(RM_ACCESS_HEAP, path, "c = 7 reads the heap");
+	freeExpr(sel);
+	TEST_CHECK(closeTable(table));
+	TEST_CHECK(openTable(table, "test_table_s"));
+	MAKE_BINOP_EXPR(sel, equalsExpr(1, "spaid"), equalsExpr(2, "i5"), OP_BOOL_AND);
+	found = countScan(table, sel, &path, &bad);
+	ASSERT_EQUALS_INT(RM_ACCESS_SECONDARY_INDEX, path, "index on b, c is kept");
+	freeExpr(sel);
+
+	TEST_CHECK(closeTable(table));
+	TEST_CHECK(deleteTable("test_table_s"));
+	ASSERT_TRUE(access("test_table_s.by_b_c.idx", F_OK) != 0, "index files are deleted");
+
+	// -0.0 and 0.0 are one value of an index on a FLOAT, whether the entries
+	// were loaded by createIndex or added by insertRecord
+	freeSchema(schema);
+	schema = floatSchema();
+	TEST_CHECK(createTable("test_table_s", schema));
+	TEST_CHECK(openTable(table, "test_table_s"));
+	for(i = 0; i < 2 * numInserts; i++)
+	{
+		if(i == numInserts)
+			TEST_CHECK(createIndex(table, 1, byF, "by_f"));
+		r = floatRecord(schema, i, i % 2 == 1 ? (float) i : i < numInserts ? -0.0f : 0.0f);
+		TEST_CHECK(insertRecord(table, r));
+		freeRecord(r);
+	}
+	sel = equalsExpr(1, "f0.0");
+	found = countScan(table, sel, &path, &bad);
+	ASSERT_EQUALS_INT(numInserts, found, "f = 0.0 matches -0.0 and 0.0");
+	ASSERT_EQUALS_INT(RM_ACCESS_SECONDARY_INDEX, path, "f = 0.0 uses the index on f");
+	ASSERT_EQUALS_INT(0, bad, "matching records sorted by RID");
+	freeExpr(sel);
+	sel = equalsExpr(1, "f-0.0");
+	found = countScan(table, sel, &path, &bad);
+	ASSERT_EQUALS_INT(numInserts, found, "f = -0.0 matches -0.0 and 0.0");
+	ASSERT_EQUALS_INT(RM_ACCESS_SECONDARY_INDEX, path, "f = -0.0 uses the index on f");
+	freeExpr(sel);
+	TEST_CHECK(closeTable(table));
+	TEST_CHECK(deleteTable("test_table_s"));
+	TEST_CHECK(shutdownRecordManager());
+
+	freeSchema(schema);
+	free(cOf);
+	free(live);
+	free(table);
+	TEST_DONE();
+}
+
+void
+testZoneMaps(void)
+{
+	RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+	int numInserts = 5000, pages, read, skipped, found, bad, total, i;
+	int counts[NUM_SCAN_WORKERS];
+	char b[5];
+	RM_AccessPath path;
+	Expr *sel;
+	Value *value;
+	Record *r;
+	Schema *schema;
+	testName = "test zone maps";
+	schema = testSchema();
+
+	// c grows with the insert order like a timestamp, b changes every 100
+	// records, so every page holds a narrow range of both
+	TEST_CHECK(initRecordManager(NULL));
+	TEST_CHECK(createTable("test_table_z", schema));
+	TEST_CHECK(openTable(table, "test_table_z"));
+	for(i = 0; i < numInserts; i++)
+	{
+		sprintf(b, "%04d", i / 100);
+		r = testRecord(schema, i, b, i);
+		TEST_CHECK(insertRecord(table, r));
+		freeRecord(r);
+	}
+	found = countPagesScan(table, NULL, &pages, &skipped);
+	ASSERT_EQUALS_INT(numInserts, found, "all records without a condition");
+	ASSERT_EQUALS_INT(0, skipped, "no page is skipped without a condition");
+	ASSERT_TRUE(pages > 20, "records span many pages");
+
+	sel = rangeExpr(2, "i1000", "i1100");
+	found = countPagesScan(table, sel, &read, &skipped);
+	ASSERT_EQUALS_INT(100, found, "c in [1000, 1100)");
+	ASSERT_TRUE(read <= 3, "c in [1000, 1100) reads a few pages");
+	ASSERT_EQUALS_INT(pages, read + skipped, "the other pages are skipped");
+	found = countScan(table, sel, &path, &bad);
+	ASSERT_EQUALS_INT(RM_ACCESS_HEAP, path, "c has no index");
+	ASSERT_EQUALS_INT(0, bad, "matching records sorted by RID");
+
+	// the workers of a parallel scan skip the same pages
+	memset(counts, 0, sizeof(counts));
+	TEST_CHECK(parallelScan(table, sel, NUM_SCAN_WORKERS, countRecord, counts));
+	for(i = 0, total = 0; i < NUM_SCAN_WORKERS; i++)
+		total += counts[i];
+	ASSERT_EQUALS_INT(100, total, "parallel scan of c in [1000, 1100)");
+	freeExpr(sel);
+
+	sel = equalsExpr(1, "s0042");
+	found = countPagesScan(table, sel, &read, &skipped);
+	ASSERT_EQUALS_INT(100, found, "b = '0042'");
+	ASSERT_TRUE(read <= 3, "b = '0042' reads a few pages");
+	freeExpr(sel);
+
+	// emptied pages are skipped by every scan, an update widens its zone
+	TEST_CHECK(createRecord(&r, schema));
+	for(i = 0; i < 1000; i++)
+	{
+		MAKE_VALUE(value, DT_INT, i);
+		TEST_CHECK(getRecordByKey(table, &value, r));
+		freeVal(value);
+		TEST_CHECK(deleteRecord(table, r->id));
+	}
+	MAKE_VALUE(value, DT_INT, 2500);
+	TEST_CHECK(getRecordByKey(table, &value, r));
+	freeVal(value);
+	value = stringToValue("i999999");
+	TEST_CHECK(setAttr(r, schema, 2, value));
+	freeVal(value);
+	TEST_CHECK(updateRecord(table, r));
+	freeRecord(r);
+	found = countPagesScan(table, NULL, &read, &skipped);
+	ASSERT_EQUALS_INT(numInserts - 1000, found, "all records after the deletes");
+	ASSERT_TRUE(skipped >= 7, "emptied pages are skipped");
+	sel = equalsExpr(2, "i999999");
+	found = countPagesScan(table, sel, &read, &skipped);
+	ASSERT_EQUALS_INT(1, found, "updated record is found");
+	ASSERT_TRUE(read <= 2, "c = 999999 reads the page of the update");
+	freeExpr(sel);
+
+	// the zone maps are stored when the table is closed and rebuilt from the
+	// records when their file is missing
+	sel = rangeExpr(2, "i3000", "i3100");
+	TEST_CHECK(closeTable(table));
+	ASSERT_TRUE(access("test_table_z.zone", F_OK) == 0, "zone map file exists");
+	TEST_CHECK(openTable(table, "test_table_z"));
+	found = countPagesScan(table, sel, &read, &skipped);
+	ASSERT_EQUALS_INT(100, found, "c in [3000, 3100) after reopening");
+	ASSERT_TRUE(read <= 3, "stored zone maps are used");
+	TEST_CHECK(closeTable(table));
+	ASSERT_TRUE(unlink("test_table_z.zone") == 0, "zone map file is removed");
+	TEST_CHECK(openTable(table, "test_table_z"));
+	found = countPagesScan(table, sel, &read, &skipped);
+	ASSERT_EQUALS_INT(100, found, "c in [3000, 3100) after rebuilding");
+	ASSERT_TRUE(read <= 3, "rebuilt zone maps are used");
+	freeExpr(sel);
+
+	TEST_CHECK(closeTable(table));
+	TEST_CHECK(deleteTable("test_table_z"));
+	ASSERT_TRUE(access("test_table_z.zone", F_OK) != 0, "zone map file is deleted");
+
+	// pages holding only -0.0 or only 0.0 match both zeros, in the zones built
+	// by the inserts and in the stored ones
+	freeSchema(schema);
+	schema = floatSchema();
+	TEST_CHECK(createTable("test_table_z", schema));
+	TEST_CHECK(openTable(table, "test_table_z"));
+	for(i = 0; i < numInserts; i++)
+	{
+		r = floatRecord(schema, i, i < 1000 ? -0.0f : i < 2000 ? 0.0f : (float) i);
+		TEST_CHECK(insertRecord(table, r));
+		freeRecord(r);
+	}
+	for(i = 0; i < 2; i++)
+	{
+		sel = equalsExpr(1, "f0.0");
+		found = countPagesScan(table, sel, &read, &skipped);
+		ASSERT_EQUALS_INT(2000, found, "f = 0.0 matches -0.0 and 0.0");
+		ASSERT_TRUE(skipped > 0, "f = 0.0 skips the pages of other values");
+		freeExpr(sel);
+		sel = equalsExpr(1, "f-0.0");
+		found = countPagesScan(table, sel, &read, &skipped);
+		ASSERT_EQUALS_INT(2000, found, "f = -0.0 matches -0.0 and 0.0");
+		freeExpr(sel);
+		sel = rangeExpr(1, "f0.0", "f1.0");
+		found = countPagesScan(table, sel, &read, &skipped);
+		ASSERT_EQUALS_INT(2000, found, "f in [0.0, 1.0) holds both zeros");
+		freeExpr(sel);
+		TEST_CHECK(closeTable(table));
+		TEST_CHECK(openTable(table, "test_table_z"));
+	}
+	TEST_CHECK(closeTable(table));
+	TEST_CHECK(deleteTable("test_table_z"));
+	TEST_CHECK(shutdownRecordManager());
+
+	freeSchema(schema);
+	free(table);
+	TEST_DONE();
+}
+
 void 
 testUpdateTable (void)
 {
@@ -698,3 +2614,162 @@ testRecord(Schema *schema, int a, char *b, int c)
 
 	return result;
 }
+
+// change the key attribute a of a test record
+void
+setKey (Record *record, Schema *schema, int a)
+{
+	Value *value;
+	MAKE_VALUE(value, DT_INT, a);
+	TEST_CHECK(setAttr(record, schema, 0, value));
+	freeVal(value);
+}
+
+// a table with the key a and a FLOAT f
+Schema *
+floatSchema (void)
+{
+	char *names[] = { "a", "f" };
+	DataType dt[] = { DT_INT, DT_FLOAT };
+	char **cpNames = (char **) malloc(sizeof(char*) * 2);
+	DataType *cpDt = (DataType *) malloc(sizeof(DataType) * 2);
+	int *cpSizes = (int *) calloc(2, sizeof(int));
+	int *cpKeys = (int *) calloc(1, sizeof(int));
+	int i;
+
+	for(i = 0; i < 2; i++)
+	{
+		cpNames[i] = (char *) malloc(2);
+		strcpy(cpNames[i], names[i]);
+	}
+	memcpy(cpDt, dt, sizeof(DataType) * 2);
+	return createSchema(2, cpNames, cpDt, cpSizes, 1, cpKeys);
+}
+
+Record *
+floatRecord (Schema *schema, int a, float f)
+{
+	Record *result;
+	Value *value;
+
+	TEST_CHECK(createRecord(&result, schema));
+	setKey(result, schema, a);
+	MAKE_VALUE(value, DT_FLOAT, f);
+	TEST_CHECK(setAttr(result, schema, 1, value));
+	freeVal(value);
+	return result;
+}
+
+// the condition attribute = value, the value is given as for stringToValue
+Expr *
+equalsExpr (int attrNum, char *value)
+{
+	Expr *attr, *cons, *result;
+	MAKE_ATTRREF(attr, attrNum);
+	MAKE_CONS(cons, stringToValue(value));
+	MAKE_BINOP_EXPR(result, attr, cons, OP_COMP_EQUAL);
+	return result;
+}
+
+// the condition low <= attribute < high, the values are given as for stringToValue
+Expr *
+rangeExpr (int attrNum, char *low, char *high)
+{
+	Expr *attr, *cons, *lower, *upper, *result;
+	MAKE_ATTRREF(attr, attrNum);
+	MAKE_CONS(cons, stringToValue(low));
+	MAKE_BINOP_EXPR(lower, attr, cons, OP_COMP_GREATER_EQUAL);
+	MAKE_ATTRREF(attr, attrNum);
+	MAKE_CONS(cons, stringToValue(high));
+	MAKE_BINOP_EXPR(upper, attr, cons, OP_COMP_SMALLER);
+	MAKE_BINOP_EXPR(result, lower, upper, OP_BOOL_AND);
+	return result;
+}
+
+// count the records a heap scan returns and the data pages it read and skipped
+int
+countPagesScan (RM_TableData *table, Expr *cond, int *pagesRead, int *pagesSkipped)
+{
+	RM_ScanHandle sc;
+	Record *r;
+	int found = 0;
+
+	TEST_CHECK(createRecord(&r, table->schema));
+	TEST_CHECK(startScan(table, &sc, cond));
+	while(next(&sc, r) == RC_OK)
+		found++;
+	TEST_CHECK(getScanPageCounts(&sc, pagesRead, pagesSkipped));
+	TEST_CHECK(closeScan(&sc));
+	freeRecord(r);
+	return found;
+}
+
+// count the records a scan returns and report its access path, bad counts
+// records out of RID order and records the condition does not match
+int
+countScan (RM_TableData *table, Expr *cond, RM_AccessPath *path, int *bad)
+{
+	RM_ScanHandle sc;
+	Record *r;
+	RID last = { -1, -1 };
+	int found = 0;
+
+	*bad = 0;
+	TEST_CHECK(createRecord(&r, table->schema));
+	TEST_CHECK(startScan(table, &sc, cond));
+	TEST_CHECK(getScanAccessPath(&sc, path));
+	while(next(&sc, r) == RC_OK)
+	{
+		if(r->id.page < last.page || (r->id.page == last.page && r->id.slot <= last.slot))
+			(*bad)++;
+		if(cond != NULL)
+		{
+			Value *match;
+			evalExpr(r, table->schema, cond, &match);
+			*bad += !match->v.boolV;
+			freeVal(match);
+		}
+		last = r->id;
+		found++;
+	}
+	TEST_CHECK(closeScan(&sc));
+	freeRecord(r);
+	return found;
+}
+
+// count the records a projected scan returns and sum their attribute c. an
+// index-only scan has to return the records in key order and must not decode
+// attribute b
+int
+countProjectedScan (RM_TableData *table, Expr *cond, int numAttrs, int *attrs,
+		RM_AccessPath *path, int *sum)
+{
+	RM_ScanHandle sc;
+	Record *r;
+	Value *value;
+	char empty[4] = {0};
+	int found = 0, last = -1, bOffset;
+
+	*sum = 0;
+	attrOffset(table->schema, 1, &bOffset);
+	TEST_CHECK(createRecord(&r, table->schema));
+	TEST_CHECK(startProjectedScan(table, &sc, cond, numAttrs, attrs));
+	TEST_CHECK(getScanAccessPath(&sc, path));
+	while(next(&sc, r) == RC_OK)
+	{
+		getAttr(r, table->schema, 0, &value);
+		if(*path == RM_ACCESS_INDEX_ONLY && (value->v.intV <= last
+				|| memcmp(r->data + bOffset, empty, 4) != 0))
+			ASSERT_TRUE(false, "index-only record in key order without b");
+		last = value->v.intV;
+		freeVal(value);
+		getAttr(r, table->schema, 2, &value);
+		*sum += value->v.intV;
+		freeVal(value);
+		memset(r->data, 0, getRecordSize(table->schema));
+		found++;
+	}
+	TEST_CHECK(closeScan(&sc));
+	freeRecord(r);
+	return found;
+}
@@ -0,0 +1,1112 @@
+#include <limits.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "dberror.h"
+
+#include "btree_mgr.h"
+#include "expr.h"
+#include "tables.h"
+#include "test_helper.h"
+#include "rm_serializer.h"
+
+// test methods
+static void testInsertAndFind (void);
+static void testDelete (void);
+static void testIndexScan (void);
+static void testRangeScan (void);
+static void testKeyEncoding (void);
+static void testStringKeys (void);
+static void testKeyCompression (void);
+static void testBulkLoad (void);
+static void testPayload (void);
+static void testConcurrentAccess (void);
+
+// helper methods
+static int *createPermutation (int size);
+static RID keyRID (int key);
+static int fewestNodeKeys (BTreeHandle *tree, int *rootKeys);
+static void mixedKey (int i, char *out);
+static int compareMixedKeys (const void *a, const void *b);
+static void *insertAndDeleteKeys (void *arg);
+static void *readKeys (void *arg);
+static void *deleteKeys (void *arg);
+
+// a thread of testConcurrentAccess, threads count their errors instead of
+// failing the test
+typedef struct TreeWorker {
+	BTreeHandle *tree;
+	int id;
+	int numKeys;
+	int *done;
+	int errors;
+	int rounds;
+} TreeWorker;
+
+#define NUM_TREE_WRITERS 3
+#define NUM_TREE_READERS 2
+
+// test name
+char *testName;
+
+// main method
+int
+main (void)
+{
+	testName = "";
+	initIndexManager(NULL);
+
+	testInsertAndFind();
+	testDelete();
+	testIndexScan();
+	testRangeScan();
+	testKeyEncoding();
+	testStringKeys();
+	testKeyCompression();
+	testBulkLoad();
+	testPayload();
+	testConcurrentAccess();
+
+	shutdownIndexManager();
+	return 0;
+}
+
+// ************************************************************
+void
+testInsertAndFind (void)
+{
+	int numKeys = 1000, n, i;
+	int *perm = createPermutation(numKeys);
+	BTreeHandle *tree;
+	DataType keyType;
+	Value *key;
+	RID rid;
+	testName = "test b-tree inserting and search";
+
+	for(n = 2; n <= 16; n *= 2)
+	{
+		TEST_CHECK(createBtree("testidx", DT_INT, n));
+		TEST_CHECK(openBtree(&tree, "testidx"));
+		TEST_CHECK(getKeyType(tree, &keyType));
+		ASSERT_EQUALS_INT(DT_INT, keyType, "key type");
+
+		for(i = 0; i < numKeys; i++)
+		{
+			MAKE_VALUE(key, DT_INT, perm[i]);
+			TEST_CHECK(insertKey(tree, key, keyRID(perm[i])));
+			freeVal(key);
+		}
+
+		// existing keys are rejected
+		MAKE_VALUE(key, DT_INT, perm[0]);
+		ASSERT_EQUALS_INT(RC_IM_KEY_ALREADY_EXISTS, insertKey(tree, key, keyRID(0)),
+				"duplicate key is rejected");
+		freeVal(key);
+
+		TEST_CHECK(getNumEntries(tree, &i));
+		ASSERT_EQUALS_INT(numKeys, i, "number of entries");
+
+		// the index survives closing and opening it again
+		TEST_CHECK(closeBtree(tree));
+		TEST_CHECK(openBtree(&tree, "testidx"));
+
+		for(i = 0; i < numKeys; i++)
+		{
+			MAKE_VALUE(key, DT_INT, i);
+			TEST_CHECK(findKey(tree, key, &rid));
+			freeVal(key);
+			if(rid.page != keyRID(i).page || rid.slot != keyRID(i).slot)
+				ASSERT_TRUE(false, "found the rid of each key");
+		}
+		ASSERT_TRUE(true, "found the rid of each key");
+
+		MAKE_VALUE(key, DT_INT, numKeys);
+		ASSERT_EQUALS_INT(RC_IM_KEY_NOT_FOUND, findKey(tree, key, &rid), "missing key");
+		freeVal(key);
+		MAKE_VALUE(key, DT_INT, -1);
+		ASSERT_EQUALS_INT(RC_IM_KEY_NOT_FOUND, findKey(tree, key, &rid), "missing key");
+		freeVal(key);
+
+		TEST_CHECK(getTreeHeight(tree, &i));
+		ASSERT_TRUE(i > 1, "the tree has grown");
+		TEST_CHECK(closeBtree(tree));
+		TEST_CHECK(deleteBtree("testidx"));
+	}
+
+	// nodes that do not fit into a page
+	ASSERT_EQUALS_INT(RC_IM_N_TO_LAGE, createBtree("testidx", DT_INT, PAGE_SIZE), "n too large");
+
+	free(perm);
+	TEST_DONE();
+}
+
+// ************************************************************
+void
+testDelete (void)
+{
+	int numKeys = 1000, n, i, numNodes;
+	int *perm = createPermutation(numKeys);
+	BTreeHandle *tree;
+	Value *key;
+	RID rid;
+	testName = "test b-tree deleting keys";
+
+	for(n = 2; n <= 16; n *= 2)
+	{
+		TEST_CHECK(createBtree("testidx", DT_INT, n));
+		TEST_CHECK(openBtree(&tree, "testidx"));
+		for(i = 0; i < numKeys; i++)
+		{
+			MAKE_VALUE(key, DT_INT, perm[i]);
+			TEST_CHECK(insertKey(tree, key, keyRID(perm[i])));
+			freeVal(key);
+		}
+
+		// delete the odd keys in random order
+		for(i = 0; i < numKeys; i++)
+		{
+			if(perm[i] % 2 == 0)
+				continue;
+			MAKE_VALUE(key, DT_INT, perm[i]);
+			TEST_CHECK(deleteKey(tree, key));
+			if(deleteKey(tree, key) != RC_IM_KEY_NOT_FOUND)
+				ASSERT_TRUE(false, "deleted key is gone");
+			freeVal(key);
+		}
+		ASSERT_TRUE(true, "deleted key is gone");
+		TEST_CHECK(getNumEntries(tree, &i));
+		ASSERT_EQUALS_INT(numKeys / 2, i, "number of entries");
+
+		for(i = 0; i < numKeys; i++)
+		{
+			RC rc;
+			MAKE_VALUE(key, DT_INT, i);
+			rc = findKey(tree, key, &rid);
+			freeVal(key);
+			if((i % 2 == 0 && (rc != RC_OK || rid.page != keyRID(i).page))
+					|| (i % 2 == 1 && rc != RC_IM_KEY_NOT_FOUND))
+				ASSERT_TRUE(false, "only even keys are left");
+		}
+		ASSERT_TRUE(true, "only even keys are left");
+
+		// deleting everything shrinks the tree to a single leaf again
+		for(i = 0; i < numKeys; i += 2)
+		{
+			MAKE_VALUE(key, DT_INT, i);
+			TEST_CHECK(deleteKey(tree, key));
+			freeVal(key);
+		}
+		TEST_CHECK(getNumNodes(tree, &numNodes));
+		ASSERT_EQUALS_INT(1, numNodes, "single node");
+		TEST_CHECK(getTreeHeight(tree, &i));
+		ASSERT_EQUALS_INT(1, i, "single level");
+
+		// freed pages are reused
+		for(i = 0; i < numKeys; i++)
+		{
+			MAKE_VALUE(key, DT_INT, perm[i]);
+			TEST_CHECK(insertKey(tree, key, keyRID(perm[i])));
+			freeVal(key);
+		}
+		TEST_CHECK(getNumEntries(tree, &i));
+		ASSERT_EQUALS_INT(numKeys, i, "number of entries");
+
+		TEST_CHECK(closeBtree(tree));
+		TEST_CHECK(deleteBtree("testidx"));
+	}
+
+	free(perm);
+	TEST_DONE();
+}
+
+// ************************************************************
+void
+testIndexScan (void)
+{
+	int numKeys = 500, count, i;
+	int *perm = createPermutation(numKeys);
+	BT_ScanHandle *scan;
+	BTreeHandle *tree;
+	Value *key;
+	RID rid;
+	RC rc;
+	testName = "test b-tree scan";
+
+	TEST_CHECK(createBtree("testidx", DT_INT, 4));
+	TEST_CHECK(openBtree(&tree, "testidx"));
+
+	// an empty tree
+	TEST_CHECK(openTreeScan(tree, &scan));
+	ASSERT_EQUALS_INT(RC_IM_NO_MORE_ENTRIES, nextEntry(scan, &rid), "no entries");
+	TEST_CHECK(closeTreeScan(scan));
+
+	for(i = 0; i < numKeys; i++)
+	{
+		MAKE_VALUE(key, DT_INT, perm[i] - numKeys / 2);
+		TEST_CHECK(insertKey(tree, key, keyRID(perm[i])));
+		freeVal(key);
+	}
+
+	// entries come in key order, negative keys first
+	TEST_CHECK(openTreeScan(tree, &scan));
+	for(count = 0; (rc = nextEntry(scan, &rid)) == RC_OK; count++)
+	{
+		if(rid.page != keyRID(count).page || rid.slot != keyRID(count).slot)
+			ASSERT_TRUE(false, "sorted scan");
+	}
+	ASSERT_EQUALS_INT(RC_IM_NO_MORE_ENTRIES, rc, "end of scan");
+	ASSERT_EQUALS_INT(numKeys, count, "scanned all entries");
+	TEST_CHECK(closeTreeScan(scan));
+
+	TEST_CHECK(closeBtree(tree));
+	TEST_CHECK(deleteBtree("testidx"));
+	free(perm);
+	TEST_DONE();
+}
+
+// ************************************************************
+void
+testRangeScan (void)
+{
+	int numKeys = 1000, count, i;
+	int *perm = createPermutation(numKeys);
+	BT_ScanHandle *scan;
+	BTreeHandle *tree;
+	Value *key, *low, *high;
+	RID rid;
+	testName = "test b-tree range scan";
+
+	TEST_CHECK(createBtree("testidx", DT_INT, 0));
+	TEST_CHECK(openBtree(&tree, "testidx"));
+	for(i = 0; i < numKeys; i++)
+	{
+		// only multiples of 3
+		MAKE_VALUE(key, DT_INT, perm[i] * 3);
+		TEST_CHECK(insertKey(tree, key, keyRID(perm[i])));
+		freeVal(key);
+	}
+
+	// bounds are inclusive and do not have to exist
+	MAKE_VALUE(low, DT_INT, 299);
+	MAKE_VALUE(high, DT_INT, 600);
+	TEST_CHECK(openTreeRangeScan(tree, low, high, &scan));
+	for(count = 0; nextEntry(scan, &rid) == RC_OK; count++)
+		ASSERT_EQUALS_INT(100 + count, rid.slot, "key in range");
+	ASSERT_EQUALS_INT(101, count, "entries in range");
+	TEST_CHECK(closeTreeScan(scan));
+	freeVal(low);
+	freeVal(high);
+
+	// open ends
+	MAKE_VALUE(low, DT_INT, 2990);
+	TEST_CHECK(openTreeRangeScan(tree, low, NULL, &scan));
+	for(count = 0; nextEntry(scan, &rid) == RC_OK; count++);
+	ASSERT_EQUALS_INT(3, count, "entries above the low bound");
+	TEST_CHECK(closeTreeScan(scan));
+	freeVal(low);
+
+	MAKE_VALUE(high, DT_INT, -1);
+	TEST_CHECK(openTreeRangeScan(tree, NULL, high, &scan));
+	ASSERT_EQUALS_INT(RC_IM_NO_MORE_ENTRIES, nextEntry(scan, &rid), "nothing below 0");
+	TEST_CHECK(closeTreeScan(scan));
+	freeVal(high);
+
+	TEST_CHECK(closeBtree(tree));
+	TEST_CHECK(deleteBtree("testidx"));
+	free(perm);
+	TEST_DONE();
+}
+
+// ************************************************************
+void
+testKeyEncoding (void)
+{
+	char *values[] = { "l-9000000000", "l-1", "l0", "l1", "l9000000000",
+			"d-1e300", "d-2.5", "d-0.5", "d0", "d0.25", "d3.5", "d1e300",
+			"f-3.5", "f-0.25", "f0", "f0.5", "f7",
+			"i-100000", "i-1", "i0", "i1", "i100000" };
+	int numValues = sizeof(values) / sizeof(values[0]);
+	char previous[8], current[8];
+	Value *value, *decoded;
+	BTreeHandle *tree;
+	RID rid;
+	int i;
+	testName = "test order preserving key encoding";
+
+	// each group is sorted, so the encoded keys have to be increasing
+	for(i = 0; i < numValues; i++)
+	{
+		value = stringToValue(values[i]);
+		int length = keyLength(value->dt, 0);
+		TEST_CHECK(encodeKey(value->dt, length, value, current));
+		if(i > 0 && values[i][0] == values[i - 1][0])
+			ASSERT_TRUE(memcmp(previous, current, length) < 0, values[i]);
+
+		TEST_CHECK(decodeKey(value->dt, length, current, &decoded));
+		char *expected = serializeValue(value), *real = serializeValue(decoded);
+		ASSERT_EQUALS_STRING(expected, real, "decoded key");
+		free(expected);
+		free(real);
+		freeVal(decoded);
+		freeVal(value);
+		memcpy(previous, current, sizeof(current));
+	}
+
+	// -0.0 and 0.0 are equal, so they are one key
+	MAKE_VALUE(value, DT_FLOAT, -0.0f);
+	TEST_CHECK(encodeKey(DT_FLOAT, 4, value, previous));
+	value->v.floatV = 0.0f;
+	TEST_CHECK(encodeKey(DT_FLOAT, 4, value, current));
+	ASSERT_TRUE(memcmp(previous, current, 4) == 0, "float -0.0 is 0.0");
+	freeVal(value);
+	MAKE_VALUE(value, DT_DOUBLE, -0.0);
+	TEST_CHECK(encodeKey(DT_DOUBLE, 8, value, previous));
+	value->v.doubleV = 0.0;
+	TEST_CHECK(encodeKey(DT_DOUBLE, 8, value, current));
+	ASSERT_TRUE(memcmp(previous, current, 8) == 0, "double -0.0 is 0.0");
+	freeVal(value);
+
+	// a key inserted as -0.0 is found as 0.0
+	TEST_CHECK(createBtree("testidx", DT_FLOAT, 0));
+	TEST_CHECK(openBtree(&tree, "testidx"));
+	MAKE_VALUE(value, DT_FLOAT, -0.0f);
+	TEST_CHECK(insertKey(tree, value, keyRID(7)));
+	value->v.floatV = 0.0f;
+	TEST_CHECK(findKey(tree, value, &rid));
+	ASSERT_EQUALS_INT(7, rid.slot, "-0.0 found as 0.0");
+	ASSERT_EQUALS_INT(RC_IM_KEY_ALREADY_EXISTS, insertKey(tree, value, keyRID(8)), "0.0 is taken by -0.0");
+	freeVal(value);
+	TEST_CHECK(closeBtree(tree));
+	TEST_CHECK(deleteBtree("testidx"));
+
+	// NaNs are one key behind infinity
+	MAKE_VALUE(value, DT_DOUBLE, -(0.0 / 0.0));
+	TEST_CHECK(encodeKey(DT_DOUBLE, 8, value, previous));
+	value->v.doubleV = 0.0 / 0.0;
+	TEST_CHECK(encodeKey(DT_DOUBLE, 8, value, current));
+	ASSERT_TRUE(memcmp(previous, current, 8) == 0, "one NaN key");
+	value->v.doubleV = 1.0 / 0.0;
+	TEST_CHECK(encodeKey(DT_DOUBLE, 8, value, previous));
+	ASSERT_TRUE(memcmp(previous, current, 8) < 0, "NaN after infinity");
+	freeVal(value);
+
+	// keys must have the type of the index
+	value = stringToValue("i1");
+	ASSERT_ERROR(encodeKey(DT_LONG, 8, value, current), "type mismatch");
+	freeVal(value);
+
+	TEST_DONE();
+}
+
+// ************************************************************
+void
+testStringKeys (void)
+{
+	char *names[] = { "carol", "alice", "bob", "", "alicia", "al", "zed", "bobby" };
+	char *sorted[] = { "", "al", "alice", "alicia", "bob", "bobby", "carol", "zed" };
+	int numNames = sizeof(names) / sizeof(names[0]), i;
+	BT_ScanHandle *scan;
+	BTreeHandle *tree;
+	Value *key;
+	RID rid;
+	testName = "test b-tree with string keys";
+
+	ASSERT_ERROR(createBtree("testidx", DT_STRING, 0), "strings need a length");
+	TEST_CHECK(createBtreeWithLength("testidx", DT_STRING, 8, 2));
+	TEST_CHECK(openBtree(&tree, "testidx"));
+	for(i = 0; i < numNames; i++)
+	{
+		MAKE_STRING_VALUE(key, names[i]);
+		TEST_CHECK(insertKey(tree, key, keyRID(i)));
+		freeVal(key);
+	}
+	MAKE_STRING_VALUE(key, "too long for the key");
+	ASSERT_ERROR(insertKey(tree, key, keyRID(0)), "key longer than the index");
+	freeVal(key);
+
+	// a prefix sorts before its extensions
+	TEST_CHECK(openTreeScan(tree, &scan));
+	for(i = 0; nextEntry(scan, &rid) == RC_OK; i++)
+		ASSERT_EQUALS_STRING(sorted[i], names[rid.slot], "string order");
+	ASSERT_EQUALS_INT(numNames, i, "scanned all keys");
+	TEST_CHECK(closeTreeScan(scan));
+
+	char *printed = printTree(tree);
+	ASSERT_TRUE(strstr(printed, "alicia") != NULL, "tree is printed");
+	free(printed);
+
+	TEST_CHECK(closeBtree(tree));
+	TEST_CHECK(deleteBtree("testidx"));
+	TEST_DONE();
+}
+
+// ************************************************************
+void
+testKeyCompression (void)
+{
+	int numKeys = 20000, numMixed = 3000, length = 200, i, bad, height, nodes, deleted;
+	int *perm = createPermutation(numKeys), *order = createPermutation(numMixed);
+	char *mixed = (char *) calloc(numMixed, length), *sorted, name[32], found[200];
+	BT_LoadHandle *load;
+	BT_ScanHandle *scan;
+	BTreeHandle *tree;
+	Value *key, *high;
+	RID rid;
+	testName = "test b-tree key compression";
+
+	// keys with a long common prefix need fewer nodes than full 32 byte keys
+	TEST_CHECK(createBtreeWithLength("testidx", DT_STRING, 32, 0));
+	TEST_CHECK(openBtree(&tree, "testidx"));
+	for(i = 0; i < numKeys; i++)
+	{
+		sprintf(name, "customer%06d", perm[i]);
+		MAKE_STRING_VALUE(key, name);
+		TEST_CHECK(insertKey(tree, key, keyRID(perm[i])));
+		freeVal(key);
+	}
+	TEST_CHECK(getNumNodes(tree, &nodes));
+	ASSERT_TRUE(nodes < numKeys / ((PAGE_SIZE - 20) / 40), "more keys per leaf than uncompressed");
+	TEST_CHECK(getTreeHeight(tree, &height));
+	ASSERT_EQUALS_INT(2, height, "tree height");
+
+	bad = 0;
+	for(i = 0; i < numKeys; i++)
+	{
+		sprintf(name, "customer%06d", i);
+		MAKE_STRING_VALUE(key, name);
+		bad += findKey(tree, key, &rid) != RC_OK || rid.slot != i;
+		freeVal(key);
+	}
+	if(bad)
+		ASSERT_TRUE(false, "found the rid of each key");
+	ASSERT_TRUE(true, "found the rid of each key");
+
+	// prefixes and extensions of stored keys are different keys
+	MAKE_STRING_VALUE(key, "customer");
+	ASSERT_EQUALS_INT(RC_IM_KEY_NOT_FOUND, findKey(tree, key, &rid), "prefix is missing");
+	freeVal(key);
+	MAKE_STRING_VALUE(key, "customer0010000");
+	ASSERT_EQUALS_INT(RC_IM_KEY_NOT_FOUND, findKey(tree, key, &rid), "extension is missing");
+	freeVal(key);
+	MAKE_STRING_VALUE(key, "customes");
+	ASSERT_EQUALS_INT(RC_IM_KEY_NOT_FOUND, findKey(tree, key, &rid), "larger key is missing");
+	freeVal(key);
+
+	// a range crossing leaves returns the keys in order
+	MAKE_STRING_VALUE(key, "customer001000");
+	MAKE_STRING_VALUE(high, "customer001999");
+	TEST_CHECK(openTreeRangeScan(tree, key, high, &scan));
+	bad = 0;
+	for(i = 0; nextEntry(scan, &rid) == RC_OK; i++)
+		bad += rid.slot != 1000 + i;
+	TEST_CHECK(closeTreeScan(scan));
+	freeVal(key);
+	freeVal(high);
+	if(bad || i != 1000)
+		ASSERT_TRUE(false, "range scan");
+	ASSERT_TRUE(true, "range scan");
+	TEST_CHECK(closeBtree(tree));
+	TEST_CHECK(deleteBtree("testidx"));
+
+	// a bulk loaded tree packs the same keys into fewer leaves
+	TEST_CHECK(createBtreeWithLength("testidx", DT_STRING, 32, 0));
+	TEST_CHECK(openBtree(&tree, "testidx"));
+	TEST_CHECK(startBulkLoad(tree, 100, 0, &load));
+	for(i = 0; i < numKeys; i++)
+	{
+		sprintf(name, "customer%06d", perm[i]);
+		MAKE_STRING_VALUE(key, name);
+		TEST_CHECK(bulkLoadKey(load, key, keyRID(perm[i])));
+		freeVal(key);
+	}
+	TEST_CHECK(finishBulkLoad(load));
+	ASSERT_TRUE(getNumNodes(tree, &i) == RC_OK && i < nodes, "loaded tree is smaller");
+	TEST_CHECK(getTreeHeight(tree, &height));
+	ASSERT_EQUALS_INT(2, height, "loaded tree height");
+	TEST_CHECK(closeBtree(tree));
+	TEST_CHECK(deleteBtree("testidx"));
+
+	// keys of every length without a common prefix, changing the layout of nodes
+	for(i = 0; i < numMixed; i++)
+		mixedKey(i, mixed + i * length);
+	sorted = (char *) malloc(numMixed * length);
+	memcpy(sorted, mixed, numMixed * length);
+	qsort(sorted, numMixed, length, compareMixedKeys);
+
+	TEST_CHECK(createBtreeWithLength("testidx", DT_STRING, length, 0));
+	TEST_CHECK(openBtree(&tree, "testidx"));
+	for(i = 0; i < numMixed; i++)
+		TEST_CHECK(insertEncodedKey(tree, mixed + order[i] * length, keyRID(order[i])));
+	deleted = 0;
+	for(i = 0; i < numMixed; i++)
+		if(order[i] % 3 != 0)
+		{
+			TEST_CHECK(deleteEncodedKey(tree, mixed + order[i] * length));
+			deleted++;
+		}
+	TEST_CHECK(getNumEntries(tree, &i));
+	ASSERT_EQUALS_INT(numMixed - deleted, i, "number of entries");
+
+	// the remaining keys come back complete and in order
+	TEST_CHECK(openTreeRangeScanEncoded(tree, NULL, NULL, &scan));
+	bad = 0;
+	for(i = 0; i < numMixed; i++)
+	{
+		char *expected = sorted + i * length;
+		int slot = atoi(expected + strspn(expected, "abcdefg"));
+		if(slot % 3 != 0)
+			continue;
+		if(nextEncodedEntry(scan, found, &rid, NULL) != RC_OK || rid.slot != slot
+				|| memcmp(found, expected, length) != 0)
+			bad++;
+	}
+	bad += nextEncodedEntry(scan, found, &rid, NULL) != RC_IM_NO_MORE_ENTRIES;
+	TEST_CHECK(closeTreeScan(scan));
+	if(bad)
+		ASSERT_TRUE(false, "scan of mixed keys");
+	ASSERT_TRUE(true, "scan of mixed keys");
+
+	// deleting the rest shrinks the tree to its root
+	for(i = 0; i < numMixed; i += 3)
+		TEST_CHECK(deleteEncodedKey(tree, mixed + i * length));
+	TEST_CHECK(getNumNodes(tree, &i));
+	ASSERT_EQUALS_INT(1, i, "single node");
+	TEST_CHECK(closeBtree(tree));
+	TEST_CHECK(deleteBtree("testidx"));
+
+	free(sorted);
+	free(mixed);
+	free(order);
+	free(perm);
+	TEST_DONE();
+}
+
+// ************************************************************
+void
+testBulkLoad (void)
+{
+	int fills[] = { 100, 70, 50 };
+	int sortPages[] = { 0, 2 };
+	int numKeys = 5000, f, p, i, bad, numNodes, loadedNodes;
+	int *perm = createPermutation(numKeys);
+	BT_LoadHandle *load;
+	BT_ScanHandle *scan;
+	BTreeHandle *tree;
+	Value *key;
+	RID rid;
+	testName = "test bulk loading b-trees";
+
+	// the number of nodes when inserting one key after the other
+	TEST_CHECK(createBtree("testidx", DT_INT, 8));
+	TEST_CHECK(openBtree(&tree, "testidx"));
+	for(i = 0; i < numKeys; i++)
+	{
+		MAKE_VALUE(key, DT_INT, perm[i]);
+		TEST_CHECK(insertKey(tree, key, keyRID(perm[i])));
+		freeVal(key);
+	}
+	TEST_CHECK(getNumNodes(tree, &numNodes));
+
+	// a tree with entries cannot be loaded
+	ASSERT_ERROR(startBulkLoad(tree, 100, 0, &load), "tree is not empty");
+	TEST_CHECK(closeBtree(tree));
+	TEST_CHECK(deleteBtree("testidx"));
+
+	// in memory and with runs spilled to the sort file
+	for(f = 0; f < 3; f++)
+		for(p = 0; p < 2; p++)
+		{
+			TEST_CHECK(createBtree("testidx", DT_INT, 8));
+			TEST_CHECK(openBtree(&tree, "testidx"));
+			TEST_CHECK(startBulkLoad(tree, fills[f], sortPages[p], &load));
+			for(i = 0; i < numKeys; i++)
+			{
+				MAKE_VALUE(key, DT_INT, perm[i]);
+				TEST_CHECK(bulkLoadKey(load, key, keyRID(perm[i])));
+				freeVal(key);
+			}
+			if(sortPages[p] > 0)
+				ASSERT_TRUE(access("testidx.sort", F_OK) == 0, "runs are spilled");
+			TEST_CHECK(finishBulkLoad(load));
+			ASSERT_TRUE(access("testidx.sort", F_OK) != 0, "sort file is removed");
+
+			TEST_CHECK(getNumEntries(tree, &i));
+			ASSERT_EQUALS_INT(numKeys, i, "number of entries");
+			TEST_CHECK(getNumNodes(tree, &loadedNodes));
+			if(fills[f] == 100)
+				ASSERT_TRUE(loadedNodes < numNodes * 3 / 4, "full nodes");
+			else
+				ASSERT_TRUE(loadedNodes > numKeys / 8, "nodes keep free space");
+
+			// the keys come back in order
+			TEST_CHECK(openTreeScan(tree, &scan));
+			bad = 0;
+			for(i = 0; nextEntry(scan, &rid) == RC_OK; i++)
+				bad += rid.slot != i;
+			TEST_CHECK(closeTreeScan(scan));
+			if(bad || i != numKeys)
+				ASSERT_TRUE(false, "scan of the loaded tree");
+			ASSERT_TRUE(true, "scan of the loaded tree");
+
+			// the tree takes inserts and deletes after the load
+			for(i = numKeys; i < numKeys + 500; i++)
+			{
+				MAKE_VALUE(key, DT_INT, i);
+				TEST_CHECK(insertKey(tree, key, keyRID(i)));
+				freeVal(key);
+			}
+			for(i = 0; i < numKeys; i += 2)
+			{
+				MAKE_VALUE(key, DT_INT, i);
+				TEST_CHECK(deleteKey(tree, key));
+				freeVal(key);
+			}
+			TEST_CHECK(closeBtree(tree));
+			TEST_CHECK(openBtree(&tree, "testidx"));
+			bad = 0;
+			for(i = 0; i < numKeys + 500; i++)
+			{
+				RC rc;
+				MAKE_VALUE(key, DT_INT, i);
+				rc = findKey(tree, key, &rid);
+				freeVal(key);
+				if(i < numKeys && i % 2 == 0)
+					bad += rc != RC_IM_KEY_NOT_FOUND;
+				else
+					bad += rc != RC_OK || rid.slot != i;
+			}
+			if(bad)
+				ASSERT_TRUE(false, "lookups after changing the loaded tree");
+			ASSERT_TRUE(true, "lookups after changing the loaded tree");
+			TEST_CHECK(closeBtree(tree));
+			TEST_CHECK(deleteBtree("testidx"));
+		}
+
+	// the last nodes of a level share their entries, so none is left empty
+	// and a full load keeps every node below the root at least half full
+	bad = 0;
+	for(int n = 2; n <= 4; n++)
+		for(f = 0; f < 3; f++)
+			for(int count = 2; count <= 40; count++)
+			{
+				int rootKeys, fewest;
+				TEST_CHECK(createBtree("testidx", DT_INT, n));
+				TEST_CHECK(openBtree(&tree, "testidx"));
+				TEST_CHECK(startBulkLoad(tree, fills[f], 0, &load));
+				for(i = 0; i < count; i++)
+				{
+					MAKE_VALUE(key, DT_INT, i);
+					TEST_CHECK(bulkLoadKey(load, key, keyRID(i)));
+					freeVal(key);
+				}
+				TEST_CHECK(finishBulkLoad(load));
+				fewest = fewestNodeKeys(tree, &rootKeys);
+				bad += rootKeys < 1 || fewest < (fills[f] == 100 ? n / 2 : 1);
+				TEST_CHECK(closeBtree(tree));
+				TEST_CHECK(deleteBtree("testidx"));
+			}
+	ASSERT_EQUALS_INT(0, bad, "loaded nodes without enough keys");
+
+	// duplicates fail the load
+	TEST_CHECK(createBtree("testidx", DT_INT, 0));
+	TEST_CHECK(openBtree(&tree, "testidx"));
+	TEST_CHECK(startBulkLoad(tree, 100, 0, &load));
+	for(i = 0; i < 3; i++)
+	{
+		MAKE_VALUE(key, DT_INT, i % 2);
+		TEST_CHECK(bulkLoadKey(load, key, keyRID(i)));
+		freeVal(key);
+	}
+	ASSERT_TRUE(finishBulkLoad(load) == RC_IM_KEY_ALREADY_EXISTS, "duplicate key");
+	TEST_CHECK(closeBtree(tree));
+	TEST_CHECK(deleteBtree("testidx"));
+
+	free(perm);
+	TEST_DONE();
+}
+
+// ************************************************************
+void
+testPayload (void)
+{
+	int numKeys = 2000, i, bad, payload, length;
+	int *perm = createPermutation(numKeys);
+	char key[4], highKey[4];
+	BT_LoadHandle *load;
+	BT_ScanHandle *scan;
+	BTreeHandle *tree;
+	Value *value;
+	RID rid;
+	testName = "test b-tree entries with a payload";
+
+	// every key carries its square, splits and merges move the payload along
+	TEST_CHECK(createBtreeWithPayload("testidx", DT_INT, 4, sizeof(int), 8));
+	TEST_CHECK(openBtree(&tree, "testidx"));
+	TEST_CHECK(getPayloadLength(tree, &length));
+	ASSERT_EQUALS_INT((int) sizeof(int), length, "payload length");
+	for(i = 0; i < numKeys; i++)
+	{
+		MAKE_VALUE(value, DT_INT, perm[i]);
+		TEST_CHECK(encodeKey(DT_INT, 4, value, key));
+		payload = perm[i] * perm[i];
+		TEST_CHECK(insertEncodedEntry(tree, key, keyRID(perm[i]), (char *) &payload));
+		freeVal(value);
+	}
+	for(i = 0; i < numKeys; i += 3)
+	{
+		MAKE_VALUE(value, DT_INT, i);
+		TEST_CHECK(deleteKey(tree, value));
+		freeVal(value);
+	}
+	TEST_CHECK(closeBtree(tree));
+	TEST_CHECK(openBtree(&tree, "testidx"));
+
+	bad = 0;
+	for(i = 0; i < numKeys; i++)
+	{
+		RC rc;
+		MAKE_VALUE(value, DT_INT, i);
+		TEST_CHECK(encodeKey(DT_INT, 4, value, key));
+		freeVal(value);
+		payload = -1;
+		rc = findEncodedEntry(tree, key, &rid, (char *) &payload);
+		if(i % 3 == 0)
+			bad += rc != RC_IM_KEY_NOT_FOUND;
+		else
+			bad += rc != RC_OK || rid.slot != i || payload != i * i;
+	}
+	if(bad)
+		ASSERT_TRUE(false, "payload found with its key");
+	ASSERT_TRUE(true, "payload found with its key");
+
+	// a payload is changed in place
+	MAKE_VALUE(value, DT_INT, 5);
+	TEST_CHECK(encodeKey(DT_INT, 4, value, key));
+	freeVal(value);
+	payload = 42;
+	TEST_CHECK(updateEncodedPayload(tree, key, (char *) &payload));
+	payload = 0;
+	TEST_CHECK(findEncodedEntry(tree, key, &rid, (char *) &payload));
+	ASSERT_EQUALS_INT(42, payload, "updated payload");
+	ASSERT_EQUALS_INT(5, rid.slot, "rid is kept");
+
+	// scans return keys and payloads, plain inserts store zeros
+	MAKE_VALUE(value, DT_INT, numKeys);
+	TEST_CHECK(insertKey(tree, value, keyRID(numKeys)));
+	freeVal(value);
+	MAKE_VALUE(value, DT_INT, numKeys - 10);
+	TEST_CHECK(encodeKey(DT_INT, 4, value, key));
+	freeVal(value);
+	MAKE_VALUE(value, DT_INT, numKeys);
+	TEST_CHECK(encodeKey(DT_INT, 4, value, highKey));
+	freeVal(value);
+	TEST_CHECK(openTreeRangeScanEncoded(tree, key, highKey, &scan));
+	bad = 0;
+	for(i = 0; nextEncodedEntry(scan, key, &rid, (char *) &payload) == RC_OK; i++)
+	{
+		TEST_CHECK(decodeKey(DT_INT, 4, key, &value));
+		bad += value->v.intV != rid.slot;
+		bad += payload != (rid.slot == numKeys ? 0 : rid.slot * rid.slot);
+		freeVal(value);
+	}
+	TEST_CHECK(closeTreeScan(scan));
+	ASSERT_EQUALS_INT(8, i, "entries in range");
+	ASSERT_EQUALS_INT(0, bad, "keys and payloads of the scan");
+	TEST_CHECK(closeBtree(tree));
+	TEST_CHECK(deleteBtree("testidx"));
+
+	// bulk loaded entries keep their payload
+	TEST_CHECK(createBtreeWithPayload("testidx", DT_INT, 4, sizeof(int), 0));
+	TEST_CHECK(openBtree(&tree, "testidx"));
+	TEST_CHECK(startBulkLoad(tree, 100, 2, &load));
+	for(i = 0; i < numKeys; i++)
+	{
+		MAKE_VALUE(value, DT_INT, perm[i]);
+		TEST_CHECK(encodeKey(DT_INT, 4, value, key));
+		payload = -perm[i];
+		TEST_CHECK(bulkLoadEncodedEntry(load, key, keyRID(perm[i]), (char *) &payload));
+		freeVal(value);
+	}
+	TEST_CHECK(finishBulkLoad(load));
+	TEST_CHECK(openTreeScan(tree, &scan));
+	bad = 0;
+	for(i = 0; nextEncodedEntry(scan, NULL, &rid, (char *) &payload) == RC_OK; i++)
+		bad += rid.slot != i || payload != -i;
+	TEST_CHECK(closeTreeScan(scan));
+	ASSERT_EQUALS_INT(numKeys, i, "loaded entries");
+	ASSERT_EQUALS_INT(0, bad, "loaded payloads");
+	TEST_CHECK(closeBtree(tree));
+	TEST_CHECK(deleteBtree("testidx"));
+
+	// the payload counts against the entries of a page
+	ASSERT_EQUALS_INT(RC_IM_N_TO_LAGE, createBtreeWithPayload("testidx", DT_INT, 4, PAGE_SIZE, 0),
+			"payload too large");
+
+	free(perm);
+	TEST_DONE();
+}
+
+// ************************************************************
+// keys divisible by 4 are inserted up front and only read, the other keys
+// are inserted and half of them deleted again by one writer each. small
+// nodes make most inserts and deletes split, refill or merge nodes
+void
+testConcurrentAccess (void)
+{
+	TreeWorker workers[NUM_TREE_WRITERS + NUM_TREE_READERS];
+	pthread_t threads[NUM_TREE_WRITERS + NUM_TREE_READERS];
+	int numKeys = 20000, i, bad, last, done = 0, expected = 0;
+	BT_ScanHandle *scan;
+	BTreeHandle *tree;
+	Value *key;
+	RID rid;
+	testName = "test concurrent b-tree access";
+
+	TEST_CHECK(createBtree("testidx", DT_INT, 8));
+	TEST_CHECK(openBtree(&tree, "testidx"));
+	for(i = 0; i < numKeys; i += 4)
+	{
+		MAKE_VALUE(key, DT_INT, i);
+		TEST_CHECK(insertKey(tree, key, keyRID(i)));
+		freeVal(key);
+	}
+
+	for(i = 0; i < NUM_TREE_WRITERS + NUM_TREE_READERS; i++)
+	{
+		workers[i].tree = tree;
+		workers[i].id = i;
+		workers[i].numKeys = numKeys;
+		workers[i].done = &done;
+		workers[i].errors = 0;
+		workers[i].rounds = 0;
+		pthread_create(&threads[i], NULL, i < NUM_TREE_WRITERS ? insertAndDeleteKeys : readKeys,
+				&workers[i]);
+	}
+	for(i = 0; i < NUM_TREE_WRITERS; i++)
+		pthread_join(threads[i], NULL);
+	__atomic_store_n(&done, 1, __ATOMIC_RELEASE);
+	for(; i < NUM_TREE_WRITERS + NUM_TREE_READERS; i++)
+		pthread_join(threads[i], NULL);
+
+	bad = 0;
+	for(i = 0; i < NUM_TREE_WRITERS + NUM_TREE_READERS; i++)
+		bad += workers[i].errors;
+	if(bad)
+		ASSERT_TRUE(false, "threads saw what they expected");
+	ASSERT_TRUE(true, "threads saw what they expected");
+	ASSERT_TRUE(workers[NUM_TREE_WRITERS].rounds > 0, "readers ran along the writers");
+
+	// the keys of the writers with an odd half are left
+	bad = 0;
+	for(i = 0; i < numKeys; i++)
+	{
+		RC rc;
+		bool kept = i % 4 == 0 || (i / 4) % 2 == 1;
+		MAKE_VALUE(key, DT_INT, i);
+		rc = findKey(tree, key, &rid);
+		freeVal(key);
+		bad += kept ? rc != RC_OK || rid.slot != i : rc != RC_IM_KEY_NOT_FOUND;
+		expected += kept;
+	}
+	if(bad)
+		ASSERT_TRUE(false, "lookups after the threads finished");
+	ASSERT_TRUE(true, "lookups after the threads finished");
+	TEST_CHECK(getNumEntries(tree, &i));
+	ASSERT_EQUALS_INT(expected, i, "number of entries");
+
+	TEST_CHECK(openTreeScan(tree, &scan));
+	bad = 0;
+	last = -1;
+	for(i = 0; nextEntry(scan, &rid) == RC_OK; i++)
+	{
+		bad += rid.slot <= last;
+		last = rid.slot;
+	}
+	TEST_CHECK(closeTreeScan(scan));
+	ASSERT_EQUALS_INT(expected, i, "scan after the threads finished");
+	ASSERT_EQUALS_INT(0, bad, "scan in order");
+
+	// all threads delete at once until the root is left
+	for(i = 0; i < NUM_TREE_WRITERS + NUM_TREE_READERS; i++)
+		pthread_create(&threads[i], NULL, deleteKeys, &workers[i]);
+	for(i = 0; i < NUM_TREE_WRITERS + NUM_TREE_READERS; i++)
+		pthread_join(threads[i], NULL);
+	bad = 0;
+	for(i = 0; i < NUM_TREE_WRITERS + NUM_TREE_READERS; i++)
+		bad += workers[i].errors;
+	ASSERT_EQUALS_INT(0, bad, "concurrent deletes");
+	TEST_CHECK(getNumEntries(tree, &i));
+	ASSERT_EQUALS_INT(0, i, "no entries left");
+	TEST_CHECK(getNumNodes(tree, &i));
+	ASSERT_EQUALS_INT(1, i, "single node");
+
+	TEST_CHECK(closeBtree(tree));
+	TEST_CHECK(deleteBtree("testidx"));
+	TEST_DONE();
+}
+
+// ************************************************************
+int *
+createPermutation (int size)
+{
+	int *result = (int *) malloc(size * sizeof(int));
+	int i;
+
+	srand(42);
+	for(i = 0; i < size; i++)
+		result[i] = i;
+	for(i = size - 1; i > 0; i--)
+	{
+		int j = rand() % (i + 1), tmp = result[i];
+		result[i] = result[j];
+		result[j] = tmp;
+	}
+	return result;
+}
+
+RID
+keyRID (int key)
+{
+	RID result;
+	result.page = key / 10 + 2;
+	result.slot = key;
+	return result;
+}
+
+// the fewest keys of a node below the root, every key adds two commas to the
+// line printTree prints for its node
+int
+fewestNodeKeys (BTreeHandle *tree, int *rootKeys)
+{
+	char *printed = printTree(tree), *line = printed, *end;
+	int fewest = INT_MAX;
+
+	for(int i = 0; (end = strchr(line, '\n')) != NULL; i++, line = end + 1)
+	{
+		int commas = 0;
+		for(char *c = line; c < end; c++)
+			commas += *c == ',';
+		if(i == 0)
+			*rootKeys = commas / 2;
+		else if(commas / 2 < fewest)
+			fewest = commas / 2;
+	}
+	free(printed);
+	return fewest;
+}
+
+// a run of one letter of any length followed by the number of the key
+void
+mixedKey (int i, char *out)
+{
+	int run = i % 150;
+
+	memset(out, 'a' + i % 7, run);
+	sprintf(out + run, "%d", i);
+}
+
+int
+compareMixedKeys (const void *a, const void *b)
+{
+	return strcmp((const char *) a, (const char *) b);
+}
+
+// writer id inserts the keys k with k % 4 == id + 1 in random order, then
+// deletes those of them with an even k / 4
+void *
+insertAndDeleteKeys (void *arg)
+{
+	TreeWorker *worker = (TreeWorker *) arg;
+	int *perm = createPermutation(worker->numKeys);
+	Value *key;
+	int i;
+
+	for(i = 0; i < worker->numKeys; i++)
+		if(perm[i] % 4 == worker->id + 1)
+		{
+			MAKE_VALUE(key, DT_INT, perm[i]);
+			worker->errors += insertKey(worker->tree, key, keyRID(perm[i])) != RC_OK;
+			freeVal(key);
+		}
+	for(i = 0; i < worker->numKeys; i++)
+		if(perm[i] % 4 == worker->id + 1 && (perm[i] / 4) % 2 == 0)
+		{
+			MAKE_VALUE(key, DT_INT, perm[i]);
+			worker->errors += deleteKey(worker->tree, key) != RC_OK;
+			freeVal(key);
+		}
+	free(perm);
+	return NULL;
+}
+
+// readers find every key divisible by 4 and scan ranges in which they have
+// to appear in order, whatever the writers do around them
+void *
+readKeys (void *arg)
+{
+	TreeWorker *worker = (TreeWorker *) arg;
+	BT_ScanHandle *scan;
+	Value *low, *high;
+	RID rid;
+	int i, last, stable;
+
+	while(!__atomic_load_n(worker->done, __ATOMIC_ACQUIRE))
+	{
+		for(i = worker->id; i < worker->numKeys; i += 4 * 97)
+		{
+			int k = i - i % 4;
+			MAKE_VALUE(low, DT_INT, k);
+			if(findKey(worker->tree, low, &rid) != RC_OK || rid.slot != k)
+				worker->errors++;
+			freeVal(low);
+		}
+
+		int start = (worker->rounds * 1009) % worker->numKeys;
+		MAKE_VALUE(low, DT_INT, start);
+		MAKE_VALUE(high, DT_INT, start + 400);
+		if(openTreeRangeScan(worker->tree, low, high, &scan) != RC_OK)
+			worker->errors++;
+		else
+		{
+			last = start - 1;
+			stable = 0;
+			while(nextEntry(scan, &rid) == RC_OK)
+			{
+				worker->errors += rid.slot <= last || rid.slot > start + 400;
+				stable += rid.slot % 4 == 0;
+				last = rid.slot;
+			}
+			closeTreeScan(scan);
+			for(i = start; i <= start + 400 && i < worker->numKeys; i++)
+				stable -= i % 4 == 0;
+			worker->errors += stable != 0;
+		}
+		freeVal(low);
+		freeVal(high);
+		worker->rounds++;
+	}
+	return NULL;
+}
+
+// thread id deletes every key k with k % 5 == id that is still there
+void *
+deleteKeys (void *arg)
+{
+	TreeWorker *worker = (TreeWorker *) arg;
+	Value *key;
+	RC rc;
+
+	worker->errors = 0;
+	for(int k = worker->id; k < worker->numKeys; k += NUM_TREE_WRITERS + NUM_TREE_READERS)
+	{
+		MAKE_VALUE(key, DT_INT, k);
+		rc = deleteKey(worker->tree, key);
+		freeVal(key);
+		if(k % 4 == 0 || (k / 4) % 2 == 1)
+			worker->errors += rc != RC_OK;
+		else
+			worker->errors += rc != RC_IM_KEY_NOT_FOUND;
+	}
+	return NULL;
+}
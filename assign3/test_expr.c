@@ -33,6 +33,18 @@
 static void testValueSerialize (void);
 static void testOperators (void);
 static void testExpressions (void);
+static void testCompiledExpressions (void);
+static void testBatchExpressions (void);
+static void testOptimizeExpressions (void);
+static void testShortCircuit (void);
+static void testRangeOperators (void);
+static void testKeyRanges (void);
+static void testExprArena (void);
+static void testWideTypes (void);
+
+// helper methods
+static Schema *testSchema (void);
+static bool evalCompiled (Expr *expr, Schema *schema, Record *record);
 
 char *testName;
 
@@ -45,6 +57,14 @@ main (void)
 	testValueSerialize();
 	testOperators();
 	// testExpressions();
+	testCompiledExpressions();
+	testBatchExpressions();
+	testOptimizeExpressions();
+	testShortCircuit();
+	testRangeOperators();
+	testKeyRanges();
+	testExprArena();
+	testWideTypes();
 
 	return 0;
 }
@@ -127,3 +147,707 @@ testOperators (void)
 
 // 	TEST_DONE();
 // }
+
+// ************************************************************
+void
+testCompiledExpressions (void)
+{
+	Expr *a, *b, *cons, *op, *left, *right, *either;
+	Record *record;
+	Value *value, *res;
+	ExprProgram *program;
+	Schema *schema;
+	testName = "test compiled expressions";
+	schema = testSchema();
+
+	TEST_CHECK(createRecord(&record, schema));
+	MAKE_VALUE(value, DT_INT, 42);
+	TEST_CHECK(setAttr(record, schema, 0, value));
+	freeVal(value);
+	MAKE_STRING_VALUE(value, "cc");
+	TEST_CHECK(setAttr(record, schema, 1, value));
+	freeVal(value);
+
+	// comparisons on attributes
+	MAKE_ATTRREF(a, 0);
+	MAKE_CONS(cons, stringToValue("i42"));
+	MAKE_BINOP_EXPR(op, a, cons, OP_COMP_EQUAL);
+	ASSERT_TRUE(evalCompiled(op, schema, record), "a = 42");
+	freeExpr(op);
+
+	MAKE_ATTRREF(a, 0);
+	MAKE_CONS(cons, stringToValue("i100"));
+	MAKE_BINOP_EXPR(op, a, cons, OP_COMP_SMALLER);
+	ASSERT_TRUE(evalCompiled(op, schema, record), "a < 100");
+	freeExpr(op);
+
+	// strings shorter than the attribute compare like their copies
+	MAKE_ATTRREF(b, 1);
+	MAKE_CONS(cons, stringToValue("scc"));
+	MAKE_BINOP_EXPR(op, b, cons, OP_COMP_EQUAL);
+	ASSERT_TRUE(evalCompiled(op, schema, record), "b = cc");
+	freeExpr(op);
+
+	MAKE_ATTRREF(b, 1);
+	MAKE_CONS(cons, stringToValue("sccc"));
+	MAKE_BINOP_EXPR(op, b, cons, OP_COMP_SMALLER);
+	ASSERT_TRUE(evalCompiled(op, schema, record), "b < ccc");
+	freeExpr(op);
+
+	// (a < 10 OR NOT b = dd) AND b < cd agrees with the tree walk
+	MAKE_ATTRREF(a, 0);
+	MAKE_CONS(cons, stringToValue("i10"));
+	MAKE_BINOP_EXPR(left, a, cons, OP_COMP_SMALLER);
+	MAKE_ATTRREF(b, 1);
+	MAKE_CONS(cons, stringToValue("sdd"));
+	MAKE_BINOP_EXPR(right, b, cons, OP_COMP_EQUAL);
+	MAKE_UNOP_EXPR(op, right, OP_BOOL_NOT);
+	MAKE_BINOP_EXPR(either, left, op, OP_BOOL_OR);
+	MAKE_ATTRREF(b, 1);
+	MAKE_CONS(cons, stringToValue("scd"));
+	MAKE_BINOP_EXPR(right, b, cons, OP_COMP_SMALLER);
+	MAKE_BINOP_EXPR(op, either, right, OP_BOOL_AND);
+	TEST_CHECK(evalExpr(record, schema, op, &res));
+	ASSERT_TRUE(evalCompiled(op, schema, record) == res->v.boolV, "compiled and interpreted agree");
+	ASSERT_TRUE(res->v.boolV, "(a < 10 OR NOT b = dd) AND b < cd");
+	freeVal(res);
+	freeExpr(op);
+
+	// type errors are found when compiling
+	MAKE_ATTRREF(a, 0);
+	MAKE_CONS(cons, stringToValue("sx"));
+	MAKE_BINOP_EXPR(op, a, cons, OP_COMP_EQUAL);
+	ASSERT_EQUALS_INT(RC_RM_COMPARE_VALUE_OF_DIFFERENT_DATATYPE, compileExpr(op, schema, &program), "compare int to string");
+	freeExpr(op);
+
+	MAKE_ATTRREF(a, 0);
+	ASSERT_EQUALS_INT(RC_RM_EXPR_RESULT_IS_NOT_BOOLEAN, compileExpr(a, schema, &program), "result is not boolean");
+	freeExpr(a);
+
+	freeRecord(record);
+	freeSchema(schema);
+	TEST_DONE();
+}
+
+// ************************************************************
+void
+testBatchExpressions (void)
+{
+	Expr *a, *b, *cons, *op, *left, *right, *either;
+	Record records[150];
+	Value *value;
+	ExprProgram *program;
+	Schema *schema;
+	uint64_t selection[3];
+	int numRecords = 150, i;
+	char *strings[] = { "aa", "bb", "cc" };
+	testName = "test evaluating expressions on batches";
+	schema = testSchema();
+
+	for(i = 0; i < numRecords; i++)
+	{
+		records[i].data = (char *) calloc(getRecordSize(schema) + 1, sizeof(char));
+		MAKE_VALUE(value, DT_INT, i);
+		TEST_CHECK(setAttr(&records[i], schema, 0, value));
+		freeVal(value);
+		MAKE_STRING_VALUE(value, strings[i % 3]);
+		TEST_CHECK(setAttr(&records[i], schema, 1, value));
+		freeVal(value);
+	}
+
+	// (a < 100 OR a = 120) AND NOT b = bb, across several blocks
+	MAKE_ATTRREF(a, 0);
+	MAKE_CONS(cons, stringToValue("i100"));
+	MAKE_BINOP_EXPR(left, a, cons, OP_COMP_SMALLER);
+	MAKE_ATTRREF(a, 0);
+	MAKE_CONS(cons, stringToValue("i120"));
+	MAKE_BINOP_EXPR(right, a, cons, OP_COMP_EQUAL);
+	MAKE_BINOP_EXPR(either, left, right, OP_BOOL_OR);
+	MAKE_ATTRREF(b, 1);
+	MAKE_CONS(cons, stringToValue("sbb"));
+	MAKE_BINOP_EXPR(right, b, cons, OP_COMP_EQUAL);
+	MAKE_UNOP_EXPR(left, right, OP_BOOL_NOT);
+	MAKE_BINOP_EXPR(op, either, left, OP_BOOL_AND);
+
+	TEST_CHECK(compileExpr(op, schema, &program));
+	TEST_CHECK(evalExprProgramBatch(program, records, numRecords, selection));
+	for(i = 0; i < numRecords; i++)
+	{
+		bool selected = (selection[i / EXPR_BLOCK_SIZE] >> (i % EXPR_BLOCK_SIZE)) & 1;
+		bool expected = (i < 100 || i == 120) && i % 3 != 1;
+		if (selected != expected)
+			break;
+	}
+	ASSERT_EQUALS_INT(numRecords, i, "batch selection matches");
+	ASSERT_TRUE(evalCompiled(op, schema, &records[120]), "scalar result of a = 120");
+
+	// the bits after the last record stay clear
+	TEST_CHECK(evalExprProgramBatch(program, records, 70, selection));
+	ASSERT_TRUE((selection[1] >> 6) == 0, "selection ends with the batch");
+	TEST_CHECK(freeExprProgram(program));
+	freeExpr(op);
+
+	for(i = 0; i < numRecords; i++)
+		free(records[i].data);
+	freeSchema(schema);
+	TEST_DONE();
+}
+
+// ************************************************************
+void
+testOptimizeExpressions (void)
+{
+	Expr *a, *b, *cons, *op, *left, *right, *opt;
+	Record *record;
+	Value *value;
+	Schema *schema;
+	char **cpNames;
+	DataType *cpDt;
+	testName = "test optimizing expressions";
+	schema = testSchema();
+
+	TEST_CHECK(createRecord(&record, schema));
+	MAKE_VALUE(value, DT_INT, 42);
+	TEST_CHECK(setAttr(record, schema, 0, value));
+	freeVal(value);
+	MAKE_STRING_VALUE(value, "cc");
+	TEST_CHECK(setAttr(record, schema, 1, value));
+	freeVal(value);
+
+	// NOT NOT a = 42 is a = 42
+	MAKE_ATTRREF(a, 0);
+	MAKE_CONS(cons, stringToValue("i42"));
+	MAKE_BINOP_EXPR(left, a, cons, OP_COMP_EQUAL);
+	MAKE_UNOP_EXPR(right, left, OP_BOOL_NOT);
+	MAKE_UNOP_EXPR(op, right, OP_BOOL_NOT);
+	TEST_CHECK(optimizeExpr(op, schema, &opt));
+	ASSERT_TRUE(opt->type == EXPR_OP && opt->expr.op->type == OP_COMP_EQUAL, "double negation removed");
+	ASSERT_TRUE(evalCompiled(opt, schema, record), "a = 42");
+	freeExpr(opt);
+	freeExpr(op);
+
+	// 1 < 2 AND a = 42 is a = 42, 2 < 1 AND a = 42 is false
+	MAKE_CONS(left, stringToValue("i1"));
+	MAKE_CONS(right, stringToValue("i2"));
+	MAKE_BINOP_EXPR(b, left, right, OP_COMP_SMALLER);
+	MAKE_ATTRREF(a, 0);
+	MAKE_CONS(cons, stringToValue("i42"));
+	MAKE_BINOP_EXPR(right, a, cons, OP_COMP_EQUAL);
+	MAKE_BINOP_EXPR(op, b, right, OP_BOOL_AND);
+	TEST_CHECK(optimizeExpr(op, schema, &opt));
+	ASSERT_TRUE(opt->type == EXPR_OP && opt->expr.op->type == OP_COMP_EQUAL, "true operand of AND dropped");
+	freeExpr(opt);
+	b->expr.op->args[0]->expr.cons->v.intV = 3;
+	TEST_CHECK(optimizeExpr(op, schema, &opt));
+	ASSERT_TRUE(opt->type == EXPR_CONST && !opt->expr.cons->v.boolV, "false operand decides AND");
+	freeExpr(opt);
+	freeExpr(op);
+
+	// NOT (a = 1 OR b = cc) is a != 1 AND b != cc
+	MAKE_ATTRREF(a, 0);
+	MAKE_CONS(cons, stringToValue("i1"));
+	MAKE_BINOP_EXPR(left, a, cons, OP_COMP_EQUAL);
+	MAKE_ATTRREF(b, 1);
+	MAKE_CONS(cons, stringToValue("scc"));
+	MAKE_BINOP_EXPR(right, b, cons, OP_COMP_EQUAL);
+	MAKE_BINOP_EXPR(b, left, right, OP_BOOL_OR);
+	MAKE_UNOP_EXPR(op, b, OP_BOOL_NOT);
+	TEST_CHECK(optimizeExpr(op, schema, &opt));
+	ASSERT_TRUE(opt->type == EXPR_OP && opt->expr.op->type == OP_BOOL_AND, "NOT pushed below OR");
+	ASSERT_TRUE(opt->expr.op->args[0]->expr.op->type == OP_COMP_NOT_EQUAL, "NOT turns = into !=");
+	ASSERT_TRUE(!evalCompiled(opt, schema, record), "NOT (a = 1 OR b = cc)");
+	freeExpr(opt);
+	freeExpr(op);
+
+	// the cheaper and more selective comparison is evaluated first
+	MAKE_ATTRREF(b, 1);
+	MAKE_CONS(cons, stringToValue("sdd"));
+	MAKE_BINOP_EXPR(left, b, cons, OP_COMP_SMALLER);
+	MAKE_ATTRREF(a, 0);
+	MAKE_CONS(cons, stringToValue("i42"));
+	MAKE_BINOP_EXPR(right, a, cons, OP_COMP_EQUAL);
+	MAKE_BINOP_EXPR(op, left, right, OP_BOOL_AND);
+	TEST_CHECK(optimizeExpr(op, schema, &opt));
+	ASSERT_EQUALS_INT(0, opt->expr.op->args[0]->expr.op->args[0]->expr.attrRef, "a = 42 first");
+	ASSERT_TRUE(evalCompiled(opt, schema, record), "a = 42 AND b < dd");
+	freeExpr(opt);
+	freeExpr(op);
+	freeRecord(record);
+	freeSchema(schema);
+
+	// NaN is neither smaller nor greater, NOT f < 1 is kept for floats
+	cpNames = (char **) malloc(sizeof(char*));
+	cpNames[0] = (char *) malloc(2);
+	strcpy(cpNames[0], "f");
+	cpDt = (DataType *) malloc(sizeof(DataType));
+	cpDt[0] = DT_FLOAT;
+	schema = createSchema(1, cpNames, cpDt, (int *) calloc(1, sizeof(int)), 0, (int *) calloc(1, sizeof(int)));
+	TEST_CHECK(createRecord(&record, schema));
+	MAKE_VALUE(value, DT_FLOAT, 0.0f / 0.0f);
+	TEST_CHECK(setAttr(record, schema, 0, value));
+	freeVal(value);
+	MAKE_ATTRREF(a, 0);
+	MAKE_CONS(cons, stringToValue("f1"));
+	MAKE_BINOP_EXPR(left, a, cons, OP_COMP_SMALLER);
+	MAKE_UNOP_EXPR(op, left, OP_BOOL_NOT);
+	TEST_CHECK(optimizeExpr(op, schema, &opt));
+	ASSERT_TRUE(opt->type == EXPR_OP && opt->expr.op->type == OP_BOOL_NOT, "NOT kept for floats");
+	ASSERT_TRUE(evalCompiled(opt, schema, record), "NOT NaN < 1");
+	freeExpr(opt);
+	freeExpr(op);
+
+	freeRecord(record);
+	freeSchema(schema);
+	TEST_DONE();
+}
+
+// ************************************************************
+void
+testShortCircuit (void)
+{
+	Expr *a, *cons, *op, *bad;
+	Record *record;
+	Value *value, *res;
+	Schema *schema;
+	testName = "test short-circuit evaluation and errors";
+	schema = testSchema();
+
+	TEST_CHECK(createRecord(&record, schema));
+	MAKE_VALUE(value, DT_INT, 42);
+	TEST_CHECK(setAttr(record, schema, 0, value));
+	freeVal(value);
+
+	// a = x compares values of different datatypes
+	MAKE_ATTRREF(a, 0);
+	MAKE_CONS(cons, stringToValue("sx"));
+	MAKE_BINOP_EXPR(bad, a, cons, OP_COMP_EQUAL);
+	ASSERT_EQUALS_INT(RC_RM_COMPARE_VALUE_OF_DIFFERENT_DATATYPE, evalExpr(record, schema, bad, &res), "error is returned");
+	ASSERT_TRUE(res == NULL, "no result on error");
+
+	// the right side is not evaluated once the left side decides
+	MAKE_CONS(cons, stringToValue("bf"));
+	MAKE_BINOP_EXPR(op, cons, bad, OP_BOOL_AND);
+	TEST_CHECK(evalExpr(record, schema, op, &res));
+	ASSERT_TRUE(res->dt == DT_BOOL && !res->v.boolV, "false AND x");
+	freeVal(res);
+
+	op->expr.op->type = OP_BOOL_OR;
+	ASSERT_EQUALS_INT(RC_RM_COMPARE_VALUE_OF_DIFFERENT_DATATYPE, evalExpr(record, schema, op, &res), "false OR x needs x");
+
+	cons->expr.cons->v.boolV = true;
+	TEST_CHECK(evalExpr(record, schema, op, &res));
+	ASSERT_TRUE(res->dt == DT_BOOL && res->v.boolV, "true OR x");
+	freeVal(res);
+
+	// references to attributes outside the schema fail
+	MAKE_ATTRREF(a, 5);
+	ASSERT_EQUALS_INT(RC_PARAMS_ERROR, evalExpr(record, schema, a, &res), "unknown attribute");
+	freeExpr(a);
+
+	freeExpr(op);
+	freeRecord(record);
+	freeSchema(schema);
+	TEST_DONE();
+}
+
+// ************************************************************
+void
+testRangeOperators (void)
+{
+	Expr *a, *b, *cons, *low, *high, *conds[7];
+	Expr *list[12];
+	Record records[150];
+	Value *value, *res;
+	ExprProgram *program;
+	Schema *schema;
+	uint64_t selection[3];
+	int numRecords = 150, i, j;
+	char *strings[] = { "aa", "bb", "cc" };
+	char *names[] = { "a <= 10", "a > 140", "a >= 140", "b != bb", "a BETWEEN 20 AND 30",
+			"a IN (12 values)", "b IN (aa, cc)" };
+	testName = "test range, inequality, BETWEEN and IN operators";
+	schema = testSchema();
+
+	for(i = 0; i < numRecords; i++)
+	{
+		records[i].data = (char *) calloc(getRecordSize(schema) + 1, sizeof(char));
+		MAKE_VALUE(value, DT_INT, i);
+		TEST_CHECK(setAttr(&records[i], schema, 0, value));
+		freeVal(value);
+		MAKE_STRING_VALUE(value, strings[i % 3]);
+		TEST_CHECK(setAttr(&records[i], schema, 1, value));
+		freeVal(value);
+	}
+
+	MAKE_ATTRREF(a, 0);
+	MAKE_CONS(cons, stringToValue("i10"));
+	MAKE_BINOP_EXPR(conds[0], a, cons, OP_COMP_SMALLER_EQUAL);
+	MAKE_ATTRREF(a, 0);
+	MAKE_CONS(cons, stringToValue("i140"));
+	MAKE_BINOP_EXPR(conds[1], a, cons, OP_COMP_GREATER);
+	MAKE_ATTRREF(a, 0);
+	MAKE_CONS(cons, stringToValue("i140"));
+	MAKE_BINOP_EXPR(conds[2], a, cons, OP_COMP_GREATER_EQUAL);
+	MAKE_ATTRREF(b, 1);
+	MAKE_CONS(cons, stringToValue("sbb"));
+	MAKE_BINOP_EXPR(conds[3], b, cons, OP_COMP_NOT_EQUAL);
+	MAKE_ATTRREF(a, 0);
+	MAKE_CONS(low, stringToValue("i20"));
+	MAKE_CONS(high, stringToValue("i30"));
+	MAKE_BETWEEN_EXPR(conds[4], a, low, high);
+	// more values than EXPR_IN_HASH_MIN are looked up in a hash table
+	for(i = 0; i < 12; i++)
+	{
+		MAKE_VALUE(value, DT_INT, i * 11);
+		MAKE_CONS(list[i], value);
+	}
+	MAKE_ATTRREF(a, 0);
+	MAKE_IN_EXPR(conds[5], a, list, 12);
+	MAKE_CONS(list[0], stringToValue("saa"));
+	MAKE_CONS(list[1], stringToValue("scc"));
+	MAKE_ATTRREF(b, 1);
+	MAKE_IN_EXPR(conds[6], b, list, 2);
+
+	// the tree walk, the compiled program and the batch agree on every record
+	for(j = 0; j < 7; j++)
+	{
+		TEST_CHECK(compileExpr(conds[j], schema, &program));
+		TEST_CHECK(evalExprProgramBatch(program, records, numRecords, selection));
+		for(i = 0; i < numRecords; i++)
+		{
+			bool expected, match, selected;
+			switch(j)
+			{
+			case 0: expected = i <= 10; break;
+			case 1: expected = i > 140; break;
+			case 2: expected = i >= 140; break;
+			case 3: expected = i % 3 != 1; break;
+			case 4: expected = i >= 20 && i <= 30; break;
+			case 5: expected = i % 11 == 0 && i < 132; break;
+			default: expected = i % 3 != 1; break;
+			}
+			TEST_CHECK(evalExpr(&records[i], schema, conds[j], &res));
+			TEST_CHECK(evalExprProgram(program, &records[i], &match));
+			selected = (selection[i / EXPR_BLOCK_SIZE] >> (i % EXPR_BLOCK_SIZE)) & 1;
+			if (res->v.boolV != expected || match != expected || selected != expected)
+				break;
+			freeVal(res);
+		}
+		ASSERT_EQUALS_INT(numRecords, i, names[j]);
+		TEST_CHECK(freeExprProgram(program));
+		freeExpr(conds[j]);
+	}
+
+	// IN requires constants of the datatype of its input
+	MAKE_CONS(list[0], stringToValue("i1"));
+	MAKE_CONS(list[1], stringToValue("sx"));
+	MAKE_ATTRREF(a, 0);
+	MAKE_IN_EXPR(conds[0], a, list, 2);
+	ASSERT_EQUALS_INT(RC_RM_COMPARE_VALUE_OF_DIFFERENT_DATATYPE, compileExpr(conds[0], schema, &program), "IN with mixed datatypes");
+	freeExpr(conds[0]);
+
+	for(i = 0; i < numRecords; i++)
+		free(records[i].data);
+	freeSchema(schema);
+	TEST_DONE();
+}
+
+// ************************************************************
+void
+testKeyRanges (void)
+{
+	Expr *a, *b, *cons, *left, *right, *op, *list[3];
+	KeyRange range;
+	testName = "test extracting key ranges";
+
+	// a > 10 AND 20 >= a AND b = x
+	MAKE_ATTRREF(a, 0);
+	MAKE_CONS(cons, stringToValue("i10"));
+	MAKE_BINOP_EXPR(left, a, cons, OP_COMP_GREATER);
+	MAKE_ATTRREF(a, 0);
+	MAKE_CONS(cons, stringToValue("i20"));
+	MAKE_BINOP_EXPR(right, cons, a, OP_COMP_GREATER_EQUAL);
+	MAKE_BINOP_EXPR(op, left, right, OP_BOOL_AND);
+	MAKE_ATTRREF(b, 1);
+	MAKE_CONS(cons, stringToValue("sx"));
+	MAKE_BINOP_EXPR(right, b, cons, OP_COMP_EQUAL);
+	MAKE_BINOP_EXPR(left, op, right, OP_BOOL_AND);
+	TEST_CHECK(extractKeyRange(left, 0, &range));
+	ASSERT_TRUE(range.hasLow && range.low.v.intV == 10 && !range.lowInclusive, "low bound a > 10");
+	ASSERT_TRUE(range.hasHigh && range.high.v.intV == 20 && range.highInclusive, "high bound a <= 20");
+	ASSERT_TRUE(!range.empty, "range is not empty");
+	TEST_CHECK(extractKeyRange(left, 1, &range));
+	ASSERT_TRUE(range.hasLow && range.hasHigh && !strcmp(range.low.v.stringV, "x"), "b = x is a point range");
+
+	// AND a BETWEEN 30 AND 40 contradicts a <= 20
+	MAKE_ATTRREF(a, 0);
+	MAKE_CONS(cons, stringToValue("i30"));
+	MAKE_CONS(right, stringToValue("i40"));
+	MAKE_BETWEEN_EXPR(op, a, cons, right);
+	MAKE_BINOP_EXPR(right, left, op, OP_BOOL_AND);
+	TEST_CHECK(extractKeyRange(right, 0, &range));
+	ASSERT_TRUE(range.empty, "contradiction gives an empty range");
+	freeExpr(right);
+
+	// a IN (5, 3, 9) OR b = x does not bound a
+	for(int i = 0; i < 3; i++)
+	{
+		Value *value;
+		MAKE_VALUE(value, DT_INT, 5 - (i % 2) * 2 + (i / 2) * 4);
+		MAKE_CONS(list[i], value);
+	}
+	MAKE_ATTRREF(a, 0);
+	MAKE_IN_EXPR(op, a, list, 3);
+	TEST_CHECK(extractKeyRange(op, 0, &range));
+	ASSERT_TRUE(range.low.v.intV == 3 && range.high.v.intV == 9, "IN is bounded by its smallest and largest value");
+	MAKE_ATTRREF(b, 1);
+	MAKE_CONS(cons, stringToValue("sx"));
+	MAKE_BINOP_EXPR(right, b, cons, OP_COMP_EQUAL);
+	MAKE_BINOP_EXPR(left, op, right, OP_BOOL_OR);
+	TEST_CHECK(extractKeyRange(left, 0, &range));
+	ASSERT_TRUE(!range.hasLow && !range.hasHigh && !range.empty, "OR is not a range");
+	freeExpr(left);
+
+	TEST_DONE();
+}
+
+// ************************************************************
+void
+testExprArena (void)
+{
+	Expr *a, *b, *cons, *op;
+	ExprArena *arena;
+	Record *record;
+	Value *value, *res;
+	Schema *schema;
+	int length, offset, i;
+	testName = "test evaluating expressions in an arena";
+	schema = testSchema();
+
+	TEST_CHECK(createRecord(&record, schema));
+	MAKE_VALUE(value, DT_INT, 42);
+	TEST_CHECK(setAttr(record, schema, 0, value));
+	freeVal(value);
+	MAKE_STRING_VALUE(value, "abcd");
+	TEST_CHECK(setAttr(record, schema, 1, value));
+	freeVal(value);
+
+	// a string attribute is a view into the record
+	value = (Value *) malloc(sizeof(Value));
+	TEST_CHECK(getAttrView(record, schema, 1, value, &length));
+	attrOffset(schema, 1, &offset);
+	ASSERT_TRUE(value->v.stringV == record->data + offset && length == 4, "view of b");
+	free(value);
+
+	// b = abcd compares the full attribute in place
+	TEST_CHECK(createExprArena(&arena, 64));
+	MAKE_ATTRREF(b, 1);
+	MAKE_CONS(cons, stringToValue("sabcd"));
+	MAKE_BINOP_EXPR(op, b, cons, OP_COMP_EQUAL);
+	TEST_CHECK(evalExprArena(record, schema, op, arena, &res));
+	ASSERT_TRUE(res->dt == DT_BOOL && res->v.boolV, "b = abcd");
+	freeExpr(op);
+
+	// a string result is copied into the arena and terminated
+	MAKE_ATTRREF(b, 1);
+	TEST_CHECK(evalExprArena(record, schema, b, arena, &res));
+	ASSERT_EQUALS_STRING("abcd", res->v.stringV, "string result");
+	freeExpr(b);
+
+	// allocations beyond the block spill, after a reset the block fits them
+	for(i = 0; i < 21; i++)
+		allocExprArena(arena, 8);
+	ASSERT_TRUE(arena->spilled > 0, "full block spills");
+	length = arena->used + arena->spilled;
+	TEST_CHECK(resetExprArena(arena));
+	ASSERT_TRUE(arena->size >= (size_t) length && arena->extra == NULL, "block grows at reset");
+	ASSERT_TRUE(allocExprArena(arena, 8) == arena->data, "reset starts over");
+
+	// the arena and evalExpr agree
+	MAKE_ATTRREF(a, 0);
+	MAKE_CONS(cons, stringToValue("i50"));
+	MAKE_BINOP_EXPR(op, a, cons, OP_COMP_GREATER_EQUAL);
+	TEST_CHECK(evalExprArena(record, schema, op, arena, &res));
+	ASSERT_TRUE(!res->v.boolV, "a >= 50 in the arena");
+	TEST_CHECK(evalExpr(record, schema, op, &value));
+	ASSERT_TRUE(!value->v.boolV, "a >= 50");
+	freeVal(value);
+	freeExpr(op);
+
+	TEST_CHECK(freeExprArena(arena));
+	freeRecord(record);
+	freeSchema(schema);
+	TEST_DONE();
+}
+
+// ************************************************************
+void
+testWideTypes (void)
+{
+	char *names[] = { "l", "d", "t", "ts" };
+	DataType dt[] = { DT_LONG, DT_DOUBLE, DT_DATE, DT_TIMESTAMP };
+	char **cpNames = (char **) malloc(sizeof(char*) * 4);
+	DataType *cpDt = (DataType *) malloc(sizeof(DataType) * 4);
+	int *cpSizes = (int *) calloc(4, sizeof(int));
+	int *cpKeys = (int *) calloc(1, sizeof(int));
+	Expr *attr, *cons, *low, *high, *op, *list, *values[12];
+	Record records[100];
+	Value *value, *big, *small;
+	ExprProgram *program;
+	Schema *schema;
+	uint64_t selection[2];
+	int64_t micros;
+	int numRecords = 100, days, i;
+	char *text;
+	testName = "test LONG, DOUBLE, DATE and TIMESTAMP values";
+
+	// values beyond 32 bits compare exactly
+	big = stringToValue("l5000000000");
+	small = stringToValue("l4999999999");
+	OP_TRUE(small, big, valueSmaller, "long a < b");
+	OP_FALSE(big, small, valueSmaller, "long a < b");
+	OP_FALSE(small, big, valueEquals, "long a != b");
+	freeVal(big);
+	freeVal(small);
+	MAKE_VALUE(big, DT_DOUBLE, 0.1 + 0.2);
+	MAKE_VALUE(small, DT_DOUBLE, 0.3);
+	OP_TRUE(small, big, valueSmaller, "double keeps precision");
+	freeVal(big);
+	freeVal(small);
+
+	// dates and timestamps are read and printed in calendar form
+	TEST_CHECK(parseDate("1970-01-02", &days));
+	ASSERT_EQUALS_INT(1, days, "day after the epoch");
+	TEST_CHECK(parseDate("1969-12-31", &days));
+	ASSERT_EQUALS_INT(-1, days, "day before the epoch");
+	ASSERT_ERROR(parseDate("2023-02-29", &days), "no leap day in 2023");
+	ASSERT_ERROR(parseDate("2024-13-01", &days), "no 13th month");
+	text = serializeValue(stringToValue("D2024-02-29"));
+	ASSERT_EQUALS_STRING("2024-02-29", text, "date round trip");
+	free(text);
+	TEST_CHECK(parseTimestamp("1970-01-01 00:00:01.5", &micros));
+	ASSERT_TRUE(micros == 1500000, "timestamp with fraction");
+	text = serializeValue(stringToValue("T1969-12-31 23:59:59.25"));
+	ASSERT_EQUALS_STRING("1969-12-31 23:59:59.250000", text, "timestamp before the epoch");
+	free(text);
+	text = serializeValue(stringToValue("l-9000000000"));
+	ASSERT_EQUALS_STRING("-9000000000", text, "long round trip");
+	free(text);
+	OP_TRUE(stringToValue("D2024-01-31"), stringToValue("D2024-02-01"), valueSmaller, "dates are ordered");
+	OP_TRUE(stringToValue("T2024-01-31 23:59:59"), stringToValue("T2024-02-01"), valueSmaller, "timestamps are ordered");
+
+	// compiled programs agree with evalExpr on every type
+	for(i = 0; i < 4; i++)
+	{
+		cpNames[i] = (char *) malloc(3);
+		strcpy(cpNames[i], names[i]);
+	}
+	memcpy(cpDt, dt, sizeof(DataType) * 4);
+	schema = createSchema(4, cpNames, cpDt, cpSizes, 1, cpKeys);
+	ASSERT_EQUALS_INT(8 + 8 + 4 + 8, getRecordSize(schema), "record size");
+	TEST_CHECK(parseDate("2024-01-01", &days));
+	for(i = 0; i < numRecords; i++)
+	{
+		records[i].data = (char *) calloc(getRecordSize(schema), sizeof(char));
+		MAKE_VALUE(value, DT_LONG, 4294967296LL * i);
+		TEST_CHECK(setAttr(&records[i], schema, 0, value));
+		freeVal(value);
+		MAKE_VALUE(value, DT_DOUBLE, i / 3.0);
+		TEST_CHECK(setAttr(&records[i], schema, 1, value));
+		freeVal(value);
+		MAKE_VALUE(value, DT_DATE, days + i);
+		TEST_CHECK(setAttr(&records[i], schema, 2, value));
+		freeVal(value);
+		MAKE_VALUE(value, DT_TIMESTAMP, (int64_t) (days + i) * 86400000000LL);
+		TEST_CHECK(setAttr(&records[i], schema, 3, value));
+		freeVal(value);
+	}
+	getAttr(&records[70], schema, 0, &value);
+	ASSERT_TRUE(value->dt == DT_LONG && value->v.longV == 4294967296LL * 70, "get long");
+	freeVal(value);
+
+	// ts BETWEEN 2024-01-11 AND 2024-02-10 AND d < 20.0 AND l IN (...), the
+	// list is long enough to be hashed
+	MAKE_ATTRREF(attr, 3);
+	MAKE_CONS(low, stringToValue("T2024-01-11"));
+	MAKE_CONS(high, stringToValue("T2024-02-10"));
+	MAKE_BETWEEN_EXPR(op, attr, low, high);
+	MAKE_ATTRREF(attr, 1);
+	MAKE_CONS(cons, stringToValue("d20.0"));
+	MAKE_BINOP_EXPR(low, attr, cons, OP_COMP_SMALLER);
+	MAKE_BINOP_EXPR(high, op, low, OP_BOOL_AND);
+	for(i = 0; i < 12; i++)
+	{
+		MAKE_VALUE(value, DT_LONG, 4294967296LL * i * 5);
+		MAKE_CONS(values[i], value);
+	}
+	MAKE_ATTRREF(attr, 0);
+	MAKE_IN_EXPR(list, attr, values, 12);
+	MAKE_BINOP_EXPR(op, high, list, OP_BOOL_AND);
+
+	TEST_CHECK(compileExpr(op, schema, &program));
+	TEST_CHECK(evalExprProgramBatch(program, records, numRecords, selection));
+	for(i = 0; i < numRecords; i++)
+	{
+		bool selected = (selection[i / EXPR_BLOCK_SIZE] >> (i % EXPR_BLOCK_SIZE)) & 1;
+		bool expected = i >= 10 && i <= 40 && i / 3.0 < 20.0 && i % 5 == 0 && i < 60;
+		TEST_CHECK(evalExpr(&records[i], schema, op, &value));
+		bool interpreted = value->v.boolV;
+		freeVal(value);
+		if (selected != expected || interpreted != expected
+				|| evalCompiled(op, schema, &records[i]) != expected)
+			break;
+	}
+	ASSERT_EQUALS_INT(numRecords, i, "batch, scalar and interpreted results match");
+	TEST_CHECK(freeExprProgram(program));
+	freeExpr(op);
+
+	// dates are not compared with timestamps
+	MAKE_ATTRREF(attr, 2);
+	MAKE_CONS(cons, stringToValue("T2024-01-11"));
+	MAKE_BINOP_EXPR(op, attr, cons, OP_COMP_EQUAL);
+	ASSERT_ERROR(compileExpr(op, schema, &program), "date and timestamp differ");
+	freeExpr(op);
+
+	for(i = 0; i < numRecords; i++)
+		free(records[i].data);
+	freeSchema(schema);
+	TEST_DONE();
+}
+
+bool
+evalCompiled (Expr *expr, Schema *schema, Record *record)
+{
+	ExprProgram *program;
+	bool result;
+
+	TEST_CHECK(compileExpr(expr, schema, &program));
+	TEST_CHECK(evalExprProgram(program, record, &result));
+	TEST_CHECK(freeExprProgram(program));
+	return result;
+}
+
+Schema *
+testSchema (void)
+{
+	char *names[] = { "a", "b" };
+	DataType dt[] = { DT_INT, DT_STRING };
+	int sizes[] = { 0, 4 };
+	int keys[] = {0};
+	int i;
+	char **cpNames = (char **) malloc(sizeof(char*) * 2);
+	DataType *cpDt = (DataType *) malloc(sizeof(DataType) * 2);
+	int *cpSizes = (int *) malloc(sizeof(int) * 2);
+	int *cpKeys = (int *) malloc(sizeof(int));
+
+	for(i = 0; i < 2; i++)
+	{
+		cpNames[i] = (char *) malloc(2);
+		strcpy(cpNames[i], names[i]);
+	}
+	memcpy(cpDt, dt, sizeof(DataType) * 2);
+	memcpy(cpSizes, sizes, sizeof(int) * 2);
+	memcpy(cpKeys, keys, sizeof(int));
+
+	return createSchema(2, cpNames, cpDt, cpSizes, 1, cpKeys);
+}
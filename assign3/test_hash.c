@@ -0,0 +1,266 @@
+#include <stdlib.h>
+
+#include "dberror.h"
+
+#include "hash_mgr.h"
+#include "btree_mgr.h"
+#include "storage_mgr.h"
+#include "expr.h"
+#include "tables.h"
+#include "test_helper.h"
+
+// test methods
+static void testInsertAndFind (void);
+static void testDelete (void);
+static void testStringKeys (void);
+
+// helper methods
+static int *createPermutation (int size);
+static RID keyRID (int key);
+
+// test name
+char *testName;
+
+// main method
+int
+main (void)
+{
+	testName = "";
+	initIndexManager(NULL);
+
+	testInsertAndFind();
+	testDelete();
+	testStringKeys();
+
+	shutdownIndexManager();
+	return 0;
+}
+
+// ************************************************************
+void
+testInsertAndFind (void)
+{
+	int sizes[] = { 4, 16, 0 };
+	int numKeys = 5000, s, i, bad;
+	int *perm = createPermutation(numKeys);
+	HashHandle *index;
+	Value *key;
+	RID rid;
+	testName = "test hash index inserting and search";
+
+	for(s = 0; s < 3; s++)
+	{
+		TEST_CHECK(createHashIndex("testhash", DT_INT, sizes[s]));
+		TEST_CHECK(openHashIndex(&index, "testhash"));
+		for(i = 0; i < numKeys; i++)
+		{
+			MAKE_VALUE(key, DT_INT, perm[i]);
+			TEST_CHECK(insertHashKey(index, key, keyRID(perm[i])));
+			freeVal(key);
+		}
+
+		// existing keys are rejected
+		MAKE_VALUE(key, DT_INT, perm[0]);
+		ASSERT_EQUALS_INT(RC_IM_KEY_ALREADY_EXISTS, insertHashKey(index, key, keyRID(0)),
+				"duplicate key is rejected");
+		freeVal(key);
+
+		TEST_CHECK(getHashNumEntries(index, &i));
+		ASSERT_EQUALS_INT(numKeys, i, "number of entries");
+		TEST_CHECK(getHashNumBuckets(index, &i));
+		ASSERT_TRUE(i > 1, "buckets were split");
+
+		// the index and its directory survive closing and opening it again
+		TEST_CHECK(closeHashIndex(index));
+		TEST_CHECK(openHashIndex(&index, "testhash"));
+
+		bad = 0;
+		for(i = 0; i < numKeys; i++)
+		{
+			MAKE_VALUE(key, DT_INT, i);
+			if(findHashKey(index, key, &rid) != RC_OK || rid.page != keyRID(i).page
+					|| rid.slot != keyRID(i).slot)
+				bad++;
+			freeVal(key);
+		}
+		if(bad)
+			ASSERT_TRUE(false, "found the rid of each key");
+		ASSERT_TRUE(true, "found the rid of each key");
+
+		MAKE_VALUE(key, DT_INT, numKeys);
+		ASSERT_EQUALS_INT(RC_IM_KEY_NOT_FOUND, findHashKey(index, key, &rid), "missing key");
+		freeVal(key);
+		MAKE_VALUE(key, DT_INT, -1);
+		ASSERT_EQUALS_INT(RC_IM_KEY_NOT_FOUND, findHashKey(index, key, &rid), "missing key");
+		freeVal(key);
+
+		TEST_CHECK(closeHashIndex(index));
+		TEST_CHECK(deleteHashIndex("testhash"));
+	}
+
+	// buckets that do not fit into a page
+	ASSERT_EQUALS_INT(RC_IM_N_TO_LAGE, createHashIndex("testhash", DT_INT, PAGE_SIZE), "n too large");
+
+	free(perm);
+	TEST_DONE();
+}
+
+// ************************************************************
+void
+testDelete (void)
+{
+	int numKeys = 5000, i, bad, pages;
+	int *perm = createPermutation(numKeys);
+	HashHandle *index;
+	SM_FileHandle fh;
+	Value *key;
+	RID rid;
+	testName = "test hash index deleting keys";
+
+	TEST_CHECK(createHashIndex("testhash", DT_INT, 8));
+	TEST_CHECK(openHashIndex(&index, "testhash"));
+	for(i = 0; i < numKeys; i++)
+	{
+		MAKE_VALUE(key, DT_INT, perm[i]);
+		TEST_CHECK(insertHashKey(index, key, keyRID(perm[i])));
+		freeVal(key);
+	}
+	TEST_CHECK(closeHashIndex(index));
+	TEST_CHECK(openPageFile("testhash", &fh));
+	pages = fh.totalNumPages;
+	TEST_CHECK(closePageFile(&fh));
+	TEST_CHECK(openHashIndex(&index, "testhash"));
+
+	// delete the odd keys in random order
+	bad = 0;
+	for(i = 0; i < numKeys; i++)
+	{
+		if(perm[i] % 2 == 0)
+			continue;
+		MAKE_VALUE(key, DT_INT, perm[i]);
+		TEST_CHECK(deleteHashKey(index, key));
+		bad += deleteHashKey(index, key) != RC_IM_KEY_NOT_FOUND;
+		freeVal(key);
+	}
+	if(bad)
+		ASSERT_TRUE(false, "deleted key is gone");
+	ASSERT_TRUE(true, "deleted key is gone");
+	TEST_CHECK(getHashNumEntries(index, &i));
+	ASSERT_EQUALS_INT(numKeys / 2, i, "number of entries");
+
+	bad = 0;
+	for(i = 0; i < numKeys; i++)
+	{
+		RC rc;
+		MAKE_VALUE(key, DT_INT, i);
+		rc = findHashKey(index, key, &rid);
+		freeVal(key);
+		if((i % 2 == 0 && (rc != RC_OK || rid.slot != keyRID(i).slot))
+				|| (i % 2 == 1 && rc != RC_IM_KEY_NOT_FOUND))
+			bad++;
+	}
+	if(bad)
+		ASSERT_TRUE(false, "only even keys are left");
+	ASSERT_TRUE(true, "only even keys are left");
+
+	// empty buckets are merged until a single one is left
+	for(i = 0; i < numKeys; i += 2)
+	{
+		MAKE_VALUE(key, DT_INT, i);
+		TEST_CHECK(deleteHashKey(index, key));
+		freeVal(key);
+	}
+	TEST_CHECK(getHashNumBuckets(index, &i));
+	ASSERT_EQUALS_INT(1, i, "single bucket");
+	TEST_CHECK(getHashGlobalDepth(index, &i));
+	ASSERT_EQUALS_INT(0, i, "directory of one slot");
+	TEST_CHECK(closeHashIndex(index));
+
+	// freed bucket and directory pages are reused
+	TEST_CHECK(openHashIndex(&index, "testhash"));
+	for(i = 0; i < numKeys; i++)
+	{
+		MAKE_VALUE(key, DT_INT, perm[i]);
+		TEST_CHECK(insertHashKey(index, key, keyRID(perm[i])));
+		freeVal(key);
+	}
+	TEST_CHECK(getHashNumEntries(index, &i));
+	ASSERT_EQUALS_INT(numKeys, i, "number of entries");
+	TEST_CHECK(closeHashIndex(index));
+	TEST_CHECK(openPageFile("testhash", &fh));
+	ASSERT_EQUALS_INT(pages, fh.totalNumPages, "file did not grow");
+	TEST_CHECK(closePageFile(&fh));
+
+	TEST_CHECK(deleteHashIndex("testhash"));
+	free(perm);
+	TEST_DONE();
+}
+
+// ************************************************************
+void
+testStringKeys (void)
+{
+	char *names[] = { "carol", "alice", "bob", "", "alicia", "al", "zed", "bobby" };
+	int numNames = sizeof(names) / sizeof(names[0]), i;
+	HashHandle *index;
+	Value *key;
+	RID rid;
+	testName = "test hash index with string keys";
+
+	ASSERT_ERROR(createHashIndex("testhash", DT_STRING, 0), "strings need a length");
+	TEST_CHECK(createHashIndexWithLength("testhash", DT_STRING, 8, 2));
+	TEST_CHECK(openHashIndex(&index, "testhash"));
+	for(i = 0; i < numNames; i++)
+	{
+		MAKE_STRING_VALUE(key, names[i]);
+		TEST_CHECK(insertHashKey(index, key, keyRID(i)));
+		freeVal(key);
+	}
+	MAKE_STRING_VALUE(key, "too long for the key");
+	ASSERT_ERROR(insertHashKey(index, key, keyRID(0)), "key longer than the index");
+	freeVal(key);
+
+	// a prefix is a different key
+	for(i = 0; i < numNames; i++)
+	{
+		MAKE_STRING_VALUE(key, names[i]);
+		TEST_CHECK(findHashKey(index, key, &rid));
+		ASSERT_EQUALS_INT(i, rid.slot, "string key");
+		freeVal(key);
+	}
+	MAKE_STRING_VALUE(key, "ali");
+	ASSERT_EQUALS_INT(RC_IM_KEY_NOT_FOUND, findHashKey(index, key, &rid), "prefix is missing");
+	freeVal(key);
+
+	TEST_CHECK(closeHashIndex(index));
+	TEST_CHECK(deleteHashIndex("testhash"));
+	TEST_DONE();
+}
+
+// ************************************************************
+int *
+createPermutation (int size)
+{
+	int *result = (int *) malloc(size * sizeof(int));
+	int i;
+
+	srand(42);
+	for(i = 0; i < size; i++)
+		result[i] = i;
+	for(i = size - 1; i > 0; i--)
+	{
+		int j = rand() % (i + 1), tmp = result[i];
+		result[i] = result[j];
+		result[j] = tmp;
+	}
+	return result;
+}
+
+RID
+keyRID (int key)
+{
+	RID result;
+	result.page = key / 10 + 2;
+	result.slot = key;
+	return result;
+}